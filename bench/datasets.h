@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace vectorcore {
+namespace bench {
+
+// Dataset readers for the TEXMEX formats used by SIFT1M, GIST1M, GloVe and
+// Deep1B subsets (http://corpus-texmex.irisa.fr/):
+// - .fvecs: per row, an int32 dimension d followed by d float32 values.
+// - .ivecs: the same with int32 values (ground-truth neighbor ids).
+// Every row of a file has the same d. `max_rows` (0 = all) reads a prefix,
+// e.g. the first 100k rows of a 1B-row base set.
+
+template <typename T>
+struct Matrix {
+  std::vector<T> data;
+  std::size_t rows = 0;
+  std::size_t dim = 0;
+
+  const T* row(std::size_t r) const noexcept { return data.data() + (r * dim); }
+};
+
+namespace detail {
+
+struct FileCloser {
+  void operator()(std::FILE* f) const noexcept { std::fclose(f); }
+};
+
+template <typename T>
+Matrix<T> read_vecs(const std::string& path, std::size_t max_rows) {
+  static_assert(sizeof(T) == 4, "vecs rows hold 4-byte values");
+  std::unique_ptr<std::FILE, FileCloser> f(std::fopen(path.c_str(), "rb"));
+  if (!f) {
+    throw std::runtime_error("cannot open " + path);
+  }
+
+  Matrix<T> out;
+  std::int32_t d = 0;
+  while (max_rows == 0 || out.rows < max_rows) {
+    if (std::fread(&d, sizeof(d), 1, f.get()) != 1) {
+      break;
+    }
+    if (d <= 0 || (out.dim != 0 && static_cast<std::size_t>(d) != out.dim)) {
+      throw std::runtime_error(path + ": bad row dimension at row " + std::to_string(out.rows));
+    }
+    out.dim = static_cast<std::size_t>(d);
+    out.data.resize((out.rows + 1) * out.dim);
+    if (std::fread(out.data.data() + (out.rows * out.dim), sizeof(T), out.dim, f.get()) != out.dim) {
+      throw std::runtime_error(path + ": truncated row " + std::to_string(out.rows));
+    }
+    ++out.rows;
+  }
+  if (out.rows == 0) {
+    throw std::runtime_error(path + ": no rows");
+  }
+  return out;
+}
+
+} // namespace detail
+
+inline Matrix<float> read_fvecs(const std::string& path, std::size_t max_rows = 0) {
+  return detail::read_vecs<float>(path, max_rows);
+}
+
+inline Matrix<std::int32_t> read_ivecs(const std::string& path, std::size_t max_rows = 0) {
+  return detail::read_vecs<std::int32_t>(path, max_rows);
+}
+
+// Uniform [-1, 1) rows, for runs without a dataset on disk.
+inline Matrix<float> random_matrix(std::size_t rows, std::size_t dim, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uni(-1.f, 1.f);
+  Matrix<float> out;
+  out.rows = rows;
+  out.dim = dim;
+  out.data.resize(rows * dim);
+  for (float& x : out.data) {
+    x = uni(rng);
+  }
+  return out;
+}
+
+} // namespace bench
+} // namespace vectorcore
@@ -0,0 +1,638 @@
+// vectorcore_bench: regression benchmarks with machine-readable output.
+//
+// Four suites, each emitting one JSON array of flat records:
+// - kernels: ns per call of every distance kernel in every compiled-in,
+//   CPU-supported family, across dimensions and 64-byte / 4-byte alignment,
+//   including the dimension-specialized fp32 kernels ("*_fixed").
+// - search:  build time of BruteForceIndex and HnswIndex, then QPS and
+//   latency percentiles per thread count, one query per call ("single") and
+//   through search_batch ("batch"). Last, once the other suites are done,
+//   the HNSW graph is reorder()ed and searched again ("hnsw_reordered").
+// - recall:  HNSW recall@k against exact ground truth over an ef_search
+//   sweep, with the QPS each setting reaches.
+// - prefetch: single-query latency and QPS of both indexes over a sweep of
+//   prefetch_distance (0 = off), on one thread and on the whole pool.
+//
+// Data is uniform random unless --base / --query point to .fvecs files
+// (SIFT1M, GloVe, Deep1B subsets; see datasets.h). --gt reads .ivecs ground
+// truth; without it, or when --max-base cuts the base set, ground truth comes
+// from BruteForceIndex.
+//
+//   vectorcore_bench --base sift_base.fvecs --query sift_query.fvecs
+//                    --gt sift_groundtruth.ivecs --out sift.json
+//
+// The JSON goes to stdout (or --out); progress goes to stderr.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "datasets.h"
+#include "vectorcore/aligned_allocator.h"
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/distance.h"
+#include "vectorcore/float16.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/thread_pool.h"
+
+namespace {
+
+using vectorcore::bench::Matrix;
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// One flat JSON object; fields keep insertion order.
+class JsonObject {
+public:
+  JsonObject& set(const std::string& key, double v) {
+    char buf[32];
+    if (std::isfinite(v)) {
+      std::snprintf(buf, sizeof(buf), "%.9g", v);
+    } else {
+      std::snprintf(buf, sizeof(buf), "null");
+    }
+    fields_.emplace_back(key, buf);
+    return *this;
+  }
+
+  JsonObject& set(const std::string& key, const std::string& v) {
+    std::string quoted = "\"";
+    for (const char c : v) {
+      if (c == '"' || c == '\\') {
+        quoted += '\\';
+      }
+      quoted += c;
+    }
+    quoted += '"';
+    fields_.emplace_back(key, quoted);
+    return *this;
+  }
+
+  JsonObject& set(const std::string& key, const char* v) { return set(key, std::string(v)); }
+
+  std::string str() const {
+    std::string out = "{";
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+      out += (i ? ", \"" : "\"") + fields_[i].first + "\": " + fields_[i].second;
+    }
+    return out + "}";
+  }
+
+private:
+  std::vector<std::pair<std::string, std::string>> fields_; // (key, encoded value)
+};
+
+struct Options {
+  std::string base_path, query_path, gt_path, out_path;
+  std::size_t max_base = 0;
+  std::size_t max_queries = 0;
+  std::size_t rows = 20000;
+  std::size_t dim = 128;
+  std::size_t queries = 1000;
+  std::size_t k = 10;
+  std::size_t M = 16;
+  std::size_t ef_construction = 200;
+  vectorcore::Metric metric = vectorcore::Metric::L2_SQUARED;
+  std::vector<std::size_t> threads;
+  double min_time = 0.05; // seconds per kernel measurement
+  std::vector<std::size_t> prefetch_distances = {0, 1, 2, 4, 8, 16};
+  bool kernels = true, search = true, recall = true, prefetch = true;
+};
+
+const char* metric_name(vectorcore::Metric m) {
+  switch (m) {
+    case vectorcore::Metric::INNER_PRODUCT:
+      return "ip";
+    case vectorcore::Metric::COSINE:
+      return "cosine";
+    case vectorcore::Metric::L2_SQUARED:
+    default:
+      return "l2";
+  }
+}
+
+std::vector<std::string> split(const std::string& s) {
+  std::vector<std::string> out;
+  std::stringstream ss(s);
+  for (std::string item; std::getline(ss, item, ',');) {
+    if (!item.empty()) {
+      out.push_back(item);
+    }
+  }
+  return out;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: vectorcore_bench [options]\n"
+               "  --suites LIST          kernels,search,recall,prefetch (default: all)\n"
+               "  --base PATH            base vectors (.fvecs); default: random\n"
+               "  --query PATH           query vectors (.fvecs)\n"
+               "  --gt PATH              ground-truth neighbors (.ivecs)\n"
+               "  --max-base N           read only the first N base rows\n"
+               "  --max-queries N        read only the first N queries\n"
+               "  --rows N --dim D --queries Q   random data shape (20000, 128, 1000)\n"
+               "  --k K                  neighbors per query (10)\n"
+               "  --metric l2|ip|cosine  (l2)\n"
+               "  --M M --ef-construction EF     HNSW build parameters (16, 200)\n"
+               "  --threads LIST         thread counts (default: powers of two up to the pool)\n"
+               "  --prefetch LIST        prefetch distances to sweep (0,1,2,4,8,16)\n"
+               "  --min-time SEC         time per kernel measurement (0.05)\n"
+               "  --out PATH             write JSON here instead of stdout\n");
+}
+
+Options parse_options(int argc, char** argv) {
+  Options opt;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      usage();
+      std::exit(0);
+    }
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("missing value for " + arg);
+    }
+    const std::string value = argv[++i];
+    auto number = [&]() { return static_cast<std::size_t>(std::stoull(value)); };
+
+    if (arg == "--suites") {
+      opt.kernels = opt.search = opt.recall = opt.prefetch = false;
+      for (const auto& s : split(value)) {
+        if (s == "kernels") {
+          opt.kernels = true;
+        } else if (s == "search") {
+          opt.search = true;
+        } else if (s == "recall") {
+          opt.recall = true;
+        } else if (s == "prefetch") {
+          opt.prefetch = true;
+        } else {
+          throw std::invalid_argument("unknown suite: " + s);
+        }
+      }
+    } else if (arg == "--base") {
+      opt.base_path = value;
+    } else if (arg == "--query") {
+      opt.query_path = value;
+    } else if (arg == "--gt") {
+      opt.gt_path = value;
+    } else if (arg == "--out") {
+      opt.out_path = value;
+    } else if (arg == "--max-base") {
+      opt.max_base = number();
+    } else if (arg == "--max-queries") {
+      opt.max_queries = number();
+    } else if (arg == "--rows") {
+      opt.rows = number();
+    } else if (arg == "--dim") {
+      opt.dim = number();
+    } else if (arg == "--queries") {
+      opt.queries = number();
+    } else if (arg == "--k") {
+      opt.k = number();
+    } else if (arg == "--M") {
+      opt.M = number();
+    } else if (arg == "--ef-construction") {
+      opt.ef_construction = number();
+    } else if (arg == "--min-time") {
+      opt.min_time = std::stod(value);
+    } else if (arg == "--threads") {
+      for (const auto& t : split(value)) {
+        opt.threads.push_back(static_cast<std::size_t>(std::stoull(t)));
+      }
+    } else if (arg == "--prefetch") {
+      opt.prefetch_distances.clear();
+      for (const auto& d : split(value)) {
+        opt.prefetch_distances.push_back(static_cast<std::size_t>(std::stoull(d)));
+      }
+    } else if (arg == "--metric") {
+      if (value == "l2") {
+        opt.metric = vectorcore::Metric::L2_SQUARED;
+      } else if (value == "ip") {
+        opt.metric = vectorcore::Metric::INNER_PRODUCT;
+      } else if (value == "cosine") {
+        opt.metric = vectorcore::Metric::COSINE;
+      } else {
+        throw std::invalid_argument("unknown metric: " + value);
+      }
+    } else {
+      throw std::invalid_argument("unknown option: " + arg);
+    }
+  }
+  if (opt.base_path.empty() != opt.query_path.empty()) {
+    throw std::invalid_argument("--base and --query go together");
+  }
+  if (opt.k == 0) {
+    throw std::invalid_argument("--k must be > 0");
+  }
+  if (opt.threads.empty()) {
+    const std::size_t max_threads = vectorcore::ThreadPool::global().num_threads();
+    for (std::size_t t = 1; t < max_threads; t *= 2) {
+      opt.threads.push_back(t);
+    }
+    opt.threads.push_back(max_threads);
+  }
+  return opt;
+}
+
+// Kernels ---------------------------------------------------------------------
+
+// Calls `fn(row)` over a pool of rows small enough to stay in L1/L2, so the
+// kernel rather than DRAM is measured, until `min_time` has passed. Returns
+// ns per call.
+template <typename Fn>
+double time_calls(std::size_t rows, double min_time, Fn&& fn) {
+  volatile float sink = 0.f;
+  std::size_t calls = 0;
+  const auto start = Clock::now();
+  double elapsed = 0.0;
+  do {
+    float acc = 0.f;
+    for (std::size_t r = 0; r < rows; ++r) {
+      acc += fn(r);
+    }
+    sink = sink + acc;
+    calls += rows;
+    elapsed = seconds_since(start);
+  } while (elapsed < min_time);
+  return elapsed * 1e9 / static_cast<double>(calls);
+}
+
+void bench_kernels(const Options& opt, std::vector<JsonObject>& out) {
+  constexpr std::size_t kDims[] = {16, 100, 128, 256, 384, 768, 960, 1024, 1536};
+  constexpr std::size_t kPoolBytes = 128 * 1024;
+
+  for (const std::size_t dim : kDims) {
+    const std::size_t rows = std::max<std::size_t>(8, kPoolBytes / (dim * sizeof(float)));
+    // One spare float per row set so offset 1 stays in bounds.
+    const auto data = vectorcore::bench::random_matrix(rows + 2, dim, 3);
+    std::vector<float, vectorcore::AlignedAllocator<float, 64>> rows_buf(data.data.begin(), data.data.end());
+    std::vector<float, vectorcore::AlignedAllocator<float, 64>> query(dim + 1);
+    std::copy(data.row(rows + 1), data.row(rows + 1) + dim, query.begin());
+    std::vector<std::uint16_t> half(rows * dim);
+    std::vector<std::uint8_t> bytes(rows * dim);
+    for (std::size_t i = 0; i < half.size(); ++i) {
+      half[i] = vectorcore::float_to_half(rows_buf[i]);
+      bytes[i] = static_cast<std::uint8_t>(i * 131u);
+    }
+    const std::vector<float> scale(dim, 1.f / 255.f);
+
+    for (const std::size_t offset : {std::size_t{0}, std::size_t{1}}) {
+      const float* q = query.data() + offset;
+      const float* base = rows_buf.data() + offset;
+
+      for (const auto& family : vectorcore::supported_distance_kernels()) {
+        auto record = [&](const char* kernel, double flops_per_dim, double ns) {
+          out.push_back(JsonObject()
+                            .set("family", family.name)
+                            .set("kernel", kernel)
+                            .set("dim", static_cast<double>(dim))
+                            .set("offset_bytes", static_cast<double>(offset * sizeof(float)))
+                            .set("ns_per_call", ns)
+                            .set("gflops", flops_per_dim * static_cast<double>(dim) / ns));
+        };
+
+        record("l2_squared", 3, time_calls(rows, opt.min_time, [&](std::size_t r) {
+                 return family.l2_squared(q, base + (r * dim), dim);
+               }));
+        record("inner_product", 2, time_calls(rows, opt.min_time, [&](std::size_t r) {
+                 return family.inner_product(q, base + (r * dim), dim);
+               }));
+        // Dimension-specialized kernels, where the family has one for dim.
+        if (family.l2_squared_for(dim) != family.l2_squared) {
+          const vectorcore::DistanceFn l2 = family.l2_squared_for(dim);
+          const vectorcore::DistanceFn ip = family.inner_product_for(dim);
+          record("l2_squared_fixed", 3, time_calls(rows, opt.min_time, [&](std::size_t r) {
+                   return l2(q, base + (r * dim), dim);
+                 }));
+          record("inner_product_fixed", 2, time_calls(rows, opt.min_time, [&](std::size_t r) {
+                   return ip(q, base + (r * dim), dim);
+                 }));
+        }
+        // Compressed rows are packed back to back; only the query moves.
+        record("l2_squared_fp16", 3, time_calls(rows, opt.min_time, [&](std::size_t r) {
+                 return family.l2_squared_fp16(q, half.data() + (r * dim), dim);
+               }));
+        record("inner_product_fp16", 2, time_calls(rows, opt.min_time, [&](std::size_t r) {
+                 return family.inner_product_fp16(q, half.data() + (r * dim), dim);
+               }));
+        record("l2_squared_sq8", 4, time_calls(rows, opt.min_time, [&](std::size_t r) {
+                 return family.l2_squared_sq8(q, scale.data(), bytes.data() + (r * dim), dim);
+               }));
+        record("inner_product_sq8", 2, time_calls(rows, opt.min_time, [&](std::size_t r) {
+                 return family.inner_product_sq8(q, bytes.data() + (r * dim), dim);
+               }));
+      }
+    }
+    std::fprintf(stderr, "kernels: dim %zu done\n", dim);
+  }
+}
+
+// Search ----------------------------------------------------------------------
+
+// Value at fraction p of sorted samples (nearest rank).
+double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  const auto rank = static_cast<std::size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+  return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+// One query per search() call, queries spread over `threads` pool threads;
+// every call is timed on its own.
+template <typename Index>
+JsonObject bench_single(const char* name, const Index& index, const Matrix<float>& queries, std::size_t k,
+                        std::size_t threads) {
+  const std::size_t m = queries.rows;
+  std::vector<double> latency(m);
+  std::vector<std::uint64_t> ids(m * k);
+  std::vector<float> scores(m * k);
+
+  const auto start = Clock::now();
+  vectorcore::ThreadPool::global().parallel_for(m, 1, [&](std::size_t begin, std::size_t end, std::size_t) {
+    for (std::size_t i = begin; i < end; ++i) {
+      const auto t0 = Clock::now();
+      index.search(queries.row(i), k, ids.data() + (i * k), scores.data() + (i * k));
+      latency[i] = seconds_since(t0) * 1e6;
+    }
+  }, threads);
+  const double wall = seconds_since(start);
+
+  double sum = 0.0;
+  for (const double l : latency) {
+    sum += l;
+  }
+  std::sort(latency.begin(), latency.end());
+  return JsonObject()
+      .set("index", name)
+      .set("mode", "single")
+      .set("threads", static_cast<double>(threads))
+      .set("queries", static_cast<double>(m))
+      .set("k", static_cast<double>(k))
+      .set("qps", static_cast<double>(m) / wall)
+      .set("mean_us", sum / static_cast<double>(m))
+      .set("p50_us", percentile(latency, 0.50))
+      .set("p90_us", percentile(latency, 0.90))
+      .set("p99_us", percentile(latency, 0.99))
+      .set("p999_us", percentile(latency, 0.999))
+      .set("max_us", latency.back());
+}
+
+// The whole query set through one search_batch() call.
+template <typename Index>
+JsonObject bench_batch(const char* name, const Index& index, const Matrix<float>& queries, std::size_t k,
+                       std::size_t threads) {
+  const std::size_t m = queries.rows;
+  std::vector<std::uint64_t> ids(m * k);
+  std::vector<float> scores(m * k);
+
+  const auto start = Clock::now();
+  index.search_batch(queries.data.data(), m, k, ids.data(), scores.data(), threads);
+  const double wall = seconds_since(start);
+  return JsonObject()
+      .set("index", name)
+      .set("mode", "batch")
+      .set("threads", static_cast<double>(threads))
+      .set("queries", static_cast<double>(m))
+      .set("k", static_cast<double>(k))
+      .set("qps", static_cast<double>(m) / wall)
+      .set("mean_us", wall * 1e6 / static_cast<double>(m));
+}
+
+// Recall ----------------------------------------------------------------------
+
+// Mean fraction of each query's true top-k found in its returned top-k.
+double recall_at_k(const std::vector<std::uint64_t>& got, const std::vector<std::uint64_t>& truth,
+                   std::size_t m, std::size_t k) {
+  std::size_t hits = 0;
+  for (std::size_t q = 0; q < m; ++q) {
+    const auto begin = truth.begin() + static_cast<std::ptrdiff_t>(q * k);
+    const auto end = begin + static_cast<std::ptrdiff_t>(k);
+    for (std::size_t i = 0; i < k; ++i) {
+      hits += std::find(begin, end, got[q * k + i]) != end ? 1 : 0;
+    }
+  }
+  return static_cast<double>(hits) / static_cast<double>(m * k);
+}
+
+std::vector<std::uint64_t> ground_truth(const Options& opt, bool full_base, const vectorcore::BruteForceIndex& exact,
+                                        const Matrix<float>& queries) {
+  const std::size_t m = queries.rows;
+  const std::size_t k = opt.k;
+  std::vector<std::uint64_t> truth(m * k);
+
+  if (!opt.gt_path.empty() && full_base) {
+    const auto gt = vectorcore::bench::read_ivecs(opt.gt_path, m);
+    if (gt.rows < m || gt.dim < k) {
+      throw std::runtime_error(opt.gt_path + ": fewer rows or neighbors than the benchmark needs");
+    }
+    for (std::size_t q = 0; q < m; ++q) {
+      for (std::size_t i = 0; i < k; ++i) {
+        truth[q * k + i] = static_cast<std::uint64_t>(gt.row(q)[i]);
+      }
+    }
+    return truth;
+  }
+  if (!opt.gt_path.empty()) {
+    std::fprintf(stderr, "recall: --max-base cuts the base set, ignoring --gt\n");
+  }
+
+  std::vector<float> scores(m * k);
+  exact.search_batch(queries.data.data(), m, k, truth.data(), scores.data(), 0);
+  return truth;
+}
+
+void write_report(const Options& opt, const std::vector<std::pair<std::string, std::vector<JsonObject>>>& sections,
+                  const JsonObject& meta) {
+  std::string json = "{\n  \"meta\": " + meta.str();
+  for (const auto& section : sections) {
+    json += ",\n  \"" + section.first + "\": [";
+    for (std::size_t i = 0; i < section.second.size(); ++i) {
+      json += (i ? ",\n    " : "\n    ") + section.second[i].str();
+    }
+    json += section.second.empty() ? "]" : "\n  ]";
+  }
+  json += "\n}\n";
+
+  if (opt.out_path.empty()) {
+    std::fputs(json.c_str(), stdout);
+    return;
+  }
+  std::unique_ptr<std::FILE, vectorcore::bench::detail::FileCloser> f(std::fopen(opt.out_path.c_str(), "w"));
+  if (!f || std::fputs(json.c_str(), f.get()) < 0) {
+    throw std::runtime_error("cannot write " + opt.out_path);
+  }
+}
+
+int run(int argc, char** argv) {
+  const Options opt = parse_options(argc, argv);
+  vectorcore::ThreadPool& pool = vectorcore::ThreadPool::global();
+
+  std::vector<JsonObject> kernels, build, search, recall, prefetch;
+  if (opt.kernels) {
+    bench_kernels(opt, kernels);
+  }
+
+  Matrix<float> base, queries;
+  std::string dataset = "random";
+  if (opt.search || opt.recall || opt.prefetch) {
+    if (opt.base_path.empty()) {
+      base = vectorcore::bench::random_matrix(opt.rows, opt.dim, 1);
+      queries = vectorcore::bench::random_matrix(opt.queries, opt.dim, 2);
+    } else {
+      base = vectorcore::bench::read_fvecs(opt.base_path, opt.max_base);
+      queries = vectorcore::bench::read_fvecs(opt.query_path, opt.max_queries);
+      if (queries.dim != base.dim) {
+        throw std::runtime_error("base and query dimensions differ");
+      }
+      dataset = opt.base_path;
+    }
+    std::fprintf(stderr, "data: %zu x %zu base, %zu queries\n", base.rows, base.dim, queries.rows);
+  }
+
+  if (opt.search || opt.recall || opt.prefetch) {
+    vectorcore::BruteForceIndex exact(base.dim, opt.metric);
+    auto start = Clock::now();
+    exact.add(base.data.data(), base.rows);
+    double secs = seconds_since(start);
+    build.push_back(JsonObject()
+                        .set("index", "bruteforce")
+                        .set("rows", static_cast<double>(base.rows))
+                        .set("threads", 1.0)
+                        .set("seconds", secs)
+                        .set("rows_per_s", static_cast<double>(base.rows) / secs));
+
+    vectorcore::HnswIndex hnsw(base.dim, opt.M, opt.metric, opt.ef_construction);
+    start = Clock::now();
+    hnsw.add(base.data.data(), base.rows, nullptr, 0);
+    secs = seconds_since(start);
+    build.push_back(JsonObject()
+                        .set("index", "hnsw")
+                        .set("rows", static_cast<double>(base.rows))
+                        .set("threads", static_cast<double>(pool.num_threads()))
+                        .set("M", static_cast<double>(opt.M))
+                        .set("ef_construction", static_cast<double>(opt.ef_construction))
+                        .set("seconds", secs)
+                        .set("rows_per_s", static_cast<double>(base.rows) / secs));
+    std::fprintf(stderr, "build: hnsw %.2f s\n", secs);
+
+    if (opt.search) {
+      for (const std::size_t t : opt.threads) {
+        search.push_back(bench_single("bruteforce", exact, queries, opt.k, t));
+        search.push_back(bench_batch("bruteforce", exact, queries, opt.k, t));
+        search.push_back(bench_single("hnsw", hnsw, queries, opt.k, t).set("ef_search",
+                                                                            static_cast<double>(hnsw.ef_search())));
+        search.push_back(bench_batch("hnsw", hnsw, queries, opt.k, t).set("ef_search",
+                                                                           static_cast<double>(hnsw.ef_search())));
+        std::fprintf(stderr, "search: %zu threads done\n", t);
+      }
+    }
+
+    if (opt.recall) {
+      const bool full_base = opt.max_base == 0 || base.rows < opt.max_base;
+      const auto truth = ground_truth(opt, full_base, exact, queries);
+      const std::size_t m = queries.rows;
+      std::vector<std::uint64_t> ids(m * opt.k);
+      std::vector<float> scores(m * opt.k);
+      const std::size_t default_ef = hnsw.ef_search();
+      for (const std::size_t ef : {16, 32, 64, 128, 256, 512}) {
+        hnsw.set_ef_search(ef);
+        start = Clock::now();
+        hnsw.search_batch(queries.data.data(), m, opt.k, ids.data(), scores.data(), 0);
+        secs = seconds_since(start);
+        recall.push_back(JsonObject()
+                             .set("index", "hnsw")
+                             .set("ef_search", static_cast<double>(ef))
+                             .set("k", static_cast<double>(opt.k))
+                             .set("recall", recall_at_k(ids, truth, m, opt.k))
+                             .set("qps", static_cast<double>(m) / secs)
+                             .set("threads", static_cast<double>(pool.num_threads())));
+        std::fprintf(stderr, "recall: ef %zu done\n", ef);
+      }
+      hnsw.set_ef_search(default_ef);
+    }
+
+    if (opt.prefetch) {
+      // One thread shows the latency a miss costs; the whole pool shows
+      // whether the extra requests eat into shared memory bandwidth.
+      std::vector<std::size_t> thread_counts = {1};
+      if (pool.num_threads() > 1) {
+        thread_counts.push_back(pool.num_threads());
+      }
+      for (const std::size_t t : thread_counts) {
+        for (const std::size_t d : opt.prefetch_distances) {
+          exact.set_prefetch_distance(d);
+          hnsw.set_prefetch_distance(d);
+          prefetch.push_back(bench_single("bruteforce", exact, queries, opt.k, t)
+                                 .set("prefetch_distance", static_cast<double>(d)));
+          prefetch.push_back(bench_single("hnsw", hnsw, queries, opt.k, t)
+                                 .set("prefetch_distance", static_cast<double>(d))
+                                 .set("ef_search", static_cast<double>(hnsw.ef_search())));
+        }
+        std::fprintf(stderr, "prefetch: %zu threads done\n", t);
+      }
+    }
+
+    if (opt.search) {
+      // Runs last: it renumbers the graph the other suites measured.
+      hnsw.set_prefetch_distance(vectorcore::HnswIndex::kDefaultPrefetchDistance);
+      start = Clock::now();
+      hnsw.reorder();
+      secs = seconds_since(start);
+      build.push_back(JsonObject()
+                          .set("index", "hnsw_reorder")
+                          .set("rows", static_cast<double>(base.rows))
+                          .set("threads", 1.0)
+                          .set("seconds", secs)
+                          .set("rows_per_s", static_cast<double>(base.rows) / secs));
+      for (const std::size_t t : opt.threads) {
+        search.push_back(bench_single("hnsw_reordered", hnsw, queries, opt.k, t)
+                             .set("ef_search", static_cast<double>(hnsw.ef_search())));
+        search.push_back(bench_batch("hnsw_reordered", hnsw, queries, opt.k, t)
+                             .set("ef_search", static_cast<double>(hnsw.ef_search())));
+      }
+      std::fprintf(stderr, "search: reordered hnsw done\n");
+    }
+  }
+
+  JsonObject meta;
+  meta.set("active_kernel", vectorcore::active_kernel())
+      .set("pool_threads", static_cast<double>(pool.num_threads()))
+      .set("dataset", dataset)
+      .set("metric", metric_name(opt.metric));
+  if (!base.data.empty()) {
+    meta.set("rows", static_cast<double>(base.rows))
+        .set("dim", static_cast<double>(base.dim))
+        .set("queries", static_cast<double>(queries.rows));
+  }
+
+  write_report(opt, {{"kernels", kernels}, {"build", build}, {"search", search}, {"recall", recall},
+                {"prefetch", prefetch}}, meta);
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  try {
+    return run(argc, argv);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "vectorcore_bench: %s\n", e.what());
+    return 1;
+  }
+}
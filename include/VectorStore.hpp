@@ -1,10 +1,13 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <stdexcept>
 #include <vector>
 
+#include "vectorcore/aligned_allocator.h"
+
 namespace vectorcore {
 
 // VectorStore
@@ -28,7 +31,16 @@ namespace vectorcore {
 // - Requires chasing pointers (more cache misses and branchy code paths).
 // - Makes tight loops slower even if the total number of floats is the same.
 //
-// This class therefore stores *all* vectors in one std::vector<float>.
+// This class therefore stores vectors back to back in large flat chunks.
+//
+// **Chunked growth**
+// One ever-growing std::vector<float> has two problems: every reallocation
+// copies all stored vectors, and it invalidates every pointer handed out by
+// get_vector(). Instead, storage is a list of fixed-size, 64-byte aligned
+// chunks of 2^k rows (about 1 MiB each). A full chunk is never touched again:
+// growth allocates a new chunk, nothing is copied, and get_vector() pointers
+// stay valid for the lifetime of the store. Within a chunk the layout is the
+// same flat [row][dim] array, so scans still stream sequential memory.
 
 class VectorStore {
 public:
@@ -41,18 +53,24 @@ public:
   // - `id` is an external identifier (metadata).
   // - `vec_data` points to `dim` floats.
   // - `dim` must match the store's fixed dimension.
-  void add_vector(int id, const float* vec_data, std::size_t dim);
+  void add_vector(std::uint64_t id, const float* vec_data, std::size_t dim);
+
+  // Adds n vectors from a row-major [n, dim] matrix with one id each. Rows
+  // are copied chunk by chunk, one memcpy per chunk touched.
+  void add_vectors(const std::uint64_t* ids, const float* vectors, std::size_t n);
 
   // Returns a raw pointer to the start of the vector at internal index.
-  // The returned pointer is valid as long as `data_` isn't reallocated.
-  // (i.e., until the next push/insert that grows the vector).
+  // Chunks never move, so the pointer stays valid for the store's lifetime.
   const float* get_vector(std::size_t internal_idx) const;
 
-  int get_id(std::size_t internal_idx) const;
+  std::uint64_t get_id(std::size_t internal_idx) const;
+
+  // Rows per storage chunk (a power of two).
+  std::size_t chunk_rows() const noexcept { return std::size_t{1} << chunk_shift_; }
 
   // Brute-force kNN search over all stored vectors.
   // Returns (distance, external_id) pairs.
-  std::vector<std::pair<float, int>> search(const float* query, int k) const;
+  std::vector<std::pair<float, std::uint64_t>> search(const float* query, int k) const;
 
 private:
   // Phase 3 requirement: a static L2 distance function with scalar + AVX2.
@@ -66,19 +84,29 @@ private:
   // Using AVX2 we load 8 floats, subtract, and fused-multiply-add into an
   // accumulator vector.
   //
-  // **Loop unrolling (educational note)**
-  // Loop unrolling reduces loop overhead (branch + index increment) and can
-  // help the compiler schedule instructions better. In SIMD code, the loop is
-  // effectively unrolled by processing 8 elements per iteration.
+  // The kernels themselves live in src/distance*.cpp; this forwards to
+  // vectorcore::l2_squared, which picks scalar/AVX2/AVX-512/NEON at runtime.
   static float calculate_l2_dist(const float* a, const float* b, std::size_t dim) noexcept;
 
+  using Chunk = std::vector<float, AlignedAllocator<float, 64>>;
+
   std::size_t dim_ = 0;
 
-  // Non-negotiable: a single flat storage vector for *all* embeddings.
-  std::vector<float> data_;
+  // Row i lives in chunks_[i >> chunk_shift_] at row (i & (chunk_rows() - 1)).
+  // Each chunk is allocated at full size once; moving the outer vector moves
+  // chunk handles, never the floats.
+  std::size_t chunk_shift_ = 0;
+  std::vector<Chunk> chunks_;
 
   // Maps internal index -> external ID.
-  std::vector<int> ids_;
+  std::vector<std::uint64_t> ids_;
+
+  float* row_ptr(std::size_t internal_idx) noexcept {
+    return chunks_[internal_idx >> chunk_shift_].data() + ((internal_idx & (chunk_rows() - 1)) * dim_);
+  }
+  const float* row_ptr(std::size_t internal_idx) const noexcept {
+    return chunks_[internal_idx >> chunk_shift_].data() + ((internal_idx & (chunk_rows() - 1)) * dim_);
+  }
 };
 
 } // namespace vectorcore
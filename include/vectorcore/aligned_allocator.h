@@ -5,6 +5,8 @@
 #include <new>
 #include <type_traits>
 
+#include "vectorcore/memory_policy.h"
+
 #if defined(_MSC_VER)
   #include <malloc.h> // _aligned_malloc, _aligned_free
 #endif
@@ -21,6 +23,10 @@ namespace vectorcore {
 // - We still keep a *flat* memory model: a single contiguous vector of floats.
 //
 // Alignment is a compile-time constant so the optimizer can reason about it.
+//
+// An allocator may also carry a MemoryPolicy (huge pages, NUMA node). It
+// then maps whole pages through allocate_pages() instead of using the heap;
+// containers keep the policy across moves, swaps and copies.
 
 template <typename T, std::size_t Alignment>
 class AlignedAllocator {
@@ -31,9 +37,12 @@ public:
   using value_type = T;
 
   AlignedAllocator() noexcept = default;
+  explicit AlignedAllocator(const MemoryPolicy& policy) noexcept : policy_(policy) {}
 
   template <typename U>
-  AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+  AlignedAllocator(const AlignedAllocator<U, Alignment>& other) noexcept : policy_(other.policy()) {}
+
+  const MemoryPolicy& policy() const noexcept { return policy_; }
 
   [[nodiscard]] T* allocate(std::size_t n) {
     if (n == 0) {
@@ -46,6 +55,10 @@ public:
     }
 
     const std::size_t bytes = n * sizeof(T);
+    if (!policy_.is_default()) {
+      // Page aligned, so any Alignment up to the page size holds.
+      return static_cast<T*>(allocate_pages(bytes, policy_));
+    }
 
 #if defined(_MSC_VER)
     void* p = _aligned_malloc(bytes, Alignment);
@@ -64,7 +77,11 @@ public:
 #endif
   }
 
-  void deallocate(T* p, std::size_t /*n*/) noexcept {
+  void deallocate(T* p, std::size_t n) noexcept {
+    if (!policy_.is_default()) {
+      free_pages(p, n * sizeof(T), policy_);
+      return;
+    }
 #if defined(_MSC_VER)
     _aligned_free(p);
 #else
@@ -77,13 +94,20 @@ public:
     using other = AlignedAllocator<U, Alignment>;
   };
 
-  // Allocators are stateless; all instances are equivalent.
-  using is_always_equal = std::true_type;
+  // Instances with the same policy are interchangeable. The policy travels
+  // with the storage, so a moved-into container frees with the right one.
+  using is_always_equal = std::false_type;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+private:
+  MemoryPolicy policy_;
 };
 
 template <typename T1, std::size_t A1, typename T2, std::size_t A2>
-inline bool operator==(const AlignedAllocator<T1, A1>&, const AlignedAllocator<T2, A2>&) noexcept {
-  return A1 == A2;
+inline bool operator==(const AlignedAllocator<T1, A1>& a, const AlignedAllocator<T2, A2>& b) noexcept {
+  return A1 == A2 && a.policy() == b.policy();
 }
 
 template <typename T1, std::size_t A1, typename T2, std::size_t A2>
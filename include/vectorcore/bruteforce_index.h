@@ -3,16 +3,30 @@
 #include <cstddef>
 #include <cstdint>
 #include <limits>
-#include <queue>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "vectorcore/aligned_allocator.h"
 #include "vectorcore/distance.h"
+#include "vectorcore/flat_array.h"
+#include "vectorcore/memory_policy.h"
+#include "vectorcore/prefetch.h"
+#include "vectorcore/published_size.h"
+#include "vectorcore/range_search.h"
+#include "vectorcore/scalar_quantizer.h"
+#include "vectorcore/search_filter.h"
+#include "vectorcore/search_stats.h"
+#include "vectorcore/tombstones.h"
+#include "vectorcore/topk.h"
 
 namespace vectorcore {
 
+class ThreadPool;
+
 // BruteForceIndex
 // --------------
 // Baseline index with predictable behavior and excellent correctness.
@@ -22,36 +36,271 @@ namespace vectorcore {
 // - Flat memory model: embeddings are stored as a single contiguous array.
 //   This improves spatial locality, cache line utilization, and SIMD throughput.
 // - Dimension is fixed per index to avoid per-vector metadata and branches.
+//
+// Compressed storage (FP16 / INT8 / BINARY) scans codes instead of fp32
+// rows, cutting the bytes streamed per query by 2x / 4x / 32x. BINARY scores
+// are coarse Hamming distances, meant as a first-stage filter: pair it with
+// rerank_factor (the oversampling factor). With rerank_factor > 0 the fp32
+// rows are kept as well and the best k * rerank_factor code-space candidates
+// are re-scored exactly, so returned scores are exact; without it, scores
+// are the quantized approximations.
+//
+// Metric::COSINE normalizes rows while copying them into embeddings_ and
+// normalizes each query once, then scans with the IP kernel.
+//
+// remove() marks rows in a tombstone bitmap that every scan skips; upsert()
+// overwrites rows in place. compact() reclaims the removed slots.
+//
+// save() / load() persist the flat arrays in the index file format of
+// index_io.h; a loaded index scans the file's pages in place.
+//
+// `memory` places the fp32 rows and codes on huge pages and / or one NUMA
+// node (see memory_policy.h); ids and norms stay on the heap.
+//
+// Searches read only the rows published when the last add() returned (see
+// published_size.h). With an ingest capacity set, the storage never moves,
+// so one add() can run while other threads search.
 
 class BruteForceIndex {
 public:
-  explicit BruteForceIndex(std::size_t dim, Metric metric = Metric::L2_SQUARED);
+  explicit BruteForceIndex(std::size_t dim, Metric metric = Metric::L2_SQUARED,
+                           Storage storage = Storage::FP32, std::size_t rerank_factor = 0,
+                           const MemoryPolicy& memory = {});
 
   std::size_t dim() const noexcept { return dim_; }
-  std::size_t size() const noexcept { return size_; }
+
+  // Live rows: everything added minus everything removed.
+  std::size_t size() const noexcept { return published_.load() - deleted_.count(); }
+
+  // Removed rows still holding a slot until compact().
+  std::size_t num_deleted() const noexcept { return deleted_.count(); }
   Metric metric() const noexcept { return metric_; }
+  Storage storage() const noexcept { return quantizer_.storage(); }
+  std::size_t rerank_factor() const noexcept { return rerank_factor_; }
+  MemoryPolicy memory_policy() const noexcept { return embeddings_.memory_policy(); }
+
+  // INT8 storage: learns the per-dimension ranges from n sample rows. Must be
+  // called before the first add(); otherwise the first add() batch is used.
+  void train(const float* vectors, std::size_t n);
 
   // Adds n vectors from a row-major [n, dim] matrix.
   //
   // Note: we must persist the vectors in the index, so we copy into our flat
   // storage exactly once. The "zero-copy" constraint applies to the Python
   // bridge for reading NumPy arrays without intermediate memcpy.
+  //
+  // Without ids, each row gets the number of rows appended before it
+  // (removed and compacted ones included) as its id.
+  // Ids are expected to be unique; use upsert() to replace a row.
   void add(const float* vectors, std::size_t n, const std::uint64_t* ids = nullptr);
 
+  // add() of 16-bit rows (fp16 or bf16 bit patterns, see HalfFormat). The
+  // rows are widened to fp32 straight into the index's storage, so callers
+  // holding half-precision embeddings need no fp32 copy of their own.
+  void add_half(const std::uint16_t* vectors, std::size_t n, HalfFormat format,
+                const std::uint64_t* ids = nullptr);
+
+  // View mode: indexes n rows of caller memory in place instead of copying
+  // them. `owner` is held for as long as the rows are viewed (e.g. the
+  // NumPy array or mmap behind `vectors`); the rows must stay unchanged.
+  // Only ids and norms are stored, so an index over a memory-mapped file
+  // costs little more than its page cache.
+  //
+  // Needs an empty index with fp32 rows (FP32 storage, or rerank_factor > 0)
+  // and a metric other than COSINE, whose rows would have to be normalized.
+  // A later add(), upsert() or compact() copies the rows into owned storage
+  // first, as after a memory-mapped load().
+  void attach(const float* vectors, std::size_t n, std::shared_ptr<const void> owner,
+              const std::uint64_t* ids = nullptr);
+
+  // Whether the fp32 rows are read in place from memory the index does not
+  // own (attach(), or a memory-mapped load()).
+  bool is_view() const noexcept { return embeddings_.is_view(); }
+
+  // Removes the rows with the given external ids and returns how many were
+  // found. Unknown ids are ignored. The first call builds an id -> row hash
+  // map, which later add() calls keep up to date.
+  std::size_t remove(const std::uint64_t* ids, std::size_t n);
+
+  // Replaces the rows of ids already present (in place, no tombstone) and
+  // adds the others. A repeated id keeps its last row.
+  void upsert(const float* vectors, std::size_t n, const std::uint64_t* ids);
+
+  // Drops removed rows from the flat arrays, keeping the order of the rest.
+  void compact();
+
+  // remove() calls compact() once removed rows exceed this fraction of the
+  // stored rows. 0 (the default) leaves compaction to the caller.
+  double compact_threshold() const noexcept { return compact_threshold_; }
+  void set_compact_threshold(double ratio) noexcept { compact_threshold_ = ratio; }
+
+  // Concurrent ingest: reserves storage for `capacity` rows, which then
+  // never moves, so one add() / add_half() at a time may run while any
+  // number of threads search. The new rows are written past the rows the
+  // searches see and published together when add() returns. An add() past
+  // the capacity throws std::length_error and changes nothing; raise the
+  // capacity (with no searches running) first. 0, the default, turns the
+  // mode off. remove(), upsert(), compact() and attach() still need the
+  // index to themselves. INT8 storage must be trained first.
+  void set_ingest_capacity(std::size_t capacity);
+  std::size_t ingest_capacity() const noexcept { return ingest_capacity_; }
+
+  // Rows ahead of the one being scored that search() prefetches, when a
+  // stored row (fp32 or code) spans at least kPrefetchMinRowBytes. The
+  // hardware prefetcher keeps up with short rows, but a scan of long rows
+  // crosses a 4 KiB page every row or two, where it stops. 0 turns
+  // prefetching off; tune it with the bench `prefetch` suite.
+  static constexpr std::size_t kDefaultPrefetchDistance = 2;
+  static constexpr std::size_t kPrefetchMinRowBytes = 1024;
+  std::size_t prefetch_distance() const noexcept { return prefetch_distance_; }
+  void set_prefetch_distance(std::size_t rows) noexcept { prefetch_distance_ = rows; }
+
+  // Pool that num_threads != 1 calls run on; nullptr (the default) is
+  // ThreadPool::global(). ShardedIndex hands each shard the pool pinned to
+  // its NUMA node. The pool must outlive the index's use of it.
+  void set_thread_pool(ThreadPool* pool) noexcept { pool_ = pool; }
+
   // kNN search for a single query vector.
   // Output arrays must have capacity >= k.
-  void search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores) const;
+  //
+  // num_threads != 1 splits a large scan into row ranges on the global
+  // ThreadPool (0 = all threads); each worker keeps its own top-k and the
+  // partial results are merged. Small indexes are always scanned serially.
+  //
+  // With a filter, rows it rejects are skipped before they are scored, so
+  // the result is the exact top-k among the allowed rows (padded when fewer
+  // than k are allowed).
+  void search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores,
+              std::size_t num_threads = 1, const SearchFilter* filter = nullptr) const;
+
+  // kNN search for m queries from a row-major [m, dim] matrix.
+  // Output arrays are row-major [m, k].
+  //
+  // Queries and database rows are tiled like a GEMM: a block of rows sized to
+  // stay in L2 is scored against a whole block of queries before moving on,
+  // so embeddings_ is streamed from DRAM once per query block instead of once
+  // per query. L2 uses ||q||^2 - 2 q.x + ||x||^2 with the cached row norms;
+  // scores can differ from search() in the last few bits.
+  //
+  // num_threads != 1 spreads query ranges over the global ThreadPool
+  // (0 = all threads). Each worker writes its rows of the output directly.
+  //
+  // With compressed storage each query runs search() instead of the tiled
+  // fp32 scan. `filter` applies to every query.
+  void search_batch(const float* queries, std::size_t m, std::size_t k, std::uint64_t* out_ids,
+                    float* out_scores, std::size_t num_threads = 1, const SearchFilter* filter = nullptr) const;
+
+  // Range search: every visible row within `radius` of each of m queries
+  // (row-major [m, dim]), best first, in CSR form (see RangeSearchResult).
+  // fp32 L2 scans give up on a row as soon as its partial distance passes
+  // the radius. num_threads != 1 spreads the queries over the global
+  // ThreadPool (0 = all threads).
+  //
+  // Compressed storage is checked against the fp32 rows when they are kept
+  // (rerank_factor > 0) and against the codes otherwise.
+  void range_search(const float* queries, std::size_t m, float radius, RangeSearchResult& out,
+                    std::size_t num_threads = 1, const SearchFilter* filter = nullptr) const;
+
+  // Search statistics (see search_stats.h), off by default. When on, every
+  // search() records its rows visited and scored, top-k admissions and
+  // latency into stats(). search_batch() records its per-query scans on
+  // compressed storage; the tiled fp32 scan scores whole query blocks at
+  // once and is not recorded.
+  bool stats_enabled() const noexcept { return stats_enabled_; }
+  void set_stats_enabled(bool on) noexcept { stats_enabled_ = on; }
+  const SearchStats& stats() const noexcept { return *stats_; }
+  void reset_stats() noexcept { stats_->reset(); }
+
+  // Writes the index to `path` (see index_io.h).
+  void save(const std::string& path) const;
+
+  // Reads an index written by save(). With mmap the rows are read from the
+  // page cache in place; otherwise the file is read into memory once. Either
+  // way a later add() copies the arrays into owned storage first.
+  static BruteForceIndex load(const std::string& path, bool mmap = true);
 
 private:
   std::size_t dim_ = 0;
-  std::size_t size_ = 0;
+  std::size_t size_ = 0;    // rows stored, written by add()
+  PublishedSize published_; // rows searches see: size_ once add() returns
+  std::size_t ingest_capacity_ = 0;
   Metric metric_ = Metric::L2_SQUARED;
+  DistanceFn distance_ = nullptr; // fp32 kernel for metric_ and dim_, resolved once
+  std::size_t rerank_factor_ = 0;
+  std::uint64_t next_id_ = 0; // first id handed out by add() without ids
+  double compact_threshold_ = 0.0;
+  std::size_t prefetch_distance_ = kDefaultPrefetchDistance;
+
+  // Flat contiguous memory: [size_ * dim_]. Empty when rows are compressed
+  // and no rerank is requested.
+  FlatArray<float> embeddings_;
+  FlatArray<std::uint64_t> ids_;
+
+  // Squared L2 norm of each stored fp32 row, filled at add() time: [size_]
+  FlatArray<float> norms_;
+
+  // Compressed rows, [size_ * code_size()] (FP16 / INT8 / BINARY).
+  ScalarQuantizer quantizer_;
+  FlatArray<std::uint8_t> codes_;
+
+  // Removed rows, and the external id -> row map behind remove() / upsert()
+  // (built on first use; live rows only).
+  Tombstones deleted_;
+  std::unordered_map<std::uint64_t, std::size_t> id_map_;
+  bool id_map_ready_ = false;
+
+  // Behind a pointer: the atomics would otherwise make the index immovable.
+  bool stats_enabled_ = false;
+  std::unique_ptr<SearchStats> stats_;
+
+  ThreadPool* pool_ = nullptr;
+  ThreadPool& thread_pool() const noexcept;
+
+  bool quantized() const noexcept { return quantizer_.storage() != Storage::FP32; }
+  bool has_fp32() const noexcept { return !quantized() || rerank_factor_ > 0; }
+
+  void build_id_map();
+
+  // add() / attach() / add_half() body. With in_place, embeddings_ already
+  // views the n rows at `vectors`; with `halves`, those rows are read
+  // instead of `vectors` and widened from `format`.
+  void append(const float* vectors, std::size_t n, const std::uint64_t* ids, bool in_place,
+              const std::uint16_t* halves = nullptr, HalfFormat format = HalfFormat::FP16);
+
+  // Writes vector v over stored row `row` (fp32, norm and code).
+  void overwrite(std::size_t row, const float* v);
+
+  // Selects (badness, internal index) pairs.
+  using Selector = TopK<std::size_t>;
+
+  float score(const float* a, const float* b) const noexcept { return distance_(a, b, dim_); }
+
+  // Removed, or rejected by `filter` (may be null).
+  bool hidden(std::size_t row, const SearchFilter* filter) const {
+    return deleted_.test(row) || (filter && !filter->allows(row, ids_[row]));
+  }
+
+  // Reserves every row array for ingest_capacity_ rows.
+  void reserve_ingest();
+
+  // Scores the visible rows of [begin, end) into `top`, using codes_ when
+  // quantized and embeddings_ otherwise. Returns how many were scored.
+  std::size_t scan_rows(const PreparedQuery& query, std::size_t begin, std::size_t end, const SearchFilter* filter,
+                 Selector& top) const;
+
+  // Replaces code-space badness with exact fp32 badness, keeping the best k.
+  void rerank(const float* query, std::size_t k, Selector& top) const;
+
+  // Sorts `top` and writes k results (padded with sentinels).
+  void write_results(Selector& top, std::size_t k, std::uint64_t* out_ids, float* out_scores) const;
 
-  // Flat contiguous memory: [size_ * dim_]
-  std::vector<float, AlignedAllocator<float, 32>> embeddings_;
-  std::vector<std::uint64_t> ids_;
+  // Appends the visible rows within `radius` of one query to `hits`.
+  void range_scan(const float* query, float radius, const SearchFilter* filter,
+                  RangeSearchResult::Hits& hits) const;
 
-  float score(const float* a, const float* b) const noexcept;
+  // Serial blocked scan behind search_batch, over the first `rows` rows.
+  void search_batch_range(const float* queries, std::size_t m, std::size_t k, std::uint64_t* out_ids,
+                          float* out_scores, const SearchFilter* filter, std::size_t rows) const;
 };
 
 } // namespace vectorcore
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "vectorcore/index_traits.h"
+
+namespace vectorcore {
+
+// On-disk vector formats the bulk loader reads.
+// - FVECS: per row, an int32 dimension d followed by d float32 values
+//   (TEXMEX: SIFT1M, GIST1M, Deep1B).
+// - BVECS: the same with d uint8 values (SIFT1B).
+// - NPY: a 2-D C-order NumPy array of <f4, <f2 or |u1, format version 1-3.
+// All multi-byte values are little-endian.
+enum class FileFormat : std::uint8_t {
+  FVECS = 0,
+  BVECS = 1,
+  NPY = 2,
+};
+
+// VectorFileReader
+// ----------------
+// Streams the rows of a vector file as fp32, a batch at a time, so a file
+// of any size is read through one batch-sized buffer. The header (and for
+// .fvecs / .bvecs the row layout) is validated on open; every error is a
+// std::runtime_error naming the file.
+class VectorFileReader {
+public:
+  VectorFileReader(const std::string& path, FileFormat format);
+
+  const std::string& path() const noexcept { return path_; }
+  FileFormat format() const noexcept { return format_; }
+  std::size_t dim() const noexcept { return dim_; }
+  std::size_t rows() const noexcept { return rows_; }
+
+  // Reads up to max_rows rows into out ([max_rows, dim] floats) and returns
+  // how many were read; 0 once every row has been returned.
+  std::size_t read(float* out, std::size_t max_rows);
+
+private:
+  enum class Element : std::uint8_t { F32, F16, U8 };
+
+  std::string path_;
+  FileFormat format_;
+  std::ifstream in_;
+  Element element_ = Element::F32;
+  std::size_t dim_ = 0;
+  std::size_t rows_ = 0;
+  std::size_t next_ = 0;           // rows returned so far
+  std::size_t row_prefix_ = 0;     // the int32 dimension before each .fvecs / .bvecs row
+  std::vector<std::uint8_t> raw_;  // one batch as stored in the file
+
+  std::size_t element_bytes() const noexcept {
+    return (element_ == Element::F32) ? sizeof(float) : (element_ == Element::F16) ? sizeof(std::uint16_t) : 1;
+  }
+
+  [[noreturn]] void fail(const std::string& what) const;
+  void open_vecs(std::size_t file_size);
+  void open_npy(std::size_t file_size);
+};
+
+// Adds m rows ([m, dim] floats) to the index being loaded.
+using AddBatchFn = std::function<void(const float* rows, std::size_t m)>;
+
+// Reads `path` on a background thread, batch_size rows at a time, into a
+// small ring of batch buffers, and hands each full batch to `add` on the
+// calling thread, so parsing the next batch overlaps with adding this one.
+// At most a few batches are in memory at once. Throws std::invalid_argument
+// if the file's dimension is not `dim` or batch_size is 0. An exception
+// from either stage stops both and is rethrown here; rows already added
+// stay. Returns the number of rows added.
+std::size_t stream_file(const std::string& path, FileFormat format, std::size_t dim, std::size_t batch_size,
+                        const AddBatchFn& add);
+
+// Appends every row of the file to `index` (BruteForceIndex, HnswIndex)
+// through its add(), which assigns ids as usual. Indexes whose add() takes
+// num_threads (HnswIndex) build each batch on that many pool threads
+// (0 = all).
+template <typename Index>
+std::size_t load_from_file(Index& index, const std::string& path, FileFormat format,
+                           std::size_t batch_size = 16384, std::size_t num_threads = 0) {
+  return stream_file(path, format, index.dim(), batch_size, [&index, num_threads](const float* rows, std::size_t m) {
+    if constexpr (AddTakesThreads<Index>::value) {
+      index.add(rows, m, nullptr, num_threads);
+    } else {
+      (void)num_threads;
+      index.add(rows, m);
+    }
+  });
+}
+
+} // namespace vectorcore
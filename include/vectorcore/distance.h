@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 namespace vectorcore {
 
@@ -12,17 +14,195 @@ namespace vectorcore {
 enum class Metric : std::uint8_t {
   L2_SQUARED = 0,
   INNER_PRODUCT = 1,
+  COSINE = 2,
 };
 
+// Cosine similarity is the inner product of unit vectors. Indexes built
+// with Metric::COSINE normalize each row once as it is stored and each query
+// once per search, and from there on score exactly like INNER_PRODUCT, so
+// cosine search costs the same as IP.
+inline Metric kernel_metric(Metric metric) noexcept {
+  return (metric == Metric::COSINE) ? Metric::INNER_PRODUCT : metric;
+}
+
+// Scales v[0, dim) to unit L2 norm in place. Zero vectors stay zero.
+void normalize(float* v, std::size_t dim) noexcept;
+
+// normalize() over n row-major [n, dim] rows.
+void normalize_rows(float* x, std::size_t n, std::size_t dim) noexcept;
+
+using DistanceFn = float (*)(const float* a, const float* b, std::size_t dim) noexcept;
+
+// Looks up a kernel specialized for vectors of exactly `dim` floats, or
+// returns nullptr when the family has none for that dim. A specialization
+// ignores its own dim argument; it is unrolled completely for the
+// embedding sizes of common models:
+//   128, 256, 384, 512, 768, 1024, 1536
+// and returns bit-identical results to the family's generic kernel.
+using FixedDimFn = DistanceFn (*)(std::size_t dim) noexcept;
+
+// Asymmetric kernels: fp32 query-side vector against a compressed row.
+//
+// SQ8 rows are uint8 codes with x_d = vmin_d + scale_d * c_d. The scalar
+// quantizer folds vmin into the query, so the kernels only see:
+//   l2:  sum_d (a_d - scale_d * c_d)^2   with a = q - vmin
+//   ip:  sum_d a_d * c_d                 with a = q * scale
+// FP16 rows are IEEE binary16, widened to fp32 inside the kernel.
+using Sq8L2Fn = float (*)(const float* a, const float* scale, const std::uint8_t* codes,
+                          std::size_t dim) noexcept;
+using Sq8IpFn = float (*)(const float* a, const std::uint8_t* codes, std::size_t dim) noexcept;
+using Fp16Fn = float (*)(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept;
+
+// 16-bit float input (e.g. fp16 / bf16 model outputs) widened to fp32:
+// src[0, n) -> dst[0, n).
+using WidenFn = void (*)(const std::uint16_t* src, float* dst, std::size_t n) noexcept;
+
+// Product-quantization ADC: sum_s table[s * 256 + codes[s]] over m subspaces,
+// i.e. one lookup per code byte into a per-query [m, 256] distance table.
+using PqAdcFn = float (*)(const float* table, const std::uint8_t* codes, std::size_t m) noexcept;
+
+// Hamming distance between two bit strings of `bytes` bytes: the number of
+// bits set in a XOR b. Scores binary (1-bit sign) codes.
+using HammingFn = std::uint32_t (*)(const std::uint8_t* a, const std::uint8_t* b, std::size_t bytes) noexcept;
+
 float l2_squared_scalar(const float* a, const float* b, std::size_t dim) noexcept;
 float inner_product_scalar(const float* a, const float* b, std::size_t dim) noexcept;
+float l2_squared_sq8_scalar(const float* a, const float* scale, const std::uint8_t* codes,
+                            std::size_t dim) noexcept;
+float inner_product_sq8_scalar(const float* a, const std::uint8_t* codes, std::size_t dim) noexcept;
+float l2_squared_fp16_scalar(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept;
+float inner_product_fp16_scalar(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept;
+float pq_adc_scalar(const float* table, const std::uint8_t* codes, std::size_t m) noexcept;
+std::uint32_t hamming_scalar(const std::uint8_t* a, const std::uint8_t* b, std::size_t bytes) noexcept;
+void fp16_to_fp32_scalar(const std::uint16_t* src, float* dst, std::size_t n) noexcept;
+void bf16_to_fp32_scalar(const std::uint16_t* src, float* dst, std::size_t n) noexcept;
 
-// AVX2 implementations (compiled in conditionally). The dispatcher lives in .cpp.
+// ISA-specific kernels. Each family lives in its own translation unit
+// (distance_avx2.cpp, distance_avx512.cpp, distance_neon.cpp) compiled with
+// that ISA's target flags, so the rest of the library stays baseline code.
+// The build defines VECTORCORE_HAVE_<ISA> for the families it compiles.
+// Never call these directly unless the running CPU supports them; go through
+// l2_squared()/inner_product() or supported_distance_kernels().
+#if defined(VECTORCORE_HAVE_AVX2)
 float l2_squared_avx2(const float* a, const float* b, std::size_t dim) noexcept;
 float inner_product_avx2(const float* a, const float* b, std::size_t dim) noexcept;
+DistanceFn l2_squared_fixed_avx2(std::size_t dim) noexcept;
+DistanceFn inner_product_fixed_avx2(std::size_t dim) noexcept;
+void fp16_to_fp32_avx2(const std::uint16_t* src, float* dst, std::size_t n) noexcept;
+void bf16_to_fp32_avx2(const std::uint16_t* src, float* dst, std::size_t n) noexcept;
+float l2_squared_sq8_avx2(const float* a, const float* scale, const std::uint8_t* codes,
+                          std::size_t dim) noexcept;
+float inner_product_sq8_avx2(const float* a, const std::uint8_t* codes, std::size_t dim) noexcept;
+float l2_squared_fp16_avx2(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept;
+float inner_product_fp16_avx2(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept;
+float pq_adc_avx2(const float* table, const std::uint8_t* codes, std::size_t m) noexcept;
+std::uint32_t hamming_avx2(const std::uint8_t* a, const std::uint8_t* b, std::size_t bytes) noexcept;
+#endif
+#if defined(VECTORCORE_HAVE_AVX512)
+float l2_squared_avx512(const float* a, const float* b, std::size_t dim) noexcept;
+float inner_product_avx512(const float* a, const float* b, std::size_t dim) noexcept;
+DistanceFn l2_squared_fixed_avx512(std::size_t dim) noexcept;
+DistanceFn inner_product_fixed_avx512(std::size_t dim) noexcept;
+void fp16_to_fp32_avx512(const std::uint16_t* src, float* dst, std::size_t n) noexcept;
+void bf16_to_fp32_avx512(const std::uint16_t* src, float* dst, std::size_t n) noexcept;
+float l2_squared_sq8_avx512(const float* a, const float* scale, const std::uint8_t* codes,
+                            std::size_t dim) noexcept;
+float inner_product_sq8_avx512(const float* a, const std::uint8_t* codes, std::size_t dim) noexcept;
+float l2_squared_fp16_avx512(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept;
+float inner_product_fp16_avx512(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept;
+float pq_adc_avx512(const float* table, const std::uint8_t* codes, std::size_t m) noexcept;
+// Needs AVX512_VPOPCNTDQ on top of AVX-512F; the avx512 family falls back
+// to hamming_avx2 on CPUs without it.
+std::uint32_t hamming_avx512(const std::uint8_t* a, const std::uint8_t* b, std::size_t bytes) noexcept;
+#endif
+#if defined(VECTORCORE_HAVE_NEON)
+float l2_squared_neon(const float* a, const float* b, std::size_t dim) noexcept;
+float inner_product_neon(const float* a, const float* b, std::size_t dim) noexcept;
+float l2_squared_sq8_neon(const float* a, const float* scale, const std::uint8_t* codes,
+                          std::size_t dim) noexcept;
+float inner_product_sq8_neon(const float* a, const std::uint8_t* codes, std::size_t dim) noexcept;
+float l2_squared_fp16_neon(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept;
+float inner_product_fp16_neon(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept;
+float pq_adc_neon(const float* table, const std::uint8_t* codes, std::size_t m) noexcept;
+#endif
+
+// One kernel family ("scalar", "avx2", "avx512", "neon").
+struct DistanceKernels {
+  const char* name = "scalar";
+  DistanceFn l2_squared = &l2_squared_scalar;
+  DistanceFn inner_product = &inner_product_scalar;
+  Sq8L2Fn l2_squared_sq8 = &l2_squared_sq8_scalar;
+  Sq8IpFn inner_product_sq8 = &inner_product_sq8_scalar;
+  Fp16Fn l2_squared_fp16 = &l2_squared_fp16_scalar;
+  Fp16Fn inner_product_fp16 = &inner_product_fp16_scalar;
+  PqAdcFn pq_adc = &pq_adc_scalar;
+  FixedDimFn l2_squared_fixed = nullptr;
+  FixedDimFn inner_product_fixed = nullptr;
+  WidenFn fp16_to_fp32 = &fp16_to_fp32_scalar;
+  WidenFn bf16_to_fp32 = &bf16_to_fp32_scalar;
+  HammingFn hamming = &hamming_scalar;
+
+  // fp32 kernels for one dimension, resolved once (e.g. by an index at
+  // construction): the specialization for `dim` if there is one, otherwise
+  // the generic kernel.
+  DistanceFn l2_squared_for(std::size_t dim) const noexcept {
+    const DistanceFn fixed = l2_squared_fixed ? l2_squared_fixed(dim) : nullptr;
+    return fixed ? fixed : l2_squared;
+  }
+  DistanceFn inner_product_for(std::size_t dim) const noexcept {
+    const DistanceFn fixed = inner_product_fixed ? inner_product_fixed(dim) : nullptr;
+    return fixed ? fixed : inner_product;
+  }
+  DistanceFn fp32_for(Metric metric, std::size_t dim) const noexcept {
+    return (kernel_metric(metric) == Metric::L2_SQUARED) ? l2_squared_for(dim) : inner_product_for(dim);
+  }
+};
+
+// The family chosen for this process. Resolved once, on first use, from
+// cpuid/xgetbv on x86 (CPU and OS support for the register state) and from
+// the target architecture on ARM; afterwards this is a plain load.
+const DistanceKernels& distance_kernels() noexcept;
+
+// Name of the active family, e.g. "avx512".
+inline const char* active_kernel() noexcept { return distance_kernels().name; }
+
+// Every family compiled into this build that the running CPU can execute,
+// from "scalar" up to the active one. Useful for tests and benchmarks.
+std::vector<DistanceKernels> supported_distance_kernels();
+
+// Runtime-dispatched entry points.
+inline float l2_squared(const float* a, const float* b, std::size_t dim) noexcept {
+  return distance_kernels().l2_squared(a, b, dim);
+}
+inline float inner_product(const float* a, const float* b, std::size_t dim) noexcept {
+  return distance_kernels().inner_product(a, b, dim);
+}
+
+// 16-bit input formats accepted next to fp32 by add_half() and the Python
+// bindings. Values are raw bit patterns: IEEE binary16, or bfloat16 (the
+// top half of a binary32, as emitted by PyTorch / JAX bf16 models).
+enum class HalfFormat : std::uint8_t {
+  FP16 = 0,
+  BF16 = 1,
+};
+
+inline void widen_to_float(HalfFormat format, const std::uint16_t* src, float* dst, std::size_t n) noexcept {
+  const DistanceKernels& k = distance_kernels();
+  (format == HalfFormat::BF16 ? k.bf16_to_fp32 : k.fp16_to_fp32)(src, dst, n);
+}
 
-// Chooses the best available kernel at compile-time.
-float l2_squared(const float* a, const float* b, std::size_t dim) noexcept;
-float inner_product(const float* a, const float* b, std::size_t dim) noexcept;
+// Appends n widened values to `out` (anything with append(first, last),
+// e.g. FlatArray<float>) through an L1-sized stack buffer, so the
+// destination is written once and no fp32 copy of the input is built.
+template <typename Out>
+void append_widened(Out& out, HalfFormat format, const std::uint16_t* src, std::size_t n) {
+  constexpr std::size_t kChunk = 1024;
+  float buf[kChunk];
+  for (std::size_t i = 0; i < n; i += kChunk) {
+    const std::size_t count = std::min(kChunk, n - i);
+    widen_to_float(format, src + i, buf, count);
+    out.append(buf, buf + count);
+  }
+}
 
 } // namespace vectorcore
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "vectorcore/aligned_allocator.h"
+
+namespace vectorcore {
+
+// FlatArray
+// ---------
+// Contiguous index storage that either owns its elements (a 32-byte aligned
+// std::vector) or views memory owned by someone else, e.g. a memory-mapped
+// index file.
+//
+// - Reads (data(), size(), operator[]) are identical in both modes, so the
+//   scan and graph-walk code never branches on where the bytes live.
+// - A view is read-only. Every mutating call first copies the view into
+//   owned storage ("copy on write"), so adding to a loaded index works and
+//   never writes through to the file.
+// - The view keeps its backing alive through a shared_ptr, so it can outlive
+//   the loader that created it.
+// - Owned storage follows a MemoryPolicy (huge pages, NUMA node), kept for
+//   the array's lifetime, including across attach() and copy on write.
+
+template <typename T>
+class FlatArray {
+public:
+  FlatArray() = default;
+  explicit FlatArray(const MemoryPolicy& policy) : owned_(Allocator(policy)) {}
+
+  const T* data() const noexcept { return view_ ? view_ : owned_.data(); }
+  T* data() {
+    own();
+    return owned_.data();
+  }
+  std::size_t size() const noexcept { return view_ ? view_size_ : owned_.size(); }
+  bool empty() const noexcept { return size() == 0; }
+
+  // Elements that fit before the next reallocation; a view is full.
+  std::size_t capacity() const noexcept { return view_ ? view_size_ : owned_.capacity(); }
+  bool is_view() const noexcept { return view_ != nullptr; }
+
+  MemoryPolicy memory_policy() const noexcept { return owned_.get_allocator().policy(); }
+
+  // Moves owned elements into storage under `policy`; a view stays a view
+  // and copies under `policy` when written.
+  void set_memory_policy(const MemoryPolicy& policy) {
+    if (policy != memory_policy()) {
+      owned_ = Owned(owned_.begin(), owned_.end(), Allocator(policy));
+    }
+  }
+
+  const T& operator[](std::size_t i) const noexcept { return data()[i]; }
+
+  // Points at n elements owned by `backing`; drops any owned storage.
+  void attach(const T* data, std::size_t n, std::shared_ptr<const void> backing) {
+    owned_ = Owned(owned_.get_allocator());
+    view_ = (n > 0) ? data : nullptr;
+    view_size_ = n;
+    backing_ = (n > 0) ? std::move(backing) : nullptr;
+  }
+
+  void reserve(std::size_t n) {
+    own();
+    owned_.reserve(n);
+  }
+  void resize(std::size_t n) {
+    own();
+    owned_.resize(n);
+  }
+  void resize(std::size_t n, const T& value) {
+    own();
+    owned_.resize(n, value);
+  }
+  void push_back(const T& value) {
+    own();
+    owned_.push_back(value);
+  }
+  void append(const T* first, const T* last) {
+    own();
+    owned_.insert(owned_.end(), first, last);
+  }
+  void clear() {
+    attach(nullptr, 0, nullptr);
+  }
+
+  // Copies a view into owned storage; a no-op when already owned. Needed
+  // before writing through a pointer taken from the const data().
+  void own() {
+    if (view_) {
+      Owned copy(view_, view_ + view_size_, owned_.get_allocator());
+      view_ = nullptr;
+      view_size_ = 0;
+      backing_.reset();
+      owned_.swap(copy);
+    }
+  }
+
+private:
+  using Allocator = AlignedAllocator<T, 32>;
+  using Owned = std::vector<T, Allocator>;
+
+  Owned owned_;
+  const T* view_ = nullptr;
+  std::size_t view_size_ = 0;
+  std::shared_ptr<const void> backing_;
+};
+
+} // namespace vectorcore
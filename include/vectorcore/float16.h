@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace vectorcore {
+
+// IEEE 754 binary16 <-> binary32 conversions in portable C++.
+//
+// These are the scalar reference for the F16C / AVX-512 / NEON conversions
+// used by the fp16 kernels, and the fallback when those are unavailable.
+// Rounding is round-to-nearest-even; NaN payloads are preserved as quiet NaN.
+
+inline float half_to_float(std::uint16_t h) noexcept {
+  const std::uint32_t sign = static_cast<std::uint32_t>(h & 0x8000u) << 16;
+  std::uint32_t exp = (h >> 10) & 0x1Fu;
+  std::uint32_t mant = h & 0x3FFu;
+
+  std::uint32_t bits;
+  if (exp == 0x1Fu) {
+    bits = sign | 0x7F800000u | (mant << 13); // inf / nan
+  } else if (exp != 0) {
+    bits = sign | ((exp + (127 - 15)) << 23) | (mant << 13); // normal
+  } else if (mant == 0) {
+    bits = sign; // +-0
+  } else {
+    // Subnormal half: normalize into a float.
+    exp = 127 - 15 + 1;
+    while ((mant & 0x400u) == 0) {
+      mant <<= 1;
+      --exp;
+    }
+    mant &= 0x3FFu;
+    bits = sign | (exp << 23) | (mant << 13);
+  }
+
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+inline std::uint16_t float_to_half(float f) noexcept {
+  std::uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+
+  const std::uint16_t sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+  const std::uint32_t abs = bits & 0x7FFFFFFFu;
+
+  if (abs >= 0x7F800000u) {
+    // inf stays inf; any nan becomes a quiet nan.
+    return static_cast<std::uint16_t>(sign | 0x7C00u | ((abs > 0x7F800000u) ? 0x200u : 0u));
+  }
+  if (abs >= 0x477FF000u) {
+    return static_cast<std::uint16_t>(sign | 0x7C00u); // rounds past 65504 -> inf
+  }
+  if (abs < 0x38800000u) {
+    // Result is subnormal (or zero) in half precision.
+    if (abs < 0x33000000u) {
+      return sign; // below half the smallest subnormal
+    }
+    const std::uint32_t exp = abs >> 23;
+    const std::uint32_t mant = (abs & 0x7FFFFFu) | 0x800000u;
+    const std::uint32_t shift = 126 - exp; // 14..24
+    std::uint32_t half_mant = mant >> shift;
+    const std::uint32_t rem = mant & ((1u << shift) - 1u);
+    const std::uint32_t halfway = 1u << (shift - 1);
+    if (rem > halfway || (rem == halfway && (half_mant & 1u))) {
+      ++half_mant;
+    }
+    return static_cast<std::uint16_t>(sign | half_mant);
+  }
+
+  // Normal: rebias exponent and round the 13 dropped mantissa bits.
+  std::uint32_t h = ((abs >> 13) - ((127 - 15) << 10));
+  const std::uint32_t rem = abs & 0x1FFFu;
+  if (rem > 0x1000u || (rem == 0x1000u && (h & 1u))) {
+    ++h; // may carry into the exponent, which is still correct
+  }
+  return static_cast<std::uint16_t>(sign | h);
+}
+
+// bfloat16 is the top half of a binary32: widening is exact, narrowing
+// rounds the dropped 16 mantissa bits to nearest even.
+inline float bfloat16_to_float(std::uint16_t b) noexcept {
+  const std::uint32_t bits = static_cast<std::uint32_t>(b) << 16;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+inline std::uint16_t float_to_bfloat16(float f) noexcept {
+  std::uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+    return static_cast<std::uint16_t>((bits >> 16) | 0x40u); // quiet nan
+  }
+  bits += 0x7FFFu + ((bits >> 16) & 1u);
+  return static_cast<std::uint16_t>(bits >> 16);
+}
+
+} // namespace vectorcore
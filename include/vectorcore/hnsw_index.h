@@ -1,50 +1,532 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "vectorcore/aligned_allocator.h"
 #include "vectorcore/distance.h"
+#include "vectorcore/flat_array.h"
+#include "vectorcore/prefetch.h"
+#include "vectorcore/product_quantizer.h"
+#include "vectorcore/published_size.h"
+#include "vectorcore/range_search.h"
+#include "vectorcore/scalar_quantizer.h"
+#include "vectorcore/search_filter.h"
+#include "vectorcore/search_stats.h"
+#include "vectorcore/tombstones.h"
+#include "vectorcore/visited_pool.h"
 
 namespace vectorcore {
 
-// HnswIndex (partial)
-// -------------------
-// This is intentionally a *partial* implementation:
-// - Single-layer graph (level 0 only)
-// - Simple neighbor selection (connect-to-nearest so far)
+class ThreadPool;
+
+// Node orders for HnswIndex::reorder().
+// - BFS: breadth-first over level-0 links from the entry point, so a node's
+//   neighbors are stored right after each other and close to it.
+// - RCM: reverse Cuthill-McKee. Breadth-first from the lowest-degree nodes,
+//   visiting neighbors by increasing degree, then reversed; it narrows the
+//   span of node numbers each link crosses.
+enum class ReorderMethod { BFS, RCM };
+
+// HnswIndex
+// ---------
+// Hierarchical Navigable Small World graph (Malkov & Yashunin).
+//
+// - Every node lives on level 0; a node assigned level L also appears on
+//   levels 1..L. Levels are drawn from an exponential distribution with
+//   mean 1/ln(M), so each level holds roughly 1/M of the nodes below it.
+// - Insert: greedy descent (ef = 1) through the levels above the node's own
+//   level, then an efConstruction beam search on each remaining level. The
+//   beam is reduced to M links with the neighbor-selection heuristic, and
+//   back-edges are re-pruned with the same heuristic once a node is full.
+// - Search: greedy descent to level 0, then an ef_search beam on level 0.
+// - Parallel build: add(..., num_threads) inserts a batch concurrently.
+//   Storage for the whole batch is reserved up front so workers never
+//   reallocate; link blocks are guarded by striped locks and the
+//   (entry point, max level) pair is one atomic word.
+//
+// Embeddings stay in one flat array; the adjacency is graph metadata.
+// Metric::COSINE stores unit rows and builds and walks the graph as IP.
+//
+// Compressed storage (FP16 / INT8) walks the graph on codes: construction
+// and search both score against the quantized rows. With rerank_factor > 0
+// the fp32 rows are kept too, the beam is widened to k * rerank_factor, and
+// those candidates are re-scored exactly before the top k are returned.
+// PQ storage (pq_m sub-spaces) works the same way; queries and inserts score
+// through an ADC table, neighbor pruning scores rows directly against the
+// codebooks. BINARY storage is flat-only and rejected here: +-1 Hamming
+// scores tie too often to steer neighbor selection.
+//
+// remove() tombstones nodes. A removed node keeps its own links, so walks
+// still route through it, but it never enters a result or gains new links.
+// Live nodes that linked to it are relinked right away with the neighbor
+// heuristic over their remaining links plus the removed node's links.
+// compact() drops the removed nodes and renumbers the adjacency.
+//
+// Searches walk only the nodes published when the last add() returned,
+// from the entry point published with them (see published_size.h). With an
+// ingest capacity set, one add() can run while other threads search.
+//
+// save() / load() persist the header, rows, codes and flat link arrays in
+// the index file format of index_io.h. A memory-mapped index walks the
+// file's pages in place, so loading costs no rebuild and no parse step.
+//
+// `memory` places the fp32 rows, codes and level-0 links (everything a hop
+// touches) on huge pages and / or one NUMA node (see memory_policy.h).
+//
+// Node numbers follow insertion order, which scatters a node's neighbors
+// over the whole row array. reorder() renumbers the graph so neighbors are
+// stored near each other; a hop then tends to land on rows already in cache
+// or on an already-touched page.
 //
-// Why it still matters for interviews:
-// - You can explain the data structures: flat embeddings + adjacency lists
-// - You can discuss how real HNSW extends this with multi-level routing,
-//   efConstruction/efSearch, heuristic neighbor pruning, and bidirectional edges.
+// The index owns mutexes and atomics, so it is neither copyable nor movable;
+// hold it by pointer when it needs to move.
 
 class HnswIndex {
 public:
-  HnswIndex(std::size_t dim, std::size_t M = 16, Metric metric = Metric::L2_SQUARED);
+  HnswIndex(std::size_t dim, std::size_t M = 16, Metric metric = Metric::L2_SQUARED,
+            std::size_t ef_construction = 200, std::uint64_t seed = 100,
+            Storage storage = Storage::FP32, std::size_t rerank_factor = 0, std::size_t pq_m = 0,
+            const MemoryPolicy& memory = {});
+
+  HnswIndex(const HnswIndex&) = delete;
+  HnswIndex& operator=(const HnswIndex&) = delete;
 
   std::size_t dim() const noexcept { return dim_; }
-  std::size_t size() const noexcept { return size_; }
 
-  void add(const float* vectors, std::size_t n, const std::uint64_t* ids = nullptr);
-  void search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores) const;
+  // Live nodes: everything added minus everything removed.
+  std::size_t size() const noexcept { return published_.load() - deleted_.count(); }
+
+  // Removed nodes still holding a slot until compact().
+  std::size_t num_deleted() const noexcept { return deleted_.count(); }
+  Metric metric() const noexcept { return metric_; }
+  std::size_t M() const noexcept { return M_; }
+  std::size_t ef_construction() const noexcept { return ef_construction_; }
+  Storage storage() const noexcept { return storage_; }
+  std::size_t rerank_factor() const noexcept { return rerank_factor_; }
+  MemoryPolicy memory_policy() const noexcept { return embeddings_.memory_policy(); }
+
+  // Beam width used by search(). The effective beam is max(ef_search, k).
+  std::size_t ef_search() const noexcept { return ef_search_; }
+  void set_ef_search(std::size_t ef) noexcept { ef_search_ = ef; }
+
+  // Neighbors ahead of the one being scored whose rows and visited marks
+  // the walks prefetch (hnswlib uses 1). Expanding a node also prefetches
+  // the link block of the next candidate. 0 turns prefetching off; tune it
+  // with the bench `prefetch` suite.
+  static constexpr std::size_t kDefaultPrefetchDistance = 4;
+  std::size_t prefetch_distance() const noexcept { return prefetch_distance_; }
+  void set_prefetch_distance(std::size_t d) noexcept { prefetch_distance_ = d; }
+
+  // Pool that num_threads != 1 calls run on; nullptr (the default) is
+  // ThreadPool::global(). ShardedIndex hands each shard the pool pinned to
+  // its NUMA node. The pool must outlive the index's use of it.
+  void set_thread_pool(ThreadPool* pool) noexcept { pool_ = pool; }
+
+  int max_level() const noexcept { return unpack_level(entry_.load(std::memory_order_acquire)); }
+
+  // Adds n vectors from a row-major [n, dim] matrix.
+  //
+  // num_threads != 1 inserts the batch concurrently on the global ThreadPool
+  // (0 = all threads). Levels are drawn up front from the seeded RNG, but the
+  // resulting graph depends on thread timing. Not safe to call concurrently
+  // with another add(), nor with search() unless an ingest capacity is set.
+  //
+  // INT8 storage learns its per-dimension ranges, PQ its codebooks, from the
+  // first batch (PQ needs >= 256 rows in it).
+  //
+  // Without ids, each row gets the number of rows appended before it
+  // (removed and compacted ones included) as its id.
+  // Ids are expected to be unique; use upsert() to replace a row.
+  void add(const float* vectors, std::size_t n, const std::uint64_t* ids = nullptr,
+           std::size_t num_threads = 1);
+
+  // add() of 16-bit rows (fp16 or bf16 bit patterns, see HalfFormat). The
+  // rows are widened to fp32 straight into the index's storage, so callers
+  // holding half-precision embeddings need no fp32 copy of their own.
+  void add_half(const std::uint16_t* vectors, std::size_t n, HalfFormat format,
+                const std::uint64_t* ids = nullptr, std::size_t num_threads = 1);
+
+  // View mode: builds the graph over n rows of caller memory without
+  // copying them. `owner` is held for as long as the rows are viewed (e.g.
+  // the NumPy array or mmap behind `vectors`); the rows must stay unchanged.
+  // The index then stores only links, ids and levels (plus codes with
+  // compressed storage and rerank).
+  //
+  // Needs an empty index with fp32 rows (FP32 storage, or rerank_factor > 0)
+  // and a metric other than COSINE, whose rows would have to be normalized.
+  // num_threads is as for add(). A later add(), upsert() or compact() copies
+  // the rows into owned storage first, as after a memory-mapped load().
+  void attach(const float* vectors, std::size_t n, std::shared_ptr<const void> owner,
+              const std::uint64_t* ids = nullptr, std::size_t num_threads = 1);
+
+  // Whether the fp32 rows are read in place from memory the index does not
+  // own (attach(), or a memory-mapped load()).
+  bool is_view() const noexcept { return embeddings_.is_view(); }
+
+  // Removes the nodes with the given external ids, repairs the links around
+  // them, and returns how many were found. Unknown ids are ignored. The
+  // first call builds an id -> node hash map, which later add() calls keep
+  // up to date. Not safe to call concurrently with search() or add().
+  std::size_t remove(const std::uint64_t* ids, std::size_t n);
+
+  // remove() of the ids already present, then add() of the batch. A repeated
+  // id keeps its last row.
+  void upsert(const float* vectors, std::size_t n, const std::uint64_t* ids, std::size_t num_threads = 1);
+
+  // Drops removed nodes from the flat arrays and renumbers the links of the
+  // rest. Not safe to call concurrently with search() or add().
+  void compact();
+
+  // Renumbers the nodes into `method`'s order for cache locality: rows,
+  // codes, ids, levels and link blocks are gathered into the new order and
+  // every link is rewritten. Search results are unchanged. Removed nodes are
+  // dropped first, as by compact(). Run it once the graph is built, before
+  // save(), so memory-mapped loads get the layout too. Needs scratch for a
+  // second copy of the arrays; not safe to call concurrently with search()
+  // or add().
+  void reorder(ReorderMethod method = ReorderMethod::BFS);
+
+  // remove() calls compact() once removed nodes exceed this fraction of the
+  // stored nodes. 0 (the default) leaves compaction to the caller.
+  double compact_threshold() const noexcept { return compact_threshold_; }
+  void set_compact_threshold(double ratio) noexcept { compact_threshold_ = ratio; }
+
+  // Concurrent ingest: reserves rows, codes and links for `capacity` nodes,
+  // which then never move, so one add() / add_half() at a time may run
+  // while any number of threads search. Inserts and searches then copy link
+  // blocks under the striped locks, and searches skip nodes past the
+  // published count, so a walk never follows a link into the batch being
+  // inserted. An add() past the capacity (or past the upper-level links
+  // reserved with it, about twice the expected count) throws
+  // std::length_error before changing anything; raise the capacity (with no
+  // searches running) first. 0, the default, turns the mode off. remove(),
+  // upsert(), compact() and attach() still need the index to themselves, as
+  // does the add() that follows removing every node.
+  void set_ingest_capacity(std::size_t capacity);
+  std::size_t ingest_capacity() const noexcept { return ingest_capacity_; }
+
+  // With a filter the walk still goes through rejected nodes, but only
+  // allowed ones enter the beam's results. When the filter allows so few
+  // nodes that the beam would rarely meet them (see kFilterScanSelectivity),
+  // the allowed nodes are scanned exhaustively instead.
+  void search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores,
+              const SearchFilter* filter = nullptr) const;
+
+  // kNN search for m queries from a row-major [m, dim] matrix into row-major
+  // [m, k] outputs. num_threads != 1 spreads queries over the global
+  // ThreadPool (0 = all threads); search() is safe to run concurrently.
+  void search_batch(const float* queries, std::size_t m, std::size_t k, std::uint64_t* out_ids,
+                    float* out_scores, std::size_t num_threads = 1, const SearchFilter* filter = nullptr) const;
+
+  // Range search: the nodes within `radius` of each of m queries, best
+  // first, in CSR form (see RangeSearchResult). The ef_search beam finds the
+  // nodes nearest the query; from those inside the radius a flood fill over
+  // level-0 links collects the rest of the ball, expanding only nodes inside
+  // it. Approximate: parts of the ball only reachable through nodes outside
+  // it are missed. Filtered and removed nodes are walked but not returned.
+  // With rerank, hits found on codes are re-scored exactly and checked again.
+  void range_search(const float* queries, std::size_t m, float radius, RangeSearchResult& out,
+                    std::size_t num_threads = 1, const SearchFilter* filter = nullptr) const;
+
+  // Filters allowing less than this fraction of the nodes (or fewer nodes
+  // than the beam width) are served by a scan of the allowed nodes.
+  static constexpr double kFilterScanSelectivity = 0.02;
+
+  // Search statistics (see search_stats.h), off by default. When on, every
+  // search() and search_batch() query records its distance evaluations,
+  // nodes visited, hops (nodes expanded), beam heap operations and latency
+  // into stats(). Graph walks during add() are not recorded.
+  bool stats_enabled() const noexcept { return stats_enabled_; }
+  void set_stats_enabled(bool on) noexcept { stats_enabled_ = on; }
+  const SearchStats& stats() const noexcept { return *stats_; }
+  void reset_stats() noexcept { stats_->reset(); }
+
+  // Writes the index to `path` (see index_io.h). Not safe to call
+  // concurrently with add().
+  void save(const std::string& path) const;
+
+  // Reads an index written by save(). With mmap rows and links are read
+  // from the page cache in place; otherwise the file is read into memory
+  // once. A later add() copies the arrays into owned storage first.
+  static std::unique_ptr<HnswIndex> load(const std::string& path, bool mmap = true);
 
 private:
+  using Candidate = std::pair<float, std::uint32_t>; // (badness, internal index)
+
   std::size_t dim_ = 0;
-  std::size_t size_ = 0;
+  std::size_t size_ = 0;    // nodes stored, written by add()
+  PublishedSize published_; // nodes searches see: size_ once add() returns
+  std::size_t ingest_capacity_ = 0;
   std::size_t M_ = 16;
+  std::size_t M0_ = 32; // level-0 degree bound (2 * M, as in the paper)
+  std::size_t ef_construction_ = 200;
+  std::size_t ef_search_ = 64;
+  std::size_t prefetch_distance_ = kDefaultPrefetchDistance;
+  std::size_t rerank_factor_ = 0;
+  double level_mult_ = 0.0;
   Metric metric_ = Metric::L2_SQUARED;
+  DistanceFn distance_ = nullptr; // fp32 kernel for metric_ and dim_, resolved once
+  Storage storage_ = Storage::FP32;
+  std::uint64_t next_id_ = 0; // first id handed out by add() without ids
+  double compact_threshold_ = 0.0;
+
+  std::mt19937_64 rng_;
+
+  // fp32 rows; empty when rows are compressed and no rerank is requested.
+  FlatArray<float> embeddings_;
+  FlatArray<std::uint64_t> ids_;
+
+  // Compressed rows, [size_ * code_size()] (FP16 / INT8 / PQ).
+  ScalarQuantizer quantizer_; // FP16 / INT8
+  ProductQuantizer pq_;       // PQ
+  FlatArray<std::uint8_t> codes_;
+
+  // Graph adjacency in flat fixed-stride blocks. A link block is
+  //   [count, n_0, n_1, ..., n_{cap-1}]
+  // so the neighbor count sits on the same cache line as the first links.
+  //
+  // - Level 0: one block of (M0_ + 1) uint32 per node in links0_, addressed
+  //   as links0_[idx * (M0_ + 1)]. Node i's links follow node i-1's.
+  // - Levels >= 1: only ~1/M of nodes have them, so they live in a compact
+  //   side table. A node with level L owns L consecutive blocks of (M_ + 1)
+  //   uint32 in links_upper_, starting at block upper_block_[idx].
+  FlatArray<std::uint32_t> links0_;
+  FlatArray<std::uint32_t> links_upper_;
+  FlatArray<std::uint32_t> upper_block_;
+  FlatArray<std::uint8_t> levels_;
+
+  // Removed nodes, and the external id -> node map behind remove() /
+  // upsert() (built on first use; live nodes only).
+  Tombstones deleted_;
+  std::unordered_map<std::uint64_t, std::uint32_t> id_map_;
+  bool id_map_ready_ = false;
+
+  // Entry point and max level packed as ((max_level + 1) << 32) | entry, so
+  // readers always see a consistent pair. 0 means the graph is empty.
+  // Writers (a node raising the max level) hold entry_mu_ for the whole
+  // insertion of that node, as in hnswlib.
+  std::atomic<std::uint64_t> entry_{0};
+  std::mutex entry_mu_;
+
+  // entry_ as of the last publish(); what searches start from.
+  std::atomic<std::uint64_t> published_entry_{0};
+
+  // What one search walks: the published entry word and node count. The
+  // entry is loaded first and published last, so it is always below rows.
+  struct Snapshot {
+    std::uint64_t entry = 0;
+    std::size_t rows = 0;
+  };
+  Snapshot snapshot() const noexcept {
+    Snapshot s;
+    s.entry = published_entry_.load(std::memory_order_acquire);
+    s.rows = published_.load();
+    return s;
+  }
+
+  // Shows nodes [0, size_) and the current entry point to searches.
+  void publish() noexcept {
+    published_.publish(size_);
+    published_entry_.store(entry_.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  // Reserves every node array for ingest_capacity_ nodes.
+  void reserve_ingest();
+
+  // Upper-level link blocks reserved with an ingest capacity.
+  std::size_t ingest_upper_blocks() const noexcept;
+
+  static std::uint64_t pack_entry(std::uint32_t ep, int level) noexcept {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(level + 1)) << 32) | ep;
+  }
+  static std::uint32_t unpack_entry(std::uint64_t packed) noexcept {
+    return static_cast<std::uint32_t>(packed & 0xFFFFFFFFu);
+  }
+  static int unpack_level(std::uint64_t packed) noexcept { return static_cast<int>(packed >> 32) - 1; }
+
+  // Striped locks over link blocks for concurrent inserts. A node's level-0
+  // and upper blocks share one stripe. At most one stripe is held at a time.
+  static constexpr std::size_t kLinkLockStripes = 1u << 16;
+  std::unique_ptr<std::mutex[]> link_locks_;
+
+  std::unique_lock<std::mutex> lock_links(std::uint32_t idx, bool concurrent) const {
+    if (!concurrent) {
+      return {};
+    }
+    return std::unique_lock<std::mutex>(link_locks_[idx & (kLinkLockStripes - 1)]);
+  }
+
+  // Reused visited tables and beam heaps, one per concurrent walk.
+  std::unique_ptr<VisitedPool> visited_pool_;
+
+  bool stats_enabled_ = false;
+  std::unique_ptr<SearchStats> stats_;
+
+  ThreadPool* pool_ = nullptr;
+  ThreadPool& thread_pool() const noexcept;
+
+  bool quantized() const noexcept { return storage_ != Storage::FP32; }
+  std::size_t code_size() const noexcept {
+    return (storage_ == Storage::PQ) ? pq_.code_size() : quantizer_.code_size();
+  }
+  bool has_fp32() const noexcept { return !quantized() || rerank_factor_ > 0; }
+
+  float score(const float* a, const float* b) const noexcept { return distance_(a, b, dim_); }
+
+  // Badness of stored row `idx` for a prepared query (exact or quantized,
+  // depending on storage).
+  float badness(const PreparedQuery& query, std::uint32_t idx) const noexcept {
+    float s;
+    if (storage_ == Storage::PQ) {
+      s = pq_.score(query, code_at(idx));
+    } else if (quantized()) {
+      s = quantizer_.score(query, code_at(idx));
+    } else {
+      s = score(query.q, vector_at(idx));
+    }
+    return (metric_ == Metric::L2_SQUARED) ? s : -s;
+  }
+
+  // Prepares a query vector for search; PQ builds its ADC table.
+  void prepare_query(const float* q, PreparedQuery& out) const {
+    if (storage_ == Storage::PQ) {
+      pq_.prepare(q, out);
+    } else {
+      quantizer_.prepare(q, out);
+    }
+  }
+
+  // Prepares stored row `idx` as a query, for row-to-row distances. PQ
+  // scores these directly (no table): each is used for only a few rows.
+  void node_query(std::uint32_t idx, PreparedQuery& out) const {
+    if (storage_ == Storage::PQ) {
+      if (has_fp32()) {
+        out.q = vector_at(idx);
+        out.table.clear();
+      } else {
+        pq_.prepare_code(code_at(idx), out);
+      }
+    } else if (has_fp32()) {
+      quantizer_.prepare(vector_at(idx), out);
+    } else {
+      quantizer_.prepare_code(code_at(idx), out);
+    }
+  }
+
+  const float* vector_at(std::uint32_t idx) const noexcept {
+    return embeddings_.data() + (static_cast<std::size_t>(idx) * dim_);
+  }
+  const std::uint8_t* code_at(std::uint32_t idx) const noexcept {
+    return codes_.data() + (static_cast<std::size_t>(idx) * code_size());
+  }
+
+  // Lines of a row prefetched ahead of scoring it; more would exhaust the
+  // core's outstanding-miss slots across several neighbors.
+  static constexpr std::size_t kPrefetchRowLines = 4;
+
+  // Prefetches what badness(query, idx) will read first.
+  void prefetch_row(std::uint32_t idx) const noexcept {
+    if (quantized()) {
+      prefetch_range(code_at(idx), code_size(), kPrefetchRowLines);
+    } else {
+      prefetch_range(vector_at(idx), dim_ * sizeof(float), kPrefetchRowLines);
+    }
+  }
+
+  std::uint32_t* links_at(std::uint32_t idx, int level) noexcept {
+    return const_cast<std::uint32_t*>(static_cast<const HnswIndex*>(this)->links_at(idx, level));
+  }
+  const std::uint32_t* links_at(std::uint32_t idx, int level) const noexcept {
+    if (level == 0) {
+      return links0_.data() + (static_cast<std::size_t>(idx) * (M0_ + 1));
+    }
+    const std::size_t block = static_cast<std::size_t>(upper_block_[idx]) + static_cast<std::size_t>(level - 1);
+    return links_upper_.data() + (block * (M_ + 1));
+  }
+
+  int random_level();
+
+  // add() / attach() / add_half() body. With in_place, embeddings_ already
+  // views the n rows at `vectors`; with `halves`, those rows are read
+  // instead of `vectors` and widened from `format`.
+  void append(const float* vectors, std::size_t n, const std::uint64_t* ids, std::size_t num_threads,
+              bool in_place, const std::uint16_t* halves = nullptr, HalfFormat format = HalfFormat::FP16);
+  void insert(std::uint32_t idx, bool concurrent, SearchScratch& scratch);
+
+  // The walks below read link blocks in place when kConcurrent is false (the
+  // query path). With kConcurrent they copy each block under its stripe lock
+  // into scratch.links first, since other inserts may be rewriting it. They
+  // skip links to nodes at or past `limit` (size_ for inserts, the
+  // published count for searches).
+
+  // Greedy walk (ef = 1) from `ep` over levels from_level .. to_level + 1.
+  // Returns the closest node found, to be used as the entry on `to_level`.
+  template <bool kConcurrent>
+  std::uint32_t greedy_descend(const PreparedQuery& query, std::uint32_t ep, int from_level, int to_level,
+                               std::size_t limit, SearchScratch& scratch) const;
+
+  // Beam search on one level. Leaves up to `ef` live candidates in
+  // scratch.results, closest first; removed nodes are expanded but not kept.
+  template <bool kConcurrent>
+  void search_layer(const PreparedQuery& query, std::uint32_t ep, std::size_t ef, int level, std::size_t limit,
+                    SearchScratch& scratch, const SearchFilter* filter = nullptr) const;
+
+  // Whether searches walk with kConcurrent (an add() may be running).
+  bool concurrent_reads() const noexcept { return ingest_capacity_ > 0; }
+
+  // Removed, or rejected by `filter` (may be null).
+  bool hidden(std::uint32_t idx, const SearchFilter* filter) const {
+    return deleted_.test(idx) || (filter && !filter->allows(idx, ids_[idx]));
+  }
+
+  // Beam width search() uses for k.
+  std::size_t beam_width(std::size_t k) const noexcept {
+    const bool reranking = quantized() && rerank_factor_ > 0;
+    return std::max(ef_search_, reranking ? std::max(k, k * rerank_factor_) : k);
+  }
+
+  // Whether `filter` is selective enough to scan the first `rows` nodes
+  // instead of walking them.
+  bool scan_filtered(const SearchFilter* filter, std::size_t ef, std::size_t rows) const;
+
+  // search() body; `scan` is scan_filtered(), decided once per batch, as is
+  // the snapshot.
+  void search_one(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores,
+                  const SearchFilter* filter, bool scan, const Snapshot& snap) const;
+
+  // range_search() body for one query; appends its hits to `hits`.
+  void range_one(const float* query, float radius, const SearchFilter* filter, const Snapshot& snap,
+                 RangeSearchResult::Hits& hits) const;
+
+  // HNSW heuristic neighbor selection (Algorithm 4 in the paper).
+  // `candidates` must be sorted closest first; it is reduced in place to at
+  // most `max_links` entries. `node` is scratch for row-to-row distances.
+  void select_neighbors(std::vector<Candidate>& candidates, std::size_t max_links, PreparedQuery& node) const;
+
+  void connect(std::uint32_t idx, int level, std::vector<Candidate>& candidates, bool concurrent,
+               PreparedQuery& node);
 
-  std::vector<float, AlignedAllocator<float, 32>> embeddings_;
-  std::vector<std::uint64_t> ids_;
+  void build_id_map();
 
-  // Graph adjacency for level 0.
-  // This is not a vector-of-vectors for embeddings (which is forbidden);
-  // adjacency is metadata, and keeping it separate is standard for HNSW.
-  std::vector<std::vector<std::uint32_t>> neighbors_;
+  // Renumbers the graph: new node i is old node order[i], and nodes missing
+  // from `order` are dropped along with the links to them. Behind compact()
+  // and reorder().
+  void permute(const std::vector<std::uint32_t>& order);
 
-  float score(const float* a, const float* b) const noexcept;
+  // Replaces node u's links to removed nodes on `level`, choosing from its
+  // live links plus the live links of the removed ones. A no-op when u has
+  // no such links. `pool` and `node` are scratch.
+  void repair_links(std::uint32_t u, int level, std::vector<std::uint32_t>& pool, PreparedQuery& node);
 };
 
 } // namespace vectorcore
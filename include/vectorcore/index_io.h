@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vectorcore/flat_array.h"
+
+namespace vectorcore {
+
+// Index file format
+// -----------------
+// A versioned binary container that maps straight back onto an index's flat
+// arrays:
+//
+//   [0, 4096)      IndexFileHeader, then the SectionEntry table
+//   [4096, ...)    one section per array, each starting on a 4096-byte
+//                  boundary (so also on AlignedAllocator's 32 bytes)
+//
+// Sections hold the raw array bytes in native byte order (the header records
+// an endianness tag and loading a foreign file fails). Nothing is encoded,
+// so loading is "validate the header, point FlatArrays at the sections":
+// with mmap the index reads rows and links from the OS page cache, and
+// processes that map the same file share one physical copy.
+//
+// I/O and format errors throw std::runtime_error.
+
+constexpr std::uint32_t kIndexFormatVersion = 1;
+constexpr std::size_t kIndexSectionAlignment = 4096;
+
+enum class IndexKind : std::uint32_t {
+  BRUTE_FORCE = 1,
+  HNSW = 2,
+};
+
+// Section tags. Values are part of the format; only append.
+enum class Section : std::uint32_t {
+  EMBEDDINGS = 1,
+  IDS = 2,
+  NORMS = 3,
+  CODES = 4,
+  LINKS0 = 5,
+  LINKS_UPPER = 6,
+  UPPER_BLOCK = 7,
+  LEVELS = 8,
+  SQ_VMIN = 9,
+  SQ_SCALE = 10,
+  PQ_CODEBOOKS = 11,
+  TOMBSTONES = 12,
+};
+
+struct IndexFileHeader {
+  char magic[8];           // "VCINDEX\0"
+  std::uint32_t version;   // kIndexFormatVersion
+  std::uint32_t kind;      // IndexKind
+  std::uint32_t endian;    // 0x01020304 in the writer's byte order
+  std::uint32_t metric;    // Metric
+  std::uint32_t storage;   // Storage
+  std::uint32_t num_sections;
+  std::uint64_t dim;
+  std::uint64_t size;
+  std::uint64_t rerank_factor;
+  std::uint64_t params[8]; // kind-specific, see the index's save()
+};
+
+struct SectionEntry {
+  std::uint32_t tag;       // Section
+  std::uint32_t elem_size; // sizeof(element), checked on load
+  std::uint64_t offset;    // from the start of the file
+  std::uint64_t bytes;
+};
+
+// Collects sections and writes them out in one pass.
+class IndexWriter {
+public:
+  explicit IndexWriter(IndexKind kind);
+
+  IndexFileHeader& header() noexcept { return header_; }
+
+  // The array must stay alive until write().
+  template <typename T>
+  void add(Section tag, const T* data, std::size_t n) {
+    sections_.push_back({tag, static_cast<std::uint32_t>(sizeof(T)), data, n * sizeof(T)});
+  }
+
+  void write(const std::string& path);
+
+private:
+  struct Pending {
+    Section tag;
+    std::uint32_t elem_size;
+    const void* data;
+    std::size_t bytes;
+  };
+
+  IndexFileHeader header_{};
+  std::vector<Pending> sections_;
+};
+
+// Opens an index file, memory-mapped (mmap = true) or read into one aligned
+// heap buffer, and hands out zero-copy views of its sections.
+class IndexReader {
+public:
+  IndexReader(const std::string& path, IndexKind expected, bool mmap);
+
+  const IndexFileHeader& header() const noexcept { return header_; }
+
+  // Views section `tag` (empty if absent). `expected` is the element count
+  // the index needs there; a mismatch means a corrupt file.
+  template <typename T>
+  void view(Section tag, std::size_t expected, FlatArray<T>& out) const {
+    const SectionEntry* s = find(tag, sizeof(T), expected * sizeof(T));
+    out.attach(s ? reinterpret_cast<const T*>(base() + s->offset) : nullptr, expected, backing_);
+  }
+
+  // Copies a small section (quantizer parameters) out of the file.
+  template <typename T>
+  std::vector<T> copy(Section tag, std::size_t expected) const {
+    const SectionEntry* s = find(tag, sizeof(T), expected * sizeof(T));
+    const T* p = s ? reinterpret_cast<const T*>(base() + s->offset) : nullptr;
+    return p ? std::vector<T>(p, p + expected) : std::vector<T>();
+  }
+
+  // Element count of section `tag` (0 if absent), for arrays whose length
+  // is not implied by the header.
+  std::size_t count(Section tag, std::size_t elem_size) const;
+
+private:
+  class Mapping;
+
+  std::shared_ptr<const void> backing_; // keeps the Mapping alive
+  const Mapping* mapping_ = nullptr;
+  IndexFileHeader header_{};
+  std::vector<SectionEntry> sections_;
+
+  const std::uint8_t* base() const noexcept;
+  const SectionEntry* find(Section tag, std::size_t elem_size, std::size_t bytes) const;
+};
+
+} // namespace vectorcore
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace vectorcore {
+
+// Whether Index::add takes a num_threads argument (HnswIndex does), for
+// generic code that feeds rows to any index type.
+template <typename Index, typename = void>
+struct AddTakesThreads : std::false_type {};
+
+template <typename Index>
+struct AddTakesThreads<Index, std::void_t<decltype(std::declval<Index&>().add(
+                                  std::declval<const float*>(), std::size_t{},
+                                  std::declval<const std::uint64_t*>(), std::size_t{}))>> : std::true_type {};
+
+} // namespace vectorcore
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vectorcore/aligned_allocator.h"
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/distance.h"
+#include "vectorcore/product_quantizer.h"
+
+namespace vectorcore {
+
+// IvfIndex
+// --------
+// Inverted-file index: k-means splits the space into `nlist` cells, every
+// vector is stored in the list of its nearest centroid, and a query only
+// scans the `nprobe` lists whose centroids are closest to it.
+//
+// - Memory is predictable: the vectors themselves plus nlist centroids and
+//   one id per vector. No graph.
+// - Each list keeps its rows in one flat aligned array (same layout as
+//   BruteForceIndex::embeddings_), so a probe is a sequential scan.
+// - nprobe trades recall for speed: nprobe == nlist is exact search.
+// - Cells are assigned with the index metric (nearest for L2, largest inner
+//   product for IP), both in train() and at add()/search() time. The
+//   centroids live in a BruteForceIndex (the "coarse quantizer"), so cell
+//   assignment reuses its blocked, threaded search_batch.
+// - Metric::COSINE normalizes training rows, added rows and queries, and is
+//   IP everywhere inside (k-means, coarse quantizer, PQ).
+//
+// With pq_m > 0 lists hold PQ codes of the residual x - centroid instead of
+// fp32 rows (IVF-PQ). A probe builds one ADC table per list for L2 (from
+// q - centroid) or one table per query plus the q . centroid term for IP,
+// then scans the codes with pq_adc. rerank_factor > 0 keeps the fp32 rows
+// as well and re-scores the best k * rerank_factor candidates exactly.
+
+class IvfIndex {
+public:
+  IvfIndex(std::size_t dim, std::size_t nlist, Metric metric = Metric::L2_SQUARED, std::uint64_t seed = 100,
+           std::size_t pq_m = 0, std::size_t rerank_factor = 0);
+
+  std::size_t dim() const noexcept { return dim_; }
+  std::size_t size() const noexcept { return size_; }
+  Metric metric() const noexcept { return metric_; }
+  std::size_t nlist() const noexcept { return nlist_; }
+  bool trained() const noexcept { return trained_; }
+  std::size_t pq_m() const noexcept { return pq_m_; }
+  std::size_t rerank_factor() const noexcept { return rerank_factor_; }
+
+  // Lists scanned when search() is called with nprobe == 0.
+  std::size_t nprobe() const noexcept { return nprobe_; }
+  void set_nprobe(std::size_t nprobe) noexcept { nprobe_ = nprobe; }
+
+  // Learns the nlist centroids with Lloyd's k-means over n training rows.
+  //
+  // See kmeans() for sampling, threading (num_threads: 0 = all threads) and
+  // empty-cell handling. Must be called before add(); calling it again on
+  // an empty index re-trains. With PQ the codebooks are then trained on the
+  // residuals of up to kMaxPqTrainRows of the rows (n >= 256).
+  void train(const float* vectors, std::size_t n, std::size_t num_threads = 1, std::size_t niter = 20);
+
+  // Assigns each row to its nearest centroid and appends it to that list.
+  // Assignment runs on the global ThreadPool when num_threads != 1.
+  void add(const float* vectors, std::size_t n, const std::uint64_t* ids = nullptr, std::size_t num_threads = 1);
+
+  // kNN over the nprobe nearest lists (0 = nprobe()). Output arrays must
+  // have capacity >= k; missing results are padded like BruteForceIndex.
+  void search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores,
+              std::size_t nprobe = 0) const;
+
+  // Row-major [m, dim] queries into [m, k] outputs; queries are spread over
+  // the global ThreadPool when num_threads != 1.
+  void search_batch(const float* queries, std::size_t m, std::size_t k, std::uint64_t* out_ids,
+                    float* out_scores, std::size_t nprobe = 0, std::size_t num_threads = 1) const;
+
+  const float* centroid(std::size_t list) const noexcept { return centroids_.data() + (list * dim_); }
+  std::size_t list_size(std::size_t list) const noexcept { return lists_[list].ids.size(); }
+
+private:
+  struct InvertedList {
+    std::vector<float, AlignedAllocator<float, 32>> vectors; // [ids.size() * dim]; empty for PQ without rerank
+    std::vector<std::uint8_t, AlignedAllocator<std::uint8_t, 32>> codes; // [ids.size() * pq_m] (PQ only)
+    std::vector<std::uint64_t> ids;
+  };
+
+  static constexpr std::size_t kMaxPqTrainRows = 65536;
+
+  std::size_t dim_ = 0;
+  std::size_t nlist_ = 0;
+  std::size_t size_ = 0;
+  std::size_t nprobe_ = 1;
+  std::size_t pq_m_ = 0;
+  std::size_t rerank_factor_ = 0;
+  Metric metric_ = Metric::L2_SQUARED;
+  DistanceFn distance_ = nullptr; // fp32 kernel for metric_ and dim_, resolved once
+  std::uint64_t seed_ = 100;
+  bool trained_ = false;
+
+  // [nlist_ * dim_]
+  std::vector<float, AlignedAllocator<float, 32>> centroids_;
+  std::vector<InvertedList> lists_;
+
+  // Exact index over centroids_, used to find the nearest cells.
+  BruteForceIndex coarse_;
+
+  // Residual codec (pq_m_ > 0 only).
+  ProductQuantizer pq_;
+
+  bool has_fp32() const noexcept { return pq_m_ == 0 || rerank_factor_ > 0; }
+
+  float badness(const float* a, const float* b) const noexcept;
+};
+
+} // namespace vectorcore
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vectorcore/distance.h"
+
+namespace vectorcore {
+
+// Training sets larger than k * kKmeansMaxPointsPerCentroid are subsampled;
+// beyond a few hundred points per cell k-means gains little (as in FAISS).
+constexpr std::size_t kKmeansMaxPointsPerCentroid = 256;
+
+// Lloyd's k-means over n row-major [n, dim] rows, writing k centroids to
+// `centroids` ([k, dim]). Requires n >= k.
+//
+// - Seeded with k distinct rows drawn from `seed`.
+// - Assignment uses `metric` (nearest for L2, largest inner product for IP)
+//   through a BruteForceIndex over the centroids, i.e. the blocked,
+//   dispatched search_batch kernel.
+// - The update step runs one ThreadPool task per range of cells
+//   (num_threads: 0 = all threads) over rows bucketed by a counting sort,
+//   accumulating in double.
+// - Empty cells are re-seeded by splitting the largest cell in two.
+void kmeans(const float* x, std::size_t n, std::size_t dim, std::size_t k, float* centroids,
+            Metric metric = Metric::L2_SQUARED, std::size_t niter = 20, std::uint64_t seed = 100,
+            std::size_t num_threads = 1);
+
+} // namespace vectorcore
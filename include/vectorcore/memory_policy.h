@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vectorcore {
+
+// MemoryPolicy
+// ------------
+// Where the large index arrays (fp32 rows, codes, level-0 links) get their
+// pages from. The default is the plain aligned heap. On a 100 GB index most
+// of a random graph hop is spent on TLB misses, and on a dual-socket host
+// half the rows sit on the remote node, so a policy can ask for:
+//
+// - Huge pages. TRANSPARENT maps 2 MB-aligned anonymous memory and marks it
+//   MADV_HUGEPAGE, so khugepaged backs it with 2 MB pages when it can.
+//   HUGETLB_2MB / HUGETLB_1GB take pages from the hugetlbfs pool
+//   (MAP_HUGETLB; reserve them via /proc/sys/vm/nr_hugepages or the kernel
+//   command line). When the pool runs dry the allocation falls back to the
+//   TRANSPARENT path instead of failing.
+// - A NUMA node (numa_node >= 0). The pages are bound there with mbind()
+//   before first touch, e.g. to place each shard next to the cores that
+//   search it.
+//
+// HUGETLB_1GB arrays smaller than 1 GB use 2 MB pages instead, and
+// allocations smaller than 2 MB stay on normal pages. Both options are
+// Linux-only; elsewhere every policy behaves as the default.
+
+enum class HugePages : std::uint8_t {
+  NONE = 0,
+  TRANSPARENT = 1,
+  HUGETLB_2MB = 2,
+  HUGETLB_1GB = 3,
+};
+
+struct MemoryPolicy {
+  HugePages huge_pages = HugePages::NONE;
+  int numa_node = -1; // -1: no binding
+
+  bool is_default() const noexcept { return huge_pages == HugePages::NONE && numa_node < 0; }
+
+  friend bool operator==(const MemoryPolicy& a, const MemoryPolicy& b) noexcept {
+    return a.huge_pages == b.huge_pages && a.numa_node == b.numa_node;
+  }
+  friend bool operator!=(const MemoryPolicy& a, const MemoryPolicy& b) noexcept { return !(a == b); }
+};
+
+// Throws std::invalid_argument if `policy` names a NUMA node this host does
+// not have. Index constructors call it so a typo fails up front.
+void validate_memory_policy(const MemoryPolicy& policy);
+
+// NUMA nodes on this host (1 without NUMA support).
+std::size_t numa_node_count() noexcept;
+
+// CPUs of NUMA node `node`, ascending; empty if unknown (no NUMA support,
+// or not Linux).
+std::vector<int> numa_node_cpus(int node);
+
+// Page-granular allocation under a non-default policy; throws
+// std::bad_alloc. Memory is at least page aligned, and free_pages() must
+// get the same bytes and policy as the allocation.
+void* allocate_pages(std::size_t bytes, const MemoryPolicy& policy);
+void free_pages(void* p, std::size_t bytes, const MemoryPolicy& policy) noexcept;
+
+} // namespace vectorcore
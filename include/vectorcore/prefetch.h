@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <xmmintrin.h> // _mm_prefetch
+#endif
+
+namespace vectorcore {
+
+// Software prefetch
+// -----------------
+// Graph walks touch rows in an order the hardware prefetcher cannot guess,
+// so every distance would otherwise start with a DRAM miss. The walks issue
+// these hints a few neighbors ahead instead, overlapping the misses with
+// the distance math of the current neighbor. Prefetches never fault, so a
+// hint past the end of an array is harmless.
+
+constexpr std::size_t kCacheLine = 64;
+
+// Brings the line holding `p` into every cache level, for reading.
+inline void prefetch(const void* p) noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p, 0, 3);
+#else
+  (void)p;
+#endif
+}
+
+// prefetch() of the lines covering [p, p + bytes), at most `max_lines` of
+// them. On long rows the first few lines are enough: once they miss, the
+// hardware streamer follows the rest.
+inline void prefetch_range(const void* p, std::size_t bytes, std::size_t max_lines = SIZE_MAX) noexcept {
+  const auto first = reinterpret_cast<std::uintptr_t>(p) & ~static_cast<std::uintptr_t>(kCacheLine - 1);
+  const auto end = reinterpret_cast<std::uintptr_t>(p) + bytes;
+  const std::size_t lines = std::min<std::size_t>((end - first + kCacheLine - 1) / kCacheLine, max_lines);
+  for (std::size_t i = 0; i < lines; ++i) {
+    prefetch(reinterpret_cast<const void*>(first + (i * kCacheLine)));
+  }
+}
+
+} // namespace vectorcore
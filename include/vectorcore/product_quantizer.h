@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vectorcore/aligned_allocator.h"
+#include "vectorcore/distance.h"
+#include "vectorcore/scalar_quantizer.h"
+
+namespace vectorcore {
+
+// ProductQuantizer
+// ----------------
+// Splits a vector into m sub-vectors of dim / m floats and replaces each one
+// by the index of its nearest centroid in a per-sub-space codebook of 256
+// entries, so a row becomes m bytes (768-d at m = 32..64 -> 32..64 bytes
+// instead of 3 KiB).
+//
+// Scoring is asymmetric (ADC): the query stays fp32. prepare() builds one
+// [m, 256] table of query-to-centroid scores per query; after that a row
+// costs m table lookups, summed by the dispatched pq_adc kernel (AVX2 /
+// AVX-512 gathers). Row-to-row distances during graph construction skip the
+// table and score the fp32 side directly against the centroids.
+//
+// Scores keep the metric's meaning: L2 returns a squared distance, IP a
+// similarity. Codebooks are always trained with L2 k-means.
+
+class ProductQuantizer {
+public:
+  static constexpr std::size_t kCentroids = 256; // 8-bit codes
+
+  ProductQuantizer() = default;
+  ProductQuantizer(std::size_t dim, std::size_t m, Metric metric);
+
+  std::size_t dim() const noexcept { return dim_; }
+  std::size_t m() const noexcept { return m_; }
+  std::size_t dsub() const noexcept { return dsub_; }
+  std::size_t code_size() const noexcept { return m_; }
+  bool trained() const noexcept { return trained_; }
+
+  // Learns the m codebooks from n rows (n >= 256). Sub-spaces are trained one
+  // after another; each k-means runs on the global ThreadPool.
+  void train(const float* x, std::size_t n, std::size_t num_threads = 1, std::size_t niter = 25);
+
+  // Encodes n rows into n * code_size() bytes, rows spread over the global
+  // ThreadPool when num_threads != 1.
+  void encode(const float* x, std::size_t n, std::uint8_t* codes, std::size_t num_threads = 1) const;
+
+  void decode(const std::uint8_t* code, float* out) const;
+
+  // table[s * 256 + j] = score(q_s, centroid_sj).
+  void compute_table(const float* q, float* table) const;
+
+  // ADC query: q plus its lookup table.
+  void prepare(const float* q, PreparedQuery& out) const;
+
+  // Decodes `code` into out.decoded for direct (table-free) scoring.
+  void prepare_code(const std::uint8_t* code, PreparedQuery& out) const;
+
+  float score(const PreparedQuery& query, const std::uint8_t* code) const noexcept {
+    if (!query.table.empty()) {
+      return distance_kernels().pq_adc(query.table.data(), code, m_);
+    }
+    return score_direct(query.q, code);
+  }
+
+  // Table-free score of an fp32 vector against a code: m sub-space kernels.
+  float score_direct(const float* q, const std::uint8_t* code) const noexcept;
+
+  // All codebooks, [m, 256, dsub] (empty until trained), for persistence.
+  const float* codebooks() const noexcept { return codebooks_.data(); }
+  std::size_t codebooks_size() const noexcept { return codebooks_.size(); }
+
+  // Restores codebooks previously read from codebooks().
+  void restore(const float* codebooks, std::size_t n);
+
+  const float* centroid(std::size_t sub, std::size_t j) const noexcept {
+    return codebooks_.data() + (((sub * kCentroids) + j) * dsub_);
+  }
+
+private:
+  std::size_t dim_ = 0;
+  std::size_t m_ = 0;
+  std::size_t dsub_ = 0;
+  Metric metric_ = Metric::L2_SQUARED;
+  bool trained_ = false;
+
+  // [m_, 256, dsub_]
+  std::vector<float, AlignedAllocator<float, 32>> codebooks_;
+};
+
+} // namespace vectorcore
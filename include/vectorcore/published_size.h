@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace vectorcore {
+
+// PublishedSize
+// -------------
+// The row count an index shows its searches. A writer fills rows past it
+// and then publish()es the new count (a release store); a search load()s it
+// once (an acquire load) and reads only rows below it, so it sees every
+// byte of those rows without taking a lock. Together with storage that
+// does not move (see set_ingest_capacity() on the indexes) this lets one
+// add() run under concurrent searches.
+//
+// Copies carry the value over, so indexes holding one stay movable; a copy
+// is not meant to race with a writer.
+
+class PublishedSize {
+public:
+  PublishedSize() = default;
+  PublishedSize(const PublishedSize& other) noexcept : n_(other.load()) {}
+  PublishedSize& operator=(const PublishedSize& other) noexcept {
+    publish(other.load());
+    return *this;
+  }
+
+  std::size_t load() const noexcept { return n_.load(std::memory_order_acquire); }
+  void publish(std::size_t n) noexcept { n_.store(n, std::memory_order_release); }
+
+private:
+  std::atomic<std::size_t> n_{0};
+};
+
+} // namespace vectorcore
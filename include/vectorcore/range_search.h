@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "vectorcore/distance.h"
+
+namespace vectorcore {
+
+// RangeSearchResult
+// -----------------
+// Variable-length results of range_search() in CSR form, as scipy.sparse
+// and FAISS use them: the hits of query i are
+//   ids[offsets[i] .. offsets[i + 1])  with  scores[...] alongside,
+// best first. offsets has m + 1 entries and offsets[m] == ids.size().
+//
+// The radius is in score units: L2 keeps rows with squared distance
+// <= radius, IP / COSINE rows with similarity >= radius.
+
+struct RangeSearchResult {
+  std::vector<std::uint64_t> offsets;
+  std::vector<std::uint64_t> ids;
+  std::vector<float> scores;
+
+  // (badness, external id) hits of one query, in any order.
+  using Hits = std::vector<std::pair<float, std::uint64_t>>;
+
+  // Sorts each query's hits best first (ties by id) and lays them out as
+  // CSR, converting badness back to scores.
+  void assign(std::vector<Hits>& per_query, Metric metric) {
+    offsets.assign(per_query.size() + 1, 0);
+    for (std::size_t i = 0; i < per_query.size(); ++i) {
+      offsets[i + 1] = offsets[i] + per_query[i].size();
+    }
+    ids.resize(static_cast<std::size_t>(offsets.back()));
+    scores.resize(ids.size());
+
+    const bool l2 = (metric == Metric::L2_SQUARED);
+    for (std::size_t i = 0; i < per_query.size(); ++i) {
+      Hits& hits = per_query[i];
+      std::sort(hits.begin(), hits.end());
+      std::size_t pos = static_cast<std::size_t>(offsets[i]);
+      for (const auto& h : hits) {
+        ids[pos] = h.second;
+        scores[pos] = l2 ? h.first : -h.first;
+        ++pos;
+      }
+    }
+  }
+};
+
+} // namespace vectorcore
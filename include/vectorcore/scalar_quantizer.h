@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vectorcore/distance.h"
+
+namespace vectorcore {
+
+// How an index stores its rows.
+// - FP32: 4 bytes per dimension, exact.
+// - FP16: IEEE binary16, 2 bytes per dimension (~3 significant digits).
+// - INT8: 1 byte per dimension, per-dimension affine quantization learned
+//   from training data: x_d ~= vmin_d + scale_d * code_d.
+// - PQ: product quantization, 1 byte per sub-space (see product_quantizer.h).
+//   Not handled by ScalarQuantizer.
+// - BINARY: 1 bit per dimension (the sign, x_d > 0), rows padded to whole
+//   64-bit words. Scored by Hamming distance as a coarse filter; pair it with
+//   rerank to get fp32-quality results.
+enum class Storage : std::uint8_t {
+  FP32 = 0,
+  FP16 = 1,
+  INT8 = 2,
+  PQ = 3,
+  BINARY = 4,
+};
+
+// Query-side state for scoring against codes. Filled by a quantizer's
+// prepare() once per query, then reused for every row, so per-row scoring
+// never recomputes query-only terms.
+struct PreparedQuery {
+  const float* q = nullptr;   // the fp32 query
+  std::vector<float> a;       // INT8: q - vmin (L2) or q * scale (IP)
+  float bias = 0.0f;          // INT8 IP: q . vmin
+  std::vector<float> table;   // PQ: [m, 256] ADC lookup table (empty = score directly)
+  std::vector<float> decoded; // backing store when q was decoded from a code
+  std::vector<std::uint8_t> bits; // BINARY: the query's sign bits
+};
+
+// ScalarQuantizer
+// ---------------
+// Encodes fp32 rows into fixed-size codes and scores fp32 queries against
+// those codes without decoding them (asymmetric distance). Scores keep the
+// metric's meaning: L2 returns a squared distance, IP a similarity.
+//
+// Quantized scores are approximate. Indexes that keep the fp32 rows as well
+// can re-score the best candidates exactly ("rerank").
+
+class ScalarQuantizer {
+public:
+  ScalarQuantizer() = default;
+  ScalarQuantizer(Storage storage, std::size_t dim, Metric metric);
+
+  Storage storage() const noexcept { return storage_; }
+  std::size_t dim() const noexcept { return dim_; }
+
+  // Bytes per encoded row.
+  std::size_t code_size() const noexcept;
+
+  // FP32/FP16/BINARY need no training; INT8 needs per-dimension ranges.
+  bool trained() const noexcept { return trained_; }
+
+  // Learns per-dimension [min, max] from n rows (INT8 only; no-op otherwise).
+  // Values outside the trained range are clamped when encoded.
+  void train(const float* x, std::size_t n);
+
+  // Trained INT8 ranges ([dim] each; empty for FP16), for persistence.
+  const std::vector<float>& vmin() const noexcept { return vmin_; }
+  const std::vector<float>& scale() const noexcept { return scale_; }
+
+  // Restores ranges previously read from vmin() / scale() (INT8 only).
+  void restore(std::vector<float> vmin, std::vector<float> scale);
+
+  // Encodes n row-major rows into n * code_size() bytes.
+  void encode(const float* x, std::size_t n, std::uint8_t* codes) const;
+
+  // Reconstructs one row from its code.
+  void decode(const std::uint8_t* code, float* out) const;
+
+  void prepare(const float* q, PreparedQuery& out) const;
+
+  // Decodes `code` into out.decoded and prepares it as a query, for
+  // row-to-row distances (graph construction, neighbor pruning).
+  void prepare_code(const std::uint8_t* code, PreparedQuery& out) const;
+
+  float score(const PreparedQuery& query, const std::uint8_t* code) const noexcept {
+    const DistanceKernels& k = distance_kernels();
+    const bool l2 = (metric_ == Metric::L2_SQUARED);
+    switch (storage_) {
+      case Storage::FP16: {
+        const auto* h = reinterpret_cast<const std::uint16_t*>(code);
+        return l2 ? k.l2_squared_fp16(query.q, h, dim_) : k.inner_product_fp16(query.q, h, dim_);
+      }
+      case Storage::INT8:
+        return l2 ? k.l2_squared_sq8(query.a.data(), scale_.data(), code, dim_)
+                  : query.bias + k.inner_product_sq8(query.a.data(), code, dim_);
+      case Storage::BINARY: {
+        // Rows decode to +-1, so over dim_ dimensions with h differing signs
+        // L2 = 4h and IP = dim_ - 2h exactly.
+        const auto h = static_cast<float>(k.hamming(query.bits.data(), code, query.bits.size()));
+        return l2 ? 4.0f * h : static_cast<float>(dim_) - 2.0f * h;
+      }
+      case Storage::FP32:
+      default: {
+        const auto* x = reinterpret_cast<const float*>(code);
+        return l2 ? k.l2_squared(query.q, x, dim_) : k.inner_product(query.q, x, dim_);
+      }
+    }
+  }
+
+private:
+  Storage storage_ = Storage::FP32;
+  std::size_t dim_ = 0;
+  Metric metric_ = Metric::L2_SQUARED;
+  bool trained_ = true;
+
+  // INT8 only: [dim_] each.
+  std::vector<float> vmin_;
+  std::vector<float> scale_;
+};
+
+} // namespace vectorcore
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace vectorcore {
+
+// SearchFilter
+// ------------
+// Restricts a search to a subset of the index ("top-k where tenant == X"),
+// evaluated inside the scan instead of over-fetching and filtering later.
+//
+// - bitmap(words, num_bits): bit r of words[r / 64] allows internal row r.
+//   Internal rows are numbered in insertion order and renumbered by
+//   compact(). Rows at or past num_bits are filtered out.
+// - allow_list(ids, n): external ids, sorted ascending; membership is a
+//   binary search.
+// - predicate(fn): fn(external id) decides. It is called from every search
+//   thread at once, so it must be thread-safe.
+//
+// Bitmaps and allow-lists are borrowed, not copied: they must outlive every
+// search that uses the filter. Removed rows stay hidden whatever the filter
+// says.
+
+class SearchFilter {
+public:
+  enum class Kind : std::uint8_t {
+    BITMAP,
+    ALLOW_LIST,
+    PREDICATE,
+  };
+
+  static SearchFilter bitmap(const std::uint64_t* words, std::size_t num_bits);
+  static SearchFilter allow_list(const std::uint64_t* sorted_ids, std::size_t n);
+  static SearchFilter predicate(std::function<bool(std::uint64_t)> fn);
+
+  Kind kind() const noexcept { return kind_; }
+
+  // Whether internal row `row`, whose external id is `id`, may be returned.
+  bool allows(std::size_t row, std::uint64_t id) const {
+    switch (kind_) {
+      case Kind::BITMAP:
+        return row < size_ && ((words_[row >> 6] >> (row & 63)) & 1u) != 0;
+      case Kind::ALLOW_LIST:
+        return std::binary_search(words_, words_ + size_, id);
+      case Kind::PREDICATE:
+      default:
+        return fn_(id);
+    }
+  }
+
+  // Estimated fraction of `rows` stored rows (external ids `ids`) that pass.
+  // Exact for bitmaps, an upper bound for allow-lists, sampled for
+  // predicates. Indexes use it to pick a filtered strategy.
+  double selectivity(const std::uint64_t* ids, std::size_t rows) const;
+
+private:
+  SearchFilter() = default;
+
+  Kind kind_ = Kind::BITMAP;
+  const std::uint64_t* words_ = nullptr; // bitmap words or sorted ids
+  std::size_t size_ = 0;                 // bits or ids
+  std::function<bool(std::uint64_t)> fn_;
+};
+
+} // namespace vectorcore
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "vectorcore/search_filter.h"
+
+namespace vectorcore {
+
+// SearchService
+// -------------
+// Coalesces single-query searches from many threads into micro-batches for
+// an index's search_batch(), so a server answering thousands of concurrent
+// one-vector requests gets the blocked multi-query scan (and one ThreadPool
+// dispatch per batch) instead of one scan per request.
+//
+// - submit() copies the query into the pending queue and returns at once,
+//   with a std::future or by calling back later.
+// - A dispatcher thread holds a batch open until max_batch queries wait, or
+//   until the oldest has waited max_delay, then searches them all with one
+//   search_batch(). Requests arriving during a search queue for the next
+//   batch, so under load batches fill without waiting out the delay.
+// - A batch with mixed k is searched once per distinct k, so every result
+//   is exactly what search_batch() returns for that query alone.
+//
+// Callbacks run on the dispatcher thread, a batch's worth at a time inside
+// options.completion_scope when set (e.g. to take Python's GIL once per
+// batch rather than once per request); the callbacks are also destroyed
+// there. They should be quick and must not block on the service.
+//
+// The index must outlive the service and must not be modified while
+// searches may run, as for any concurrent search. Per-request filters are
+// not supported, since a batch shares one.
+
+struct SearchServiceOptions {
+  std::size_t max_batch = 64;               // dispatch once this many queries wait
+  std::chrono::microseconds max_delay{200}; // or once the oldest has waited this long
+  std::size_t num_threads = 0;              // search_batch() threads per batch (0 = all)
+
+  // Runs around each batch's completions: completion_scope(complete) must
+  // call complete() exactly once.
+  std::function<void(const std::function<void()>& complete)> completion_scope;
+};
+
+class SearchService {
+public:
+  struct Result {
+    std::vector<std::uint64_t> ids; // k entries, best first, padded like search()
+    std::vector<float> scores;
+  };
+
+  // Called once per request with the error that failed its batch, or with
+  // a null error and the result.
+  using Callback = std::function<void(std::exception_ptr error, Result result)>;
+
+  // Searches m row-major queries at k into [m, k] outputs; may throw.
+  using BatchFn =
+      std::function<void(const float* queries, std::size_t m, std::size_t k, std::uint64_t* ids, float* scores)>;
+
+  SearchService(std::size_t dim, BatchFn search_batch, const SearchServiceOptions& options = {});
+
+  // Serves `index` (BruteForceIndex, HnswIndex, ShardedIndex) through its
+  // search_batch(queries, m, k, ids, scores, num_threads, filter).
+  template <typename Index>
+  explicit SearchService(const Index& index, const SearchServiceOptions& options = {})
+      : SearchService(index.dim(),
+                      [&index, threads = options.num_threads](const float* queries, std::size_t m, std::size_t k,
+                                                              std::uint64_t* ids, float* scores) {
+                        index.search_batch(queries, m, k, ids, scores, threads,
+                                           static_cast<const SearchFilter*>(nullptr));
+                      },
+                      options) {}
+
+  // Serves the queries still pending, then stops the dispatcher.
+  ~SearchService();
+
+  SearchService(const SearchService&) = delete;
+  SearchService& operator=(const SearchService&) = delete;
+
+  std::size_t dim() const noexcept { return dim_; }
+  const SearchServiceOptions& options() const noexcept { return options_; }
+
+  // Queues `query` (dim floats, copied) for a k-NN search. Throws
+  // std::logic_error after shutdown().
+  std::future<Result> submit(const float* query, std::size_t k);
+  void submit(const float* query, std::size_t k, Callback done);
+
+  // Serves everything already submitted and joins the dispatcher; later
+  // submits throw. Idempotent.
+  void shutdown();
+
+  // Batches run and queries served so far; queries() / batches() is the
+  // mean batch size.
+  std::uint64_t batches() const noexcept { return batches_.load(std::memory_order_relaxed); }
+  std::uint64_t queries() const noexcept { return queries_.load(std::memory_order_relaxed); }
+
+private:
+  struct Request {
+    std::size_t k = 0;
+    Callback done;
+    std::chrono::steady_clock::time_point arrival;
+  };
+
+  void dispatch_loop();
+  void run_batch(std::vector<Request>& batch, const std::vector<float>& queries);
+
+  std::size_t dim_;
+  BatchFn search_batch_;
+  SearchServiceOptions options_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Request> pending_;
+  std::vector<float> pending_queries_; // row-major, one row per pending_ entry
+  bool stop_ = false;
+
+  std::atomic<std::uint64_t> batches_{0};
+  std::atomic<std::uint64_t> queries_{0};
+
+  std::once_flag shutdown_once_;
+  std::thread dispatcher_; // last: starts once everything above exists
+};
+
+} // namespace vectorcore
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h> // __rdtsc
+#elif defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h> // __rdtsc
+#endif
+
+// Search instrumentation is compiled in unless the build sets
+// VECTORCORE_STATS=0 (CMake: -DVECTORCORE_ENABLE_STATS=OFF). Compiled in, it
+// still costs only a few counter increments per query until an index turns
+// it on with set_stats_enabled(true).
+#ifndef VECTORCORE_STATS
+  #define VECTORCORE_STATS 1
+#endif
+
+// Adds n to a QueryStats counter. n is evaluated either way.
+#if VECTORCORE_STATS
+  #define VECTORCORE_COUNT(counter, n) ((counter) += (n))
+#else
+  #define VECTORCORE_COUNT(counter, n) ((void)(n))
+#endif
+
+namespace vectorcore {
+
+// Work done by one query.
+struct QueryStats {
+  std::uint64_t distances = 0; // distance / code-score evaluations
+  std::uint64_t visited = 0;   // rows or nodes looked at, scored or not
+  std::uint64_t hops = 0;      // graph nodes whose links were expanded
+  std::uint64_t heap_ops = 0;  // beam heap pushes / pops, or top-k admissions
+  std::uint64_t cycles = 0;    // elapsed timestamp-counter ticks
+
+  void clear() noexcept { *this = QueryStats{}; }
+};
+
+// Timestamp counter: rdtsc on x86, the virtual counter on AArch64, steady
+// clock nanoseconds elsewhere. Only differences are meaningful.
+inline std::uint64_t read_cycles() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  std::uint64_t t;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(t));
+  return t;
+#else
+  return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// LatencyHistogram
+// ----------------
+// HDR-style log-linear histogram over the full uint64 range: values below
+// 2^kSubBits get one bucket each, and every power of two above is split
+// into 2^kSubBits linear sub-buckets, so any recorded value is known to
+// within 1 / 2^kSubBits (6.25%). record() is one relaxed atomic increment,
+// safe from any number of threads.
+
+class LatencyHistogram {
+public:
+  static constexpr unsigned kSubBits = 4;
+  static constexpr std::size_t kBuckets = (64 - kSubBits + 1) << kSubBits;
+
+  void record(std::uint64_t value) noexcept {
+    counts_[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::uint64_t count(std::size_t bucket) const noexcept {
+    return counts_[bucket].load(std::memory_order_relaxed);
+  }
+  std::uint64_t total() const noexcept;
+
+  // Largest value that falls in `bucket`.
+  static std::uint64_t upper_bound(std::size_t bucket) noexcept;
+  static std::size_t bucket_of(std::uint64_t value) noexcept;
+
+  // Smallest bucket upper bound covering fraction p of the recorded values
+  // (0 when empty).
+  std::uint64_t percentile(double p) const noexcept;
+
+  void reset() noexcept;
+
+private:
+  std::array<std::atomic<std::uint64_t>, kBuckets> counts_{};
+};
+
+// SearchStats
+// -----------
+// Per-index aggregate of QueryStats plus a latency histogram in
+// nanoseconds. Every field is a relaxed atomic, so concurrent searches
+// record without locks. A reader concurrent with searches sees each counter
+// at some recent value, not one consistent snapshot; reset() likewise
+// clears the counters one by one.
+
+class SearchStats {
+public:
+  void record(const QueryStats& query, std::uint64_t latency_ns) noexcept;
+
+  std::uint64_t queries() const noexcept { return queries_.load(std::memory_order_relaxed); }
+  std::uint64_t total_ns() const noexcept { return total_ns_.load(std::memory_order_relaxed); }
+  std::uint64_t max_ns() const noexcept { return max_ns_.load(std::memory_order_relaxed); }
+
+  // Sums over every recorded query.
+  QueryStats totals() const noexcept;
+  const LatencyHistogram& latency() const noexcept { return latency_; }
+
+  void reset() noexcept;
+
+  // The last query recorded by the calling thread (into any index).
+  static QueryStats last_query() noexcept;
+
+private:
+  std::atomic<std::uint64_t> queries_{0};
+  std::atomic<std::uint64_t> distances_{0};
+  std::atomic<std::uint64_t> visited_{0};
+  std::atomic<std::uint64_t> hops_{0};
+  std::atomic<std::uint64_t> heap_ops_{0};
+  std::atomic<std::uint64_t> cycles_{0};
+  std::atomic<std::uint64_t> total_ns_{0};
+  std::atomic<std::uint64_t> max_ns_{0};
+  LatencyHistogram latency_;
+};
+
+// Times one query when `enabled`; finish() records it. With stats compiled
+// out it never reads a clock and finish() does nothing.
+class QueryTimer {
+public:
+  explicit QueryTimer(bool enabled) noexcept : enabled_(VECTORCORE_STATS && enabled) {
+    if (enabled_) {
+      start_ = std::chrono::steady_clock::now();
+      start_cycles_ = read_cycles();
+    }
+  }
+
+  void finish(SearchStats& stats, QueryStats& query) const noexcept {
+    if (!enabled_) {
+      return;
+    }
+    query.cycles = read_cycles() - start_cycles_;
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+    stats.record(query, static_cast<std::uint64_t>(ns.count()));
+  }
+
+private:
+  bool enabled_ = false;
+  std::chrono::steady_clock::time_point start_{};
+  std::uint64_t start_cycles_ = 0;
+};
+
+} // namespace vectorcore
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "vectorcore/distance.h"
+#include "vectorcore/index_traits.h"
+#include "vectorcore/memory_policy.h"
+#include "vectorcore/search_filter.h"
+#include "vectorcore/thread_pool.h"
+#include "vectorcore/topk.h"
+
+namespace vectorcore {
+
+// ShardedIndex
+// ------------
+// N independent indexes (BruteForceIndex or HnswIndex) behind one add() /
+// search() surface, so one logical index can span every socket of a host,
+// and more memory than a single build can take.
+//
+// - Partitioning: add() splits each batch across the shards, by round robin
+//   or by a hash of the external id (see ShardRouting). Ids stay global:
+//   without explicit ids the rows are numbered in one sequence across all
+//   shards, exactly as a single index would number them.
+// - Placement: with options.numa on a multi-node host, shard s lives on node
+//   s % nodes. Its rows, codes and links are bound there (MemoryPolicy), and
+//   it runs its add() and search() work on a ThreadPool pinned to that
+//   node's CPUs, so a walk never crosses the interconnect. On a single node
+//   the shards share ThreadPool::global().
+// - Fan-out: a batch goes to every node at once, one fan-out thread per
+//   node. Each node's pool works through its (shard, query) pairs, and the
+//   per-shard top-k lists are merged per query with the shared TopK
+//   selector. A single query is searched by each shard in turn with the
+//   shard's own intra-query parallelism.
+//
+// Bitmap filters address the rows of one index and are rejected; id
+// allow-lists and predicates apply to every shard. add() and remove() are
+// applied shard by shard and are not atomic across shards. Not safe to call
+// concurrently with itself or with search(), like the inner indexes.
+//
+// Multi-host serving composes the same way: the merge only needs each
+// partition's top-k ids and scores.
+
+enum class ShardRouting : std::uint8_t {
+  // Each add() is cut into contiguous slices, one per shard (no copy). The
+  // shards that take the remainder rotate, so sizes never differ by more
+  // than one row.
+  ROUND_ROBIN = 0,
+  // Row with id x goes to shard hash(x) % N, so an id always maps to the
+  // same shard. Rows are gathered into per-shard buffers first.
+  HASH = 1,
+};
+
+struct ShardOptions {
+  ShardRouting routing = ShardRouting::ROUND_ROBIN;
+  bool numa = true; // spread shards over NUMA nodes (no-op on one node)
+  HugePages huge_pages = HugePages::NONE;
+};
+
+namespace sharded_detail {
+
+// splitmix64 finalizer: sequential ids spread evenly over the shards.
+inline std::uint64_t mix_id(std::uint64_t x) noexcept {
+  x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ull;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBull;
+  x ^= x >> 31;
+  return x;
+}
+
+} // namespace sharded_detail
+
+template <typename Inner>
+class ShardedIndex {
+public:
+  // Builds shard `shard` with the placement it should use; every shard
+  // must have the same dim and metric.
+  using Factory = std::function<std::unique_ptr<Inner>(std::size_t shard, const MemoryPolicy& memory)>;
+
+  ShardedIndex(std::size_t num_shards, const Factory& make_shard, const ShardOptions& options = {});
+
+  ShardedIndex(const ShardedIndex&) = delete;
+  ShardedIndex& operator=(const ShardedIndex&) = delete;
+
+  std::size_t dim() const noexcept { return shards_.front()->dim(); }
+  Metric metric() const noexcept { return metric_; }
+  ShardRouting routing() const noexcept { return routing_; }
+
+  // Live rows over all shards.
+  std::size_t size() const noexcept {
+    std::size_t total = 0;
+    for (const auto& shard : shards_) {
+      total += shard->size();
+    }
+    return total;
+  }
+
+  std::size_t num_shards() const noexcept { return shards_.size(); }
+  Inner& shard(std::size_t s) { return *shards_[s]; }
+  const Inner& shard(std::size_t s) const { return *shards_[s]; }
+
+  // NUMA node shard `s` is placed on; -1 when unplaced (one node, or
+  // options.numa off).
+  int shard_node(std::size_t s) const noexcept { return shard_node_[s]; }
+
+  // Nodes the shards are spread over (1 when unplaced).
+  std::size_t num_nodes() const noexcept { return groups_.size(); }
+
+  // Splits the batch across the shards (see ShardRouting) and adds each
+  // part; nodes work in parallel. num_threads caps the threads of each
+  // node's pool (0 = all) and is passed on to inner add()s that take it.
+  void add(const float* vectors, std::size_t n, const std::uint64_t* ids = nullptr, std::size_t num_threads = 1);
+
+  // Removes the ids from whichever shards hold them; returns how many were
+  // found.
+  std::size_t remove(const std::uint64_t* ids, std::size_t n) {
+    std::size_t found = 0;
+    for (const auto& shard : shards_) {
+      found += shard->remove(ids, n);
+    }
+    return found;
+  }
+
+  // Same contract as the inner search(): results best first, padded with
+  // UINT64_MAX ids and +inf scores past the rows found.
+  void search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores,
+              std::size_t num_threads = 1, const SearchFilter* filter = nullptr) const {
+    search_batch(query, 1, k, out_ids, out_scores, num_threads, filter);
+  }
+
+  // Row-major [m, dim] queries into [m, k] outputs.
+  void search_batch(const float* queries, std::size_t m, std::size_t k, std::uint64_t* out_ids,
+                    float* out_scores, std::size_t num_threads = 1, const SearchFilter* filter = nullptr) const;
+
+private:
+  struct NodeGroup {
+    int node = -1;                     // -1: unplaced
+    std::unique_ptr<ThreadPool> owned; // pinned to the node; null on one node
+    ThreadPool* pool = nullptr;
+    std::vector<std::size_t> shards;
+  };
+
+  Metric metric_ = Metric::L2_SQUARED;
+  ShardRouting routing_ = ShardRouting::ROUND_ROBIN;
+  std::vector<std::unique_ptr<Inner>> shards_;
+  std::vector<int> shard_node_;
+  std::vector<NodeGroup> groups_;
+  std::unique_ptr<ThreadPool> fanout_; // one thread per node group; null with one group
+  std::uint64_t next_id_ = 0;
+  std::size_t cursor_ = 0; // first shard of the next round-robin remainder
+
+  // Runs fn(group) for every node group, the groups in parallel.
+  template <typename Fn>
+  void for_each_group(std::size_t num_threads, const Fn& fn) const;
+};
+
+template <typename Inner>
+ShardedIndex<Inner>::ShardedIndex(std::size_t num_shards, const Factory& make_shard, const ShardOptions& options)
+    : routing_(options.routing) {
+  if (num_shards == 0) {
+    throw std::invalid_argument("num_shards must be > 0");
+  }
+  if (!make_shard) {
+    throw std::invalid_argument("make_shard is empty");
+  }
+
+  const std::size_t nodes = options.numa ? std::min(numa_node_count(), num_shards) : 1;
+  const bool placed = nodes > 1;
+  groups_.resize(nodes);
+  for (std::size_t g = 0; g < nodes; ++g) {
+    NodeGroup& group = groups_[g];
+    if (placed) {
+      group.node = static_cast<int>(g);
+      const std::vector<int> cpus = numa_node_cpus(group.node);
+      group.owned = std::make_unique<ThreadPool>(std::max<std::size_t>(1, cpus.size()), cpus);
+      group.pool = group.owned.get();
+    } else {
+      group.pool = &ThreadPool::global();
+    }
+  }
+
+  shards_.reserve(num_shards);
+  for (std::size_t s = 0; s < num_shards; ++s) {
+    NodeGroup& group = groups_[s % nodes];
+    std::unique_ptr<Inner> shard = make_shard(s, MemoryPolicy{options.huge_pages, group.node});
+    if (!shard) {
+      throw std::invalid_argument("make_shard returned no index");
+    }
+    if (s > 0 && (shard->dim() != dim() || shard->metric() != metric_)) {
+      throw std::invalid_argument("all shards must have the same dim and metric");
+    }
+    if (placed) {
+      shard->set_thread_pool(group.pool);
+    }
+    metric_ = shard->metric();
+    group.shards.push_back(s);
+    shard_node_.push_back(group.node);
+    shards_.push_back(std::move(shard));
+  }
+
+  if (placed) {
+    fanout_ = std::make_unique<ThreadPool>(nodes);
+  }
+}
+
+template <typename Inner>
+template <typename Fn>
+void ShardedIndex<Inner>::for_each_group(std::size_t num_threads, const Fn& fn) const {
+  if (groups_.size() == 1) {
+    fn(groups_.front());
+    return;
+  }
+  fanout_->parallel_for(groups_.size(), 1, [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+    for (std::size_t g = begin; g < end; ++g) {
+      fn(groups_[g]);
+    }
+  }, (num_threads == 1) ? 1 : 0);
+}
+
+template <typename Inner>
+void ShardedIndex<Inner>::add(const float* vectors, std::size_t n, const std::uint64_t* ids,
+                              std::size_t num_threads) {
+  if (!vectors) {
+    throw std::invalid_argument("vectors pointer is null");
+  }
+  if (n == 0) {
+    return;
+  }
+  const std::size_t dim = this->dim();
+  const std::size_t num_shards = shards_.size();
+
+  // Without ids, the next n of the one sequence all shards share.
+  std::vector<std::uint64_t> sequence;
+  if (!ids) {
+    sequence.resize(n);
+    std::iota(sequence.begin(), sequence.end(), next_id_);
+    ids = sequence.data();
+  }
+
+  struct Part {
+    const float* rows = nullptr;
+    const std::uint64_t* ids = nullptr;
+    std::size_t n = 0;
+    std::vector<float> gathered_rows; // HASH only
+    std::vector<std::uint64_t> gathered_ids;
+  };
+  std::vector<Part> parts(num_shards);
+
+  if (routing_ == ShardRouting::ROUND_ROBIN) {
+    const std::size_t base = n / num_shards;
+    const std::size_t extra = n % num_shards;
+    std::size_t offset = 0;
+    for (std::size_t j = 0; j < num_shards; ++j) {
+      Part& part = parts[(cursor_ + j) % num_shards];
+      part.rows = vectors + (offset * dim);
+      part.ids = ids + offset;
+      part.n = base + ((j < extra) ? 1 : 0);
+      offset += part.n;
+    }
+    cursor_ = (cursor_ + extra) % num_shards;
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      Part& part = parts[sharded_detail::mix_id(ids[i]) % num_shards];
+      part.gathered_rows.insert(part.gathered_rows.end(), vectors + (i * dim), vectors + ((i + 1) * dim));
+      part.gathered_ids.push_back(ids[i]);
+    }
+    for (Part& part : parts) {
+      part.rows = part.gathered_rows.data();
+      part.ids = part.gathered_ids.data();
+      part.n = part.gathered_ids.size();
+    }
+  }
+
+  for_each_group(num_threads, [&](const NodeGroup& group) {
+    for (const std::size_t s : group.shards) {
+      const Part& part = parts[s];
+      if (part.n == 0) {
+        continue;
+      }
+      if constexpr (AddTakesThreads<Inner>::value) {
+        shards_[s]->add(part.rows, part.n, part.ids, num_threads);
+      } else {
+        shards_[s]->add(part.rows, part.n, part.ids);
+      }
+    }
+  });
+  next_id_ += n;
+}
+
+template <typename Inner>
+void ShardedIndex<Inner>::search_batch(const float* queries, std::size_t m, std::size_t k, std::uint64_t* out_ids,
+                                       float* out_scores, std::size_t num_threads,
+                                       const SearchFilter* filter) const {
+  if (!queries) {
+    throw std::invalid_argument("queries pointer is null");
+  }
+  if (!out_ids || !out_scores) {
+    throw std::invalid_argument("output pointers are null");
+  }
+  if (filter && filter->kind() == SearchFilter::Kind::BITMAP) {
+    throw std::invalid_argument("bitmap filters address one index's rows; use an id allow-list with shards");
+  }
+  if (k == 0 || m == 0) {
+    return;
+  }
+  const std::size_t dim = this->dim();
+
+  // Per-shard [m, k] results, merged per query below.
+  const std::size_t block = m * k;
+  std::vector<std::uint64_t> shard_ids(shards_.size() * block);
+  std::vector<float> shard_scores(shards_.size() * block);
+
+  for_each_group(num_threads, [&](const NodeGroup& group) {
+    ThreadPool& pool = *group.pool;
+    const std::size_t threads = (num_threads == 0) ? pool.num_threads() : num_threads;
+    const std::size_t items = group.shards.size() * m;
+
+    // Too few (shard, query) pairs to keep the node busy: let each shard
+    // spread its own work (brute-force row ranges) over the pool instead.
+    if (items < threads) {
+      for (const std::size_t s : group.shards) {
+        shards_[s]->search_batch(queries, m, k, shard_ids.data() + (s * block), shard_scores.data() + (s * block),
+                                 num_threads, filter);
+      }
+      return;
+    }
+
+    // Pairs are shard-major, so a chunk stays within one shard for all but
+    // its last few queries and reaches the inner batch kernels as a batch.
+    const std::size_t grain = std::max<std::size_t>(1, std::min<std::size_t>(64, items / (threads * 4)));
+    pool.parallel_for(items, grain, [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+      while (begin < end) {
+        const std::size_t s = group.shards[begin / m];
+        const std::size_t q = begin % m;
+        const std::size_t count = std::min(end - begin, m - q);
+        const std::size_t out = (s * block) + (q * k);
+        shards_[s]->search_batch(queries + (q * dim), count, k, shard_ids.data() + out, shard_scores.data() + out,
+                                 1, filter);
+        begin += count;
+      }
+    }, num_threads);
+  });
+
+  // Merge: per query, every shard's list through one TopK over badness.
+  const bool l2 = metric_ == Metric::L2_SQUARED;
+  ThreadPool& pool = *groups_.front().pool;
+  const std::size_t grain = 16;
+  const std::size_t parts = pool.participants(m, grain, num_threads);
+  std::vector<TopK<std::uint64_t>> tops(parts);
+  pool.parallel_for(m, grain, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+    TopK<std::uint64_t>& top = tops[worker];
+    for (std::size_t q = begin; q < end; ++q) {
+      top.reset(k);
+      for (std::size_t s = 0; s < shards_.size(); ++s) {
+        const std::uint64_t* ids = shard_ids.data() + (s * block) + (q * k);
+        const float* scores = shard_scores.data() + (s * block) + (q * k);
+        // Shards pad their lists at the end.
+        for (std::size_t j = 0; j < k && ids[j] != std::numeric_limits<std::uint64_t>::max(); ++j) {
+          top.push(l2 ? scores[j] : -scores[j], ids[j]);
+        }
+      }
+      top.sort();
+
+      std::uint64_t* q_ids = out_ids + (q * k);
+      float* q_scores = out_scores + (q * k);
+      const std::size_t kk = std::min(k, top.size());
+      for (std::size_t i = 0; i < kk; ++i) {
+        q_ids[i] = top.ids()[i];
+        q_scores[i] = l2 ? top.badness()[i] : -top.badness()[i];
+      }
+      for (std::size_t i = kk; i < k; ++i) {
+        q_ids[i] = std::numeric_limits<std::uint64_t>::max();
+        q_scores[i] = std::numeric_limits<float>::infinity();
+      }
+    }
+  }, num_threads);
+}
+
+} // namespace vectorcore
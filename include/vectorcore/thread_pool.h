@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vectorcore {
+
+// ThreadPool
+// ----------
+// A fixed set of worker threads for data-parallel loops over index ranges.
+//
+// - parallel_for() blocks until the whole range is done. The calling thread
+//   participates as worker 0, so a pool of N threads owns N - 1 OS threads.
+// - Work is handed out dynamically in `grain`-sized chunks from an atomic
+//   cursor, which keeps uneven per-item cost (e.g. HNSW queries) balanced.
+// - The callback gets a worker id in [0, participants) so callers can keep
+//   per-thread state (top-k buffers, scratch) without locking.
+// - One loop runs at a time; concurrent callers queue up. A parallel_for
+//   issued from inside a worker of the same pool runs inline on that
+//   worker; one issued into another pool (e.g. a per-NUMA-node pool driven
+//   from a fan-out pool) queues there like any caller.
+// - The first exception thrown by a chunk is rethrown to the caller once
+//   all workers have stopped.
+
+class ThreadPool {
+public:
+  using RangeFn = std::function<void(std::size_t begin, std::size_t end, std::size_t worker)>;
+
+  // num_threads == 0 uses std::thread::hardware_concurrency().
+  explicit ThreadPool(std::size_t num_threads = 0);
+
+  // As above, with the pool's own threads pinned to `cpus` (e.g. one NUMA
+  // node's, see numa_node_cpus()). The calling thread is not pinned.
+  // Linux only; elsewhere, or with an empty list, threads float freely.
+  ThreadPool(std::size_t num_threads, const std::vector<int>& cpus);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Total threads available to a loop, including the caller.
+  std::size_t num_threads() const noexcept { return workers_.size() + 1; }
+
+  // Number of workers a loop over `n` items would use when capped at
+  // `max_threads` (0 = no cap). Use it to size per-worker state.
+  std::size_t participants(std::size_t n, std::size_t grain, std::size_t max_threads) const noexcept;
+
+  // Runs fn(begin, end, worker) over [0, n) in chunks of at most `grain`.
+  // At most `max_threads` threads take part (0 = all of them).
+  void parallel_for(std::size_t n, std::size_t grain, const RangeFn& fn, std::size_t max_threads = 0);
+
+  // Process-wide pool sized to the machine, created on first use.
+  static ThreadPool& global();
+
+private:
+  struct Job {
+    const RangeFn* fn = nullptr;
+    std::size_t n = 0;
+    std::size_t grain = 1;
+    std::size_t participants = 1;
+    std::atomic<std::size_t> next{0};
+    std::mutex error_mu;
+    std::exception_ptr error;
+  };
+
+  static void run_chunks(Job& job, std::size_t worker) noexcept;
+  void start(std::size_t num_threads, const std::vector<int>& cpus);
+  void worker_loop(std::size_t worker, const std::vector<int>& cpus);
+
+  std::vector<std::thread> workers_;
+
+  std::mutex submit_mu_; // serializes parallel_for callers
+
+  std::mutex mu_;
+  std::condition_variable wake_cv_;
+  std::condition_variable done_cv_;
+  Job* job_ = nullptr;
+  std::uint64_t generation_ = 0;
+  std::size_t pending_ = 0; // pool workers still running the current job
+  bool stop_ = false;
+};
+
+} // namespace vectorcore
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "vectorcore/flat_array.h"
+
+namespace vectorcore {
+
+// Tombstones
+// ----------
+// One bit per internal row, set when the row has been removed. Rows keep
+// their slot (and, in a graph, their links) until the index is compacted,
+// so removal never moves data under a running scan.
+//
+// - any() is checked once per scan; an index without removals pays nothing
+//   else on the hot path.
+// - The words are a FlatArray, so a loaded index can view the saved bitmap
+//   in place and copy it only on the next removal.
+// - Rows past the end of the bitmap are live: add() never has to grow it.
+
+class Tombstones {
+public:
+  bool any() const noexcept { return count_ > 0; }
+  std::size_t count() const noexcept { return count_; }
+
+  bool test(std::size_t row) const noexcept {
+    const std::size_t w = row >> 6;
+    return w < words_.size() && ((words_[w] >> (row & 63)) & 1u) != 0;
+  }
+
+  // Marks `row`; returns false if it was already marked.
+  bool set(std::size_t row) {
+    const std::size_t w = row >> 6;
+    if (w >= words_.size()) {
+      words_.resize(w + 1, 0);
+    }
+    const std::uint64_t bit = std::uint64_t{1} << (row & 63);
+    if ((words_[w] & bit) != 0) {
+      return false;
+    }
+    words_.data()[w] |= bit;
+    ++count_;
+    return true;
+  }
+
+  void clear() {
+    words_.clear();
+    count_ = 0;
+  }
+
+  const FlatArray<std::uint64_t>& words() const noexcept { return words_; }
+
+  // Takes over a saved bitmap and recounts it.
+  void restore(FlatArray<std::uint64_t> words) {
+    words_ = std::move(words);
+    count_ = 0;
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      std::uint64_t w = words_[i];
+      for (; w != 0; w &= w - 1) {
+        ++count_;
+      }
+    }
+  }
+
+private:
+  FlatArray<std::uint64_t> words_;
+  std::size_t count_ = 0;
+};
+
+// Moves the unmarked rows of `a` ([rows * stride] elements) to the front,
+// keeping their order, and shrinks it to match. Empty arrays are left alone.
+template <typename T>
+void compact_rows(FlatArray<T>& a, std::size_t stride, std::size_t rows, const Tombstones& removed) {
+  if (a.empty()) {
+    return;
+  }
+  T* p = a.data();
+  std::size_t kept = 0;
+  for (std::size_t r = 0; r < rows; ++r) {
+    if (removed.test(r)) {
+      continue;
+    }
+    if (kept != r) {
+      std::copy_n(p + (r * stride), stride, p + (kept * stride));
+    }
+    ++kept;
+  }
+  a.resize(kept * stride);
+}
+
+} // namespace vectorcore
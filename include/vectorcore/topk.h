@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace vectorcore {
+
+// TopK
+// ----
+// Keeps the k smallest badness values of a stream together with their ids.
+// This is the selector behind every exact top-k in the library.
+//
+// - Structure of arrays: badness and ids sit in two flat buffers of
+//   capacity 2k, so the hot reject test touches only floats.
+// - Cached threshold: a candidate is rejected with a single compare against
+//   threshold(), the worst badness still kept. Almost every row of a large
+//   scan with a small k ends there.
+// - Batched selection: accepted candidates are appended, not heapified.
+//   When the buffer fills up, one nth_element pass cuts it back to k and
+//   tightens the threshold. That is amortized O(1) per accepted candidate,
+//   instead of O(log k) per heap push.
+// - push_block() tests a whole block of scores against the threshold with a
+//   branch-free loop the compiler vectorizes, and only falls back to
+//   per-candidate work when some score in the block passes.
+//
+// Equal badness keeps the earlier candidate, as a strict-less heap would.
+// The object is reusable: reset() keeps its allocations.
+
+template <typename Id>
+class TopK {
+public:
+  TopK() = default;
+  explicit TopK(std::size_t k) { reset(k); }
+
+  // Empties the selector and sets its capacity to k (k == 0 keeps nothing).
+  void reset(std::size_t k) {
+    k_ = k;
+    size_ = 0;
+    accepted_ = 0;
+    threshold_ = (k > 0) ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+    const std::size_t cap = std::max<std::size_t>(2 * k, k + kMinSlack);
+    if (badness_.size() < cap) {
+      badness_.resize(cap);
+      ids_.resize(cap);
+    }
+  }
+
+  std::size_t k() const noexcept { return k_; }
+
+  // Candidates with badness >= threshold() can never enter the result.
+  float threshold() const noexcept { return threshold_; }
+
+  void push(float badness, Id id) {
+    if (badness < threshold_) {
+      append(badness, id);
+    }
+  }
+
+  // Pushes badness[i] with id first_id + i for i in [0, n).
+  void push_block(const float* badness, Id first_id, std::size_t n) {
+    std::size_t i = 0;
+    for (; i + kBlock <= n; i += kBlock) {
+      // No early exit: the compares vectorize into one mask per block.
+      const float t = threshold_;
+      bool any = false;
+      for (std::size_t j = 0; j < kBlock; ++j) {
+        any |= (badness[i + j] < t);
+      }
+      if (any) {
+        for (std::size_t j = 0; j < kBlock; ++j) {
+          push(badness[i + j], static_cast<Id>(first_id + static_cast<Id>(i + j)));
+        }
+      }
+    }
+    for (; i < n; ++i) {
+      push(badness[i], static_cast<Id>(first_id + static_cast<Id>(i)));
+    }
+  }
+
+  // Pushes every candidate kept by `other` (per-thread partials, shards).
+  void merge(const TopK& other) {
+    for (std::size_t i = 0; i < other.size_; ++i) {
+      push(other.badness_[i], other.ids_[i]);
+    }
+  }
+
+  // Cuts the buffer to the k best and sorts them best first. After this,
+  // size() <= k and badness()[i] / ids()[i] are the results in order.
+  void sort() {
+    compact();
+    order_.resize(size_);
+    std::iota(order_.begin(), order_.end(), std::uint32_t{0});
+    std::stable_sort(order_.begin(), order_.end(),
+                     [this](std::uint32_t a, std::uint32_t b) { return badness_[a] < badness_[b]; });
+    sorted_badness_.resize(size_);
+    sorted_ids_.resize(size_);
+    for (std::size_t i = 0; i < size_; ++i) {
+      sorted_badness_[i] = badness_[order_[i]];
+      sorted_ids_[i] = ids_[order_[i]];
+    }
+    std::copy(sorted_badness_.begin(), sorted_badness_.end(), badness_.begin());
+    std::copy(sorted_ids_.begin(), sorted_ids_.end(), ids_.begin());
+  }
+
+  // Lowers k, e.g. after re-scoring a wider candidate set in place through
+  // badness(). Takes effect at the next sort().
+  void truncate(std::size_t k) noexcept { k_ = std::min(k_, k); }
+
+  // Candidates that passed the threshold since reset(), for statistics.
+  std::size_t accepted() const noexcept { return accepted_; }
+
+  // Kept candidates; only ordered (and only <= k of them) after sort().
+  std::size_t size() const noexcept { return size_; }
+  const float* badness() const noexcept { return badness_.data(); }
+  float* badness() noexcept { return badness_.data(); }
+  const Id* ids() const noexcept { return ids_.data(); }
+
+private:
+  // Extra room for tiny k, so compaction does not run every few pushes.
+  static constexpr std::size_t kMinSlack = 16;
+  static constexpr std::size_t kBlock = 16;
+
+  std::size_t k_ = 0;
+  std::size_t size_ = 0;
+  std::size_t accepted_ = 0;
+  float threshold_ = -std::numeric_limits<float>::infinity();
+
+  std::vector<float> badness_;
+  std::vector<Id> ids_;
+
+  // Scratch for compact() / sort(), kept between queries.
+  std::vector<float> select_;
+  std::vector<std::uint32_t> order_;
+  std::vector<float> sorted_badness_;
+  std::vector<Id> sorted_ids_;
+
+  void append(float badness, Id id) {
+    ++accepted_;
+    if (size_ == badness_.size()) {
+      compact();
+      if (!(badness < threshold_)) {
+        return;
+      }
+    }
+    badness_[size_] = badness;
+    ids_[size_] = id;
+    ++size_;
+  }
+
+  // Keeps the k best in insertion order and sets threshold_ to the k-th.
+  void compact() {
+    if (size_ <= k_) {
+      return;
+    }
+    if (k_ == 0) {
+      size_ = 0;
+      return;
+    }
+    select_.assign(badness_.begin(), badness_.begin() + static_cast<std::ptrdiff_t>(size_));
+    std::nth_element(select_.begin(), select_.begin() + static_cast<std::ptrdiff_t>(k_ - 1), select_.end());
+    const float kth = select_[k_ - 1];
+
+    // Everything before the k-th is <= it; the rest of the k slots go to the
+    // earliest candidates that tie with it.
+    std::size_t ties = k_;
+    for (std::size_t i = 0; i + 1 < k_; ++i) {
+      ties -= (select_[i] < kth) ? 1 : 0;
+    }
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < size_; ++i) {
+      const float b = badness_[i];
+      const bool tie = !(b < kth) && !(kth < b);
+      if (b < kth || (tie && ties > 0)) {
+        ties -= tie ? 1 : 0;
+        badness_[kept] = b;
+        ids_[kept] = ids_[i];
+        ++kept;
+      }
+    }
+    size_ = kept;
+    threshold_ = kth;
+  }
+};
+
+} // namespace vectorcore
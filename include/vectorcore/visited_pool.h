@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "vectorcore/prefetch.h"
+#include "vectorcore/scalar_quantizer.h"
+#include "vectorcore/search_stats.h"
+#include "vectorcore/topk.h"
+
+namespace vectorcore {
+
+// VisitedTable
+// ------------
+// Visited marks for a graph walk, cleared in O(1).
+//
+// Instead of a bool per node that must be zeroed before every query, each
+// slot stores the epoch in which it was last visited. Starting a new walk
+// just bumps the epoch; a real memset only happens when the 16-bit epoch
+// wraps, i.e. once every 65535 walks.
+
+class VisitedTable {
+public:
+  using Mark = std::uint16_t;
+
+  // Starts a new walk over at least `n` nodes.
+  void prepare(std::size_t n) {
+    if (marks_.size() < n) {
+      // New slots hold 0, which is never a live epoch.
+      marks_.resize(n, 0);
+    }
+    if (++epoch_ == 0) {
+      std::fill(marks_.begin(), marks_.end(), Mark{0});
+      epoch_ = 1;
+    }
+  }
+
+  bool visited(std::uint32_t idx) const noexcept { return marks_[idx] == epoch_; }
+  void mark(std::uint32_t idx) noexcept { marks_[idx] = epoch_; }
+  void prefetch(std::uint32_t idx) const noexcept { vectorcore::prefetch(marks_.data() + idx); }
+
+  // Marks `idx` and reports whether it had already been visited.
+  bool test_and_mark(std::uint32_t idx) noexcept {
+    if (marks_[idx] == epoch_) {
+      return true;
+    }
+    marks_[idx] = epoch_;
+    return false;
+  }
+
+private:
+  std::vector<Mark> marks_;
+  Mark epoch_ = 0;
+};
+
+// Per-walk working set: the visited table plus the two beam heaps. Heaps are
+// plain vectors driven by std::push_heap/pop_heap so their capacity survives
+// clear() and a steady-state query allocates nothing.
+struct SearchScratch {
+  using Candidate = std::pair<float, std::uint32_t>; // (badness, internal index)
+
+  // The beam keeps its two heaps: expansion needs the exact worst result
+  // after every insert, which a lazily tightened TopK threshold cannot give.
+  VisitedTable visited;
+  std::vector<Candidate> candidates;
+  std::vector<Candidate> results;
+
+  // Final rerank selection over the widened beam.
+  TopK<std::uint32_t> top;
+
+  // Copy of one link block, for walks that run while other threads insert.
+  std::vector<std::uint32_t> links;
+
+  // Query-side state for the walk (`query`) and for row-to-row distances
+  // during neighbor selection (`node`), reused across walks.
+  PreparedQuery query;
+  PreparedQuery node;
+
+  // Normalized copy of the query (COSINE only).
+  std::vector<float> unit;
+
+  // Counters of the current search; walks add to them (see search_stats.h).
+  QueryStats stats;
+};
+
+// VisitedPool
+// -----------
+// A free list of SearchScratch objects shared by concurrent searches on one
+// index. Each search checks one out, uses it exclusively, and returns it on
+// scope exit. After warm-up there is one scratch per concurrently searching
+// thread, each already sized to the graph.
+
+class VisitedPool {
+public:
+  class Lease {
+  public:
+    Lease(VisitedPool* pool, std::unique_ptr<SearchScratch> scratch) noexcept
+        : pool_(pool), scratch_(std::move(scratch)) {}
+    Lease(Lease&&) noexcept = default;
+    Lease& operator=(Lease&&) = delete;
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    ~Lease() {
+      if (scratch_) {
+        pool_->release(std::move(scratch_));
+      }
+    }
+
+    SearchScratch& operator*() const noexcept { return *scratch_; }
+    SearchScratch* operator->() const noexcept { return scratch_.get(); }
+
+  private:
+    VisitedPool* pool_;
+    std::unique_ptr<SearchScratch> scratch_;
+  };
+
+  // Checks out a scratch. Callers start each walk with visited.prepare(n)
+  // and clear the heaps they use.
+  Lease acquire() {
+    std::unique_ptr<SearchScratch> scratch;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (!free_.empty()) {
+        scratch = std::move(free_.back());
+        free_.pop_back();
+      }
+    }
+    if (!scratch) {
+      scratch = std::make_unique<SearchScratch>();
+    }
+    return Lease(this, std::move(scratch));
+  }
+
+private:
+  void release(std::unique_ptr<SearchScratch> scratch) {
+    std::lock_guard<std::mutex> lock(mu_);
+    free_.push_back(std::move(scratch));
+  }
+
+  std::mutex mu_;
+  std::vector<std::unique_ptr<SearchScratch>> free_;
+};
+
+} // namespace vectorcore
@@ -1,5 +1,6 @@
 from __future__ import annotations
 
+import platform
 import sys
 
 from setuptools import setup
@@ -9,28 +10,64 @@ from setuptools import setup
 from pybind11.setup_helpers import Pybind11Extension, build_ext
 
 
+IS_MSVC = sys.platform.startswith("win")
+MACHINE = platform.machine().lower()
+IS_X86 = MACHINE in ("x86_64", "amd64", "i386", "i686", "x86")
+IS_ARM64 = MACHINE in ("aarch64", "arm64")
+
+
 def compile_args():
     """Return compiler args for high-performance builds.
 
     Requirement mapping:
     - C++17
     - -O3
-    - -mavx2 for SIMD
+
+    SIMD flags are *not* applied globally: the distance kernels for each ISA
+    live in their own translation units (see isa_libraries below) and are
+    selected at runtime, so one wheel runs on any CPU of its architecture.
 
     Note (Windows/MSVC):
-    - MSVC doesn't understand -O3/-mavx2, so we translate to /O2 and /arch:AVX2.
+    - MSVC doesn't understand -O3, so we translate to /O2.
     """
 
-    if sys.platform.startswith("win"):
+    if IS_MSVC:
         # MSVC flags
-        return ["/O2", "/arch:AVX2"]
+        return ["/O2"]
 
     # GCC/Clang flags
-    return [
-        "-O3",
-        "-mavx2",
-        "-mfma",
-    ]
+    return ["-O3"]
+
+
+def isa_libraries():
+    """Static libraries for the per-ISA kernels, each with its own flags.
+
+    Returns (libraries, define_macros) for setup()/the extension.
+    """
+
+    def lib(name, source, flags):
+        std = ["/std:c++17"] if IS_MSVC else ["-std=c++17", "-fPIC"]
+        return (name, {
+            "sources": [source],
+            "include_dirs": ["include"],
+            "cflags": std + compile_args() + flags,
+            "macros": macros,
+        })
+
+    libs, macros = [], []
+    if IS_X86:
+        macros = [("VECTORCORE_HAVE_AVX2", None), ("VECTORCORE_HAVE_AVX512", None)]
+        libs.append(lib("vectorcore_avx2", "src/distance_avx2.cpp",
+                        ["/arch:AVX2"] if IS_MSVC else ["-mavx2", "-mfma", "-mf16c"]))
+        libs.append(lib("vectorcore_avx512", "src/distance_avx512.cpp",
+                        ["/arch:AVX512"] if IS_MSVC else ["-mavx512f", "-mfma"]))
+    elif IS_ARM64:
+        macros = [("VECTORCORE_HAVE_NEON", None)]
+        libs.append(lib("vectorcore_neon", "src/distance_neon.cpp", []))
+    return libs, macros
+
+
+ISA_LIBRARIES, ISA_MACROS = isa_libraries()
 
 
 ext_modules = [
@@ -39,6 +76,7 @@ ext_modules = [
         [
             "src/main.cpp",
             "src/VectorStore.cpp",
+            "src/distance.cpp",
         ],
         include_dirs=[
             "include",
@@ -46,6 +84,7 @@ ext_modules = [
         ],
         cxx_std=17,
         extra_compile_args=compile_args(),
+        define_macros=ISA_MACROS,
     )
 ]
 
@@ -55,6 +94,7 @@ setup(
     version="0.0.0",
     description="VectorCore (prototype) - pybind11 extension",
     ext_modules=ext_modules,
+    libraries=ISA_LIBRARIES,
     cmdclass={"build_ext": build_ext},
     zip_safe=False,
 )
@@ -1,92 +1,71 @@
 #include "VectorStore.hpp"
 
 #include <algorithm>
-#include <immintrin.h>
+#include <cstring>
 #include <limits>
-#include <queue>
 #include <utility>
 
-namespace vectorcore {
-
-float VectorStore::calculate_l2_dist(const float* a, const float* b, std::size_t dim) noexcept {
-  // Scalar fallback (always correct).
-  //
-  // Note: This function is hot in brute-force search. Keeping it `noexcept`
-  // allows the compiler to optimize more aggressively.
-
-#if defined(__AVX2__)
-  // AVX2 path: process 8 floats per iteration.
-  // We use unaligned loads (_mm256_loadu_ps) because callers only guarantee
-  // pointer validity, not 32-byte alignment.
-  __m256 acc = _mm256_setzero_ps();
-  std::size_t i = 0;
-
-  for (; i + 8 <= dim; i += 8) {
-    const __m256 va = _mm256_loadu_ps(a + i);
-    const __m256 vb = _mm256_loadu_ps(b + i);
-    const __m256 diff = _mm256_sub_ps(va, vb);
-
-    // FMA: acc += diff * diff
-    // On CPUs with FMA, this reduces instruction count and improves throughput.
-    acc = _mm256_fmadd_ps(diff, diff, acc);
-  }
-
-  alignas(32) float tmp[8];
-  _mm256_store_ps(tmp, acc);
+#include "vectorcore/distance.h"
+#include "vectorcore/topk.h"
 
-  float sum = tmp[0] + tmp[1] + tmp[2] + tmp[3] + tmp[4] + tmp[5] + tmp[6] + tmp[7];
+namespace vectorcore {
 
-  // Tail loop for remaining elements.
-  for (; i < dim; ++i) {
-    const float d = a[i] - b[i];
-    sum += d * d;
-  }
+namespace {
+// Target chunk size. Rows per chunk is the largest power of two that fits.
+constexpr std::size_t kChunkBytes = std::size_t{1} << 20;
+} // namespace
 
-  return sum;
-#else
-  // Scalar loop.
-  float sum = 0.0f;
-
-  // Mild unrolling helps reduce loop overhead and may improve instruction
-  // scheduling even without SIMD.
-  std::size_t i = 0;
-  for (; i + 4 <= dim; i += 4) {
-    const float d0 = a[i + 0] - b[i + 0];
-    const float d1 = a[i + 1] - b[i + 1];
-    const float d2 = a[i + 2] - b[i + 2];
-    const float d3 = a[i + 3] - b[i + 3];
-    sum += d0 * d0 + d1 * d1 + d2 * d2 + d3 * d3;
-  }
-  for (; i < dim; ++i) {
-    const float d = a[i] - b[i];
-    sum += d * d;
-  }
-  return sum;
-#endif
+float VectorStore::calculate_l2_dist(const float* a, const float* b, std::size_t dim) noexcept {
+  // Same runtime-dispatched kernel as the index classes (scalar/AVX2/AVX-512/NEON).
+  return l2_squared(a, b, dim);
 }
 
 VectorStore::VectorStore(std::size_t dim) : dim_(dim) {
   if (dim_ == 0) {
     throw std::invalid_argument("VectorStore dim must be > 0");
   }
+  const std::size_t rows = std::max<std::size_t>(1, kChunkBytes / (dim_ * sizeof(float)));
+  while ((std::size_t{2} << chunk_shift_) <= rows) {
+    ++chunk_shift_;
+  }
 }
 
-void VectorStore::add_vector(int id, const float* vec_data, std::size_t dim) {
+void VectorStore::add_vector(std::uint64_t id, const float* vec_data, std::size_t dim) {
   if (!vec_data) {
     throw std::invalid_argument("vec_data pointer is null");
   }
   if (dim != dim_) {
     throw std::invalid_argument("dim mismatch: vector dim must match store dim");
   }
+  add_vectors(&id, vec_data, 1);
+}
+
+void VectorStore::add_vectors(const std::uint64_t* ids, const float* vectors, std::size_t n) {
+  if (n == 0) {
+    return;
+  }
+  if (!ids || !vectors) {
+    throw std::invalid_argument("ids / vectors pointer is null");
+  }
 
-  // Reserve to avoid repeated reallocations.
-  // Each reallocation copies the entire backing array, which is expensive.
-  const std::size_t next_size = size() + 1;
-  data_.reserve(next_size * dim_);
-  ids_.reserve(next_size);
+  // Allocate the chunks first, so a failed allocation leaves the store as it
+  // was. Full chunks are never touched again: nothing stored is ever copied.
+  const std::size_t begin = size();
+  const std::size_t end = begin + n;
+  const std::size_t needed = (end + chunk_rows() - 1) >> chunk_shift_;
+  while (chunks_.size() < needed) {
+    chunks_.emplace_back(chunk_rows() * dim_);
+  }
 
-  ids_.push_back(id);
-  data_.insert(data_.end(), vec_data, vec_data + dim_);
+  for (std::size_t row = begin; row < end;) {
+    const std::size_t take = std::min(chunk_rows() - (row & (chunk_rows() - 1)), end - row);
+    std::memcpy(row_ptr(row), vectors, take * dim_ * sizeof(float));
+    vectors += take * dim_;
+    row += take;
+  }
+
+  // Rows become visible once their ids are in; ids_ grows geometrically.
+  ids_.insert(ids_.end(), ids, ids + n);
 }
 
 const float* VectorStore::get_vector(std::size_t internal_idx) const {
@@ -95,20 +74,19 @@ const float* VectorStore::get_vector(std::size_t internal_idx) const {
   }
 
   // Pointer arithmetic is safe here because:
-  // - data_ is contiguous
-  // - we store exactly dim_ floats per vector
+  // - each chunk is contiguous and holds chunk_rows() rows of dim_ floats
   // - internal_idx is bounds-checked above
-  return data_.data() + (internal_idx * dim_);
+  return row_ptr(internal_idx);
 }
 
-int VectorStore::get_id(std::size_t internal_idx) const {
+std::uint64_t VectorStore::get_id(std::size_t internal_idx) const {
   if (internal_idx >= size()) {
     throw std::out_of_range("internal_idx out of range");
   }
   return ids_[internal_idx];
 }
 
-std::vector<std::pair<float, int>> VectorStore::search(const float* query, int k) const {
+std::vector<std::pair<float, std::uint64_t>> VectorStore::search(const float* query, int k) const {
   if (!query) {
     throw std::invalid_argument("query pointer is null");
   }
@@ -123,45 +101,33 @@ std::vector<std::pair<float, int>> VectorStore::search(const float* query, int k
 
   const std::size_t kk = std::min<std::size_t>(static_cast<std::size_t>(k), n);
 
-  // Requirement: use a std::priority_queue (min-heap) to keep top-k.
-  //
-  // A min-heap naturally gives you the smallest element at the top.
-  // For top-k *nearest* neighbors (smallest distances) we'd like to quickly
-  // evict the *worst* (largest distance) among the kept items.
-  //
-  // Trick: store `key = -distance`. Then:
-  // - Worst (largest distance) => most negative key => becomes the *smallest*
-  //   key => rises to the top of a min-heap.
-  // - When heap grows beyond k, popping removes the worst candidate.
-  using Keyed = std::pair<float, int>; // (key=-dist, external_id)
-  struct GreaterKey {
-    bool operator()(const Keyed& a, const Keyed& b) const noexcept { return a.first > b.first; }
-  };
-
-  std::priority_queue<Keyed, std::vector<Keyed>, GreaterKey> heap;
-
-  for (std::size_t i = 0; i < n; ++i) {
-    const float* v = data_.data() + (i * dim_);
-    const float dist = calculate_l2_dist(query, v, dim_);
-    heap.emplace(-dist, ids_[i]);
-
-    if (heap.size() > kk) {
-      heap.pop();
+  // Same selector as the index classes: a block of distances is rejected
+  // with one compare against the current k-th best, and survivors are
+  // selected in batches instead of one heap push/pop per row.
+  constexpr std::size_t kBlock = 64;
+  float block[kBlock];
+  TopK<std::size_t> top(kk);
+
+  // Chunk sizes are powers of two >= 1, so a block never straddles chunks
+  // when it starts at a multiple of min(kBlock, chunk_rows()).
+  const std::size_t step = std::min(kBlock, chunk_rows());
+  for (std::size_t i0 = 0; i0 < n; i0 += step) {
+    const std::size_t bn = std::min(step, n - i0);
+    const float* rows = row_ptr(i0);
+    for (std::size_t i = 0; i < bn; ++i) {
+      block[i] = calculate_l2_dist(query, rows + (i * dim_), dim_);
     }
+    top.push_block(block, i0, bn);
   }
+  top.sort();
 
-  std::vector<std::pair<float, int>> result;
-  result.reserve(kk);
-  while (!heap.empty()) {
-    const auto [key, id] = heap.top();
-    heap.pop();
-    result.emplace_back(-key, id); // convert back to positive distance
+  // Smaller distance first.
+  std::vector<std::pair<float, std::uint64_t>> result;
+  result.reserve(top.size());
+  for (std::size_t i = 0; i < top.size(); ++i) {
+    result.emplace_back(top.badness()[i], ids_[top.ids()[i]]);
   }
 
-  std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
-    return a.first < b.first; // smaller distance first
-  });
-
   return result;
 }
 
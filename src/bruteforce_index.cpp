@@ -2,25 +2,85 @@
 
 #include <algorithm>
 #include <cstring>
+#include <unordered_map>
+
+#include "vectorcore/index_io.h"
+#include "vectorcore/thread_pool.h"
 
 namespace vectorcore {
 
 namespace {
 
 // For L2 we want *smaller* scores; for inner product we want *larger* scores.
-// To reuse a single heap structure we store a "badness" value:
+// To reuse a single top-k selector we store a "badness" value:
 // - L2: badness = distance (larger is worse)
 // - IP: badness = -similarity (larger is worse)
 inline float badness_from_score(Metric metric, float score) noexcept {
   return (metric == Metric::L2_SQUARED) ? score : -score;
 }
 
+// search_batch tiling. A query block and a row block together should fit in
+// L2 (e.g. 64 x 768-d queries = 192 KiB plus 256 KiB of rows).
+constexpr std::size_t kQueryBlock = 64;
+constexpr std::size_t kRowBlockBytes = 256 * 1024;
+
+// Single-query scans are split across threads only when each task gets at
+// least this many rows; below that the fork/join costs more than it saves.
+constexpr std::size_t kMinRowsPerTask = 16384;
+
+// Rows scored per push_block() call in scan_rows.
+constexpr std::size_t kScanBlock = 64;
+
+// Badness of a removed or filtered row: never below any selector's threshold.
+constexpr float kRemoved = std::numeric_limits<float>::infinity();
+
+// L2 range scans compare the running distance against the radius after
+// every chunk of this many dimensions.
+constexpr std::size_t kRangeChunk = 64;
+
+// Squared L2 distance, or some partial sum above `bound` once it is clear
+// the full distance would exceed it. Chunks go through the same kernel.
+inline float l2_squared_bounded(const float* a, const float* b, std::size_t dim, float bound) noexcept {
+  float sum = 0.f;
+  for (std::size_t d = 0; d < dim; d += kRangeChunk) {
+    sum += l2_squared(a + d, b + d, std::min(kRangeChunk, dim - d));
+    if (sum > bound) {
+      break;
+    }
+  }
+  return sum;
+}
+
 } // namespace
 
-BruteForceIndex::BruteForceIndex(std::size_t dim, Metric metric) : dim_(dim), metric_(metric) {
+BruteForceIndex::BruteForceIndex(std::size_t dim, Metric metric, Storage storage, std::size_t rerank_factor,
+                                 const MemoryPolicy& memory)
+    : dim_(dim), metric_(metric), distance_(distance_kernels().fp32_for(metric, dim)), rerank_factor_(rerank_factor),
+      stats_(std::make_unique<SearchStats>()) {
   if (dim_ == 0) {
     throw std::invalid_argument("dim must be > 0");
   }
+  validate_memory_policy(memory);
+  embeddings_.set_memory_policy(memory);
+  codes_.set_memory_policy(memory);
+  quantizer_ = ScalarQuantizer(storage, dim_, kernel_metric(metric_));
+}
+
+ThreadPool& BruteForceIndex::thread_pool() const noexcept {
+  return pool_ ? *pool_ : ThreadPool::global();
+}
+
+void BruteForceIndex::train(const float* vectors, std::size_t n) {
+  if (size_ != 0) {
+    throw std::logic_error("train() must be called before add()");
+  }
+  if (metric_ == Metric::COSINE && vectors) {
+    std::vector<float> unit(vectors, vectors + (n * dim_));
+    normalize_rows(unit.data(), n, dim_);
+    quantizer_.train(unit.data(), n);
+    return;
+  }
+  quantizer_.train(vectors, n);
 }
 
 void BruteForceIndex::add(const float* vectors, std::size_t n, const std::uint64_t* ids) {
@@ -30,91 +90,357 @@ void BruteForceIndex::add(const float* vectors, std::size_t n, const std::uint64
   if (n == 0) {
     return;
   }
+  append(vectors, n, ids, false);
+}
+
+void BruteForceIndex::add_half(const std::uint16_t* vectors, std::size_t n, HalfFormat format,
+                               const std::uint64_t* ids) {
+  if (!vectors) {
+    throw std::invalid_argument("vectors pointer is null");
+  }
+  if (n == 0) {
+    return;
+  }
+  append(nullptr, n, ids, false, vectors, format);
+}
 
+void BruteForceIndex::attach(const float* vectors, std::size_t n, std::shared_ptr<const void> owner,
+                             const std::uint64_t* ids) {
+  if (!vectors) {
+    throw std::invalid_argument("vectors pointer is null");
+  }
+  if (size_ != 0) {
+    throw std::logic_error("attach() needs an empty index");
+  }
+  if (ingest_capacity_ > 0) {
+    throw std::logic_error("attach() views caller memory, which concurrent ingest cannot append to");
+  }
+  if (!has_fp32()) {
+    throw std::invalid_argument("attach() needs fp32 rows (FP32 storage, or rerank_factor > 0)");
+  }
+  if (metric_ == Metric::COSINE) {
+    throw std::invalid_argument("attach() cannot normalize caller memory; use INNER_PRODUCT over unit rows");
+  }
+  if (n == 0) {
+    return;
+  }
+  embeddings_.attach(vectors, n * dim_, std::move(owner));
+  try {
+    append(vectors, n, ids, true);
+  } catch (...) {
+    // Do not leave the view behind if indexing the rows fails.
+    embeddings_.clear();
+    throw;
+  }
+}
+
+void BruteForceIndex::append(const float* vectors, std::size_t n, const std::uint64_t* ids, bool in_place,
+                             const std::uint16_t* halves, HalfFormat format) {
   // Reserve once to avoid repeated reallocations (each reallocation is a full memcpy).
   const std::size_t old_size = size_;
   const std::size_t new_size = size_ + n;
+  if (ingest_capacity_ > 0 && new_size > ingest_capacity_) {
+    throw std::length_error("add() would pass the ingest capacity; raise it first");
+  }
 
-  embeddings_.reserve(new_size * dim_);
   ids_.reserve(new_size);
 
-  // Append the new vectors in a single flat block.
-  embeddings_.insert(embeddings_.end(), vectors, vectors + (n * dim_));
+  // `rows` is what gets encoded and normed: the input, or its widened and
+  // (for COSINE) normalized copy, in embeddings_ when the rows are kept.
+  const float* rows = vectors;
+  std::vector<float> unit;
+
+  if (has_fp32()) {
+    // Append the new vectors in a single flat block. attach() (in_place)
+    // already views them.
+    if (halves) {
+      embeddings_.reserve(new_size * dim_);
+      append_widened(embeddings_, format, halves, n * dim_);
+    } else if (!in_place) {
+      embeddings_.reserve(new_size * dim_);
+      embeddings_.append(vectors, vectors + (n * dim_));
+    }
+    if (halves || metric_ == Metric::COSINE) {
+      const FlatArray<float>& stored = embeddings_;
+      rows = stored.data() + (old_size * dim_);
+    }
+    if (metric_ == Metric::COSINE) {
+      normalize_rows(embeddings_.data() + (old_size * dim_), n, dim_);
+    }
+  } else if (halves || metric_ == Metric::COSINE) {
+    if (halves) {
+      unit.resize(n * dim_);
+      widen_to_float(format, halves, unit.data(), unit.size());
+    } else {
+      unit.assign(vectors, vectors + (n * dim_));
+    }
+    if (metric_ == Metric::COSINE) {
+      normalize_rows(unit.data(), n, dim_);
+    }
+    rows = unit.data();
+  }
+
+  if (quantized()) {
+    // INT8 without an explicit train() learns its ranges from the first batch.
+    if (!quantizer_.trained()) {
+      quantizer_.train(rows, n);
+    }
+    const std::size_t code_size = quantizer_.code_size();
+    codes_.resize(new_size * code_size);
+    quantizer_.encode(rows, n, codes_.data() + (old_size * code_size));
+  } else {
+    // Norms of the stored rows for the L2 expansion in search_batch.
+    norms_.reserve(new_size);
+    for (std::size_t i = 0; i < n; ++i) {
+      const float* v = rows + (i * dim_);
+      norms_.push_back(inner_product(v, v, dim_));
+    }
+  }
 
   if (ids) {
-    ids_.insert(ids_.end(), ids, ids + n);
+    ids_.append(ids, ids + n);
   } else {
     // Deterministic IDs (0..N-1) are interview-friendly.
     // In production you might accept external IDs (uint64) from the caller.
     for (std::size_t i = 0; i < n; ++i) {
-      ids_.push_back(static_cast<std::uint64_t>(old_size + i));
+      ids_.push_back(next_id_ + i);
     }
   }
+  next_id_ += n;
 
+  if (id_map_ready_) {
+    for (std::size_t r = old_size; r < new_size; ++r) {
+      id_map_[ids_[r]] = r;
+    }
+  }
+
+  // Searches see the new rows from here on, all written.
   size_ = new_size;
+  published_.publish(size_);
 }
 
-float BruteForceIndex::score(const float* a, const float* b) const noexcept {
-  // Small but important C++ detail:
-  // - We keep metric_ as an enum class (scoped enum) for type safety.
-  // - We switch to avoid branches inside the inner loop; each metric has its own kernel.
-  switch (metric_) {
-    case Metric::L2_SQUARED:
-      return l2_squared(a, b, dim_);
-    case Metric::INNER_PRODUCT:
-      return inner_product(a, b, dim_);
-    default:
-      return l2_squared(a, b, dim_);
+void BruteForceIndex::set_ingest_capacity(std::size_t capacity) {
+  if (capacity > 0 && capacity < size_) {
+    throw std::invalid_argument("ingest capacity is below the rows already stored");
+  }
+  if (capacity > 0 && quantized() && !quantizer_.trained()) {
+    throw std::logic_error("INT8 storage needs train() before concurrent ingest");
   }
+  ingest_capacity_ = capacity;
+  reserve_ingest();
 }
 
-void BruteForceIndex::search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores) const {
-  if (!query) {
-    throw std::invalid_argument("query pointer is null");
+void BruteForceIndex::reserve_ingest() {
+  if (ingest_capacity_ == 0) {
+    return;
   }
-  if (!out_ids || !out_scores) {
-    throw std::invalid_argument("output pointers are null");
+  ids_.reserve(ingest_capacity_);
+  if (has_fp32()) {
+    embeddings_.reserve(ingest_capacity_ * dim_);
   }
-  if (k == 0) {
+  if (quantized()) {
+    codes_.reserve(ingest_capacity_ * quantizer_.code_size());
+  } else {
+    norms_.reserve(ingest_capacity_);
+  }
+}
+
+void BruteForceIndex::build_id_map() {
+  if (id_map_ready_) {
     return;
   }
+  id_map_.reserve(size());
+  for (std::size_t r = 0; r < size_; ++r) {
+    if (!deleted_.test(r)) {
+      id_map_[ids_[r]] = r;
+    }
+  }
+  id_map_ready_ = true;
+}
 
-  const std::size_t kk = std::min(k, size_);
+void BruteForceIndex::overwrite(std::size_t row, const float* v) {
+  const float* src = v;
+  std::vector<float> unit;
+  if (has_fp32()) {
+    float* dst = embeddings_.data() + (row * dim_);
+    std::copy_n(v, dim_, dst);
+    if (metric_ == Metric::COSINE) {
+      normalize(dst, dim_);
+    }
+    src = dst;
+  } else if (metric_ == Metric::COSINE) {
+    unit.assign(v, v + dim_);
+    normalize(unit.data(), dim_);
+    src = unit.data();
+  }
 
-  // Max-heap of current best results by "badness".
-  // top() is the worst among the kept candidates, which makes replacement O(log k).
-  using Item = std::pair<float, std::uint64_t>; // (badness, id)
-  auto worse = [](const Item& a, const Item& b) { return a.first < b.first; };
-  std::priority_queue<Item, std::vector<Item>, decltype(worse)> heap(worse);
+  if (quantized()) {
+    const std::size_t code_size = quantizer_.code_size();
+    quantizer_.encode(src, 1, codes_.data() + (row * code_size));
+  } else {
+    norms_.data()[row] = inner_product(src, src, dim_);
+  }
+}
 
-  for (std::size_t i = 0; i < size_; ++i) {
-    const float* vec = embeddings_.data() + (i * dim_);
-    const float s = score(query, vec);
-    const float b = badness_from_score(metric_, s);
+std::size_t BruteForceIndex::remove(const std::uint64_t* ids, std::size_t n) {
+  if (!ids && n > 0) {
+    throw std::invalid_argument("ids pointer is null");
+  }
+  build_id_map();
 
-    if (heap.size() < kk) {
-      heap.emplace(b, ids_[i]);
-    } else if (b < heap.top().first) {
-      heap.pop();
-      heap.emplace(b, ids_[i]);
+  std::size_t removed = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto it = id_map_.find(ids[i]);
+    if (it == id_map_.end()) {
+      continue;
     }
+    deleted_.set(it->second);
+    id_map_.erase(it);
+    ++removed;
   }
 
-  // Extract heap into output arrays. Heap gives worst-first, so we reverse.
-  // For L2: best has smallest distance; for IP: best has largest similarity.
-  std::vector<Item> tmp;
-  tmp.reserve(kk);
-  while (!heap.empty()) {
-    tmp.push_back(heap.top());
-    heap.pop();
+  if (compact_threshold_ > 0.0 &&
+      static_cast<double>(deleted_.count()) > compact_threshold_ * static_cast<double>(size_)) {
+    compact();
+  }
+  return removed;
+}
+
+void BruteForceIndex::upsert(const float* vectors, std::size_t n, const std::uint64_t* ids) {
+  if (!vectors) {
+    throw std::invalid_argument("vectors pointer is null");
+  }
+  if (!ids) {
+    throw std::invalid_argument("upsert() needs ids");
+  }
+  if (n == 0) {
+    return;
+  }
+  build_id_map();
+
+  std::unordered_map<std::uint64_t, std::size_t> last;
+  last.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    last[ids[i]] = i;
+  }
+
+  // Known ids are rewritten where they are; the rest go through one add().
+  std::vector<float> fresh;
+  std::vector<std::uint64_t> fresh_ids;
+  for (std::size_t i = 0; i < n; ++i) {
+    if (last[ids[i]] != i) {
+      continue;
+    }
+    const float* v = vectors + (i * dim_);
+    const auto it = id_map_.find(ids[i]);
+    if (it != id_map_.end()) {
+      overwrite(it->second, v);
+    } else {
+      fresh.insert(fresh.end(), v, v + dim_);
+      fresh_ids.push_back(ids[i]);
+    }
+  }
+  if (!fresh_ids.empty()) {
+    add(fresh.data(), fresh_ids.size(), fresh_ids.data());
+  }
+}
+
+void BruteForceIndex::compact() {
+  if (!deleted_.any()) {
+    return;
+  }
+  compact_rows(embeddings_, dim_, size_, deleted_);
+  compact_rows(ids_, 1, size_, deleted_);
+  compact_rows(norms_, 1, size_, deleted_);
+  compact_rows(codes_, quantizer_.code_size(), size_, deleted_);
+
+  size_ -= deleted_.count();
+  published_.publish(size_);
+  deleted_.clear();
+
+  // Rows moved; the map is rebuilt on the next remove() / upsert().
+  id_map_.clear();
+  id_map_ready_ = false;
+}
+
+std::size_t BruteForceIndex::scan_rows(const PreparedQuery& query, std::size_t begin, std::size_t end,
+                                       const SearchFilter* filter, Selector& top) const {
+  // Score a block of rows, then let the selector reject the block with one
+  // vectorized compare against its threshold.
+  float block[kScanBlock];
+  const std::size_t code_size = quantizer_.code_size();
+  const bool skip = deleted_.any() || filter != nullptr;
+  std::size_t hidden_rows = 0;
+
+  // Prefetch only rows long enough to outrun the hardware prefetcher.
+  const std::size_t row_bytes = quantized() ? code_size : dim_ * sizeof(float);
+  const std::size_t ahead = (row_bytes >= kPrefetchMinRowBytes) ? prefetch_distance_ : 0;
+  const std::uint8_t* rows = quantized() ? codes_.data() : reinterpret_cast<const std::uint8_t*>(embeddings_.data());
+
+  // Row r + ahead is requested just before row r is scored.
+  for (std::size_t r = begin; r < std::min(end, begin + ahead); ++r) {
+    prefetch_range(rows + (r * row_bytes), row_bytes);
   }
-  std::reverse(tmp.begin(), tmp.end());
+  auto prefetch_ahead = [&](std::size_t r) {
+    if (ahead > 0 && r + ahead < end) {
+      prefetch_range(rows + ((r + ahead) * row_bytes), row_bytes);
+    }
+  };
+
+  for (std::size_t b0 = begin; b0 < end; b0 += kScanBlock) {
+    const std::size_t bn = std::min(kScanBlock, end - b0);
+    if (!quantized()) {
+      for (std::size_t i = 0; i < bn; ++i) {
+        prefetch_ahead(b0 + i);
+        // Removed and filtered rows are never scored.
+        if (skip && hidden(b0 + i, filter)) {
+          block[i] = kRemoved;
+          ++hidden_rows;
+          continue;
+        }
+        const float* vec = embeddings_.data() + ((b0 + i) * dim_);
+        block[i] = badness_from_score(metric_, score(query.q, vec));
+      }
+    } else {
+      for (std::size_t i = 0; i < bn; ++i) {
+        prefetch_ahead(b0 + i);
+        if (skip && hidden(b0 + i, filter)) {
+          block[i] = kRemoved;
+          ++hidden_rows;
+          continue;
+        }
+        const float s = quantizer_.score(query, codes_.data() + ((b0 + i) * code_size));
+        block[i] = badness_from_score(metric_, s);
+      }
+    }
+    top.push_block(block, b0, bn);
+  }
+  return (end - begin) - hidden_rows;
+}
 
+void BruteForceIndex::rerank(const float* query, std::size_t k, Selector& top) const {
+  top.sort();
+  float* badness = top.badness();
+  const std::size_t* rows = top.ids();
+  for (std::size_t i = 0; i < top.size(); ++i) {
+    badness[i] = badness_from_score(metric_, score(query, embeddings_.data() + (rows[i] * dim_)));
+  }
+  top.truncate(k);
+}
+
+void BruteForceIndex::write_results(Selector& top, std::size_t k, std::uint64_t* out_ids,
+                                    float* out_scores) const {
+  // For L2: best has smallest distance; for IP: best has largest similarity.
+  top.sort();
+
+  const std::size_t kk = std::min(k, top.size());
+  const float* badness = top.badness();
+  const std::size_t* rows = top.ids();
   for (std::size_t i = 0; i < kk; ++i) {
-    out_ids[i] = tmp[i].second;
+    out_ids[i] = ids_[rows[i]];
 
     // Convert back from badness to the user-facing score.
-    out_scores[i] = (metric_ == Metric::L2_SQUARED) ? tmp[i].first : -tmp[i].first;
+    out_scores[i] = (metric_ == Metric::L2_SQUARED) ? badness[i] : -badness[i];
   }
 
   // If caller asked for more than size_, pad deterministically.
@@ -124,4 +450,304 @@ void BruteForceIndex::search(const float* query, std::size_t k, std::uint64_t* o
   }
 }
 
+void BruteForceIndex::search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores,
+                             std::size_t num_threads, const SearchFilter* filter) const {
+  if (!query) {
+    throw std::invalid_argument("query pointer is null");
+  }
+  if (!out_ids || !out_scores) {
+    throw std::invalid_argument("output pointers are null");
+  }
+  if (k == 0) {
+    return;
+  }
+
+  const QueryTimer timer(stats_enabled_);
+  QueryStats qs;
+  const std::size_t rows = published_.load();
+  const std::size_t live = rows - deleted_.count();
+  VECTORCORE_COUNT(qs.visited, rows);
+
+  // With rerank, collect k * rerank_factor code-space candidates and let the
+  // exact fp32 scores pick the final k.
+  const bool reranking = quantized() && rerank_factor_ > 0;
+  const std::size_t kk = reranking ? std::min(std::max(k, k * rerank_factor_), live) : std::min(k, live);
+
+  std::vector<float> unit;
+  if (metric_ == Metric::COSINE) {
+    unit.assign(query, query + dim_);
+    normalize(unit.data(), dim_);
+    query = unit.data();
+  }
+
+  PreparedQuery prepared;
+  quantizer_.prepare(query, prepared);
+
+  Selector best(kk);
+
+  if (num_threads == 1 || rows < 2 * kMinRowsPerTask) {
+    VECTORCORE_COUNT(qs.distances, scan_rows(prepared, 0, rows, filter, best));
+    VECTORCORE_COUNT(qs.heap_ops, best.accepted());
+    if (reranking) {
+      VECTORCORE_COUNT(qs.distances, best.size());
+      rerank(query, k, best);
+    }
+    write_results(best, k, out_ids, out_scores);
+    timer.finish(*stats_, qs);
+    return;
+  }
+
+  // Intra-query parallelism: each worker scans row ranges into its own
+  // top-kk selector; the partial results are merged at the end.
+  ThreadPool& pool = thread_pool();
+  const std::size_t threads = (num_threads == 0) ? pool.num_threads() : num_threads;
+  const std::size_t grain = std::max(kMinRowsPerTask, (rows + threads - 1) / threads);
+
+  const std::size_t parts = pool.participants(rows, grain, num_threads);
+  std::vector<Selector> partial(parts, Selector(kk));
+  std::vector<std::size_t> scored(parts, 0);
+  pool.parallel_for(rows, grain, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+    scored[worker] += scan_rows(prepared, begin, end, filter, partial[worker]);
+  }, num_threads);
+
+  for (std::size_t w = 0; w < parts; ++w) {
+    best.merge(partial[w]);
+    VECTORCORE_COUNT(qs.distances, scored[w]);
+    VECTORCORE_COUNT(qs.heap_ops, partial[w].accepted());
+  }
+  VECTORCORE_COUNT(qs.heap_ops, best.accepted());
+  if (reranking) {
+    VECTORCORE_COUNT(qs.distances, best.size());
+    rerank(query, k, best);
+  }
+  write_results(best, k, out_ids, out_scores);
+  timer.finish(*stats_, qs);
+}
+
+void BruteForceIndex::search_batch(const float* queries, std::size_t m, std::size_t k,
+                                   std::uint64_t* out_ids, float* out_scores, std::size_t num_threads,
+                                   const SearchFilter* filter) const {
+  if (!queries) {
+    throw std::invalid_argument("queries pointer is null");
+  }
+  if (!out_ids || !out_scores) {
+    throw std::invalid_argument("output pointers are null");
+  }
+  if (k == 0 || m == 0) {
+    return;
+  }
+
+  ThreadPool& pool = thread_pool();
+  const std::size_t threads = (num_threads == 0) ? pool.num_threads() : num_threads;
+
+  // The tiled scan is fp32-only; compressed rows are scanned per query.
+  if (quantized()) {
+    auto run = [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+      for (std::size_t i = begin; i < end; ++i) {
+        search(queries + (i * dim_), k, out_ids + (i * k), out_scores + (i * k), 1, filter);
+      }
+    };
+    if (num_threads == 1) {
+      run(0, m, 0);
+      return;
+    }
+    pool.parallel_for(m, std::max<std::size_t>(1, m / (threads * 4)), run, num_threads);
+    return;
+  }
+
+  // One row count for the whole batch, whichever task scans a query.
+  const std::size_t rows = published_.load();
+  if (num_threads == 1 || m == 1) {
+    search_batch_range(queries, m, k, out_ids, out_scores, filter, rows);
+    return;
+  }
+
+  // Split queries into contiguous ranges; each task runs the blocked scan on
+  // its range and writes straight into its rows of the output matrix. Ranges
+  // shrink below kQueryBlock only when there are too few queries to go round.
+  const std::size_t grain = std::min(kQueryBlock, (m + threads - 1) / threads);
+
+  pool.parallel_for(m, grain, [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+    search_batch_range(queries + (begin * dim_), end - begin, k, out_ids + (begin * k),
+                       out_scores + (begin * k), filter, rows);
+  }, num_threads);
+}
+
+void BruteForceIndex::search_batch_range(const float* queries, std::size_t m, std::size_t k,
+                                         std::uint64_t* out_ids, float* out_scores,
+                                         const SearchFilter* filter, std::size_t rows) const {
+  const std::size_t kk = std::min(k, rows - deleted_.count());
+  const std::size_t row_block = std::max<std::size_t>(1, kRowBlockBytes / (dim_ * sizeof(float)));
+  const bool l2 = (metric_ == Metric::L2_SQUARED);
+  const bool skip = deleted_.any() || filter != nullptr;
+
+  // One selector per query in the current query block, plus one row block
+  // of scores.
+  std::vector<Selector> tops(kQueryBlock, Selector(kk));
+  std::vector<float> query_norms(kQueryBlock);
+  std::vector<float> block(row_block);
+  std::vector<float> unit_queries(metric_ == Metric::COSINE ? kQueryBlock * dim_ : 0);
+
+  for (std::size_t q0 = 0; q0 < m; q0 += kQueryBlock) {
+    const std::size_t qn = std::min(kQueryBlock, m - q0);
+    const float* block_queries = queries + (q0 * dim_);
+    if (metric_ == Metric::COSINE) {
+      std::copy(block_queries, block_queries + (qn * dim_), unit_queries.begin());
+      normalize_rows(unit_queries.data(), qn, dim_);
+      block_queries = unit_queries.data();
+    }
+
+    for (std::size_t qi = 0; qi < qn; ++qi) {
+      const float* q = block_queries + (qi * dim_);
+      query_norms[qi] = l2 ? inner_product(q, q, dim_) : 0.0f;
+      tops[qi].reset(kk);
+    }
+
+    // The row block stays cache-resident while every query in the block scans it.
+    for (std::size_t r0 = 0; r0 < rows; r0 += row_block) {
+      const std::size_t r1 = std::min(rows, r0 + row_block);
+
+      for (std::size_t qi = 0; qi < qn; ++qi) {
+        const float* q = block_queries + (qi * dim_);
+        for (std::size_t r = r0; r < r1; ++r) {
+          if (skip && hidden(r, filter)) {
+            block[r - r0] = kRemoved;
+            continue;
+          }
+          const float ip = inner_product(q, embeddings_.data() + (r * dim_), dim_);
+
+          // Clamp: cancellation in the expansion can go slightly negative.
+          block[r - r0] = l2 ? std::max(0.0f, query_norms[qi] + norms_[r] - 2.0f * ip) : -ip;
+        }
+        tops[qi].push_block(block.data(), r0, r1 - r0);
+      }
+    }
+
+    for (std::size_t qi = 0; qi < qn; ++qi) {
+      write_results(tops[qi], k, out_ids + ((q0 + qi) * k), out_scores + ((q0 + qi) * k));
+    }
+  }
+}
+
+void BruteForceIndex::range_scan(const float* query, float radius, const SearchFilter* filter,
+                                 RangeSearchResult::Hits& hits) const {
+  std::vector<float> unit;
+  if (metric_ == Metric::COSINE) {
+    unit.assign(query, query + dim_);
+    normalize(unit.data(), dim_);
+    query = unit.data();
+  }
+
+  const float bound = badness_from_score(metric_, radius);
+  const bool skip = deleted_.any() || filter != nullptr;
+  const std::size_t rows = published_.load();
+
+  if (has_fp32()) {
+    const bool l2 = (metric_ == Metric::L2_SQUARED);
+    for (std::size_t r = 0; r < rows; ++r) {
+      if (skip && hidden(r, filter)) {
+        continue;
+      }
+      const float* vec = embeddings_.data() + (r * dim_);
+      const float b = l2 ? l2_squared_bounded(query, vec, dim_, bound) : -score(query, vec);
+      if (b <= bound) {
+        hits.emplace_back(b, ids_[r]);
+      }
+    }
+    return;
+  }
+
+  PreparedQuery prepared;
+  quantizer_.prepare(query, prepared);
+  const std::size_t code_size = quantizer_.code_size();
+  for (std::size_t r = 0; r < rows; ++r) {
+    if (skip && hidden(r, filter)) {
+      continue;
+    }
+    const float b = badness_from_score(metric_, quantizer_.score(prepared, codes_.data() + (r * code_size)));
+    if (b <= bound) {
+      hits.emplace_back(b, ids_[r]);
+    }
+  }
+}
+
+void BruteForceIndex::range_search(const float* queries, std::size_t m, float radius, RangeSearchResult& out,
+                                   std::size_t num_threads, const SearchFilter* filter) const {
+  if (!queries && m > 0) {
+    throw std::invalid_argument("queries pointer is null");
+  }
+
+  // Each query collects its hits separately; assign() lays them out once
+  // every count is known.
+  std::vector<RangeSearchResult::Hits> hits(m);
+  auto run = [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+    for (std::size_t i = begin; i < end; ++i) {
+      range_scan(queries + (i * dim_), radius, filter, hits[i]);
+    }
+  };
+
+  if (num_threads == 1 || m <= 1) {
+    run(0, m, 0);
+  } else {
+    ThreadPool& pool = thread_pool();
+    const std::size_t threads = (num_threads == 0) ? pool.num_threads() : num_threads;
+    pool.parallel_for(m, std::max<std::size_t>(1, m / (threads * 4)), run, num_threads);
+  }
+  out.assign(hits, metric_);
+}
+
+void BruteForceIndex::save(const std::string& path) const {
+  IndexWriter writer(IndexKind::BRUTE_FORCE);
+  IndexFileHeader& h = writer.header();
+  h.metric = static_cast<std::uint32_t>(metric_);
+  h.storage = static_cast<std::uint32_t>(quantizer_.storage());
+  h.dim = dim_;
+  h.size = size_;
+  h.rerank_factor = rerank_factor_;
+  h.params[0] = next_id_;
+
+  writer.add(Section::EMBEDDINGS, embeddings_.data(), embeddings_.size());
+  writer.add(Section::IDS, ids_.data(), ids_.size());
+  writer.add(Section::TOMBSTONES, deleted_.words().data(), deleted_.words().size());
+  writer.add(Section::NORMS, norms_.data(), norms_.size());
+  writer.add(Section::CODES, codes_.data(), codes_.size());
+  writer.add(Section::SQ_VMIN, quantizer_.vmin().data(), quantizer_.vmin().size());
+  writer.add(Section::SQ_SCALE, quantizer_.scale().data(), quantizer_.scale().size());
+  writer.write(path);
+}
+
+BruteForceIndex BruteForceIndex::load(const std::string& path, bool mmap) {
+  const IndexReader reader(path, IndexKind::BRUTE_FORCE, mmap);
+  const IndexFileHeader& h = reader.header();
+
+  BruteForceIndex index(static_cast<std::size_t>(h.dim), static_cast<Metric>(h.metric),
+                        static_cast<Storage>(h.storage), static_cast<std::size_t>(h.rerank_factor));
+  const std::size_t n = static_cast<std::size_t>(h.size);
+  const bool quantized = index.quantized();
+
+  // INT8 ranges are absent when the index was saved before training.
+  if (reader.count(Section::SQ_VMIN, sizeof(float)) > 0) {
+    index.quantizer_.restore(reader.copy<float>(Section::SQ_VMIN, index.dim_),
+                             reader.copy<float>(Section::SQ_SCALE, index.dim_));
+  }
+
+  reader.view(Section::EMBEDDINGS, (!quantized || index.rerank_factor_ > 0) ? n * index.dim_ : 0, index.embeddings_);
+  reader.view(Section::IDS, n, index.ids_);
+  reader.view(Section::NORMS, quantized ? 0 : n, index.norms_);
+  reader.view(Section::CODES, quantized ? n * index.quantizer_.code_size() : 0, index.codes_);
+
+  FlatArray<std::uint64_t> deleted;
+  const std::size_t words = reader.count(Section::TOMBSTONES, sizeof(std::uint64_t));
+  if (words > (n + 63) / 64) {
+    throw std::runtime_error("index file '" + path + "': corrupt tombstone bitmap");
+  }
+  reader.view(Section::TOMBSTONES, words, deleted);
+  index.deleted_.restore(std::move(deleted));
+
+  index.size_ = n;
+  index.published_.publish(n);
+  index.next_id_ = std::max<std::uint64_t>(h.params[0], n);
+  return index;
+}
+
 } // namespace vectorcore
@@ -0,0 +1,338 @@
+#include "vectorcore/bulk_loader.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "vectorcore/distance.h"
+
+namespace vectorcore {
+
+namespace {
+
+constexpr char kNpyMagic[6] = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+
+std::uint32_t read_le32(const std::uint8_t* p) noexcept {
+  return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+         (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+// Value of `'key': <value>` in a .npy header dict, up to the next top-level
+// ',' or '}' (a tuple value keeps its commas). Empty if the key is absent.
+std::string npy_field(const std::string& header, const char* key) {
+  const std::string quoted = std::string("'") + key + "'";
+  std::size_t pos = header.find(quoted);
+  if (pos == std::string::npos) {
+    return {};
+  }
+  pos = header.find(':', pos + quoted.size());
+  if (pos == std::string::npos) {
+    return {};
+  }
+  std::size_t begin = header.find_first_not_of(' ', pos + 1);
+  if (begin == std::string::npos) {
+    return {};
+  }
+  std::size_t end = begin;
+  if (header[begin] == '(') {
+    end = header.find(')', begin);
+    end = (end == std::string::npos) ? header.size() : end + 1;
+  } else {
+    end = header.find_first_of(",}", begin);
+    end = (end == std::string::npos) ? header.size() : end;
+  }
+  while (end > begin && header[end - 1] == ' ') {
+    --end;
+  }
+  return header.substr(begin, end - begin);
+}
+
+// Parses "(rows, dim)" (also "(rows, dim,)"), the only shape loaded.
+bool parse_shape(const std::string& tuple, std::size_t& rows, std::size_t& dim) {
+  std::vector<std::size_t> extents;
+  std::size_t i = 1;
+  while (i < tuple.size()) {
+    while (i < tuple.size() && (tuple[i] == ' ' || tuple[i] == ',')) {
+      ++i;
+    }
+    if (i >= tuple.size() || tuple[i] == ')') {
+      break;
+    }
+    if (tuple[i] < '0' || tuple[i] > '9') {
+      return false;
+    }
+    std::size_t v = 0;
+    for (; i < tuple.size() && tuple[i] >= '0' && tuple[i] <= '9'; ++i) {
+      v = v * 10 + static_cast<std::size_t>(tuple[i] - '0');
+    }
+    extents.push_back(v);
+  }
+  if (tuple.empty() || tuple.front() != '(' || extents.size() != 2) {
+    return false;
+  }
+  rows = extents[0];
+  dim = extents[1];
+  return true;
+}
+
+// A batch buffer passed between the reader and the adding thread.
+struct Batch {
+  std::vector<float> rows;
+  std::size_t n = 0;
+};
+
+// Unbounded by itself; the pipeline bounds it by owning a fixed number of
+// Batch buffers that cycle between a free and a filled queue.
+class BatchQueue {
+public:
+  void push(Batch batch) {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      items_.push_back(std::move(batch));
+    }
+    ready_.notify_one();
+  }
+
+  // Blocks for the next batch; false once closed and drained.
+  bool pop(Batch& out) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return closed_ || !items_.empty(); });
+    if (items_.empty()) {
+      return false;
+    }
+    out = std::move(items_.front());
+    items_.pop_front();
+    return true;
+  }
+
+  // No more pushes; `drop` also discards what is still queued.
+  void close(bool drop = false) {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+      if (drop) {
+        items_.clear();
+      }
+    }
+    ready_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<Batch> items_;
+  bool closed_ = false;
+};
+
+} // namespace
+
+VectorFileReader::VectorFileReader(const std::string& path, FileFormat format) : path_(path), format_(format) {
+  in_.open(path, std::ios::binary | std::ios::ate);
+  if (!in_) {
+    fail("cannot open");
+  }
+  const auto file_size = static_cast<std::size_t>(in_.tellg());
+  in_.seekg(0);
+  if (format_ == FileFormat::NPY) {
+    open_npy(file_size);
+  } else {
+    open_vecs(file_size);
+  }
+}
+
+void VectorFileReader::fail(const std::string& what) const {
+  throw std::runtime_error("vector file '" + path_ + "': " + what);
+}
+
+void VectorFileReader::open_vecs(std::size_t file_size) {
+  element_ = (format_ == FileFormat::BVECS) ? Element::U8 : Element::F32;
+  std::uint8_t prefix[4];
+  if (file_size < sizeof(prefix) || !in_.read(reinterpret_cast<char*>(prefix), sizeof(prefix))) {
+    fail("no rows");
+  }
+  const auto d = static_cast<std::int32_t>(read_le32(prefix));
+  if (d <= 0) {
+    fail("bad row dimension " + std::to_string(d));
+  }
+  dim_ = static_cast<std::size_t>(d);
+  row_prefix_ = sizeof(prefix);
+
+  // Every row has the same length, so the file size fixes the row count.
+  const std::size_t row_bytes = row_prefix_ + dim_ * element_bytes();
+  if (file_size % row_bytes != 0) {
+    fail("size is not a whole number of " + std::to_string(dim_) + "-dimensional rows");
+  }
+  rows_ = file_size / row_bytes;
+  in_.seekg(0);
+}
+
+void VectorFileReader::open_npy(std::size_t file_size) {
+  std::uint8_t preamble[12];
+  if (file_size < 10 || !in_.read(reinterpret_cast<char*>(preamble), 10) ||
+      std::memcmp(preamble, kNpyMagic, sizeof(kNpyMagic)) != 0) {
+    fail("not a .npy file");
+  }
+
+  // Version 1 has a 2-byte header length, versions 2 and 3 a 4-byte one.
+  const std::uint8_t major = preamble[6];
+  std::size_t header_len = 0;
+  std::size_t offset = 0;
+  if (major == 1) {
+    header_len = static_cast<std::size_t>(preamble[8]) | (static_cast<std::size_t>(preamble[9]) << 8);
+    offset = 10;
+  } else if (major == 2 || major == 3) {
+    if (!in_.read(reinterpret_cast<char*>(preamble + 10), 2)) {
+      fail("truncated header");
+    }
+    header_len = read_le32(preamble + 8);
+    offset = 12;
+  } else {
+    fail("unsupported .npy version " + std::to_string(major));
+  }
+  if (header_len > file_size - offset) {
+    fail("truncated header");
+  }
+  std::string header(header_len, '\0');
+  if (!in_.read(&header[0], static_cast<std::streamsize>(header_len))) {
+    fail("truncated header");
+  }
+  offset += header_len;
+
+  const std::string descr = npy_field(header, "descr");
+  if (descr == "'<f4'") {
+    element_ = Element::F32;
+  } else if (descr == "'<f2'") {
+    element_ = Element::F16;
+  } else if (descr == "'|u1'") {
+    element_ = Element::U8;
+  } else {
+    fail("unsupported dtype " + (descr.empty() ? std::string("(none)") : descr) + " (need <f4, <f2 or |u1)");
+  }
+  if (npy_field(header, "fortran_order") != "False") {
+    fail("Fortran-order arrays are not supported");
+  }
+  if (!parse_shape(npy_field(header, "shape"), rows_, dim_) || dim_ == 0) {
+    fail("need a 2-D array with dim > 0");
+  }
+
+  if (file_size - offset != rows_ * dim_ * element_bytes()) {
+    fail("data size does not match shape (" + std::to_string(rows_) + ", " + std::to_string(dim_) + ")");
+  }
+}
+
+std::size_t VectorFileReader::read(float* out, std::size_t max_rows) {
+  const std::size_t n = std::min(max_rows, rows_ - next_);
+  if (n == 0) {
+    return 0;
+  }
+
+  const std::size_t row_bytes = row_prefix_ + dim_ * element_bytes();
+  const std::size_t bytes = n * row_bytes;
+
+  // Contiguous fp32 (.npy <f4) goes straight into the output.
+  if (row_prefix_ == 0 && element_ == Element::F32) {
+    if (!in_.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(bytes))) {
+      fail("truncated at row " + std::to_string(next_));
+    }
+    next_ += n;
+    return n;
+  }
+
+  raw_.resize(bytes);
+  if (!in_.read(reinterpret_cast<char*>(raw_.data()), static_cast<std::streamsize>(bytes))) {
+    fail("truncated at row " + std::to_string(next_));
+  }
+  const DistanceKernels& k = distance_kernels();
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::uint8_t* row = raw_.data() + (i * row_bytes);
+    if (row_prefix_ != 0 && read_le32(row) != dim_) {
+      fail("bad row dimension at row " + std::to_string(next_ + i));
+    }
+    const std::uint8_t* values = row + row_prefix_;
+    float* dst = out + (i * dim_);
+    switch (element_) {
+      case Element::F32:
+        std::memcpy(dst, values, dim_ * sizeof(float));
+        break;
+      case Element::F16:
+        // .npy rows are 2 * dim_ bytes, so each starts 2-byte aligned in raw_.
+        k.fp16_to_fp32(reinterpret_cast<const std::uint16_t*>(values), dst, dim_);
+        break;
+      case Element::U8:
+        for (std::size_t d = 0; d < dim_; ++d) {
+          dst[d] = static_cast<float>(values[d]);
+        }
+        break;
+    }
+  }
+  next_ += n;
+  return n;
+}
+
+std::size_t stream_file(const std::string& path, FileFormat format, std::size_t dim, std::size_t batch_size,
+                        const AddBatchFn& add) {
+  if (batch_size == 0) {
+    throw std::invalid_argument("batch_size must be > 0");
+  }
+  VectorFileReader reader(path, format);
+  if (reader.dim() != dim) {
+    throw std::invalid_argument("vector file '" + path + "' has dim " + std::to_string(reader.dim()) +
+                                ", the index has dim " + std::to_string(dim));
+  }
+  if (reader.rows() == 0) {
+    return 0;
+  }
+
+  // Three buffers: one being parsed, one queued, one being added.
+  constexpr std::size_t kBuffers = 3;
+  const std::size_t batch_rows = std::min(batch_size, reader.rows());
+  BatchQueue free_batches;
+  BatchQueue full_batches;
+  for (std::size_t i = 0; i < kBuffers; ++i) {
+    free_batches.push(Batch{std::vector<float>(batch_rows * dim), 0});
+  }
+
+  std::exception_ptr read_error;
+  std::thread producer([&] {
+    try {
+      Batch batch;
+      while (free_batches.pop(batch)) {
+        batch.n = reader.read(batch.rows.data(), batch_rows);
+        if (batch.n == 0) {
+          break;
+        }
+        full_batches.push(std::move(batch));
+      }
+    } catch (...) {
+      read_error = std::current_exception();
+    }
+    full_batches.close();
+  });
+
+  std::size_t added = 0;
+  try {
+    Batch batch;
+    while (full_batches.pop(batch)) {
+      add(batch.rows.data(), batch.n);
+      added += batch.n;
+      free_batches.push(std::move(batch));
+    }
+  } catch (...) {
+    free_batches.close(true);
+    producer.join();
+    throw;
+  }
+  producer.join();
+  if (read_error) {
+    std::rethrow_exception(read_error);
+  }
+  return added;
+}
+
+} // namespace vectorcore
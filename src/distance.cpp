@@ -1,6 +1,18 @@
 #include "vectorcore/distance.h"
 
-#include <immintrin.h>
+#include <cmath>
+#include <cstring>
+
+#include "vectorcore/float16.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define VECTORCORE_X86 1
+  #if defined(_MSC_VER)
+    #include <intrin.h> // __cpuidex, _xgetbv
+  #else
+    #include <cpuid.h>  // __get_cpuid_count
+  #endif
+#endif
 
 namespace vectorcore {
 
@@ -21,85 +33,233 @@ float inner_product_scalar(const float* a, const float* b, std::size_t dim) noex
   return acc;
 }
 
-// AVX2 kernels
-// Note: We keep these functions available even when AVX2 isn't enabled;
-// the dispatcher will call scalar fallbacks when __AVX2__ is not defined.
-
-float l2_squared_avx2(const float* a, const float* b, std::size_t dim) noexcept {
-#if defined(__AVX2__)
-  __m256 sum = _mm256_setzero_ps();
-  std::size_t i = 0;
-
-  // Process 8 floats per iteration.
-  for (; i + 8 <= dim; i += 8) {
-    const __m256 va = _mm256_loadu_ps(a + i);
-    const __m256 vb = _mm256_loadu_ps(b + i);
-    const __m256 diff = _mm256_sub_ps(va, vb);
-    sum = _mm256_fmadd_ps(diff, diff, sum); // sum += diff * diff
+float l2_squared_sq8_scalar(const float* a, const float* scale, const std::uint8_t* codes,
+                            std::size_t dim) noexcept {
+  float acc = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) {
+    const float d = a[i] - scale[i] * static_cast<float>(codes[i]);
+    acc += d * d;
   }
+  return acc;
+}
 
-  // Horizontal sum of sum's lanes.
-  alignas(32) float tmp[8];
-  _mm256_store_ps(tmp, sum);
-  float acc = tmp[0] + tmp[1] + tmp[2] + tmp[3] + tmp[4] + tmp[5] + tmp[6] + tmp[7];
+float inner_product_sq8_scalar(const float* a, const std::uint8_t* codes, std::size_t dim) noexcept {
+  float acc = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) {
+    acc += a[i] * static_cast<float>(codes[i]);
+  }
+  return acc;
+}
 
-  // Tail.
-  for (; i < dim; ++i) {
-    const float d = a[i] - b[i];
+float l2_squared_fp16_scalar(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept {
+  float acc = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) {
+    const float d = a[i] - half_to_float(codes[i]);
     acc += d * d;
   }
+  return acc;
+}
 
+float inner_product_fp16_scalar(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept {
+  float acc = 0.0f;
+  for (std::size_t i = 0; i < dim; ++i) {
+    acc += a[i] * half_to_float(codes[i]);
+  }
   return acc;
-#else
-  (void)a;
-  (void)b;
-  (void)dim;
-  return 0.0f;
-#endif
 }
 
-float inner_product_avx2(const float* a, const float* b, std::size_t dim) noexcept {
-#if defined(__AVX2__)
-  __m256 sum = _mm256_setzero_ps();
-  std::size_t i = 0;
+float pq_adc_scalar(const float* table, const std::uint8_t* codes, std::size_t m) noexcept {
+  float acc = 0.0f;
+  for (std::size_t s = 0; s < m; ++s) {
+    acc += table[(s * 256) + codes[s]];
+  }
+  return acc;
+}
 
-  for (; i + 8 <= dim; i += 8) {
-    const __m256 va = _mm256_loadu_ps(a + i);
-    const __m256 vb = _mm256_loadu_ps(b + i);
-    sum = _mm256_fmadd_ps(va, vb, sum);
+std::uint32_t hamming_scalar(const std::uint8_t* a, const std::uint8_t* b, std::size_t bytes) noexcept {
+  // Word at a time, with the classic SWAR bit count (compilers with a
+  // popcount instruction available turn it into one).
+  std::uint32_t count = 0;
+  std::size_t i = 0;
+  for (; i + 8 <= bytes; i += 8) {
+    std::uint64_t x, y;
+    std::memcpy(&x, a + i, sizeof(x));
+    std::memcpy(&y, b + i, sizeof(y));
+    std::uint64_t v = x ^ y;
+    v -= (v >> 1) & 0x5555555555555555ull;
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    count += static_cast<std::uint32_t>((v * 0x0101010101010101ull) >> 56);
   }
+  for (; i < bytes; ++i) {
+    for (unsigned v = a[i] ^ b[i]; v != 0; v &= v - 1) {
+      ++count;
+    }
+  }
+  return count;
+}
 
-  alignas(32) float tmp[8];
-  _mm256_store_ps(tmp, sum);
-  float acc = tmp[0] + tmp[1] + tmp[2] + tmp[3] + tmp[4] + tmp[5] + tmp[6] + tmp[7];
+void fp16_to_fp32_scalar(const std::uint16_t* src, float* dst, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; ++i) {
+    dst[i] = half_to_float(src[i]);
+  }
+}
 
-  for (; i < dim; ++i) {
-    acc += a[i] * b[i];
+void bf16_to_fp32_scalar(const std::uint16_t* src, float* dst, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n; ++i) {
+    dst[i] = bfloat16_to_float(src[i]);
   }
+}
 
-  return acc;
+namespace {
+
+#if defined(VECTORCORE_X86)
+struct CpuidRegs {
+  unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+};
+
+CpuidRegs cpuid(unsigned leaf, unsigned subleaf) noexcept {
+  CpuidRegs r;
+#if defined(_MSC_VER)
+  int regs[4];
+  __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+  r.eax = static_cast<unsigned>(regs[0]);
+  r.ebx = static_cast<unsigned>(regs[1]);
+  r.ecx = static_cast<unsigned>(regs[2]);
+  r.edx = static_cast<unsigned>(regs[3]);
 #else
-  (void)a;
-  (void)b;
-  (void)dim;
-  return 0.0f;
+  __get_cpuid_count(leaf, subleaf, &r.eax, &r.ebx, &r.ecx, &r.edx);
 #endif
+  return r;
 }
 
-float l2_squared(const float* a, const float* b, std::size_t dim) noexcept {
-#if defined(__AVX2__)
-  return l2_squared_avx2(a, b, dim);
+// XCR0: which register files the OS saves on context switch.
+unsigned long long xgetbv0() noexcept {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
 #else
-  return l2_squared_scalar(a, b, dim);
+  unsigned eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<unsigned long long>(edx) << 32) | eax;
 #endif
 }
 
-float inner_product(const float* a, const float* b, std::size_t dim) noexcept {
-#if defined(__AVX2__)
-  return inner_product_avx2(a, b, dim);
-#else
-  return inner_product_scalar(a, b, dim);
+struct X86Features {
+  bool avx2 = false;            // AVX2 + FMA + F16C, YMM state enabled
+  bool avx512f = false;         // AVX-512F, ZMM/opmask state enabled
+  bool avx512_vpopcntdq = false; // AVX512_VPOPCNTDQ on top of avx512f
+};
+
+X86Features detect_x86() noexcept {
+  X86Features f;
+
+  const unsigned max_leaf = cpuid(0, 0).eax;
+  if (max_leaf < 7) {
+    return f;
+  }
+
+  const CpuidRegs l1 = cpuid(1, 0);
+  const bool osxsave = (l1.ecx >> 27) & 1u;
+  const bool avx = (l1.ecx >> 28) & 1u;
+  const bool fma = (l1.ecx >> 12) & 1u;
+  const bool f16c = (l1.ecx >> 29) & 1u;
+  if (!osxsave || !avx) {
+    return f;
+  }
+
+  // Instruction support is not enough: the OS must also preserve the wider
+  // registers, otherwise the first AVX instruction faults.
+  const unsigned long long xcr0 = xgetbv0();
+  const bool ymm_state = (xcr0 & 0x6) == 0x6;    // XMM | YMM
+  const bool zmm_state = (xcr0 & 0xE6) == 0xE6;  // + opmask | ZMM_Hi256 | Hi16_ZMM
+
+  const CpuidRegs l7 = cpuid(7, 0);
+  f.avx2 = ymm_state && fma && f16c && ((l7.ebx >> 5) & 1u);
+  f.avx512f = f.avx2 && zmm_state && ((l7.ebx >> 16) & 1u);
+  f.avx512_vpopcntdq = f.avx512f && ((l7.ecx >> 14) & 1u);
+  return f;
+}
+#endif
+
+// Fixed-size so detection never allocates (distance_kernels() is noexcept).
+struct KernelList {
+  DistanceKernels items[4];
+  std::size_t count = 0;
+
+  void push(const DistanceKernels& k) noexcept { items[count++] = k; }
+};
+
+KernelList detect_supported() noexcept {
+  KernelList out;
+  out.push(DistanceKernels{});
+
+#if defined(VECTORCORE_X86)
+  const X86Features cpu = detect_x86();
+  #if defined(VECTORCORE_HAVE_AVX2)
+  if (cpu.avx2) {
+    out.push(DistanceKernels{"avx2", &l2_squared_avx2, &inner_product_avx2,
+                             &l2_squared_sq8_avx2, &inner_product_sq8_avx2,
+                             &l2_squared_fp16_avx2, &inner_product_fp16_avx2, &pq_adc_avx2,
+                             &l2_squared_fixed_avx2, &inner_product_fixed_avx2,
+                             &fp16_to_fp32_avx2, &bf16_to_fp32_avx2, &hamming_avx2});
+  }
+  #endif
+  #if defined(VECTORCORE_HAVE_AVX512)
+  if (cpu.avx512f) {
+    // Without VPOPCNTDQ the best bit count is AVX2's nibble lookup (plain
+    // AVX-512F has no byte shuffle).
+    const HammingFn hamming = cpu.avx512_vpopcntdq ? &hamming_avx512 : out.items[out.count - 1].hamming;
+    out.push(DistanceKernels{"avx512", &l2_squared_avx512, &inner_product_avx512,
+                             &l2_squared_sq8_avx512, &inner_product_sq8_avx512,
+                             &l2_squared_fp16_avx512, &inner_product_fp16_avx512, &pq_adc_avx512,
+                             &l2_squared_fixed_avx512, &inner_product_fixed_avx512,
+                             &fp16_to_fp32_avx512, &bf16_to_fp32_avx512, hamming});
+  }
+  #endif
+  (void)cpu;
+#endif
+
+#if defined(VECTORCORE_HAVE_NEON)
+  // NEON (ASIMD) is mandatory on AArch64, so building it is enough.
+  out.push(DistanceKernels{"neon", &l2_squared_neon, &inner_product_neon,
+                           &l2_squared_sq8_neon, &inner_product_sq8_neon,
+                           &l2_squared_fp16_neon, &inner_product_fp16_neon, &pq_adc_neon});
 #endif
+
+  return out;
+}
+
+} // namespace
+
+std::vector<DistanceKernels> supported_distance_kernels() {
+  const KernelList list = detect_supported();
+  return std::vector<DistanceKernels>(list.items, list.items + list.count);
+}
+
+const DistanceKernels& distance_kernels() noexcept {
+  // Thread-safe one-time initialization (C++11 magic statics).
+  static const DistanceKernels active = [] {
+    const KernelList list = detect_supported();
+    return list.items[list.count - 1];
+  }();
+  return active;
+}
+
+void normalize(float* v, std::size_t dim) noexcept {
+  const float sq = inner_product(v, v, dim);
+  if (!(sq > 0.0f)) {
+    return;
+  }
+  const float inv = 1.0f / std::sqrt(sq);
+  for (std::size_t d = 0; d < dim; ++d) {
+    v[d] *= inv;
+  }
+}
+
+void normalize_rows(float* x, std::size_t n, std::size_t dim) noexcept {
+  for (std::size_t i = 0; i < n; ++i) {
+    normalize(x + (i * dim), dim);
+  }
 }
 
 } // namespace vectorcore
@@ -0,0 +1,288 @@
+#include "vectorcore/distance.h"
+
+// Built with AVX2 + FMA + F16C target flags (see CMakeLists.txt). Only reached
+// through the runtime dispatcher in distance.cpp after cpuid confirms support.
+
+#include "vectorcore/float16.h"
+
+#include <immintrin.h>
+
+namespace vectorcore {
+
+namespace {
+
+inline float hsum256(__m256 v) noexcept {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+
+// Lane mask for the first n (< 8) floats: a window into -1 x 8, 0 x 8.
+alignas(32) constexpr std::int32_t kTailMask[16] = {-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+inline __m256i tail_mask(std::size_t n) noexcept {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kTailMask + 8 - n));
+}
+
+// fp32 kernels
+// ------------
+// Four independent accumulators over 32 floats per step keep both FMA ports
+// busy instead of waiting out one long dependency chain. Leftover groups of
+// 8 and a masked tail (masked-off lanes load as 0, and never fault) go into
+// the same accumulators, which are reduced pairwise at the end.
+//
+// kFixed > 0 is the specialization for dim == kFixed (a multiple of 32):
+// the trip count is a constant, so the loop is unrolled completely and the
+// remainder code disappears. For a given dim it adds in exactly the same
+// order as the generic kernel, so both return bit-identical results.
+
+struct L2Step {
+  static __m256 apply(__m256 acc, __m256 a, __m256 b) noexcept {
+    const __m256 d = _mm256_sub_ps(a, b);
+    return _mm256_fmadd_ps(d, d, acc);
+  }
+};
+
+struct IpStep {
+  static __m256 apply(__m256 acc, __m256 a, __m256 b) noexcept { return _mm256_fmadd_ps(a, b, acc); }
+};
+
+template <typename Step>
+struct Fp32Accumulators {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+
+  void step32(const float* a, const float* b) noexcept {
+    acc0 = Step::apply(acc0, _mm256_loadu_ps(a), _mm256_loadu_ps(b));
+    acc1 = Step::apply(acc1, _mm256_loadu_ps(a + 8), _mm256_loadu_ps(b + 8));
+    acc2 = Step::apply(acc2, _mm256_loadu_ps(a + 16), _mm256_loadu_ps(b + 16));
+    acc3 = Step::apply(acc3, _mm256_loadu_ps(a + 24), _mm256_loadu_ps(b + 24));
+  }
+
+  float sum() const noexcept { return hsum256(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3))); }
+};
+
+template <typename Step, std::size_t kFixed>
+float fp32_kernel(const float* a, const float* b, std::size_t dim) noexcept {
+  Fp32Accumulators<Step> acc;
+  if constexpr (kFixed > 0) {
+    static_assert(kFixed % 32 == 0, "fixed dimensions are whole 32-float steps");
+#if defined(__GNUC__)
+  #pragma GCC unroll 48
+#endif
+    for (std::size_t i = 0; i < kFixed; i += 32) {
+      acc.step32(a + i, b + i);
+    }
+    return acc.sum();
+  }
+
+  std::size_t i = 0;
+  for (; i + 32 <= dim; i += 32) {
+    acc.step32(a + i, b + i);
+  }
+  for (; i + 8 <= dim; i += 8) {
+    acc.acc0 = Step::apply(acc.acc0, _mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+  }
+  if (i < dim) {
+    const __m256i mask = tail_mask(dim - i);
+    acc.acc1 = Step::apply(acc.acc1, _mm256_maskload_ps(a + i, mask), _mm256_maskload_ps(b + i, mask));
+  }
+  return acc.sum();
+}
+
+template <typename Step>
+DistanceFn fp32_fixed(std::size_t dim) noexcept {
+  switch (dim) {
+    case 128:
+      return &fp32_kernel<Step, 128>;
+    case 256:
+      return &fp32_kernel<Step, 256>;
+    case 384:
+      return &fp32_kernel<Step, 384>;
+    case 512:
+      return &fp32_kernel<Step, 512>;
+    case 768:
+      return &fp32_kernel<Step, 768>;
+    case 1024:
+      return &fp32_kernel<Step, 1024>;
+    case 1536:
+      return &fp32_kernel<Step, 1536>;
+    default:
+      return nullptr;
+  }
+}
+
+} // namespace
+
+float l2_squared_avx2(const float* a, const float* b, std::size_t dim) noexcept {
+  return fp32_kernel<L2Step, 0>(a, b, dim);
+}
+
+float inner_product_avx2(const float* a, const float* b, std::size_t dim) noexcept {
+  return fp32_kernel<IpStep, 0>(a, b, dim);
+}
+
+DistanceFn l2_squared_fixed_avx2(std::size_t dim) noexcept {
+  return fp32_fixed<L2Step>(dim);
+}
+
+DistanceFn inner_product_fixed_avx2(std::size_t dim) noexcept {
+  return fp32_fixed<IpStep>(dim);
+}
+
+namespace {
+// 8 uint8 codes -> 8 floats.
+inline __m256 load_u8x8(const std::uint8_t* p) noexcept {
+  const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+  return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+}
+
+// 8 binary16 codes -> 8 floats (F16C).
+inline __m256 load_f16x8(const std::uint16_t* p) noexcept {
+  return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+} // namespace
+
+float l2_squared_sq8_avx2(const float* a, const float* scale, const std::uint8_t* codes,
+                          std::size_t dim) noexcept {
+  __m256 sum = _mm256_setzero_ps();
+  std::size_t i = 0;
+
+  for (; i + 8 <= dim; i += 8) {
+    const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(scale + i), load_u8x8(codes + i));
+    const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(a + i), x);
+    sum = _mm256_fmadd_ps(diff, diff, sum);
+  }
+
+  float acc = hsum256(sum);
+  for (; i < dim; ++i) {
+    const float d = a[i] - scale[i] * static_cast<float>(codes[i]);
+    acc += d * d;
+  }
+  return acc;
+}
+
+float inner_product_sq8_avx2(const float* a, const std::uint8_t* codes, std::size_t dim) noexcept {
+  __m256 sum = _mm256_setzero_ps();
+  std::size_t i = 0;
+
+  for (; i + 8 <= dim; i += 8) {
+    sum = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), load_u8x8(codes + i), sum);
+  }
+
+  float acc = hsum256(sum);
+  for (; i < dim; ++i) {
+    acc += a[i] * static_cast<float>(codes[i]);
+  }
+  return acc;
+}
+
+float l2_squared_fp16_avx2(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept {
+  __m256 sum = _mm256_setzero_ps();
+  std::size_t i = 0;
+
+  for (; i + 8 <= dim; i += 8) {
+    const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(a + i), load_f16x8(codes + i));
+    sum = _mm256_fmadd_ps(diff, diff, sum);
+  }
+
+  float acc = hsum256(sum);
+  for (; i < dim; ++i) {
+    const float d = a[i] - half_to_float(codes[i]);
+    acc += d * d;
+  }
+  return acc;
+}
+
+float inner_product_fp16_avx2(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept {
+  __m256 sum = _mm256_setzero_ps();
+  std::size_t i = 0;
+
+  for (; i + 8 <= dim; i += 8) {
+    sum = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), load_f16x8(codes + i), sum);
+  }
+
+  float acc = hsum256(sum);
+  for (; i < dim; ++i) {
+    acc += a[i] * half_to_float(codes[i]);
+  }
+  return acc;
+}
+
+float pq_adc_avx2(const float* table, const std::uint8_t* codes, std::size_t m) noexcept {
+  // Lane j gathers table[(s + j) * 256 + codes[s + j]].
+  const __m256i row = _mm256_setr_epi32(0, 256, 512, 768, 1024, 1280, 1536, 1792);
+  __m256 sum = _mm256_setzero_ps();
+  std::size_t s = 0;
+
+  for (; s + 8 <= m; s += 8) {
+    const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + s));
+    const __m256i idx = _mm256_add_epi32(_mm256_cvtepu8_epi32(bytes), row);
+    sum = _mm256_add_ps(sum, _mm256_i32gather_ps(table + (s * 256), idx, 4));
+  }
+
+  float acc = hsum256(sum);
+  for (; s < m; ++s) {
+    acc += table[(s * 256) + codes[s]];
+  }
+  return acc;
+}
+
+std::uint32_t hamming_avx2(const std::uint8_t* a, const std::uint8_t* b, std::size_t bytes) noexcept {
+  // Bit counts per nibble by table lookup (vpshufb), summed into four
+  // 64-bit lanes with vpsadbw; the last < 32 bytes go through the scalar
+  // kernel.
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0F);
+  __m256i total = _mm256_setzero_si256();
+  std::size_t i = 0;
+
+  for (; i + 32 <= bytes; i += 32) {
+    const __m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m256i bits = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(x, low)),
+                                         _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), low)));
+    total = _mm256_add_epi64(total, _mm256_sad_epu8(bits, _mm256_setzero_si256()));
+  }
+
+  alignas(32) std::uint64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), total);
+  const std::uint64_t count = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  return static_cast<std::uint32_t>(count) + hamming_scalar(a + i, b + i, bytes - i);
+}
+
+// Input conversion. bf16 -> fp32 is a 16-bit shift into the high half,
+// which plain AVX2 does exactly; AVX-512-BF16 adds nothing for this
+// direction.
+namespace {
+inline __m256 load_bf16x8(const std::uint16_t* p) noexcept {
+  const __m256i words = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(words, 16));
+}
+} // namespace
+
+void fp16_to_fp32_avx2(const std::uint16_t* src, float* dst, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(dst + i, load_f16x8(src + i));
+  }
+  for (; i < n; ++i) {
+    dst[i] = half_to_float(src[i]);
+  }
+}
+
+void bf16_to_fp32_avx2(const std::uint16_t* src, float* dst, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(dst + i, load_bf16x8(src + i));
+  }
+  for (; i < n; ++i) {
+    dst[i] = bfloat16_to_float(src[i]);
+  }
+}
+
+} // namespace vectorcore
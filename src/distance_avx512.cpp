@@ -0,0 +1,312 @@
+#include "vectorcore/distance.h"
+
+// Built with AVX-512F target flags (see CMakeLists.txt). Only reached
+// through the runtime dispatcher in distance.cpp after cpuid confirms support.
+
+#include <immintrin.h>
+
+namespace vectorcore {
+
+namespace {
+
+// fp32 kernels: the AVX2 scheme (see distance_avx2.cpp) at twice the width.
+// Four accumulators over 64 floats per step, then groups of 16, then one
+// masked tail; kFixed > 0 specializes for dim == kFixed (a multiple of 64)
+// with bit-identical results.
+
+struct L2Step {
+  static __m512 apply(__m512 acc, __m512 a, __m512 b) noexcept {
+    const __m512 d = _mm512_sub_ps(a, b);
+    return _mm512_fmadd_ps(d, d, acc);
+  }
+};
+
+struct IpStep {
+  static __m512 apply(__m512 acc, __m512 a, __m512 b) noexcept { return _mm512_fmadd_ps(a, b, acc); }
+};
+
+template <typename Step>
+struct Fp32Accumulators {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  __m512 acc2 = _mm512_setzero_ps();
+  __m512 acc3 = _mm512_setzero_ps();
+
+  void step64(const float* a, const float* b) noexcept {
+    acc0 = Step::apply(acc0, _mm512_loadu_ps(a), _mm512_loadu_ps(b));
+    acc1 = Step::apply(acc1, _mm512_loadu_ps(a + 16), _mm512_loadu_ps(b + 16));
+    acc2 = Step::apply(acc2, _mm512_loadu_ps(a + 32), _mm512_loadu_ps(b + 32));
+    acc3 = Step::apply(acc3, _mm512_loadu_ps(a + 48), _mm512_loadu_ps(b + 48));
+  }
+
+  float sum() const noexcept {
+    return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+  }
+};
+
+template <typename Step, std::size_t kFixed>
+float fp32_kernel(const float* a, const float* b, std::size_t dim) noexcept {
+  Fp32Accumulators<Step> acc;
+  if constexpr (kFixed > 0) {
+    static_assert(kFixed % 64 == 0, "fixed dimensions are whole 64-float steps");
+#if defined(__GNUC__)
+  #pragma GCC unroll 24
+#endif
+    for (std::size_t i = 0; i < kFixed; i += 64) {
+      acc.step64(a + i, b + i);
+    }
+    return acc.sum();
+  }
+
+  std::size_t i = 0;
+  for (; i + 64 <= dim; i += 64) {
+    acc.step64(a + i, b + i);
+  }
+  for (; i + 16 <= dim; i += 16) {
+    acc.acc0 = Step::apply(acc.acc0, _mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+  }
+  // Masked loads zero the inactive lanes, so they add nothing.
+  if (i < dim) {
+    const __mmask16 mask = static_cast<__mmask16>((1u << (dim - i)) - 1u);
+    acc.acc1 = Step::apply(acc.acc1, _mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+  }
+  return acc.sum();
+}
+
+template <typename Step>
+DistanceFn fp32_fixed(std::size_t dim) noexcept {
+  switch (dim) {
+    case 128:
+      return &fp32_kernel<Step, 128>;
+    case 256:
+      return &fp32_kernel<Step, 256>;
+    case 384:
+      return &fp32_kernel<Step, 384>;
+    case 512:
+      return &fp32_kernel<Step, 512>;
+    case 768:
+      return &fp32_kernel<Step, 768>;
+    case 1024:
+      return &fp32_kernel<Step, 1024>;
+    case 1536:
+      return &fp32_kernel<Step, 1536>;
+    default:
+      return nullptr;
+  }
+}
+
+} // namespace
+
+float l2_squared_avx512(const float* a, const float* b, std::size_t dim) noexcept {
+  return fp32_kernel<L2Step, 0>(a, b, dim);
+}
+
+float inner_product_avx512(const float* a, const float* b, std::size_t dim) noexcept {
+  return fp32_kernel<IpStep, 0>(a, b, dim);
+}
+
+DistanceFn l2_squared_fixed_avx512(std::size_t dim) noexcept {
+  return fp32_fixed<L2Step>(dim);
+}
+
+DistanceFn inner_product_fixed_avx512(std::size_t dim) noexcept {
+  return fp32_fixed<IpStep>(dim);
+}
+
+namespace {
+inline __mmask16 tail_mask(std::size_t n) noexcept {
+  return static_cast<__mmask16>((1u << n) - 1u);
+}
+
+// 16 uint8 codes -> 16 floats.
+inline __m512 load_u8x16(const std::uint8_t* p) noexcept {
+  return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+}
+
+// 16 binary16 codes -> 16 floats.
+inline __m512 load_f16x16(const std::uint16_t* p) noexcept {
+  return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+}
+
+// Byte/word masked loads need AVX-512BW, which we do not require, so code
+// tails are staged through a zero-filled stack buffer instead.
+inline __m512 maskz_load_u8x16(std::size_t n, const std::uint8_t* p) noexcept {
+  alignas(16) std::uint8_t buf[16] = {};
+  for (std::size_t j = 0; j < n; ++j) {
+    buf[j] = p[j];
+  }
+  return load_u8x16(buf);
+}
+inline __m512 maskz_load_f16x16(std::size_t n, const std::uint16_t* p) noexcept {
+  alignas(32) std::uint16_t buf[16] = {};
+  for (std::size_t j = 0; j < n; ++j) {
+    buf[j] = p[j];
+  }
+  return load_f16x16(buf);
+}
+} // namespace
+
+float l2_squared_sq8_avx512(const float* a, const float* scale, const std::uint8_t* codes,
+                            std::size_t dim) noexcept {
+  __m512 sum = _mm512_setzero_ps();
+  std::size_t i = 0;
+
+  for (; i + 16 <= dim; i += 16) {
+    const __m512 x = _mm512_mul_ps(_mm512_loadu_ps(scale + i), load_u8x16(codes + i));
+    const __m512 diff = _mm512_sub_ps(_mm512_loadu_ps(a + i), x);
+    sum = _mm512_fmadd_ps(diff, diff, sum);
+  }
+
+  if (i < dim) {
+    const __mmask16 mask = tail_mask(dim - i);
+    const __m512 x = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, scale + i), maskz_load_u8x16(dim - i, codes + i));
+    const __m512 diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), x);
+    sum = _mm512_fmadd_ps(diff, diff, sum);
+  }
+
+  return _mm512_reduce_add_ps(sum);
+}
+
+float inner_product_sq8_avx512(const float* a, const std::uint8_t* codes, std::size_t dim) noexcept {
+  __m512 sum = _mm512_setzero_ps();
+  std::size_t i = 0;
+
+  for (; i + 16 <= dim; i += 16) {
+    sum = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), load_u8x16(codes + i), sum);
+  }
+
+  if (i < dim) {
+    const __mmask16 mask = tail_mask(dim - i);
+    sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), maskz_load_u8x16(dim - i, codes + i), sum);
+  }
+
+  return _mm512_reduce_add_ps(sum);
+}
+
+float l2_squared_fp16_avx512(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept {
+  __m512 sum = _mm512_setzero_ps();
+  std::size_t i = 0;
+
+  for (; i + 16 <= dim; i += 16) {
+    const __m512 diff = _mm512_sub_ps(_mm512_loadu_ps(a + i), load_f16x16(codes + i));
+    sum = _mm512_fmadd_ps(diff, diff, sum);
+  }
+
+  if (i < dim) {
+    const __mmask16 mask = tail_mask(dim - i);
+    const __m512 diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), maskz_load_f16x16(dim - i, codes + i));
+    sum = _mm512_fmadd_ps(diff, diff, sum);
+  }
+
+  return _mm512_reduce_add_ps(sum);
+}
+
+float inner_product_fp16_avx512(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept {
+  __m512 sum = _mm512_setzero_ps();
+  std::size_t i = 0;
+
+  for (; i + 16 <= dim; i += 16) {
+    sum = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), load_f16x16(codes + i), sum);
+  }
+
+  if (i < dim) {
+    const __mmask16 mask = tail_mask(dim - i);
+    sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), maskz_load_f16x16(dim - i, codes + i), sum);
+  }
+
+  return _mm512_reduce_add_ps(sum);
+}
+
+float pq_adc_avx512(const float* table, const std::uint8_t* codes, std::size_t m) noexcept {
+  // Lane j gathers table[(s + j) * 256 + codes[s + j]].
+  const __m512i row = _mm512_mullo_epi32(
+      _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(256));
+  __m512 sum = _mm512_setzero_ps();
+  std::size_t s = 0;
+
+  for (; s + 16 <= m; s += 16) {
+    const __m512i idx = _mm512_add_epi32(
+        _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + s))), row);
+    sum = _mm512_add_ps(sum, _mm512_i32gather_ps(idx, table + (s * 256), 4));
+  }
+
+  // Masked gather for the tail; inactive lanes keep 0 and read nothing.
+  if (s < m) {
+    const __mmask16 mask = tail_mask(m - s);
+    alignas(16) std::uint8_t buf[16] = {};
+    for (std::size_t j = 0; j < m - s; ++j) {
+      buf[j] = codes[s + j];
+    }
+    const __m512i idx = _mm512_add_epi32(
+        _mm512_cvtepu8_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(buf))), row);
+    sum = _mm512_add_ps(sum, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, idx, table + (s * 256), 4));
+  }
+
+  return _mm512_reduce_add_ps(sum);
+}
+
+// VPOPCNTDQ is not implied by the file's AVX-512F flags, so the kernel
+// enables it for itself; the dispatcher only picks it when cpuid reports it.
+#if defined(__GNUC__)
+__attribute__((target("avx512f,avx512vpopcntdq")))
+#endif
+std::uint32_t hamming_avx512(const std::uint8_t* a, const std::uint8_t* b, std::size_t bytes) noexcept {
+  __m512i total = _mm512_setzero_si512();
+  std::size_t i = 0;
+
+  for (; i + 64 <= bytes; i += 64) {
+    const __m512i x = _mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(x));
+  }
+
+  // Whole words of the tail under a mask (masked-off lanes load as 0 and
+  // never fault), then the last < 8 bytes.
+  const std::size_t words = (bytes - i) / 8;
+  if (words > 0) {
+    const auto mask = static_cast<__mmask8>((1u << words) - 1);
+    const __m512i x = _mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, a + i), _mm512_maskz_loadu_epi64(mask, b + i));
+    total = _mm512_add_epi64(total, _mm512_popcnt_epi64(x));
+    i += words * 8;
+  }
+
+  const auto count = static_cast<std::uint64_t>(_mm512_reduce_add_epi64(total));
+  return static_cast<std::uint32_t>(count) + hamming_scalar(a + i, b + i, bytes - i);
+}
+
+// Input conversion; tails go through the staged loads above and a masked
+// store. bf16 widens with a shift (see distance_avx2.cpp).
+namespace {
+inline __m512 load_bf16x16(const std::uint16_t* p) noexcept {
+  const __m512i words = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+  return _mm512_castsi512_ps(_mm512_slli_epi32(words, 16));
+}
+inline __m512 maskz_load_bf16x16(std::size_t n, const std::uint16_t* p) noexcept {
+  alignas(32) std::uint16_t buf[16] = {};
+  for (std::size_t j = 0; j < n; ++j) {
+    buf[j] = p[j];
+  }
+  return load_bf16x16(buf);
+}
+} // namespace
+
+void fp16_to_fp32_avx512(const std::uint16_t* src, float* dst, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(dst + i, load_f16x16(src + i));
+  }
+  if (i < n) {
+    _mm512_mask_storeu_ps(dst + i, tail_mask(n - i), maskz_load_f16x16(n - i, src + i));
+  }
+}
+
+void bf16_to_fp32_avx512(const std::uint16_t* src, float* dst, std::size_t n) noexcept {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(dst + i, load_bf16x16(src + i));
+  }
+  if (i < n) {
+    _mm512_mask_storeu_ps(dst + i, tail_mask(n - i), maskz_load_bf16x16(n - i, src + i));
+  }
+}
+
+} // namespace vectorcore
@@ -0,0 +1,167 @@
+#include "vectorcore/distance.h"
+
+// AArch64 NEON kernels. ASIMD is part of the AArch64 baseline, so no extra
+// target flags are needed; the dispatcher enables these whenever they are built.
+
+#include "vectorcore/float16.h"
+
+#include <arm_neon.h>
+
+namespace vectorcore {
+
+float l2_squared_neon(const float* a, const float* b, std::size_t dim) noexcept {
+  float32x4_t sum = vdupq_n_f32(0.0f);
+  std::size_t i = 0;
+
+  // Process 4 floats per iteration.
+  for (; i + 4 <= dim; i += 4) {
+    const float32x4_t va = vld1q_f32(a + i);
+    const float32x4_t vb = vld1q_f32(b + i);
+    const float32x4_t diff = vsubq_f32(va, vb);
+    sum = vfmaq_f32(sum, diff, diff);
+  }
+
+  float acc = vaddvq_f32(sum);
+
+  for (; i < dim; ++i) {
+    const float d = a[i] - b[i];
+    acc += d * d;
+  }
+
+  return acc;
+}
+
+float inner_product_neon(const float* a, const float* b, std::size_t dim) noexcept {
+  float32x4_t sum = vdupq_n_f32(0.0f);
+  std::size_t i = 0;
+
+  for (; i + 4 <= dim; i += 4) {
+    sum = vfmaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+  }
+
+  float acc = vaddvq_f32(sum);
+
+  for (; i < dim; ++i) {
+    acc += a[i] * b[i];
+  }
+
+  return acc;
+}
+
+namespace {
+// 4 uint8 codes -> 4 floats.
+inline float32x4_t load_u8x4(const std::uint8_t* p) noexcept {
+  const uint32x4_t w = {p[0], p[1], p[2], p[3]};
+  return vcvtq_f32_u32(w);
+}
+
+// 4 binary16 codes -> 4 floats (half conversion is baseline on AArch64).
+inline float32x4_t load_f16x4(const std::uint16_t* p) noexcept {
+  return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(p)));
+}
+} // namespace
+
+float l2_squared_sq8_neon(const float* a, const float* scale, const std::uint8_t* codes,
+                          std::size_t dim) noexcept {
+  float32x4_t sum = vdupq_n_f32(0.0f);
+  std::size_t i = 0;
+
+  // 16 codes per iteration: widen u8 -> u16 -> u32 -> f32.
+  for (; i + 16 <= dim; i += 16) {
+    const uint8x16_t c = vld1q_u8(codes + i);
+    const uint16x8_t lo = vmovl_u8(vget_low_u8(c));
+    const uint16x8_t hi = vmovl_u8(vget_high_u8(c));
+    const float32x4_t x[4] = {
+        vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))),
+        vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi)))};
+    for (int j = 0; j < 4; ++j) {
+      const float32x4_t diff = vsubq_f32(vld1q_f32(a + i + 4 * j), vmulq_f32(vld1q_f32(scale + i + 4 * j), x[j]));
+      sum = vfmaq_f32(sum, diff, diff);
+    }
+  }
+  for (; i + 4 <= dim; i += 4) {
+    const float32x4_t diff = vsubq_f32(vld1q_f32(a + i), vmulq_f32(vld1q_f32(scale + i), load_u8x4(codes + i)));
+    sum = vfmaq_f32(sum, diff, diff);
+  }
+
+  float acc = vaddvq_f32(sum);
+  for (; i < dim; ++i) {
+    const float d = a[i] - scale[i] * static_cast<float>(codes[i]);
+    acc += d * d;
+  }
+  return acc;
+}
+
+float inner_product_sq8_neon(const float* a, const std::uint8_t* codes, std::size_t dim) noexcept {
+  float32x4_t sum = vdupq_n_f32(0.0f);
+  std::size_t i = 0;
+
+  for (; i + 16 <= dim; i += 16) {
+    const uint8x16_t c = vld1q_u8(codes + i);
+    const uint16x8_t lo = vmovl_u8(vget_low_u8(c));
+    const uint16x8_t hi = vmovl_u8(vget_high_u8(c));
+    sum = vfmaq_f32(sum, vld1q_f32(a + i), vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))));
+    sum = vfmaq_f32(sum, vld1q_f32(a + i + 4), vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))));
+    sum = vfmaq_f32(sum, vld1q_f32(a + i + 8), vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))));
+    sum = vfmaq_f32(sum, vld1q_f32(a + i + 12), vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))));
+  }
+  for (; i + 4 <= dim; i += 4) {
+    sum = vfmaq_f32(sum, vld1q_f32(a + i), load_u8x4(codes + i));
+  }
+
+  float acc = vaddvq_f32(sum);
+  for (; i < dim; ++i) {
+    acc += a[i] * static_cast<float>(codes[i]);
+  }
+  return acc;
+}
+
+float l2_squared_fp16_neon(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept {
+  float32x4_t sum = vdupq_n_f32(0.0f);
+  std::size_t i = 0;
+
+  for (; i + 4 <= dim; i += 4) {
+    const float32x4_t diff = vsubq_f32(vld1q_f32(a + i), load_f16x4(codes + i));
+    sum = vfmaq_f32(sum, diff, diff);
+  }
+
+  float acc = vaddvq_f32(sum);
+  for (; i < dim; ++i) {
+    const float d = a[i] - half_to_float(codes[i]);
+    acc += d * d;
+  }
+  return acc;
+}
+
+float inner_product_fp16_neon(const float* a, const std::uint16_t* codes, std::size_t dim) noexcept {
+  float32x4_t sum = vdupq_n_f32(0.0f);
+  std::size_t i = 0;
+
+  for (; i + 4 <= dim; i += 4) {
+    sum = vfmaq_f32(sum, vld1q_f32(a + i), load_f16x4(codes + i));
+  }
+
+  float acc = vaddvq_f32(sum);
+  for (; i < dim; ++i) {
+    acc += a[i] * half_to_float(codes[i]);
+  }
+  return acc;
+}
+
+float pq_adc_neon(const float* table, const std::uint8_t* codes, std::size_t m) noexcept {
+  // NEON has no gather; four independent scalar chains hide the load latency.
+  float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  std::size_t s = 0;
+  for (; s + 4 <= m; s += 4) {
+    acc[0] += table[((s + 0) * 256) + codes[s + 0]];
+    acc[1] += table[((s + 1) * 256) + codes[s + 1]];
+    acc[2] += table[((s + 2) * 256) + codes[s + 2]];
+    acc[3] += table[((s + 3) * 256) + codes[s + 3]];
+  }
+  for (; s < m; ++s) {
+    acc[0] += table[(s * 256) + codes[s]];
+  }
+  return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+} // namespace vectorcore
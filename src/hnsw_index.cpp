@@ -1,9 +1,13 @@
 #include "vectorcore/hnsw_index.h"
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
-#include <queue>
 #include <stdexcept>
+#include <unordered_map>
+
+#include "vectorcore/index_io.h"
+#include "vectorcore/thread_pool.h"
 
 namespace vectorcore {
 
@@ -11,107 +15,921 @@ namespace {
 inline float badness_from_score(Metric metric, float score) noexcept {
   return (metric == Metric::L2_SQUARED) ? score : -score;
 }
+
+using Candidate = SearchScratch::Candidate;
+
+// Heap orderings for the std::*_heap algorithms over the scratch vectors.
+// - CloserFirst: front() is the closest unexpanded candidate (min-heap).
+// - FurtherFirst: front() is the worst kept result (max-heap), so eviction
+//   is O(log ef).
+struct CloserFirst {
+  bool operator()(const Candidate& a, const Candidate& b) const noexcept { return a.first > b.first; }
+};
+struct FurtherFirst {
+  bool operator()(const Candidate& a, const Candidate& b) const noexcept { return a.first < b.first; }
+};
+
+// Rearranges `a` (stride elements per row) so row i holds old row order[i],
+// dropping rows missing from `order`. An ascending order (compaction) moves
+// rows down in place; any other order gathers into fresh storage under the
+// same memory policy. Empty arrays are left alone.
+template <typename T>
+void permute_rows(FlatArray<T>& a, std::size_t stride, const std::vector<std::uint32_t>& order) {
+  if (a.empty()) {
+    return;
+  }
+  if (std::is_sorted(order.begin(), order.end())) {
+    T* p = a.data();
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      if (order[i] != i) {
+        std::copy_n(p + (static_cast<std::size_t>(order[i]) * stride), stride, p + (i * stride));
+      }
+    }
+    a.resize(order.size() * stride);
+    return;
+  }
+  const FlatArray<T>& in = a;
+  FlatArray<T> out(in.memory_policy());
+  out.resize(order.size() * stride);
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    std::copy_n(in.data() + (static_cast<std::size_t>(order[i]) * stride), stride, out.data() + (i * stride));
+  }
+  a = std::move(out);
 }
+} // namespace
 
-HnswIndex::HnswIndex(std::size_t dim, std::size_t M, Metric metric)
-    : dim_(dim), M_(M), metric_(metric) {
+HnswIndex::HnswIndex(std::size_t dim, std::size_t M, Metric metric, std::size_t ef_construction,
+                     std::uint64_t seed, Storage storage, std::size_t rerank_factor, std::size_t pq_m,
+                     const MemoryPolicy& memory)
+    : dim_(dim), M_(M), M0_(2 * M), ef_construction_(ef_construction), rerank_factor_(rerank_factor),
+      metric_(metric), distance_(distance_kernels().fp32_for(metric, dim)), storage_(storage), rng_(seed),
+      link_locks_(std::make_unique<std::mutex[]>(kLinkLockStripes)),
+      visited_pool_(std::make_unique<VisitedPool>()), stats_(std::make_unique<SearchStats>()) {
   if (dim_ == 0) {
     throw std::invalid_argument("dim must be > 0");
   }
   if (M_ == 0) {
     throw std::invalid_argument("M must be > 0");
   }
+  if (ef_construction_ == 0) {
+    throw std::invalid_argument("ef_construction must be > 0");
+  }
+  if (storage_ == Storage::BINARY) {
+    throw std::invalid_argument("BINARY storage is only supported by BruteForceIndex");
+  }
+  validate_memory_policy(memory);
+  embeddings_.set_memory_policy(memory);
+  codes_.set_memory_policy(memory);
+  links0_.set_memory_policy(memory);
+
+  if (storage_ == Storage::PQ) {
+    pq_ = ProductQuantizer(dim_, pq_m, kernel_metric(metric_));
+  } else {
+    quantizer_ = ScalarQuantizer(storage, dim_, kernel_metric(metric_));
+  }
+
+  // mL = 1 / ln(M). With M == 1 the hierarchy degenerates, so keep one level.
+  level_mult_ = (M_ > 1) ? 1.0 / std::log(static_cast<double>(M_)) : 0.0;
+}
+
+ThreadPool& HnswIndex::thread_pool() const noexcept {
+  return pool_ ? *pool_ : ThreadPool::global();
+}
+
+int HnswIndex::random_level() {
+  // 1 - U[0, 1) lies in (0, 1], so the log is always finite.
+  // Levels are stored as uint8; reaching 255 would take r < e^-(255 ln M).
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  const double r = 1.0 - uniform(rng_);
+  return std::min(static_cast<int>(-std::log(r) * level_mult_), 255);
+}
+
+void HnswIndex::add(const float* vectors, std::size_t n, const std::uint64_t* ids, std::size_t num_threads) {
+  if (!vectors) {
+    throw std::invalid_argument("vectors pointer is null");
+  }
+  if (n == 0) {
+    return;
+  }
+  append(vectors, n, ids, num_threads, false);
 }
 
-float HnswIndex::score(const float* a, const float* b) const noexcept {
-  switch (metric_) {
-    case Metric::L2_SQUARED:
-      return l2_squared(a, b, dim_);
-    case Metric::INNER_PRODUCT:
-      return inner_product(a, b, dim_);
-    default:
-      return l2_squared(a, b, dim_);
+void HnswIndex::add_half(const std::uint16_t* vectors, std::size_t n, HalfFormat format, const std::uint64_t* ids,
+                         std::size_t num_threads) {
+  if (!vectors) {
+    throw std::invalid_argument("vectors pointer is null");
   }
+  if (n == 0) {
+    return;
+  }
+  append(nullptr, n, ids, num_threads, false, vectors, format);
 }
 
-void HnswIndex::add(const float* vectors, std::size_t n, const std::uint64_t* ids) {
+void HnswIndex::attach(const float* vectors, std::size_t n, std::shared_ptr<const void> owner,
+                       const std::uint64_t* ids, std::size_t num_threads) {
   if (!vectors) {
     throw std::invalid_argument("vectors pointer is null");
   }
+  if (size_ != 0) {
+    throw std::logic_error("attach() needs an empty index");
+  }
+  if (ingest_capacity_ > 0) {
+    throw std::logic_error("attach() views caller memory, which concurrent ingest cannot append to");
+  }
+  if (!has_fp32()) {
+    throw std::invalid_argument("attach() needs fp32 rows (FP32 storage, or rerank_factor > 0)");
+  }
+  if (metric_ == Metric::COSINE) {
+    throw std::invalid_argument("attach() cannot normalize caller memory; use INNER_PRODUCT over unit rows");
+  }
   if (n == 0) {
     return;
   }
+  embeddings_.attach(vectors, n * dim_, std::move(owner));
+  try {
+    append(vectors, n, ids, num_threads, true);
+  } catch (...) {
+    // Rejected (e.g. too few rows to train PQ): do not leave the view behind.
+    embeddings_.clear();
+    throw;
+  }
+}
+
+void HnswIndex::append(const float* vectors, std::size_t n, const std::uint64_t* ids, std::size_t num_threads,
+                       bool in_place, const std::uint16_t* halves, HalfFormat format) {
+  // Every node removed: start over, or the new nodes would only find
+  // removed neighbors and stay unreachable.
+  if (size_ > 0 && size() == 0) {
+    compact();
+  }
 
   const std::size_t old_size = size_;
   const std::size_t new_size = size_ + n;
 
-  embeddings_.reserve(new_size * dim_);
+  // Internal indices are stored as uint32 in the adjacency lists.
+  if (new_size > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("HnswIndex supports at most 2^32 - 1 vectors");
+  }
+  if (storage_ == Storage::PQ && !pq_.trained() && n < ProductQuantizer::kCentroids) {
+    throw std::invalid_argument("PQ storage needs at least 256 vectors in the first add()");
+  }
+  if (ingest_capacity_ > 0 && new_size > ingest_capacity_) {
+    throw std::length_error("add() would pass the ingest capacity; raise it first");
+  }
+
+  // Draw levels serially (keeps the RNG stream deterministic) before
+  // anything is written, so a batch whose upper links would outgrow the
+  // ingest reservation is turned away whole.
+  std::vector<std::uint8_t> levels(n);
+  std::size_t upper_blocks = links_upper_.size() / (M_ + 1);
+  for (std::uint8_t& level : levels) {
+    level = static_cast<std::uint8_t>(random_level());
+    upper_blocks += level;
+  }
+  if (ingest_capacity_ > 0 && upper_blocks * (M_ + 1) > links_upper_.capacity()) {
+    throw std::length_error("add() would pass the upper links reserved for ingest; raise the capacity first");
+  }
+
+  // Everything the inserts touch is sized for the whole batch here, so no
+  // worker ever triggers a reallocation under another worker's reads.
   ids_.reserve(new_size);
-  neighbors_.reserve(new_size);
+  levels_.reserve(new_size);
+  upper_block_.reserve(new_size);
 
-  // Insert vectors first.
-  embeddings_.insert(embeddings_.end(), vectors, vectors + (n * dim_));
+  // Level-0 blocks for the whole batch in one allocation; counts start at 0.
+  links0_.resize(new_size * (M0_ + 1), 0);
+
+  // Insert vectors first. Half rows are widened and COSINE rows normalized
+  // once here (in place in embeddings_ when it is kept, which attach()
+  // already views), and `rows` is what gets encoded.
+  const float* rows = vectors;
+  std::vector<float> unit;
+  if (has_fp32()) {
+    if (halves) {
+      embeddings_.reserve(new_size * dim_);
+      append_widened(embeddings_, format, halves, n * dim_);
+    } else if (!in_place) {
+      embeddings_.reserve(new_size * dim_);
+      embeddings_.append(vectors, vectors + (n * dim_));
+    }
+    if (halves || metric_ == Metric::COSINE) {
+      const FlatArray<float>& stored = embeddings_;
+      rows = stored.data() + (old_size * dim_);
+    }
+    if (metric_ == Metric::COSINE) {
+      normalize_rows(embeddings_.data() + (old_size * dim_), n, dim_);
+    }
+  } else if (halves || metric_ == Metric::COSINE) {
+    if (halves) {
+      unit.resize(n * dim_);
+      widen_to_float(format, halves, unit.data(), unit.size());
+    } else {
+      unit.assign(vectors, vectors + (n * dim_));
+    }
+    if (metric_ == Metric::COSINE) {
+      normalize_rows(unit.data(), n, dim_);
+    }
+    rows = unit.data();
+  }
+  if (storage_ == Storage::PQ) {
+    if (!pq_.trained()) {
+      pq_.train(rows, n, num_threads);
+    }
+    codes_.resize(new_size * pq_.code_size());
+    pq_.encode(rows, n, codes_.data() + (old_size * pq_.code_size()), num_threads);
+  } else if (quantized()) {
+    if (!quantizer_.trained()) {
+      quantizer_.train(rows, n);
+    }
+    const std::size_t code_size = quantizer_.code_size();
+    codes_.resize(new_size * code_size);
+    quantizer_.encode(rows, n, codes_.data() + (old_size * code_size));
+  }
 
   if (ids) {
-    ids_.insert(ids_.end(), ids, ids + n);
+    ids_.append(ids, ids + n);
   } else {
     for (std::size_t i = 0; i < n; ++i) {
-      ids_.push_back(static_cast<std::uint64_t>(old_size + i));
+      ids_.push_back(next_id_ + i);
+    }
+  }
+  next_id_ += n;
+  if (id_map_ready_) {
+    for (std::size_t idx = old_size; idx < new_size; ++idx) {
+      id_map_[ids_[idx]] = static_cast<std::uint32_t>(idx);
+    }
+  }
+
+  // Lay out the upper-level side table. Block indices (not pointers) are
+  // stored, so the single resize below never invalidates them.
+  upper_blocks = links_upper_.size() / (M_ + 1);
+  for (const std::uint8_t level : levels) {
+    levels_.push_back(level);
+    upper_block_.push_back(static_cast<std::uint32_t>(upper_blocks));
+    upper_blocks += level;
+  }
+  links_upper_.resize(upper_blocks * (M_ + 1), 0);
+
+  // Unlinked nodes have empty blocks, so the walks cannot reach them early.
+  size_ = new_size;
+
+  // Searches running alongside read link blocks under the stripe locks, so
+  // even a serial insert takes them.
+  if (num_threads == 1) {
+    auto scratch = visited_pool_->acquire();
+    for (std::size_t idx = old_size; idx < new_size; ++idx) {
+      insert(static_cast<std::uint32_t>(idx), concurrent_reads(), *scratch);
+    }
+  } else {
+    ThreadPool& pool = thread_pool();
+    pool.parallel_for(n, 16, [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+      auto scratch = visited_pool_->acquire();
+      for (std::size_t i = begin; i < end; ++i) {
+        insert(static_cast<std::uint32_t>(old_size + i), true, *scratch);
+      }
+    }, num_threads);
+  }
+  publish();
+}
+
+std::size_t HnswIndex::ingest_upper_blocks() const noexcept {
+  // A node owns a geometric number of upper blocks with mean 1 / (M - 1);
+  // twice that plus some slack covers any realistic draw.
+  if (M_ <= 1) {
+    return 0;
+  }
+  return 2 * ingest_capacity_ / (M_ - 1) + 1024;
+}
+
+void HnswIndex::set_ingest_capacity(std::size_t capacity) {
+  if (capacity > 0 && capacity < size_) {
+    throw std::invalid_argument("ingest capacity is below the nodes already stored");
+  }
+  if (capacity > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("HnswIndex supports at most 2^32 - 1 vectors");
+  }
+  ingest_capacity_ = capacity;
+  reserve_ingest();
+}
+
+void HnswIndex::reserve_ingest() {
+  if (ingest_capacity_ == 0) {
+    return;
+  }
+  ids_.reserve(ingest_capacity_);
+  levels_.reserve(ingest_capacity_);
+  upper_block_.reserve(ingest_capacity_);
+  links0_.reserve(ingest_capacity_ * (M0_ + 1));
+  links_upper_.reserve(links_upper_.size() + (ingest_upper_blocks() * (M_ + 1)));
+  if (has_fp32()) {
+    embeddings_.reserve(ingest_capacity_ * dim_);
+  }
+  if (quantized()) {
+    codes_.reserve(ingest_capacity_ * code_size());
+  }
+}
+
+void HnswIndex::insert(std::uint32_t idx, bool concurrent, SearchScratch& scratch) {
+  const int level = levels_[idx];
+
+  // A node that raises the max level keeps entry_mu_ until it is fully
+  // linked, so no other insert can start from a half-built top level.
+  std::unique_lock<std::mutex> top(entry_mu_);
+  const std::uint64_t packed = entry_.load(std::memory_order_acquire);
+  if (packed == 0) {
+    entry_.store(pack_entry(idx, level), std::memory_order_release);
+    return;
+  }
+  const int max_level = unpack_level(packed);
+  if (level <= max_level) {
+    top.unlock();
+  }
+
+  PreparedQuery& v = scratch.query;
+  node_query(idx, v);
+  if (storage_ == Storage::PQ) {
+    // The insert beam scores hundreds of rows: worth an ADC table.
+    pq_.prepare(v.q, v);
+  }
+
+  // Route through the levels the new node does not occupy.
+  std::uint32_t ep = concurrent
+                         ? greedy_descend<true>(v, unpack_entry(packed), max_level, level, size_, scratch)
+                         : greedy_descend<false>(v, unpack_entry(packed), max_level, level, size_, scratch);
+
+  for (int l = std::min(level, max_level); l >= 0; --l) {
+    if (concurrent) {
+      search_layer<true>(v, ep, ef_construction_, l, size_, scratch);
+    } else {
+      search_layer<false>(v, ep, ef_construction_, l, size_, scratch);
+    }
+    if (scratch.results.empty()) {
+      continue; // only removed nodes reachable on this level
+    }
+    ep = scratch.results.front().second;
+    connect(idx, l, scratch.results, concurrent, scratch.node);
+  }
+
+  if (level > max_level) {
+    entry_.store(pack_entry(idx, level), std::memory_order_release);
+  }
+}
+
+template <bool kConcurrent>
+std::uint32_t HnswIndex::greedy_descend(const PreparedQuery& query, std::uint32_t ep, int from_level,
+                                        int to_level, std::size_t limit, SearchScratch& scratch) const {
+  float best = badness(query, ep);
+  VECTORCORE_COUNT(scratch.stats.distances, 1);
+  VECTORCORE_COUNT(scratch.stats.visited, 1);
+
+  for (int level = from_level; level > to_level; --level) {
+    bool improved = true;
+    while (improved) {
+      improved = false;
+      VECTORCORE_COUNT(scratch.stats.hops, 1);
+
+      const std::uint32_t* links;
+      std::uint32_t count;
+      if constexpr (kConcurrent) {
+        auto lock = lock_links(ep, true);
+        const std::uint32_t* block = links_at(ep, level);
+        scratch.links.assign(block + 1, block + 1 + block[0]);
+        lock.unlock();
+        links = scratch.links.data();
+        count = static_cast<std::uint32_t>(scratch.links.size());
+      } else {
+        const std::uint32_t* block = links_at(ep, level);
+        links = block + 1;
+        count = block[0];
+      }
+
+      VECTORCORE_COUNT(scratch.stats.distances, count);
+      VECTORCORE_COUNT(scratch.stats.visited, count);
+      const std::size_t ahead = prefetch_distance_;
+      for (std::uint32_t j = 0; j < std::min<std::size_t>(ahead, count); ++j) {
+        prefetch_row(links[j]);
+      }
+      for (std::uint32_t j = 0; j < count; ++j) {
+        if (j + ahead < count) {
+          prefetch_row(links[j + ahead]);
+        }
+        const std::uint32_t nb = links[j];
+        if (nb >= limit) {
+          continue;
+        }
+        const float b = badness(query, nb);
+        if (b < best) {
+          best = b;
+          ep = nb;
+          improved = true;
+        }
+      }
     }
   }
 
-  // Build a very small "HNSW-like" graph: connect each new node to its M nearest
-  // existing nodes (by brute force). This is not the full algorithm, but it gives
-  // you a concrete graph structure and a real approximate search routine.
-  for (std::size_t local = 0; local < n; ++local) {
-    const std::size_t idx = old_size + local;
-    const float* v = embeddings_.data() + (idx * dim_);
+  return ep;
+}
+
+template <bool kConcurrent>
+void HnswIndex::search_layer(const PreparedQuery& query, std::uint32_t ep, std::size_t ef, int level,
+                             std::size_t limit, SearchScratch& scratch, const SearchFilter* filter) const {
+  VisitedTable& visited = scratch.visited;
+  std::vector<Candidate>& candidates = scratch.candidates;
+  std::vector<Candidate>& results = scratch.results;
 
-    neighbors_.push_back({});
+  visited.prepare(limit);
+  candidates.clear();
+  results.clear();
 
-    if (idx == 0) {
-      continue; // first node has no neighbors
+  // Removed and filtered nodes are expanded like any other but never kept.
+  const bool skip = deleted_.any() || filter != nullptr;
+  const std::size_t ahead = prefetch_distance_;
+
+  const float b0 = badness(query, ep);
+  visited.mark(ep);
+  VECTORCORE_COUNT(scratch.stats.distances, 1);
+  VECTORCORE_COUNT(scratch.stats.visited, 1);
+  candidates.emplace_back(b0, ep);
+  if (!skip || !hidden(ep, filter)) {
+    results.emplace_back(b0, ep);
+  }
+
+  while (!candidates.empty()) {
+    const Candidate current = candidates.front();
+
+    // Every remaining candidate is further than the worst kept result.
+    if (!results.empty() && current.first > results.front().first) {
+      break;
     }
+    std::pop_heap(candidates.begin(), candidates.end(), CloserFirst{});
+    candidates.pop_back();
+    VECTORCORE_COUNT(scratch.stats.heap_ops, 1);
+    VECTORCORE_COUNT(scratch.stats.hops, 1);
 
-    using Candidate = std::pair<float, std::uint32_t>; // (badness, neighbor index)
-    auto worse = [](const Candidate& a, const Candidate& b) { return a.first < b.first; };
-    std::priority_queue<Candidate, std::vector<Candidate>, decltype(worse)> heap(worse);
+    // The closest remaining candidate is the likeliest next expansion.
+    if (ahead > 0 && !candidates.empty()) {
+      prefetch(links_at(candidates.front().second, level));
+    }
 
-    const std::size_t max_neighbors = std::min<std::size_t>(M_, idx);
+    const std::uint32_t* links;
+    std::uint32_t count;
+    if constexpr (kConcurrent) {
+      auto lock = lock_links(current.second, true);
+      const std::uint32_t* block = links_at(current.second, level);
+      scratch.links.assign(block + 1, block + 1 + block[0]);
+      lock.unlock();
+      links = scratch.links.data();
+      count = static_cast<std::uint32_t>(scratch.links.size());
+    } else {
+      const std::uint32_t* block = links_at(current.second, level);
+      links = block + 1;
+      count = block[0];
+    }
+
+    // Rows and visited marks of the next `ahead` neighbors are in flight
+    // while the current one is scored.
+    for (std::uint32_t j = 0; j < std::min<std::size_t>(ahead, count); ++j) {
+      visited.prefetch(links[j]);
+      prefetch_row(links[j]);
+    }
+    for (std::uint32_t j = 0; j < count; ++j) {
+      if (j + ahead < count) {
+        visited.prefetch(links[j + ahead]);
+        prefetch_row(links[j + ahead]);
+      }
+      const std::uint32_t nb = links[j];
+      if (nb >= limit || visited.test_and_mark(nb)) {
+        continue;
+      }
 
-    for (std::size_t j = 0; j < idx; ++j) {
-      const float* u = embeddings_.data() + (j * dim_);
-      const float s = score(v, u);
-      const float b = badness_from_score(metric_, s);
+      const float b = badness(query, nb);
+      VECTORCORE_COUNT(scratch.stats.distances, 1);
+      VECTORCORE_COUNT(scratch.stats.visited, 1);
+      if (results.size() < ef || b < results.front().first) {
+        candidates.emplace_back(b, nb);
+        std::push_heap(candidates.begin(), candidates.end(), CloserFirst{});
+        VECTORCORE_COUNT(scratch.stats.heap_ops, 1);
 
-      if (heap.size() < max_neighbors) {
-        heap.emplace(b, static_cast<std::uint32_t>(j));
-      } else if (b < heap.top().first) {
-        heap.pop();
-        heap.emplace(b, static_cast<std::uint32_t>(j));
+        if (skip && hidden(nb, filter)) {
+          continue;
+        }
+        results.emplace_back(b, nb);
+        std::push_heap(results.begin(), results.end(), FurtherFirst{});
+        VECTORCORE_COUNT(scratch.stats.heap_ops, 1);
+        if (results.size() > ef) {
+          std::pop_heap(results.begin(), results.end(), FurtherFirst{});
+          results.pop_back();
+          VECTORCORE_COUNT(scratch.stats.heap_ops, 1);
+        }
       }
     }
+  }
+
+  // Max-heap -> ascending badness, closest first.
+  std::sort_heap(results.begin(), results.end(), FurtherFirst{});
+}
 
-    auto& adj = neighbors_.back();
-    adj.reserve(max_neighbors);
-    while (!heap.empty()) {
-      adj.push_back(heap.top().second);
-      heap.pop();
+void HnswIndex::select_neighbors(std::vector<Candidate>& candidates, std::size_t max_links,
+                                 PreparedQuery& node) const {
+  if (candidates.size() <= max_links) {
+    return;
+  }
+
+  // Keep a candidate only if it is closer to the base node than to every
+  // neighbor already selected. This spreads links over different directions
+  // instead of spending them all on one dense cluster.
+  std::vector<Candidate> selected;
+  selected.reserve(max_links);
+
+  for (const Candidate& c : candidates) {
+    if (selected.size() >= max_links) {
+      break;
     }
 
-    // Make edges bidirectional (again, simplified vs true HNSW pruning).
-    for (const std::uint32_t nb : adj) {
-      auto& back = neighbors_[nb];
-      if (back.size() < M_) {
-        back.push_back(static_cast<std::uint32_t>(idx));
+    if (!selected.empty()) {
+      node_query(c.second, node);
+    }
+    bool keep = true;
+    for (const Candidate& s : selected) {
+      if (badness(node, s.second) < c.first) {
+        keep = false;
+        break;
       }
     }
+
+    if (keep) {
+      selected.push_back(c);
+    }
   }
 
-  size_ = new_size;
+  candidates.swap(selected);
 }
 
-void HnswIndex::search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores) const {
+void HnswIndex::connect(std::uint32_t idx, int level, std::vector<Candidate>& candidates, bool concurrent,
+                        PreparedQuery& node) {
+  const std::size_t max_links = (level == 0) ? M0_ : M_;
+
+  select_neighbors(candidates, M_, node);
+
+  {
+    auto lock = lock_links(idx, concurrent);
+    std::uint32_t* adj = links_at(idx, level);
+    adj[0] = static_cast<std::uint32_t>(candidates.size());
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+      adj[i + 1] = candidates[i].second;
+    }
+  }
+
+  // Back-edges. When the neighbor is already full, re-run the heuristic over
+  // its links plus the new node instead of silently dropping the edge.
+  // Iterate the local candidate list: once our block is published, other
+  // inserts may append to it.
+  std::vector<Candidate> pruned;
+  for (const Candidate& c : candidates) {
+    const std::uint32_t nb = c.second;
+    auto lock = lock_links(nb, concurrent);
+    std::uint32_t* back = links_at(nb, level);
+    const std::uint32_t count = back[0];
+
+    // A concurrent insert of `nb` may already have linked back to us.
+    if (std::find(back + 1, back + 1 + count, idx) != back + 1 + count) {
+      continue;
+    }
+
+    if (count < max_links) {
+      back[count + 1] = idx;
+      back[0] = count + 1;
+      continue;
+    }
+
+    node_query(nb, node);
+    pruned.clear();
+    pruned.reserve(count + 1);
+    pruned.emplace_back(badness(node, idx), idx);
+    for (std::uint32_t j = 1; j <= count; ++j) {
+      pruned.emplace_back(badness(node, back[j]), back[j]);
+    }
+    std::sort(pruned.begin(), pruned.end(),
+              [](const Candidate& a, const Candidate& b) { return a.first < b.first; });
+
+    select_neighbors(pruned, max_links, node);
+
+    back[0] = static_cast<std::uint32_t>(pruned.size());
+    for (std::size_t j = 0; j < pruned.size(); ++j) {
+      back[j + 1] = pruned[j].second;
+    }
+  }
+}
+
+void HnswIndex::build_id_map() {
+  if (id_map_ready_) {
+    return;
+  }
+  id_map_.reserve(size());
+  for (std::size_t idx = 0; idx < size_; ++idx) {
+    if (!deleted_.test(idx)) {
+      id_map_[ids_[idx]] = static_cast<std::uint32_t>(idx);
+    }
+  }
+  id_map_ready_ = true;
+}
+
+void HnswIndex::repair_links(std::uint32_t u, int level, std::vector<std::uint32_t>& pool, PreparedQuery& node) {
+  std::uint32_t* block = links_at(u, level);
+  const std::uint32_t count = block[0];
+
+  pool.clear();
+  bool stale = false;
+  for (std::uint32_t j = 1; j <= count; ++j) {
+    const std::uint32_t nb = block[j];
+    if (!deleted_.test(nb)) {
+      pool.push_back(nb);
+      continue;
+    }
+    // Bridge over the removed node: its links on this level are the
+    // natural replacements (a node linked on `level` exists on it).
+    stale = true;
+    const std::uint32_t* hole = links_at(nb, level);
+    for (std::uint32_t t = 1; t <= hole[0]; ++t) {
+      if (hole[t] != u && !deleted_.test(hole[t])) {
+        pool.push_back(hole[t]);
+      }
+    }
+  }
+  if (!stale) {
+    return;
+  }
+  std::sort(pool.begin(), pool.end());
+  pool.erase(std::unique(pool.begin(), pool.end()), pool.end());
+
+  node_query(u, node);
+  std::vector<Candidate> candidates;
+  candidates.reserve(pool.size());
+  for (const std::uint32_t c : pool) {
+    candidates.emplace_back(badness(node, c), c);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) { return a.first < b.first; });
+  select_neighbors(candidates, (level == 0) ? M0_ : M_, node);
+
+  block[0] = static_cast<std::uint32_t>(candidates.size());
+  for (std::size_t j = 0; j < candidates.size(); ++j) {
+    block[j + 1] = candidates[j].second;
+  }
+}
+
+std::size_t HnswIndex::remove(const std::uint64_t* ids, std::size_t n) {
+  if (!ids && n > 0) {
+    throw std::invalid_argument("ids pointer is null");
+  }
+  build_id_map();
+
+  std::vector<std::uint32_t> removed;
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto it = id_map_.find(ids[i]);
+    if (it == id_map_.end()) {
+      continue;
+    }
+    deleted_.set(it->second);
+    removed.push_back(it->second);
+    id_map_.erase(it);
+  }
+  if (removed.empty()) {
+    return 0;
+  }
+
+  // Repair rewrites link blocks in place; take them out of a mapped file.
+  links0_.own();
+  links_upper_.own();
+
+  // Links are mostly symmetric, so the removed nodes' own neighbors are the
+  // nodes that point at them. One-way links left over are fixed by compact().
+  std::vector<std::uint32_t> pool;
+  PreparedQuery node;
+  for (const std::uint32_t d : removed) {
+    for (int l = 0; l <= levels_[d]; ++l) {
+      const std::uint32_t* block = links_at(d, l);
+      for (std::uint32_t j = 1; j <= block[0]; ++j) {
+        if (!deleted_.test(block[j])) {
+          repair_links(block[j], l, pool, node);
+        }
+      }
+    }
+  }
+
+  if (compact_threshold_ > 0.0 &&
+      static_cast<double>(deleted_.count()) > compact_threshold_ * static_cast<double>(size_)) {
+    compact();
+  }
+  return removed.size();
+}
+
+void HnswIndex::upsert(const float* vectors, std::size_t n, const std::uint64_t* ids, std::size_t num_threads) {
+  if (!vectors) {
+    throw std::invalid_argument("vectors pointer is null");
+  }
+  if (!ids) {
+    throw std::invalid_argument("upsert() needs ids");
+  }
+  if (n == 0) {
+    return;
+  }
+
+  std::unordered_map<std::uint64_t, std::size_t> last;
+  last.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    last[ids[i]] = i;
+  }
+
+  remove(ids, n);
+  if (last.size() == n) {
+    add(vectors, n, ids, num_threads);
+    return;
+  }
+
+  std::vector<float> rows;
+  std::vector<std::uint64_t> row_ids;
+  rows.reserve(last.size() * dim_);
+  row_ids.reserve(last.size());
+  for (std::size_t i = 0; i < n; ++i) {
+    if (last[ids[i]] == i) {
+      rows.insert(rows.end(), vectors + (i * dim_), vectors + ((i + 1) * dim_));
+      row_ids.push_back(ids[i]);
+    }
+  }
+  add(rows.data(), row_ids.size(), row_ids.data(), num_threads);
+}
+
+void HnswIndex::compact() {
+  if (!deleted_.any()) {
+    return;
+  }
+  links0_.own();
+  links_upper_.own();
+
+  // Fix one-way links into removed nodes first, so renumbering can simply
+  // drop removed targets without cutting a live node off.
+  std::vector<std::uint32_t> pool;
+  PreparedQuery node;
+  for (std::size_t u = 0; u < size_; ++u) {
+    if (deleted_.test(u)) {
+      continue;
+    }
+    for (int l = 0; l <= levels_[u]; ++l) {
+      repair_links(static_cast<std::uint32_t>(u), l, pool, node);
+    }
+  }
+
+  std::vector<std::uint32_t> order;
+  order.reserve(size());
+  for (std::size_t idx = 0; idx < size_; ++idx) {
+    if (!deleted_.test(idx)) {
+      order.push_back(static_cast<std::uint32_t>(idx));
+    }
+  }
+  deleted_.clear();
+  permute(order);
+}
+
+void HnswIndex::reorder(ReorderMethod method) {
+  compact();
+  if (size_ < 2) {
+    return;
+  }
+
+  std::vector<std::uint32_t> order;
+  order.reserve(size_);
+  std::vector<std::uint8_t> seen(size_, 0);
+  std::vector<std::uint32_t> next; // one node's unseen neighbors (RCM)
+
+  // Appends everything reachable from `start` in breadth-first order; RCM
+  // enqueues each node's unseen neighbors lowest degree first.
+  auto bfs = [&](std::uint32_t start) {
+    seen[start] = 1;
+    order.push_back(start);
+    for (std::size_t head = order.size() - 1; head < order.size(); ++head) {
+      const std::uint32_t* block = links_at(order[head], 0);
+      next.clear();
+      for (std::uint32_t j = 1; j <= block[0]; ++j) {
+        if (!seen[block[j]]) {
+          seen[block[j]] = 1;
+          next.push_back(block[j]);
+        }
+      }
+      if (method == ReorderMethod::RCM) {
+        std::stable_sort(next.begin(), next.end(), [&](std::uint32_t a, std::uint32_t b) {
+          return links_at(a, 0)[0] < links_at(b, 0)[0];
+        });
+      }
+      order.insert(order.end(), next.begin(), next.end());
+    }
+  };
+
+  if (method == ReorderMethod::BFS) {
+    // The entry point first, then whatever its component does not reach.
+    bfs(unpack_entry(entry_.load(std::memory_order_acquire)));
+    for (std::size_t idx = 0; idx < size_; ++idx) {
+      if (!seen[idx]) {
+        bfs(static_cast<std::uint32_t>(idx));
+      }
+    }
+  } else {
+    // Each component starts from its lowest-degree node.
+    std::vector<std::uint32_t> by_degree(size_);
+    for (std::size_t idx = 0; idx < size_; ++idx) {
+      by_degree[idx] = static_cast<std::uint32_t>(idx);
+    }
+    std::stable_sort(by_degree.begin(), by_degree.end(), [&](std::uint32_t a, std::uint32_t b) {
+      return links_at(a, 0)[0] < links_at(b, 0)[0];
+    });
+    for (const std::uint32_t idx : by_degree) {
+      if (!seen[idx]) {
+        bfs(idx);
+      }
+    }
+    std::reverse(order.begin(), order.end());
+  }
+
+  permute(order);
+}
+
+void HnswIndex::permute(const std::vector<std::uint32_t>& order) {
+  constexpr std::uint32_t kGone = std::numeric_limits<std::uint32_t>::max();
+  std::vector<std::uint32_t> remap(size_, kGone);
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    remap[order[i]] = static_cast<std::uint32_t>(i);
+  }
+  const auto kept = static_cast<std::uint32_t>(order.size());
+
+  // Copies one link block with renumbered targets.
+  auto copy_block = [&](const std::uint32_t* src, std::uint32_t* dst) {
+    std::uint32_t count = 0;
+    for (std::uint32_t j = 1; j <= src[0]; ++j) {
+      const std::uint32_t to = remap[src[j]];
+      if (to != kGone) {
+        dst[++count] = to;
+      }
+    }
+    dst[0] = count;
+  };
+
+  FlatArray<std::uint32_t> links0(links0_.memory_policy());
+  FlatArray<std::uint32_t> links_upper;
+  FlatArray<std::uint32_t> upper_block;
+  links0.resize(static_cast<std::size_t>(kept) * (M0_ + 1), 0);
+  upper_block.reserve(kept);
+  std::size_t upper_blocks = 0;
+  for (const std::uint32_t old : order) {
+    upper_blocks += levels_[old];
+  }
+  links_upper.resize(upper_blocks * (M_ + 1), 0);
+
+  upper_blocks = 0;
+  std::uint32_t entry = kGone;
+  int top = -1;
+  for (std::uint32_t to = 0; to < kept; ++to) {
+    const std::uint32_t old = order[to];
+    copy_block(links_at(old, 0), links0.data() + (static_cast<std::size_t>(to) * (M0_ + 1)));
+    upper_block.push_back(static_cast<std::uint32_t>(upper_blocks));
+    for (int l = 1; l <= levels_[old]; ++l) {
+      copy_block(links_at(old, l), links_upper.data() + (upper_blocks * (M_ + 1)));
+      ++upper_blocks;
+    }
+    if (static_cast<int>(levels_[old]) > top) {
+      top = levels_[old];
+      entry = to;
+    }
+  }
+
+  // Keep the old entry point if it survived; otherwise the first of the
+  // highest-level survivors takes over.
+  const std::uint64_t packed = entry_.load(std::memory_order_acquire);
+  const std::uint32_t old_entry = unpack_entry(packed);
+  if (packed != 0 && remap[old_entry] != kGone) {
+    entry = remap[old_entry];
+    top = unpack_level(packed);
+  }
+
+  permute_rows(embeddings_, dim_, order);
+  permute_rows(codes_, code_size(), order);
+  permute_rows(ids_, 1, order);
+  permute_rows(levels_, 1, order);
+  links0_ = std::move(links0);
+  links_upper_ = std::move(links_upper);
+  upper_block_ = std::move(upper_block);
+
+  size_ = kept;
+  entry_.store(kept > 0 ? pack_entry(entry, top) : 0, std::memory_order_release);
+  publish();
+  reserve_ingest();
+
+  // Nodes moved; the map is rebuilt on the next remove() / upsert().
+  id_map_.clear();
+  id_map_ready_ = false;
+}
+
+void HnswIndex::search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores,
+                       const SearchFilter* filter) const {
   if (!query) {
     throw std::invalid_argument("query pointer is null");
   }
@@ -121,82 +939,372 @@ void HnswIndex::search(const float* query, std::size_t k, std::uint64_t* out_ids
   if (k == 0) {
     return;
   }
+  const Snapshot snap = snapshot();
+  search_one(query, k, out_ids, out_scores, filter, scan_filtered(filter, beam_width(k), snap.rows), snap);
+}
 
-  if (size_ == 0) {
+bool HnswIndex::scan_filtered(const SearchFilter* filter, std::size_t ef, std::size_t rows) const {
+  if (!filter || rows == 0) {
+    return false;
+  }
+  const double allowed = filter->selectivity(ids_.data(), rows);
+  return allowed < kFilterScanSelectivity || allowed * static_cast<double>(rows) < static_cast<double>(ef);
+}
+
+void HnswIndex::search_one(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores,
+                           const SearchFilter* filter, bool scan, const Snapshot& snap) const {
+  const QueryTimer timer(stats_enabled_);
+  if (snap.entry == 0 || snap.rows == deleted_.count()) {
     for (std::size_t i = 0; i < k; ++i) {
       out_ids[i] = std::numeric_limits<std::uint64_t>::max();
       out_scores[i] = std::numeric_limits<float>::infinity();
     }
+    QueryStats none;
+    timer.finish(*stats_, none);
     return;
   }
 
-  // Greedy best-first exploration from entrypoint 0.
-  // Real HNSW uses efSearch, candidate queues, and multi-level routing.
-  const std::size_t kk = std::min(k, size_);
+  const std::uint64_t packed = snap.entry;
+  auto scratch = visited_pool_->acquire();
+  scratch->stats.clear();
+  if (metric_ == Metric::COSINE) {
+    scratch->unit.assign(query, query + dim_);
+    normalize(scratch->unit.data(), dim_);
+    query = scratch->unit.data();
+  }
+  PreparedQuery& prepared = scratch->query;
+  prepare_query(query, prepared);
 
-  using Node = std::pair<float, std::uint32_t>; // (badness, index)
+  // Rerank widens the beam to k * rerank_factor code-space candidates.
+  const bool reranking = quantized() && rerank_factor_ > 0;
+  const std::size_t rerank_k = std::max(k, k * rerank_factor_);
+  std::vector<Candidate>& best = scratch->results;
 
-  auto better = [](const Node& a, const Node& b) { return a.first > b.first; };
-  std::priority_queue<Node, std::vector<Node>, decltype(better)> candidates(better);
+  if (scan) {
+    // Too few allowed nodes for the beam to find: score all of them, in the
+    // same closest-first form the beam leaves behind.
+    TopK<std::uint32_t>& top = scratch->top;
+    top.reset(reranking ? rerank_k : k);
+    std::size_t scored = 0;
+    for (std::size_t idx = 0; idx < snap.rows; ++idx) {
+      const auto node = static_cast<std::uint32_t>(idx);
+      if (!hidden(node, filter)) {
+        top.push(badness(prepared, node), node);
+        ++scored;
+      }
+    }
+    VECTORCORE_COUNT(scratch->stats.visited, snap.rows);
+    VECTORCORE_COUNT(scratch->stats.distances, scored);
+    VECTORCORE_COUNT(scratch->stats.heap_ops, top.accepted());
+    top.sort();
+    best.resize(top.size());
+    for (std::size_t i = 0; i < top.size(); ++i) {
+      best[i] = Candidate(top.badness()[i], top.ids()[i]);
+    }
+  } else if (concurrent_reads()) {
+    const std::uint32_t ep =
+        greedy_descend<true>(prepared, unpack_entry(packed), unpack_level(packed), 0, snap.rows, *scratch);
+    search_layer<true>(prepared, ep, beam_width(k), 0, snap.rows, *scratch, filter);
+  } else {
+    const std::uint32_t ep =
+        greedy_descend<false>(prepared, unpack_entry(packed), unpack_level(packed), 0, snap.rows, *scratch);
+    search_layer<false>(prepared, ep, beam_width(k), 0, snap.rows, *scratch, filter);
+  }
 
-  std::vector<std::uint8_t> visited(size_, 0);
+  if (reranking) {
+    // Exact scores pick the final k out of the first rerank_k of the beam.
+    TopK<std::uint32_t>& top = scratch->top;
+    top.reset(k);
+    const std::size_t n = std::min(best.size(), rerank_k);
+    for (std::size_t i = 0; i < n; ++i) {
+      top.push(badness_from_score(metric_, score(query, vector_at(best[i].second))), best[i].second);
+    }
+    VECTORCORE_COUNT(scratch->stats.distances, n);
+    VECTORCORE_COUNT(scratch->stats.heap_ops, top.accepted());
+    top.sort();
+    best.resize(top.size());
+    for (std::size_t i = 0; i < top.size(); ++i) {
+      best[i] = Candidate(top.badness()[i], top.ids()[i]);
+    }
+  }
 
-  auto push = [&](std::uint32_t idx) {
-    if (visited[idx]) {
-      return;
+  const std::size_t kk = std::min(k, best.size());
+  for (std::size_t i = 0; i < kk; ++i) {
+    const auto idx = best[i].second;
+    out_ids[i] = ids_[idx];
+    out_scores[i] = (metric_ == Metric::L2_SQUARED) ? best[i].first : -best[i].first;
+  }
+
+  for (std::size_t i = kk; i < k; ++i) {
+    out_ids[i] = std::numeric_limits<std::uint64_t>::max();
+    out_scores[i] = std::numeric_limits<float>::infinity();
+  }
+  timer.finish(*stats_, scratch->stats);
+}
+
+void HnswIndex::search_batch(const float* queries, std::size_t m, std::size_t k, std::uint64_t* out_ids,
+                             float* out_scores, std::size_t num_threads, const SearchFilter* filter) const {
+  if (!queries) {
+    throw std::invalid_argument("queries pointer is null");
+  }
+  if (!out_ids || !out_scores) {
+    throw std::invalid_argument("output pointers are null");
+  }
+  if (k == 0 || m == 0) {
+    return;
+  }
+
+  // The snapshot and the filter's strategy are decided once for the whole
+  // batch.
+  const Snapshot snap = snapshot();
+  const bool scan = scan_filtered(filter, beam_width(k), snap.rows);
+  auto run = [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+    for (std::size_t i = begin; i < end; ++i) {
+      search_one(queries + (i * dim_), k, out_ids + (i * k), out_scores + (i * k), filter, scan, snap);
+    }
+  };
+
+  if (num_threads == 1) {
+    run(0, m, 0);
+    return;
+  }
+
+  // Graph walks vary in cost, so hand out small chunks dynamically.
+  ThreadPool& pool = thread_pool();
+  const std::size_t threads = (num_threads == 0) ? pool.num_threads() : num_threads;
+  const std::size_t grain = std::max<std::size_t>(1, std::min<std::size_t>(64, m / (threads * 8)));
+  pool.parallel_for(m, grain, run, num_threads);
+}
+
+void HnswIndex::range_search(const float* queries, std::size_t m, float radius, RangeSearchResult& out,
+                             std::size_t num_threads, const SearchFilter* filter) const {
+  if (!queries && m > 0) {
+    throw std::invalid_argument("queries pointer is null");
+  }
+
+  std::vector<RangeSearchResult::Hits> hits(m);
+  const Snapshot snap = snapshot();
+  auto run = [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+    for (std::size_t i = begin; i < end; ++i) {
+      range_one(queries + (i * dim_), radius, filter, snap, hits[i]);
     }
-    visited[idx] = 1;
-    const float* v = embeddings_.data() + (static_cast<std::size_t>(idx) * dim_);
-    const float s = score(query, v);
-    const float b = badness_from_score(metric_, s);
-    candidates.emplace(b, idx);
   };
 
-  push(0);
+  if (num_threads == 1 || m <= 1) {
+    run(0, m, 0);
+  } else {
+    ThreadPool& pool = thread_pool();
+    const std::size_t threads = (num_threads == 0) ? pool.num_threads() : num_threads;
+    const std::size_t grain = std::max<std::size_t>(1, std::min<std::size_t>(64, m / (threads * 8)));
+    pool.parallel_for(m, grain, run, num_threads);
+  }
+  out.assign(hits, metric_);
+}
+
+void HnswIndex::range_one(const float* query, float radius, const SearchFilter* filter, const Snapshot& snap,
+                          RangeSearchResult::Hits& hits) const {
+  if (snap.entry == 0 || snap.rows == deleted_.count()) {
+    return;
+  }
 
-  // Keep a max-heap of the best results.
-  auto worse = [](const Node& a, const Node& b) { return a.first < b.first; };
-  std::priority_queue<Node, std::vector<Node>, decltype(worse)> best(worse);
+  const std::uint64_t packed = snap.entry;
+  auto scratch = visited_pool_->acquire();
+  if (metric_ == Metric::COSINE) {
+    scratch->unit.assign(query, query + dim_);
+    normalize(scratch->unit.data(), dim_);
+    query = scratch->unit.data();
+  }
+  PreparedQuery& prepared = scratch->query;
+  prepare_query(query, prepared);
 
-  // Fixed exploration budget for the prototype.
-  const std::size_t ef = std::min<std::size_t>(64, size_);
+  // The beam runs unfiltered: filtered nodes inside the ball are still
+  // needed as seeds and bridges, they are only left out of the hits.
+  const bool concurrent = concurrent_reads();
+  const std::size_t ef = std::max<std::size_t>(ef_search_, 1);
+  if (concurrent) {
+    const std::uint32_t ep =
+        greedy_descend<true>(prepared, unpack_entry(packed), unpack_level(packed), 0, snap.rows, *scratch);
+    search_layer<true>(prepared, ep, ef, 0, snap.rows, *scratch);
+  } else {
+    const std::uint32_t ep =
+        greedy_descend<false>(prepared, unpack_entry(packed), unpack_level(packed), 0, snap.rows, *scratch);
+    search_layer<false>(prepared, ep, ef, 0, snap.rows, *scratch);
+  }
 
-  while (!candidates.empty() && visited.size() > 0 && (best.size() < ef)) {
-    const auto [b, idx] = candidates.top();
-    candidates.pop();
+  const float bound = badness_from_score(metric_, radius);
+  const bool reranking = quantized() && rerank_factor_ > 0;
+  auto keep = [&](float b, std::uint32_t idx) {
+    if (hidden(idx, filter)) {
+      return;
+    }
+    if (reranking) {
+      b = badness_from_score(metric_, score(query, vector_at(idx)));
+      if (b > bound) {
+        return;
+      }
+    }
+    hits.emplace_back(b, ids_[idx]);
+  };
 
-    if (best.size() < ef) {
-      best.emplace(b, idx);
-    } else if (b < best.top().first) {
-      best.pop();
-      best.emplace(b, idx);
+  // Flood fill from the beam's hits, expanding every node inside the ball
+  // once. Depth-first: the order does not matter, only the visited set.
+  VisitedTable& visited = scratch->visited;
+  visited.prepare(snap.rows);
+  std::vector<Candidate>& frontier = scratch->candidates;
+  frontier.clear();
+  for (const Candidate& c : scratch->results) {
+    if (c.first > bound) {
+      break;
     }
+    visited.mark(c.second);
+    frontier.push_back(c);
+  }
+
+  while (!frontier.empty()) {
+    const Candidate c = frontier.back();
+    frontier.pop_back();
+    keep(c.first, c.second);
 
-    for (const std::uint32_t nb : neighbors_[idx]) {
-      push(nb);
+    const std::uint32_t* links;
+    std::uint32_t count;
+    if (concurrent) {
+      auto lock = lock_links(c.second, true);
+      const std::uint32_t* block = links_at(c.second, 0);
+      scratch->links.assign(block + 1, block + 1 + block[0]);
+      lock.unlock();
+      links = scratch->links.data();
+      count = static_cast<std::uint32_t>(scratch->links.size());
+    } else {
+      const std::uint32_t* block = links_at(c.second, 0);
+      links = block + 1;
+      count = block[0];
+    }
+    for (std::uint32_t j = 0; j < count; ++j) {
+      const std::uint32_t nb = links[j];
+      if (nb >= snap.rows || visited.test_and_mark(nb)) {
+        continue;
+      }
+      const float b = badness(prepared, nb);
+      if (b <= bound) {
+        frontier.emplace_back(b, nb);
+      }
     }
   }
+}
+
+// Header params: [0] M, [1] ef_construction, [2] ef_search, [3] packed
+// entry word, [4] pq_m, [5] next default id.
+void HnswIndex::save(const std::string& path) const {
+  IndexWriter writer(IndexKind::HNSW);
+  IndexFileHeader& h = writer.header();
+  h.metric = static_cast<std::uint32_t>(metric_);
+  h.storage = static_cast<std::uint32_t>(storage_);
+  h.dim = dim_;
+  h.size = size_;
+  h.rerank_factor = rerank_factor_;
+  h.params[0] = M_;
+  h.params[1] = ef_construction_;
+  h.params[2] = ef_search_;
+  h.params[3] = entry_.load(std::memory_order_acquire);
+  h.params[4] = (storage_ == Storage::PQ) ? pq_.m() : 0;
+  h.params[5] = next_id_;
+
+  writer.add(Section::EMBEDDINGS, embeddings_.data(), embeddings_.size());
+  writer.add(Section::IDS, ids_.data(), ids_.size());
+  writer.add(Section::TOMBSTONES, deleted_.words().data(), deleted_.words().size());
+  writer.add(Section::CODES, codes_.data(), codes_.size());
+  writer.add(Section::LINKS0, links0_.data(), links0_.size());
+  writer.add(Section::LINKS_UPPER, links_upper_.data(), links_upper_.size());
+  writer.add(Section::UPPER_BLOCK, upper_block_.data(), upper_block_.size());
+  writer.add(Section::LEVELS, levels_.data(), levels_.size());
+  writer.add(Section::SQ_VMIN, quantizer_.vmin().data(), quantizer_.vmin().size());
+  writer.add(Section::SQ_SCALE, quantizer_.scale().data(), quantizer_.scale().size());
+  writer.add(Section::PQ_CODEBOOKS, pq_.codebooks(), pq_.codebooks_size());
+  writer.write(path);
+}
 
-  // Convert best set to top-k.
-  std::vector<Node> tmp;
-  tmp.reserve(best.size());
-  while (!best.empty()) {
-    tmp.push_back(best.top());
-    best.pop();
+std::unique_ptr<HnswIndex> HnswIndex::load(const std::string& path, bool mmap) {
+  const IndexReader reader(path, IndexKind::HNSW, mmap);
+  const IndexFileHeader& h = reader.header();
+
+  // The level RNG only matters for later add() calls; reseed from the size
+  // so those stay deterministic.
+  auto index = std::make_unique<HnswIndex>(
+      static_cast<std::size_t>(h.dim), static_cast<std::size_t>(h.params[0]), static_cast<Metric>(h.metric),
+      static_cast<std::size_t>(h.params[1]), 100 + h.size, static_cast<Storage>(h.storage),
+      static_cast<std::size_t>(h.rerank_factor), static_cast<std::size_t>(h.params[4]));
+  HnswIndex& x = *index;
+  const std::size_t n = static_cast<std::size_t>(h.size);
+  if (n > std::numeric_limits<std::uint32_t>::max() || (n > 0 && unpack_entry(h.params[3]) >= n)) {
+    throw std::runtime_error("index file '" + path + "': corrupt header");
   }
 
-  std::sort(tmp.begin(), tmp.end(), [](const Node& a, const Node& b) { return a.first < b.first; });
+  if (reader.count(Section::SQ_VMIN, sizeof(float)) > 0) {
+    x.quantizer_.restore(reader.copy<float>(Section::SQ_VMIN, x.dim_), reader.copy<float>(Section::SQ_SCALE, x.dim_));
+  }
+  if (x.storage_ == Storage::PQ) {
+    const std::size_t books = reader.count(Section::PQ_CODEBOOKS, sizeof(float));
+    if (books > 0) {
+      const auto codebooks = reader.copy<float>(Section::PQ_CODEBOOKS, books);
+      x.pq_.restore(codebooks.data(), codebooks.size());
+    }
+  }
 
-  for (std::size_t i = 0; i < kk; ++i) {
-    const auto idx = tmp[i].second;
-    out_ids[i] = ids_[idx];
-    out_scores[i] = (metric_ == Metric::L2_SQUARED) ? tmp[i].first : -tmp[i].first;
+  reader.view(Section::EMBEDDINGS, x.has_fp32() ? n * x.dim_ : 0, x.embeddings_);
+  reader.view(Section::IDS, n, x.ids_);
+  reader.view(Section::CODES, x.quantized() ? n * x.code_size() : 0, x.codes_);
+  reader.view(Section::LINKS0, n * (x.M0_ + 1), x.links0_);
+  reader.view(Section::LINKS_UPPER, reader.count(Section::LINKS_UPPER, sizeof(std::uint32_t)), x.links_upper_);
+  reader.view(Section::UPPER_BLOCK, n, x.upper_block_);
+  reader.view(Section::LEVELS, n, x.levels_);
+  if (x.links_upper_.size() % (x.M_ + 1) != 0) {
+    throw std::runtime_error("index file '" + path + "': corrupt upper link table");
   }
 
-  for (std::size_t i = kk; i < k; ++i) {
-    out_ids[i] = std::numeric_limits<std::uint64_t>::max();
-    out_scores[i] = std::numeric_limits<float>::infinity();
+  // Searches index rows, blocks and levels straight from these arrays, so a
+  // truncated or corrupt file must fail here rather than read out of bounds.
+  const auto corrupt_graph = [&path] {
+    return std::runtime_error("index file '" + path + "': corrupt graph");
+  };
+  const auto check_block = [&](const std::uint32_t* block, std::size_t cap) {
+    if (block[0] > cap) {
+      throw corrupt_graph();
+    }
+    for (std::uint32_t j = 1; j <= block[0]; ++j) {
+      if (block[j] >= n) {
+        throw corrupt_graph();
+      }
+    }
+  };
+  const std::size_t upper_blocks = x.links_upper_.size() / (x.M_ + 1);
+  for (std::size_t i = 0; i < n; ++i) {
+    check_block(x.links0_.data() + (i * (x.M0_ + 1)), x.M0_);
+    const std::size_t level = x.levels_[i];
+    if (level > 0 && static_cast<std::size_t>(x.upper_block_[i]) + level > upper_blocks) {
+      throw corrupt_graph();
+    }
+    for (std::size_t l = 0; l < level; ++l) {
+      check_block(x.links_upper_.data() + ((x.upper_block_[i] + l) * (x.M_ + 1)), x.M_);
+    }
+  }
+  if (n > 0 && unpack_level(h.params[3]) != x.levels_[unpack_entry(h.params[3])]) {
+    throw corrupt_graph();
   }
+
+  FlatArray<std::uint64_t> deleted;
+  const std::size_t words = reader.count(Section::TOMBSTONES, sizeof(std::uint64_t));
+  if (words > (n + 63) / 64) {
+    throw std::runtime_error("index file '" + path + "': corrupt tombstone bitmap");
+  }
+  reader.view(Section::TOMBSTONES, words, deleted);
+  x.deleted_.restore(std::move(deleted));
+
+  x.size_ = n;
+  x.next_id_ = std::max<std::uint64_t>(h.params[5], n);
+  x.ef_search_ = static_cast<std::size_t>(h.params[2]);
+  x.entry_.store(h.params[3], std::memory_order_release);
+  x.publish();
+  return index;
 }
 
 } // namespace vectorcore
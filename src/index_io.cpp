@@ -0,0 +1,269 @@
+#include "vectorcore/index_io.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "vectorcore/aligned_allocator.h"
+#include "vectorcore/distance.h"
+#include "vectorcore/scalar_quantizer.h"
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace vectorcore {
+
+namespace {
+constexpr char kMagic[8] = {'V', 'C', 'I', 'N', 'D', 'E', 'X', '\0'};
+constexpr std::uint32_t kEndianTag = 0x01020304u;
+
+// Everything before the first section: header plus section table.
+constexpr std::size_t kMaxSections = (kIndexSectionAlignment - sizeof(IndexFileHeader)) / sizeof(SectionEntry);
+
+std::uint64_t align_up(std::uint64_t x) noexcept {
+  return (x + (kIndexSectionAlignment - 1)) & ~static_cast<std::uint64_t>(kIndexSectionAlignment - 1);
+}
+
+[[noreturn]] void fail(const std::string& path, const char* what) {
+  throw std::runtime_error("index file '" + path + "': " + what);
+}
+} // namespace
+
+// The file's bytes: a read-only mapping, or one aligned heap buffer.
+class IndexReader::Mapping {
+public:
+  Mapping(const std::string& path, bool use_mmap) {
+    if (use_mmap) {
+      map(path);
+    } else {
+      read(path);
+    }
+  }
+
+  ~Mapping() {
+    if (!mapped_) {
+      return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(mapped_);
+#else
+    munmap(mapped_, size_);
+#endif
+  }
+
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+
+  const std::uint8_t* data() const noexcept {
+    return mapped_ ? static_cast<const std::uint8_t*>(mapped_) : buffer_.data();
+  }
+  std::size_t size() const noexcept { return size_; }
+
+private:
+  void* mapped_ = nullptr;
+  std::size_t size_ = 0;
+  std::vector<std::uint8_t, AlignedAllocator<std::uint8_t, kIndexSectionAlignment>> buffer_;
+
+  void read(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+      fail(path, "cannot open");
+    }
+    size_ = static_cast<std::size_t>(in.tellg());
+    buffer_.resize(size_);
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(size_))) {
+      fail(path, "read failed");
+    }
+  }
+
+  void map(const std::string& path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      fail(path, "cannot open");
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      CloseHandle(file);
+      fail(path, "cannot stat");
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    if (size_ < sizeof(IndexFileHeader)) {
+      CloseHandle(file);
+      fail(path, "truncated header");
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+      fail(path, "mmap failed");
+    }
+    mapped_ = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!mapped_) {
+      fail(path, "mmap failed");
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      fail(path, "cannot open");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      fail(path, "cannot stat");
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ < sizeof(IndexFileHeader)) {
+      ::close(fd);
+      fail(path, "truncated header");
+    }
+    // MAP_SHARED + PROT_READ: pages come from the page cache and are shared
+    // with every other process mapping the same file.
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      fail(path, "mmap failed");
+    }
+    mapped_ = p;
+#endif
+  }
+};
+
+IndexWriter::IndexWriter(IndexKind kind) {
+  std::memcpy(header_.magic, kMagic, sizeof(kMagic));
+  header_.version = kIndexFormatVersion;
+  header_.kind = static_cast<std::uint32_t>(kind);
+  header_.endian = kEndianTag;
+}
+
+void IndexWriter::write(const std::string& path) {
+  if (sections_.size() > kMaxSections) {
+    fail(path, "too many sections");
+  }
+
+  std::vector<SectionEntry> table;
+  table.reserve(sections_.size());
+  std::uint64_t offset = kIndexSectionAlignment;
+  for (const Pending& s : sections_) {
+    table.push_back({static_cast<std::uint32_t>(s.tag), s.elem_size, offset, s.bytes});
+    offset = align_up(offset + s.bytes);
+  }
+  header_.num_sections = static_cast<std::uint32_t>(table.size());
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    fail(path, "cannot open for writing");
+  }
+
+  // Header page, zero padded.
+  std::vector<char> page(kIndexSectionAlignment, 0);
+  std::memcpy(page.data(), &header_, sizeof(header_));
+  if (!table.empty()) {
+    std::memcpy(page.data() + sizeof(header_), table.data(), table.size() * sizeof(SectionEntry));
+  }
+  out.write(page.data(), static_cast<std::streamsize>(page.size()));
+
+  std::uint64_t pos = kIndexSectionAlignment;
+  for (std::size_t i = 0; i < sections_.size(); ++i) {
+    if (sections_[i].bytes > 0) {
+      out.write(static_cast<const char*>(sections_[i].data), static_cast<std::streamsize>(sections_[i].bytes));
+    }
+    pos += sections_[i].bytes;
+    const std::uint64_t next = align_up(pos);
+    if (next > pos && i + 1 < sections_.size()) {
+      const std::vector<char> pad(static_cast<std::size_t>(next - pos), 0);
+      out.write(pad.data(), static_cast<std::streamsize>(pad.size()));
+    }
+    pos = next;
+  }
+
+  out.flush();
+  if (!out) {
+    fail(path, "write failed");
+  }
+}
+
+IndexReader::IndexReader(const std::string& path, IndexKind expected, bool mmap) {
+  auto mapping = std::make_shared<const Mapping>(path, mmap);
+  mapping_ = mapping.get();
+  backing_ = mapping;
+
+  const std::size_t file_size = mapping_->size();
+  if (file_size < sizeof(IndexFileHeader)) {
+    fail(path, "truncated header");
+  }
+  std::memcpy(&header_, mapping_->data(), sizeof(header_));
+
+  if (std::memcmp(header_.magic, kMagic, sizeof(kMagic)) != 0) {
+    fail(path, "not a VectorCore index");
+  }
+  if (header_.endian != kEndianTag) {
+    fail(path, "written on a machine with a different byte order");
+  }
+  if (header_.version != kIndexFormatVersion) {
+    fail(path, "unsupported format version");
+  }
+  if (header_.kind != static_cast<std::uint32_t>(expected)) {
+    fail(path, "holds a different index type");
+  }
+  if (header_.metric > static_cast<std::uint32_t>(Metric::COSINE) ||
+      header_.storage > static_cast<std::uint32_t>(Storage::BINARY) || header_.dim == 0) {
+    fail(path, "corrupt header");
+  }
+  if (header_.num_sections > kMaxSections) {
+    fail(path, "corrupt section table");
+  }
+
+  sections_.resize(header_.num_sections);
+  if (!sections_.empty()) {
+    std::memcpy(sections_.data(), mapping_->data() + sizeof(header_), sections_.size() * sizeof(SectionEntry));
+  }
+  for (const SectionEntry& s : sections_) {
+    if (s.offset % kIndexSectionAlignment != 0 || s.offset > file_size || s.bytes > file_size - s.offset) {
+      fail(path, "section out of bounds");
+    }
+  }
+}
+
+const std::uint8_t* IndexReader::base() const noexcept { return mapping_->data(); }
+
+std::size_t IndexReader::count(Section tag, std::size_t elem_size) const {
+  for (const SectionEntry& s : sections_) {
+    if (s.tag == static_cast<std::uint32_t>(tag)) {
+      if (s.elem_size != elem_size || s.bytes % elem_size != 0) {
+        throw std::runtime_error("index file: section has the wrong element type");
+      }
+      return static_cast<std::size_t>(s.bytes / elem_size);
+    }
+  }
+  return 0;
+}
+
+const SectionEntry* IndexReader::find(Section tag, std::size_t elem_size, std::size_t bytes) const {
+  for (const SectionEntry& s : sections_) {
+    if (s.tag != static_cast<std::uint32_t>(tag)) {
+      continue;
+    }
+    if (s.elem_size != elem_size || s.bytes != bytes) {
+      throw std::runtime_error("index file: section size does not match the header");
+    }
+    return &s;
+  }
+  if (bytes != 0) {
+    throw std::runtime_error("index file: missing section");
+  }
+  return nullptr;
+}
+
+} // namespace vectorcore
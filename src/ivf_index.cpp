@@ -0,0 +1,306 @@
+#include "vectorcore/ivf_index.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "vectorcore/kmeans.h"
+#include "vectorcore/thread_pool.h"
+#include "vectorcore/topk.h"
+
+namespace vectorcore {
+
+namespace {
+inline float badness_from_score(Metric metric, float score) noexcept {
+  return (metric == Metric::L2_SQUARED) ? score : -score;
+}
+
+// Selects (badness, (list << 32) | row) pairs. Rows of one list have
+// consecutive locations, so a list is pushed block by block.
+using Selector = TopK<std::uint64_t>;
+
+// Rows scored per push_block() call.
+constexpr std::size_t kScanBlock = 64;
+
+inline std::uint64_t pack_location(std::size_t list, std::size_t row) noexcept {
+  return (static_cast<std::uint64_t>(list) << 32) | static_cast<std::uint64_t>(row);
+}
+} // namespace
+
+IvfIndex::IvfIndex(std::size_t dim, std::size_t nlist, Metric metric, std::uint64_t seed, std::size_t pq_m,
+                   std::size_t rerank_factor)
+    : dim_(dim),
+      nlist_(nlist),
+      pq_m_(pq_m),
+      rerank_factor_(rerank_factor),
+      metric_(metric),
+      distance_(distance_kernels().fp32_for(metric, dim)),
+      seed_(seed),
+      coarse_(dim, kernel_metric(metric)) {
+  if (dim_ == 0) {
+    throw std::invalid_argument("dim must be > 0");
+  }
+  if (nlist_ == 0) {
+    throw std::invalid_argument("nlist must be > 0");
+  }
+  if (nlist_ > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::invalid_argument("nlist must fit in uint32");
+  }
+  if (pq_m_ > 0) {
+    pq_ = ProductQuantizer(dim_, pq_m_, kernel_metric(metric_));
+  } else if (rerank_factor_ > 0) {
+    throw std::invalid_argument("rerank_factor requires pq_m > 0");
+  }
+}
+
+float IvfIndex::badness(const float* a, const float* b) const noexcept {
+  return badness_from_score(metric_, distance_(a, b, dim_));
+}
+
+void IvfIndex::train(const float* vectors, std::size_t n, std::size_t num_threads, std::size_t niter) {
+  if (!vectors) {
+    throw std::invalid_argument("vectors pointer is null");
+  }
+  if (size_ != 0) {
+    throw std::logic_error("train() must be called before add()");
+  }
+  if (n < nlist_) {
+    throw std::invalid_argument("train() needs at least nlist vectors");
+  }
+  if (pq_m_ > 0 && n < ProductQuantizer::kCentroids) {
+    throw std::invalid_argument("train() with PQ needs at least 256 vectors");
+  }
+
+  // COSINE trains on unit rows; everything below is plain IP on them.
+  std::vector<float> unit;
+  if (metric_ == Metric::COSINE) {
+    unit.assign(vectors, vectors + (n * dim_));
+    normalize_rows(unit.data(), n, dim_);
+    vectors = unit.data();
+  }
+
+  centroids_.resize(nlist_ * dim_);
+  kmeans(vectors, n, dim_, nlist_, centroids_.data(), kernel_metric(metric_), niter, seed_, num_threads);
+
+  coarse_ = BruteForceIndex(dim_, kernel_metric(metric_));
+  coarse_.add(centroids_.data(), nlist_);
+
+  if (pq_m_ > 0) {
+    // Residuals of an evenly strided sample.
+    const std::size_t rows = std::min(n, kMaxPqTrainRows);
+    const std::size_t stride = n / rows;
+    std::vector<float> sample(rows * dim_);
+    for (std::size_t i = 0; i < rows; ++i) {
+      std::copy_n(vectors + (i * stride * dim_), dim_, sample.data() + (i * dim_));
+    }
+    std::vector<std::uint64_t> assign(rows);
+    std::vector<float> assign_scores(rows);
+    coarse_.search_batch(sample.data(), rows, 1, assign.data(), assign_scores.data(), num_threads);
+    for (std::size_t i = 0; i < rows; ++i) {
+      const float* c = centroid(assign[i]);
+      float* r = sample.data() + (i * dim_);
+      for (std::size_t d = 0; d < dim_; ++d) {
+        r[d] -= c[d];
+      }
+    }
+    pq_.train(sample.data(), rows, num_threads);
+  }
+
+  lists_.assign(nlist_, InvertedList{});
+  trained_ = true;
+}
+
+void IvfIndex::add(const float* vectors, std::size_t n, const std::uint64_t* ids, std::size_t num_threads) {
+  if (!vectors) {
+    throw std::invalid_argument("vectors pointer is null");
+  }
+  if (!trained_) {
+    throw std::logic_error("IvfIndex must be trained before add()");
+  }
+  if (n == 0) {
+    return;
+  }
+
+  std::vector<float> unit;
+  if (metric_ == Metric::COSINE) {
+    unit.assign(vectors, vectors + (n * dim_));
+    normalize_rows(unit.data(), n, dim_);
+    vectors = unit.data();
+  }
+
+  std::vector<std::uint64_t> assign(n);
+  std::vector<float> assign_scores(n);
+  coarse_.search_batch(vectors, n, 1, assign.data(), assign_scores.data(), num_threads);
+
+  std::vector<std::uint8_t> codes;
+  if (pq_m_ > 0) {
+    std::vector<float> residuals(vectors, vectors + (n * dim_));
+    for (std::size_t i = 0; i < n; ++i) {
+      const float* c = centroid(assign[i]);
+      float* r = residuals.data() + (i * dim_);
+      for (std::size_t d = 0; d < dim_; ++d) {
+        r[d] -= c[d];
+      }
+    }
+    codes.resize(n * pq_m_);
+    pq_.encode(residuals.data(), n, codes.data(), num_threads);
+  }
+
+  // Append in input order, so ids within a list keep their insertion order.
+  for (std::size_t i = 0; i < n; ++i) {
+    InvertedList& list = lists_[assign[i]];
+    if (has_fp32()) {
+      const float* v = vectors + (i * dim_);
+      list.vectors.insert(list.vectors.end(), v, v + dim_);
+    }
+    if (pq_m_ > 0) {
+      const std::uint8_t* code = codes.data() + (i * pq_m_);
+      list.codes.insert(list.codes.end(), code, code + pq_m_);
+    }
+    list.ids.push_back(ids ? ids[i] : static_cast<std::uint64_t>(size_ + i));
+  }
+
+  size_ += n;
+}
+
+void IvfIndex::search(const float* query, std::size_t k, std::uint64_t* out_ids, float* out_scores,
+                      std::size_t nprobe) const {
+  if (!query) {
+    throw std::invalid_argument("query pointer is null");
+  }
+  if (!out_ids || !out_scores) {
+    throw std::invalid_argument("output pointers are null");
+  }
+  if (k == 0) {
+    return;
+  }
+
+  std::vector<float> unit;
+  if (metric_ == Metric::COSINE) {
+    unit.assign(query, query + dim_);
+    normalize(unit.data(), dim_);
+    query = unit.data();
+  }
+
+  Selector best;
+  if (trained_ && size_ > 0) {
+    nprobe = std::min(nprobe == 0 ? std::max<std::size_t>(1, nprobe_) : nprobe, nlist_);
+
+    std::vector<std::uint64_t> probes(nprobe);
+    std::vector<float> probe_scores(nprobe);
+    coarse_.search(query, nprobe, probes.data(), probe_scores.data());
+
+    float block[kScanBlock];
+    const std::size_t kk = std::min(k, size_);
+    if (pq_m_ == 0) {
+      best.reset(kk);
+      for (const std::uint64_t list_id : probes) {
+        const InvertedList& list = lists_[list_id];
+        for (std::size_t r0 = 0; r0 < list.ids.size(); r0 += kScanBlock) {
+          const std::size_t bn = std::min(kScanBlock, list.ids.size() - r0);
+          for (std::size_t i = 0; i < bn; ++i) {
+            block[i] = badness(query, list.vectors.data() + ((r0 + i) * dim_));
+          }
+          best.push_block(block, pack_location(list_id, r0), bn);
+        }
+      }
+    } else {
+      best.reset((rerank_factor_ > 0) ? std::min(kk * rerank_factor_, size_) : kk);
+
+      // score(q, c + r) = score(q - c, r) for L2, q . c + q . r for IP. IP
+      // needs one table; its q . c term is the coarse score of the list.
+      const bool l2 = (metric_ == Metric::L2_SQUARED);
+      const DistanceKernels& kernels = distance_kernels();
+      std::vector<float> table(pq_m_ * ProductQuantizer::kCentroids);
+      std::vector<float> residual;
+      if (l2) {
+        residual.resize(dim_);
+      } else {
+        pq_.compute_table(query, table.data());
+      }
+
+      for (std::size_t p = 0; p < probes.size(); ++p) {
+        const std::uint64_t list_id = probes[p];
+        const InvertedList& list = lists_[list_id];
+        if (list.ids.empty()) {
+          continue;
+        }
+        float bias = 0.0f;
+        if (l2) {
+          const float* c = centroid(list_id);
+          for (std::size_t d = 0; d < dim_; ++d) {
+            residual[d] = query[d] - c[d];
+          }
+          pq_.compute_table(residual.data(), table.data());
+        } else {
+          bias = probe_scores[p];
+        }
+        for (std::size_t r0 = 0; r0 < list.ids.size(); r0 += kScanBlock) {
+          const std::size_t bn = std::min(kScanBlock, list.ids.size() - r0);
+          for (std::size_t i = 0; i < bn; ++i) {
+            const float s = bias + kernels.pq_adc(table.data(), list.codes.data() + ((r0 + i) * pq_m_), pq_m_);
+            block[i] = badness_from_score(metric_, s);
+          }
+          best.push_block(block, pack_location(list_id, r0), bn);
+        }
+      }
+
+      if (rerank_factor_ > 0) {
+        best.sort();
+        float* badness_out = best.badness();
+        for (std::size_t i = 0; i < best.size(); ++i) {
+          const std::uint64_t loc = best.ids()[i];
+          const std::size_t list_id = static_cast<std::size_t>(loc >> 32);
+          const std::size_t r = static_cast<std::size_t>(loc & 0xFFFFFFFFu);
+          badness_out[i] = badness(query, lists_[list_id].vectors.data() + (r * dim_));
+        }
+        best.truncate(kk);
+      }
+    }
+    best.sort();
+  }
+
+  for (std::size_t i = 0; i < best.size(); ++i) {
+    const std::uint64_t loc = best.ids()[i];
+    const std::size_t list_id = static_cast<std::size_t>(loc >> 32);
+    const std::size_t r = static_cast<std::size_t>(loc & 0xFFFFFFFFu);
+    out_ids[i] = lists_[list_id].ids[r];
+    out_scores[i] = (metric_ == Metric::L2_SQUARED) ? best.badness()[i] : -best.badness()[i];
+  }
+  for (std::size_t i = best.size(); i < k; ++i) {
+    out_ids[i] = std::numeric_limits<std::uint64_t>::max();
+    out_scores[i] = std::numeric_limits<float>::infinity();
+  }
+}
+
+void IvfIndex::search_batch(const float* queries, std::size_t m, std::size_t k, std::uint64_t* out_ids,
+                            float* out_scores, std::size_t nprobe, std::size_t num_threads) const {
+  if (!queries) {
+    throw std::invalid_argument("queries pointer is null");
+  }
+  if (!out_ids || !out_scores) {
+    throw std::invalid_argument("output pointers are null");
+  }
+  if (k == 0 || m == 0) {
+    return;
+  }
+
+  auto run = [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+    for (std::size_t i = begin; i < end; ++i) {
+      search(queries + (i * dim_), k, out_ids + (i * k), out_scores + (i * k), nprobe);
+    }
+  };
+
+  if (num_threads == 1) {
+    run(0, m, 0);
+    return;
+  }
+
+  // List sizes vary, so hand out small chunks dynamically.
+  ThreadPool& pool = ThreadPool::global();
+  const std::size_t threads = (num_threads == 0) ? pool.num_threads() : num_threads;
+  const std::size_t grain = std::max<std::size_t>(1, std::min<std::size_t>(64, m / (threads * 8)));
+  pool.parallel_for(m, grain, run, num_threads);
+}
+
+} // namespace vectorcore
@@ -0,0 +1,143 @@
+#include "vectorcore/kmeans.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/thread_pool.h"
+
+namespace vectorcore {
+
+namespace {
+// Relative nudge applied when an empty cell takes over half of a large one.
+constexpr float kSplitEps = 1.0f / 1024.0f;
+} // namespace
+
+void kmeans(const float* x, std::size_t n, std::size_t dim, std::size_t k, float* centroids, Metric metric,
+            std::size_t niter, std::uint64_t seed, std::size_t num_threads) {
+  if (!x || !centroids) {
+    throw std::invalid_argument("kmeans: null pointer");
+  }
+  if (dim == 0 || k == 0) {
+    throw std::invalid_argument("kmeans: dim and k must be > 0");
+  }
+  if (n < k) {
+    throw std::invalid_argument("kmeans: needs at least k training vectors");
+  }
+
+  std::mt19937_64 rng(seed);
+
+  // Subsample.
+  std::vector<float> sample;
+  const std::size_t max_points = k * kKmeansMaxPointsPerCentroid;
+  if (n > max_points) {
+    std::vector<std::size_t> perm(n);
+    std::iota(perm.begin(), perm.end(), std::size_t{0});
+    for (std::size_t i = 0; i < max_points; ++i) {
+      std::uniform_int_distribution<std::size_t> pick(i, n - 1);
+      std::swap(perm[i], perm[pick(rng)]);
+    }
+    std::sort(perm.begin(), perm.begin() + max_points); // sequential reads below
+    sample.resize(max_points * dim);
+    for (std::size_t i = 0; i < max_points; ++i) {
+      std::copy_n(x + (perm[i] * dim), dim, sample.data() + (i * dim));
+    }
+    x = sample.data();
+    n = max_points;
+  }
+
+  // Seed with k distinct training rows.
+  {
+    std::vector<std::size_t> perm(n);
+    std::iota(perm.begin(), perm.end(), std::size_t{0});
+    for (std::size_t i = 0; i < k; ++i) {
+      std::uniform_int_distribution<std::size_t> pick(i, n - 1);
+      std::swap(perm[i], perm[pick(rng)]);
+    }
+    for (std::size_t c = 0; c < k; ++c) {
+      std::copy_n(x + (perm[c] * dim), dim, centroids + (c * dim));
+    }
+  }
+
+  ThreadPool& pool = ThreadPool::global();
+  std::vector<std::uint64_t> assign(n);
+  std::vector<float> assign_scores(n);
+  std::vector<std::size_t> counts(k);
+  std::vector<std::size_t> offsets(k + 1);
+  std::vector<std::size_t> order(n);
+
+  for (std::size_t iter = 0; iter < niter; ++iter) {
+    // Assignment step: nearest centroid per row, blocked and threaded.
+    BruteForceIndex quantizer(dim, metric);
+    quantizer.add(centroids, k);
+    quantizer.search_batch(x, n, 1, assign.data(), assign_scores.data(), num_threads);
+
+    // Bucket rows by cell (counting sort) so each cell's update only reads
+    // its own rows and cells can be updated independently.
+    std::fill(counts.begin(), counts.end(), std::size_t{0});
+    for (std::size_t i = 0; i < n; ++i) {
+      ++counts[assign[i]];
+    }
+    offsets[0] = 0;
+    for (std::size_t c = 0; c < k; ++c) {
+      offsets[c + 1] = offsets[c] + counts[c];
+    }
+    {
+      std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+      for (std::size_t i = 0; i < n; ++i) {
+        order[cursor[assign[i]]++] = i;
+      }
+    }
+
+    // Update step: each centroid becomes the mean of its rows. Accumulate
+    // in double; float sums over thousands of rows drift.
+    pool.parallel_for(k, 16, [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+      std::vector<double> sum(dim);
+      for (std::size_t c = begin; c < end; ++c) {
+        if (counts[c] == 0) {
+          continue;
+        }
+        std::fill(sum.begin(), sum.end(), 0.0);
+        for (std::size_t j = offsets[c]; j < offsets[c + 1]; ++j) {
+          const float* row = x + (order[j] * dim);
+          for (std::size_t d = 0; d < dim; ++d) {
+            sum[d] += row[d];
+          }
+        }
+        float* cent = centroids + (c * dim);
+        const double inv = 1.0 / static_cast<double>(counts[c]);
+        for (std::size_t d = 0; d < dim; ++d) {
+          cent[d] = static_cast<float>(sum[d] * inv);
+        }
+      }
+    }, num_threads);
+
+    // Empty cells: split the largest cell in two by nudging copies of its
+    // centroid in opposite directions (as in FAISS).
+    for (std::size_t c = 0; c < k; ++c) {
+      if (counts[c] != 0) {
+        continue;
+      }
+      const std::size_t big =
+          static_cast<std::size_t>(std::max_element(counts.begin(), counts.end()) - counts.begin());
+      if (counts[big] < 2) {
+        break;
+      }
+      float* dst = centroids + (c * dim);
+      float* src = centroids + (big * dim);
+      for (std::size_t d = 0; d < dim; ++d) {
+        const float nudge = (d % 2 == 0) ? kSplitEps : -kSplitEps;
+        dst[d] = src[d] * (1.0f + nudge);
+        src[d] = src[d] * (1.0f - nudge);
+      }
+      counts[c] = counts[big] / 2;
+      counts[big] -= counts[c];
+    }
+  }
+
+}
+
+} // namespace vectorcore
@@ -2,10 +2,12 @@
 #include <pybind11/pybind11.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 
 #include "VectorStore.hpp"
+#include "vectorcore/distance.h"
 
 namespace py = pybind11;
 
@@ -53,6 +55,46 @@ inline const float* require_1d_float32_contiguous(const py::array& arr, std::siz
   return ptr;
 }
 
+// Same checks for a (n, dim) C-contiguous float32 matrix; returns n.
+inline const float* require_2d_float32_contiguous(const py::array& arr, std::size_t expected_dim,
+                                                  std::size_t& rows) {
+  py::buffer_info buf = arr.request();
+
+  if (buf.ndim != 2) {
+    throw std::invalid_argument("Expected a 2D NumPy array of shape (n, dim)");
+  }
+  if (static_cast<std::size_t>(buf.shape[1]) != expected_dim) {
+    throw std::invalid_argument("dim mismatch: NumPy array width must equal store dim");
+  }
+  if (buf.itemsize != sizeof(float) || buf.format != py::format_descriptor<float>::format()) {
+    throw std::invalid_argument("Expected dtype float32");
+  }
+  if (buf.strides[1] != static_cast<py::ssize_t>(sizeof(float)) ||
+      buf.strides[0] != static_cast<py::ssize_t>(expected_dim * sizeof(float))) {
+    throw std::invalid_argument("Expected C-contiguous float32 array (no slicing/Fortran order)");
+  }
+
+  rows = static_cast<std::size_t>(buf.shape[0]);
+  return static_cast<const float*>(buf.ptr);
+}
+
+// External ids: a contiguous 1D uint64 array of `expected` entries.
+inline const std::uint64_t* require_uint64_ids(const py::array& arr, std::size_t expected) {
+  py::buffer_info buf = arr.request();
+
+  if (buf.ndim != 1 || static_cast<std::size_t>(buf.shape[0]) != expected) {
+    throw std::invalid_argument("ids must be a 1D array with one id per row");
+  }
+  // Not a format-string compare: NumPy spells uint64 'L' on LP64, pybind11 'Q'.
+  if (!buf.item_type_is_equivalent_to<std::uint64_t>()) {
+    throw std::invalid_argument("ids must be uint64");
+  }
+  if (buf.strides[0] != static_cast<py::ssize_t>(sizeof(std::uint64_t))) {
+    throw std::invalid_argument("ids must be contiguous");
+  }
+  return static_cast<const std::uint64_t*>(buf.ptr);
+}
+
 } // namespace
 
 PYBIND11_MODULE(vectorcore, m) {
@@ -60,6 +102,8 @@ PYBIND11_MODULE(vectorcore, m) {
   m.doc() = "VectorCore: zero-copy VectorStore bindings (pybind11)";
 
   m.def("ping", []() { return "VectorCore Online"; });
+  m.def("active_kernel", []() { return std::string(vectorcore::active_kernel()); },
+        "Name of the distance kernel family selected for this CPU (scalar/avx2/avx512/neon).");
 
   py::class_<vectorcore::VectorStore>(m, "VectorStore")
       .def(py::init<std::size_t>(), py::arg("dim"))
@@ -69,7 +113,7 @@ PYBIND11_MODULE(vectorcore, m) {
       // store.add_vector(id, np.ndarray[float32, (dim,)])
       .def(
           "add_vector",
-          [](vectorcore::VectorStore& self, int id, const py::array& vec) {
+          [](vectorcore::VectorStore& self, std::uint64_t id, const py::array& vec) {
             const float* ptr = require_1d_float32_contiguous(vec, self.dim());
             self.add_vector(id, ptr, self.dim());
           },
@@ -77,6 +121,21 @@ PYBIND11_MODULE(vectorcore, m) {
           py::arg("vec"),
           "Add a single vector (zero-copy read from NumPy buffer).")
 
+      // store.add_vectors(np.ndarray[uint64, (n,)], np.ndarray[float32, (n, dim)])
+      .def(
+          "add_vectors",
+          [](vectorcore::VectorStore& self, const py::array& ids, const py::array& vectors) {
+            std::size_t rows = 0;
+            const float* ptr = require_2d_float32_contiguous(vectors, self.dim(), rows);
+            const std::uint64_t* id_ptr = require_uint64_ids(ids, rows);
+            // Keep the GIL, like add_vector / search: VectorStore has no lock of
+            // its own, and this call grows chunks_ and ids_.
+            self.add_vectors(id_ptr, ptr, rows);
+          },
+          py::arg("ids"),
+          py::arg("vectors"),
+          "Bulk add: one copy of the matrix into chunked storage, no per-row Python calls.")
+
       // store.search(np.ndarray[float32, (dim,)], k) -> List[Tuple[distance, id]]
       .def(
           "search",
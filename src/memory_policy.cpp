@@ -0,0 +1,234 @@
+#include "vectorcore/memory_policy.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#elif defined(_MSC_VER)
+  #include <malloc.h> // _aligned_malloc, _aligned_free
+#endif
+
+namespace vectorcore {
+
+namespace {
+
+constexpr std::size_t kPageFallback = 4096;
+
+std::size_t round_up(std::size_t n, std::size_t a) noexcept {
+  return (n + a - 1) / a * a;
+}
+
+#if defined(__linux__)
+
+constexpr std::size_t kTwoMb = std::size_t{1} << 21;
+constexpr std::size_t kOneGb = std::size_t{1} << 30;
+
+std::size_t huge_page_size(HugePages h) noexcept {
+  switch (h) {
+    case HugePages::NONE:
+      return 0;
+    case HugePages::HUGETLB_1GB:
+      return kOneGb;
+    case HugePages::TRANSPARENT:
+    case HugePages::HUGETLB_2MB:
+      break;
+  }
+  return kTwoMb;
+}
+
+#ifndef MAP_HUGE_SHIFT
+  #define MAP_HUGE_SHIFT 26
+#endif
+
+// <numaif.h> lives in libnuma's headers; the syscall needs only this.
+constexpr int kMpolBind = 2;
+
+std::size_t base_page() noexcept {
+  static const std::size_t page = [] {
+    const long p = ::sysconf(_SC_PAGESIZE);
+    return p > 0 ? static_cast<std::size_t>(p) : kPageFallback;
+  }();
+  return page;
+}
+
+// What an allocation of `bytes` is rounded up to: the huge page size once
+// it fills one, base pages below. HUGETLB_1GB arrays under 1 GB drop to the
+// 2 MB granule (hugetlb, then transparent) rather than to base pages.
+// allocate_pages() and free_pages() both derive the mapping length from
+// this, so it must depend on nothing else.
+std::size_t granule(std::size_t bytes, const MemoryPolicy& policy) noexcept {
+  const std::size_t huge = huge_page_size(policy.huge_pages);
+  if (huge != 0 && bytes >= huge) {
+    return huge;
+  }
+  return (huge != 0 && bytes >= kTwoMb) ? kTwoMb : base_page();
+}
+
+// Anonymous mapping of `length` bytes starting on an `align` boundary.
+// Over-maps by `align` and trims both ends, so a transparent huge page can
+// back every 2 MB of the range rather than only the aligned middle.
+void* map_aligned(std::size_t length, std::size_t align) noexcept {
+  const int prot = PROT_READ | PROT_WRITE;
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  if (align <= base_page()) {
+    void* p = ::mmap(nullptr, length, prot, flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+  }
+  void* raw = ::mmap(nullptr, length + align, prot, flags, -1, 0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+  const auto first = reinterpret_cast<std::uintptr_t>(raw);
+  const std::uintptr_t start = round_up(first, align);
+  if (start > first) {
+    ::munmap(raw, start - first);
+  }
+  const std::size_t tail = (first + length + align) - (start + length);
+  if (tail > 0) {
+    ::munmap(reinterpret_cast<void*>(start + length), tail);
+  }
+  return reinterpret_cast<void*>(start);
+}
+
+// Best effort: a kernel without NUMA (or a seccomp filter) refuses
+// mbind(), and the pages are then placed on first touch as usual.
+void bind_to_node(void* p, std::size_t length, int node) noexcept {
+  constexpr std::size_t kWordBits = sizeof(unsigned long) * 8;
+  constexpr std::size_t kMaskWords = 16;
+  const auto n = static_cast<std::size_t>(node);
+  if (n >= kMaskWords * kWordBits) {
+    return;
+  }
+  unsigned long mask[kMaskWords] = {};
+  mask[n / kWordBits] |= 1ul << (n % kWordBits);
+  // maxnode counts one past the last bit the kernel reads.
+  (void)::syscall(SYS_mbind, p, length, kMpolBind, mask, kMaskWords * kWordBits + 1, 0u);
+}
+
+#endif
+
+} // namespace
+
+std::size_t numa_node_count() noexcept {
+#if defined(__linux__)
+  // e.g. "0" or "0-1" or "0,2-3": the last number is the highest node.
+  std::ifstream in("/sys/devices/system/node/online");
+  std::string line;
+  if (!std::getline(in, line)) {
+    return 1;
+  }
+  const std::size_t pos = line.find_last_of(",-");
+  const std::string last = (pos == std::string::npos) ? line : line.substr(pos + 1);
+  char* end = nullptr;
+  const unsigned long highest = std::strtoul(last.c_str(), &end, 10);
+  return end == last.c_str() ? 1 : static_cast<std::size_t>(highest) + 1;
+#else
+  return 1;
+#endif
+}
+
+std::vector<int> numa_node_cpus(int node) {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  if (node < 0) {
+    return cpus;
+  }
+  // A cpulist such as "0-15,32-47".
+  std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  std::string range;
+  while (std::getline(in, range, ',')) {
+    char* end = nullptr;
+    const long first = std::strtol(range.c_str(), &end, 10);
+    if (end == range.c_str()) {
+      break;
+    }
+    const long last = (*end == '-') ? std::strtol(end + 1, nullptr, 10) : first;
+    for (long cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+  }
+#else
+  (void)node;
+#endif
+  return cpus;
+}
+
+void validate_memory_policy(const MemoryPolicy& policy) {
+  if (policy.numa_node < -1) {
+    throw std::invalid_argument("numa_node must be >= 0, or -1 for no binding");
+  }
+  if (policy.numa_node >= 0 && static_cast<std::size_t>(policy.numa_node) >= numa_node_count()) {
+    throw std::invalid_argument("numa_node " + std::to_string(policy.numa_node) + " does not exist on this host");
+  }
+}
+
+void* allocate_pages(std::size_t bytes, const MemoryPolicy& policy) {
+#if defined(__linux__)
+  const std::size_t page = granule(bytes, policy);
+  const std::size_t length = round_up(bytes, page);
+  const bool huge = page > base_page();
+
+  void* p = nullptr;
+  if (huge && policy.huge_pages != HugePages::TRANSPARENT) {
+    const int log2_page = (page == kOneGb) ? 30 : 21;
+    p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log2_page << MAP_HUGE_SHIFT), -1, 0);
+    if (p == MAP_FAILED) {
+      p = nullptr; // pool empty or not configured: transparent pages instead
+    }
+  }
+  if (!p) {
+    p = map_aligned(length, huge ? kTwoMb : page);
+    if (!p) {
+      throw std::bad_alloc();
+    }
+    if (huge) {
+      (void)::madvise(p, length, MADV_HUGEPAGE);
+    }
+  }
+  if (policy.numa_node >= 0) {
+    bind_to_node(p, length, policy.numa_node);
+  }
+  return p;
+#else
+  (void)policy;
+  const std::size_t length = round_up(bytes, kPageFallback);
+  #if defined(_MSC_VER)
+  void* p = _aligned_malloc(length, kPageFallback);
+  #else
+  void* p = nullptr;
+  if (posix_memalign(&p, kPageFallback, length) != 0) {
+    p = nullptr;
+  }
+  #endif
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+#endif
+}
+
+void free_pages(void* p, std::size_t bytes, const MemoryPolicy& policy) noexcept {
+  if (!p) {
+    return;
+  }
+#if defined(__linux__)
+  ::munmap(p, round_up(bytes, granule(bytes, policy)));
+#else
+  (void)bytes;
+  (void)policy;
+  #if defined(_MSC_VER)
+  _aligned_free(p);
+  #else
+  std::free(p);
+  #endif
+#endif
+}
+
+} // namespace vectorcore
@@ -0,0 +1,134 @@
+#include "vectorcore/product_quantizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "vectorcore/kmeans.h"
+#include "vectorcore/thread_pool.h"
+
+namespace vectorcore {
+
+ProductQuantizer::ProductQuantizer(std::size_t dim, std::size_t m, Metric metric)
+    : dim_(dim), m_(m), metric_(metric) {
+  if (dim_ == 0) {
+    throw std::invalid_argument("dim must be > 0");
+  }
+  if (m_ == 0 || dim_ % m_ != 0) {
+    throw std::invalid_argument("pq_m must be > 0 and divide dim");
+  }
+  dsub_ = dim_ / m_;
+}
+
+void ProductQuantizer::train(const float* x, std::size_t n, std::size_t num_threads, std::size_t niter) {
+  if (!x) {
+    throw std::invalid_argument("vectors pointer is null");
+  }
+  if (n < kCentroids) {
+    throw std::invalid_argument("PQ training needs at least 256 vectors");
+  }
+
+  codebooks_.resize(m_ * kCentroids * dsub_);
+
+  // k-means only ever sees 256 * kKmeansMaxPointsPerCentroid rows; take an
+  // even stride through the input rather than copying all of it.
+  const std::size_t max_points = kCentroids * kKmeansMaxPointsPerCentroid;
+  const std::size_t rows = std::min(n, max_points);
+  const std::size_t stride = n / rows;
+
+  std::vector<float> sub(rows * dsub_);
+  for (std::size_t s = 0; s < m_; ++s) {
+    for (std::size_t i = 0; i < rows; ++i) {
+      std::copy_n(x + (i * stride * dim_) + (s * dsub_), dsub_, sub.data() + (i * dsub_));
+    }
+    kmeans(sub.data(), rows, dsub_, kCentroids, codebooks_.data() + (s * kCentroids * dsub_),
+           Metric::L2_SQUARED, niter, 1234 + s, num_threads);
+  }
+  trained_ = true;
+}
+
+void ProductQuantizer::restore(const float* codebooks, std::size_t n) {
+  if (n != m_ * kCentroids * dsub_) {
+    throw std::invalid_argument("PQ codebooks must have m * 256 * dsub entries");
+  }
+  codebooks_.assign(codebooks, codebooks + n);
+  trained_ = true;
+}
+
+void ProductQuantizer::encode(const float* x, std::size_t n, std::uint8_t* codes, std::size_t num_threads) const {
+  if (!trained_) {
+    throw std::logic_error("ProductQuantizer must be trained before encode()");
+  }
+
+  auto run = [&](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+    for (std::size_t i = begin; i < end; ++i) {
+      const float* row = x + (i * dim_);
+      std::uint8_t* code = codes + (i * m_);
+      for (std::size_t s = 0; s < m_; ++s) {
+        const float* v = row + (s * dsub_);
+        float best = std::numeric_limits<float>::infinity();
+        std::size_t best_j = 0;
+        for (std::size_t j = 0; j < kCentroids; ++j) {
+          const float d = l2_squared(v, centroid(s, j), dsub_);
+          if (d < best) {
+            best = d;
+            best_j = j;
+          }
+        }
+        code[s] = static_cast<std::uint8_t>(best_j);
+      }
+    }
+  };
+
+  if (num_threads == 1) {
+    run(0, n, 0);
+    return;
+  }
+  ThreadPool::global().parallel_for(n, 256, run, num_threads);
+}
+
+void ProductQuantizer::decode(const std::uint8_t* code, float* out) const {
+  for (std::size_t s = 0; s < m_; ++s) {
+    std::copy_n(centroid(s, code[s]), dsub_, out + (s * dsub_));
+  }
+}
+
+void ProductQuantizer::compute_table(const float* q, float* table) const {
+  const bool l2 = (metric_ == Metric::L2_SQUARED);
+  for (std::size_t s = 0; s < m_; ++s) {
+    const float* qs = q + (s * dsub_);
+    float* row = table + (s * kCentroids);
+    for (std::size_t j = 0; j < kCentroids; ++j) {
+      row[j] = l2 ? l2_squared(qs, centroid(s, j), dsub_) : inner_product(qs, centroid(s, j), dsub_);
+    }
+  }
+}
+
+void ProductQuantizer::prepare(const float* q, PreparedQuery& out) const {
+  out.q = q;
+  out.table.resize(m_ * kCentroids);
+  compute_table(q, out.table.data());
+}
+
+void ProductQuantizer::prepare_code(const std::uint8_t* code, PreparedQuery& out) const {
+  out.decoded.resize(dim_);
+  decode(code, out.decoded.data());
+  out.q = out.decoded.data();
+  out.table.clear();
+}
+
+float ProductQuantizer::score_direct(const float* q, const std::uint8_t* code) const noexcept {
+  float acc = 0.0f;
+  if (metric_ == Metric::L2_SQUARED) {
+    for (std::size_t s = 0; s < m_; ++s) {
+      acc += l2_squared(q + (s * dsub_), centroid(s, code[s]), dsub_);
+    }
+  } else {
+    for (std::size_t s = 0; s < m_; ++s) {
+      acc += inner_product(q + (s * dsub_), centroid(s, code[s]), dsub_);
+    }
+  }
+  return acc;
+}
+
+} // namespace vectorcore
@@ -1,13 +1,30 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/numpy.h>
+#include <pybind11/stl.h>
 
+#include <chrono>
 #include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "vectorcore/bruteforce_index.h"
+#include "vectorcore/bulk_loader.h"
+#include "vectorcore/distance.h"
 #include "vectorcore/hnsw_index.h"
+#include "vectorcore/ivf_index.h"
+#include "vectorcore/memory_policy.h"
+#include "vectorcore/range_search.h"
+#include "vectorcore/search_filter.h"
+#include "vectorcore/search_service.h"
+#include "vectorcore/search_stats.h"
+#include "vectorcore/sharded_index.h"
+#include "vectorcore/thread_pool.h"
 
 namespace py = pybind11;
 
@@ -59,6 +76,63 @@ Float32MatrixView as_float32_matrix_view(const py::array& arr, std::size_t expec
   };
 }
 
+// 16-bit float input, accepted next to float32 by add() and search() and
+// widened in C++ (F16C / AVX-512 where available): float16 arrays, and
+// uint16 arrays holding bfloat16 bit patterns (NumPy has no bfloat16; e.g.
+// torch_bf16.view(torch.uint16).numpy()). Nothing else is 2 bytes wide here.
+std::optional<vectorcore::HalfFormat> half_format(const py::buffer_info& info) {
+  if (info.itemsize != sizeof(std::uint16_t)) {
+    return std::nullopt;
+  }
+  if (info.format == "e") {
+    return vectorcore::HalfFormat::FP16;
+  }
+  if (info.format == py::format_descriptor<std::uint16_t>::format()) {
+    return vectorcore::HalfFormat::BF16;
+  }
+  return std::nullopt;
+}
+
+// Rows of a C-contiguous 16-bit array of shape (dim,) or (n, dim); a vector
+// is one row.
+std::size_t half_rows(const py::buffer_info& info, std::size_t expected_cols) {
+  if (info.ndim != 1 && info.ndim != 2) {
+    throw std::invalid_argument("Expected a 1D (dim,) or 2D (n, dim) array");
+  }
+  const std::size_t cols = static_cast<std::size_t>(info.shape[info.ndim - 1]);
+  if (cols != expected_cols) {
+    throw std::invalid_argument("dim mismatch");
+  }
+  const auto expected_stride = static_cast<py::ssize_t>(sizeof(std::uint16_t));
+  if (info.strides[info.ndim - 1] != expected_stride ||
+      (info.ndim == 2 && info.strides[0] != static_cast<py::ssize_t>(cols) * expected_stride)) {
+    throw std::invalid_argument("Expected a C-contiguous array (no slicing/Fortran order)");
+  }
+  return info.ndim == 2 ? static_cast<std::size_t>(info.shape[0]) : 1;
+}
+
+// add() input: float32 rows, or 16-bit rows for add_half().
+struct InputMatrixView {
+  const float* data = nullptr;
+  const std::uint16_t* half = nullptr;
+  vectorcore::HalfFormat format = vectorcore::HalfFormat::FP16;
+  std::size_t rows = 0;
+};
+
+InputMatrixView as_input_matrix_view(const py::array& arr, std::size_t expected_cols) {
+  py::buffer_info info = arr.request();
+  const auto format = half_format(info);
+  if (!format) {
+    const auto mat = as_float32_matrix_view(arr, expected_cols);
+    return InputMatrixView{mat.data, nullptr, vectorcore::HalfFormat::FP16, mat.rows};
+  }
+  if (info.ndim != 2) {
+    throw std::invalid_argument("Expected a 2D NumPy array of shape (n, dim)");
+  }
+  return InputMatrixView{nullptr, static_cast<const std::uint16_t*>(info.ptr), *format,
+                         half_rows(info, expected_cols)};
+}
+
 struct Float32VectorView {
   const float* data = nullptr;
   std::size_t dim = 0;
@@ -83,6 +157,196 @@ Float32VectorView as_float32_vector_view(const py::array& arr, std::size_t expec
   return Float32VectorView{static_cast<const float*>(info.ptr), expected_dim};
 }
 
+// External ids: a contiguous 1D uint64 array. `data` borrows the array's
+// buffer; `owner` keeps it alive in case the cast had to create a new array.
+struct Uint64IdsView {
+  py::array owner;
+  const std::uint64_t* data = nullptr;
+  std::size_t size = 0;
+};
+
+Uint64IdsView as_uint64_array(const py::object& ids_obj) {
+  Uint64IdsView view;
+  view.owner = py::cast<py::array>(ids_obj);
+  py::buffer_info ids_info = view.owner.request();
+
+  if (ids_info.ndim != 1) {
+    throw std::invalid_argument("ids must be a 1D array");
+  }
+  // Compare item types, not format strings: NumPy reports uint64 as 'L' on
+  // LP64 platforms where pybind11 spells it 'Q'.
+  if (!ids_info.item_type_is_equivalent_to<std::uint64_t>()) {
+    throw std::invalid_argument("ids must be uint64");
+  }
+  if (ids_info.strides[0] != static_cast<py::ssize_t>(sizeof(std::uint64_t))) {
+    throw std::invalid_argument("ids must be contiguous");
+  }
+  view.data = static_cast<const std::uint64_t*>(ids_info.ptr);
+  view.size = static_cast<std::size_t>(ids_info.shape[0]);
+  return view;
+}
+
+// Optional ids for add(): None, or one id per row.
+Uint64IdsView as_uint64_ids(const py::object& ids_obj, std::size_t rows) {
+  if (ids_obj.is_none()) {
+    return {};
+  }
+  Uint64IdsView view = as_uint64_array(ids_obj);
+  if (view.size != rows) {
+    throw std::invalid_argument("ids length must match x.shape[0]");
+  }
+  return view;
+}
+
+// Optional search filter: a sorted uint64 allow-list of external ids, or a
+// packed uint64 bitmap over internal rows (bit r of word r // 64, e.g.
+// np.packbits(mask, bitorder="little") padded to 8 bytes and viewed as
+// uint64). The filter borrows `array`, which stays alive with this object.
+struct SearchFilterArg {
+  Uint64IdsView array;
+  std::optional<vectorcore::SearchFilter> filter;
+
+  const vectorcore::SearchFilter* get() const { return filter ? &*filter : nullptr; }
+};
+
+SearchFilterArg as_search_filter(const py::object& allow_ids, const py::object& allow_bitmap) {
+  SearchFilterArg arg;
+  if (!allow_ids.is_none() && !allow_bitmap.is_none()) {
+    throw std::invalid_argument("Pass allow_ids or allow_bitmap, not both");
+  }
+  if (!allow_ids.is_none()) {
+    arg.array = as_uint64_array(allow_ids);
+    arg.filter = vectorcore::SearchFilter::allow_list(arg.array.data, arg.array.size);
+  } else if (!allow_bitmap.is_none()) {
+    arg.array = as_uint64_array(allow_bitmap);
+    arg.filter = vectorcore::SearchFilter::bitmap(arg.array.data, arg.array.size * 64);
+  }
+  return arg;
+}
+
+// search() runs without the GIL, so add() may only drop it when the rows
+// fit the index's ingest capacity: storage then never moves under a
+// concurrent search. Otherwise add() keeps the GIL and stays serialized
+// with every other call, as without concurrent ingest.
+template <typename Index>
+bool add_can_release_gil(const Index& self, std::size_t rows) {
+  return self.ingest_capacity() >= self.size() + rows;
+}
+
+// Concurrent ingest allows one add() at a time; adds that dropped the GIL
+// serialize on this process-wide lock instead.
+std::mutex& ingest_mutex() {
+  static std::mutex mu;
+  return mu;
+}
+
+// Keeps `obj` (the array an index views in attach()) alive for as long as
+// the index holds the returned pointer. The last reference may go away on a
+// thread without the GIL, e.g. a compact() run with it released, so the
+// deleter takes the GIL before touching the refcount.
+std::shared_ptr<py::object> shared_py_object(py::object obj) {
+  return std::shared_ptr<py::object>(new py::object(std::move(obj)), [](py::object* p) {
+    if (!Py_IsInitialized()) {
+      return; // interpreter already gone; leak the reference
+    }
+    py::gil_scoped_acquire gil;
+    delete p;
+  });
+}
+
+std::shared_ptr<const void> keep_alive(py::object obj) {
+  return shared_py_object(std::move(obj));
+}
+
+// Caller-supplied search outputs (out_ids / out_scores), or freshly
+// allocated ones when both are None. Given ones must be writable,
+// C-contiguous, of dtype uint64 / float32 and of exactly the result shape,
+// so they can be written without a copy and reused across calls.
+struct SearchOutputs {
+  py::array ids;
+  py::array scores;
+  std::uint64_t* ids_ptr = nullptr;
+  float* scores_ptr = nullptr;
+};
+
+template <typename T>
+T* as_output_array(const py::array& arr, const std::vector<py::ssize_t>& shape, const char* name) {
+  py::buffer_info info = arr.request(/*writable=*/true);
+  if (!info.item_type_is_equivalent_to<T>()) {
+    throw std::invalid_argument(std::string(name) + " has the wrong dtype");
+  }
+  if (info.shape != shape) {
+    throw std::invalid_argument(std::string(name) + " must have the result shape ((k,) or (m, k))");
+  }
+  py::ssize_t stride = static_cast<py::ssize_t>(sizeof(T));
+  for (std::size_t d = shape.size(); d-- > 0;) {
+    if (shape[d] > 1 && info.strides[d] != stride) {
+      throw std::invalid_argument(std::string(name) + " must be C-contiguous");
+    }
+    stride *= shape[d];
+  }
+  return static_cast<T*>(info.ptr);
+}
+
+SearchOutputs as_search_outputs(const py::object& out_ids, const py::object& out_scores,
+                                const std::vector<py::ssize_t>& shape) {
+  SearchOutputs out;
+  if (out_ids.is_none() != out_scores.is_none()) {
+    throw std::invalid_argument("Pass both out_ids and out_scores, or neither");
+  }
+  if (out_ids.is_none()) {
+    // Our own arrays already have the right dtype and layout.
+    py::array_t<std::uint64_t> ids(shape);
+    py::array_t<float> scores(shape);
+    out.ids_ptr = ids.mutable_data();
+    out.scores_ptr = scores.mutable_data();
+    out.ids = std::move(ids);
+    out.scores = std::move(scores);
+    return out;
+  }
+  out.ids = py::cast<py::array>(out_ids);
+  out.scores = py::cast<py::array>(out_scores);
+  out.ids_ptr = as_output_array<std::uint64_t>(out.ids, shape, "out_ids");
+  out.scores_ptr = as_output_array<float>(out.scores, shape, "out_scores");
+  return out;
+}
+
+py::dict query_stats_dict(const vectorcore::QueryStats& q) {
+  py::dict d;
+  d["distances"] = q.distances;
+  d["visited"] = q.visited;
+  d["hops"] = q.hops;
+  d["heap_ops"] = q.heap_ops;
+  d["cycles"] = q.cycles;
+  return d;
+}
+
+// Aggregate counters (totals over all recorded queries), latency
+// percentiles in ns, and the non-empty histogram buckets as
+// (upper bound ns, count) pairs.
+py::dict search_stats_dict(const vectorcore::SearchStats& stats) {
+  py::dict d = query_stats_dict(stats.totals());
+  const std::uint64_t queries = stats.queries();
+  const vectorcore::LatencyHistogram& latency = stats.latency();
+  d["queries"] = queries;
+  d["total_ns"] = stats.total_ns();
+  d["mean_ns"] = queries ? static_cast<double>(stats.total_ns()) / static_cast<double>(queries) : 0.0;
+  d["p50_ns"] = latency.percentile(0.50);
+  d["p90_ns"] = latency.percentile(0.90);
+  d["p99_ns"] = latency.percentile(0.99);
+  d["p999_ns"] = latency.percentile(0.999);
+  d["max_ns"] = stats.max_ns();
+
+  py::list buckets;
+  for (std::size_t b = 0; b < vectorcore::LatencyHistogram::kBuckets; ++b) {
+    if (const std::uint64_t n = latency.count(b)) {
+      buckets.append(py::make_tuple(vectorcore::LatencyHistogram::upper_bound(b), n));
+    }
+  }
+  d["histogram"] = buckets;
+  return d;
+}
+
 vectorcore::Metric parse_metric(const std::string& m) {
   if (m == "l2" || m == "l2_squared") {
     return vectorcore::Metric::L2_SQUARED;
@@ -90,142 +354,850 @@ vectorcore::Metric parse_metric(const std::string& m) {
   if (m == "ip" || m == "inner_product") {
     return vectorcore::Metric::INNER_PRODUCT;
   }
+  if (m == "cosine" || m == "cos") {
+    return vectorcore::Metric::COSINE;
+  }
   throw std::invalid_argument("Unknown metric: " + m);
 }
 
+vectorcore::Storage parse_storage(const std::string& s) {
+  if (s == "fp32" || s == "float32") {
+    return vectorcore::Storage::FP32;
+  }
+  if (s == "fp16" || s == "float16") {
+    return vectorcore::Storage::FP16;
+  }
+  if (s == "int8" || s == "sq8") {
+    return vectorcore::Storage::INT8;
+  }
+  if (s == "pq") {
+    return vectorcore::Storage::PQ;
+  }
+  if (s == "binary") {
+    return vectorcore::Storage::BINARY;
+  }
+  throw std::invalid_argument("Unknown storage: " + s);
+}
+
+std::string storage_name(vectorcore::Storage s) {
+  switch (s) {
+    case vectorcore::Storage::FP16:
+      return "fp16";
+    case vectorcore::Storage::INT8:
+      return "int8";
+    case vectorcore::Storage::PQ:
+      return "pq";
+    case vectorcore::Storage::BINARY:
+      return "binary";
+    case vectorcore::Storage::FP32:
+    default:
+      return "fp32";
+  }
+}
+
+// huge_pages= / numa_node= constructor arguments (see memory_policy.h).
+vectorcore::MemoryPolicy parse_memory_policy(const std::string& huge_pages, int numa_node) {
+  vectorcore::MemoryPolicy policy;
+  if (huge_pages == "none") {
+    policy.huge_pages = vectorcore::HugePages::NONE;
+  } else if (huge_pages == "thp" || huge_pages == "transparent") {
+    policy.huge_pages = vectorcore::HugePages::TRANSPARENT;
+  } else if (huge_pages == "2mb") {
+    policy.huge_pages = vectorcore::HugePages::HUGETLB_2MB;
+  } else if (huge_pages == "1gb") {
+    policy.huge_pages = vectorcore::HugePages::HUGETLB_1GB;
+  } else {
+    throw std::invalid_argument("Unknown huge_pages: " + huge_pages + " (none, thp, 2mb or 1gb)");
+  }
+  policy.numa_node = numa_node;
+  return policy;
+}
+
+std::string huge_pages_name(vectorcore::HugePages h) {
+  switch (h) {
+    case vectorcore::HugePages::TRANSPARENT:
+      return "thp";
+    case vectorcore::HugePages::HUGETLB_2MB:
+      return "2mb";
+    case vectorcore::HugePages::HUGETLB_1GB:
+      return "1gb";
+    case vectorcore::HugePages::NONE:
+    default:
+      return "none";
+  }
+}
+
+vectorcore::ShardRouting parse_routing(const std::string& r) {
+  if (r == "round_robin" || r == "rr") {
+    return vectorcore::ShardRouting::ROUND_ROBIN;
+  }
+  if (r == "hash") {
+    return vectorcore::ShardRouting::HASH;
+  }
+  throw std::invalid_argument("Unknown routing: " + r + " (expected round_robin or hash)");
+}
+
+vectorcore::ReorderMethod parse_reorder(const std::string& m) {
+  if (m == "bfs") {
+    return vectorcore::ReorderMethod::BFS;
+  }
+  if (m == "rcm") {
+    return vectorcore::ReorderMethod::RCM;
+  }
+  throw std::invalid_argument("Unknown reorder method: " + m + " (expected bfs or rcm)");
+}
+
+// format="auto" goes by the file extension.
+vectorcore::FileFormat parse_file_format(const std::string& f, const std::string& path) {
+  std::string name = f;
+  if (name == "auto") {
+    const std::size_t dot = path.rfind('.');
+    name = (dot == std::string::npos) ? std::string() : path.substr(dot + 1);
+  }
+  if (name == "fvecs") {
+    return vectorcore::FileFormat::FVECS;
+  }
+  if (name == "bvecs") {
+    return vectorcore::FileFormat::BVECS;
+  }
+  if (name == "npy") {
+    return vectorcore::FileFormat::NPY;
+  }
+  throw std::invalid_argument("Unknown file format for " + path + " (expected fvecs, bvecs or npy)");
+}
+
+// index.load_from_file(): streams the file into add() batch by batch. The
+// GIL follows the add() rule, so the file's row count is read up front.
+template <typename Index>
+std::size_t run_load_from_file(Index& self, const std::string& path, const std::string& format,
+                               std::size_t batch_size, std::size_t num_threads) {
+  const auto f = parse_file_format(format, path);
+  const std::size_t rows = vectorcore::VectorFileReader(path, f).rows();
+  std::optional<py::gil_scoped_release> release;
+  std::unique_lock<std::mutex> lock;
+  if (add_can_release_gil(self, rows)) {
+    release.emplace();
+    lock = std::unique_lock<std::mutex>(ingest_mutex());
+  }
+  return vectorcore::load_from_file(self, path, f, batch_size, num_threads);
+}
+
+vectorcore::ShardOptions parse_shard_options(const std::string& routing, bool numa, const std::string& huge_pages) {
+  vectorcore::ShardOptions options;
+  options.routing = parse_routing(routing);
+  options.numa = numa;
+  options.huge_pages = parse_memory_policy(huge_pages, -1).huge_pages;
+  return options;
+}
+
+// Single-query entry points with a uniform signature for run_search.
+void search_one(const vectorcore::BruteForceIndex& index, const float* q, std::size_t k,
+                std::uint64_t* ids, float* scores, std::size_t num_threads,
+                const vectorcore::SearchFilter* filter) {
+  index.search(q, k, ids, scores, num_threads, filter);
+}
+
+void search_one(const vectorcore::HnswIndex& index, const float* q, std::size_t k,
+                std::uint64_t* ids, float* scores, std::size_t /*num_threads*/,
+                const vectorcore::SearchFilter* filter) {
+  index.search(q, k, ids, scores, filter);
+}
+
+template <typename Inner>
+void search_one(const vectorcore::ShardedIndex<Inner>& index, const float* q, std::size_t k, std::uint64_t* ids,
+                float* scores, std::size_t num_threads, const vectorcore::SearchFilter* filter) {
+  index.search(q, k, ids, scores, num_threads, filter);
+}
+
+// IvfIndex takes nprobe on every call; bind it here so run_search can treat
+// all index types alike. IVF has no filtered search, so its binding always
+// passes filter == nullptr.
+struct IvfSearch {
+  const vectorcore::IvfIndex& index;
+  std::size_t nprobe;
+
+  std::size_t dim() const noexcept { return index.dim(); }
+  void search_batch(const float* q, std::size_t m, std::size_t k, std::uint64_t* ids, float* scores,
+                    std::size_t num_threads, const vectorcore::SearchFilter* /*filter*/) const {
+    index.search_batch(q, m, k, ids, scores, nprobe, num_threads);
+  }
+};
+
+void search_one(const IvfSearch& s, const float* q, std::size_t k, std::uint64_t* ids, float* scores,
+                std::size_t /*num_threads*/, const vectorcore::SearchFilter* /*filter*/) {
+  s.index.search(q, k, ids, scores, s.nprobe);
+}
+
+// Shared search binding for q of shape (dim,) or (m, dim).
+//
+// Output arrays are allocated (or, with out_ids / out_scores, validated)
+// while we still hold the GIL; the C++ call then runs with the GIL released
+// and writes straight into them, so other Python threads keep running and
+// all cores can work on one batch.
+template <typename Index>
+py::tuple run_search(const Index& self, const py::array& q, std::size_t k, std::size_t num_threads,
+                     const vectorcore::SearchFilter* filter = nullptr, const py::object& out_ids = py::none(),
+                     const py::object& out_scores = py::none()) {
+  py::buffer_info info = q.request();
+
+  // float16 / bfloat16 queries are widened below, after the GIL is dropped.
+  const auto half = half_format(info);
+  if (!half && (info.itemsize != sizeof(float) || info.format != py::format_descriptor<float>::format())) {
+    throw std::invalid_argument("Expected float32 queries (or float16, or bfloat16 bits as uint16)");
+  }
+  if (info.ndim != 1 && info.ndim != 2) {
+    throw std::invalid_argument("q must be 1D (dim,) or 2D (m, dim)");
+  }
+
+  const float* data = nullptr;
+  std::size_t m_queries = 1;
+  if (half) {
+    m_queries = half_rows(info, self.dim());
+  } else if (info.ndim == 1) {
+    data = as_float32_vector_view(q, self.dim()).data;
+  } else {
+    auto mat = as_float32_matrix_view(q, self.dim());
+    data = mat.data;
+    m_queries = mat.rows;
+  }
+
+  const auto kk = static_cast<py::ssize_t>(k);
+  SearchOutputs out = info.ndim == 1
+                          ? as_search_outputs(out_ids, out_scores, {kk})
+                          : as_search_outputs(out_ids, out_scores, {static_cast<py::ssize_t>(m_queries), kk});
+  {
+    py::gil_scoped_release release;
+    std::vector<float> widened;
+    if (half) {
+      widened.resize(m_queries * self.dim());
+      vectorcore::widen_to_float(*half, static_cast<const std::uint16_t*>(info.ptr), widened.data(),
+                                 widened.size());
+      data = widened.data();
+    }
+    if (info.ndim == 1) {
+      search_one(self, data, k, out.ids_ptr, out.scores_ptr, num_threads, filter);
+    } else {
+      self.search_batch(data, m_queries, k, out.ids_ptr, out.scores_ptr, num_threads, filter);
+    }
+  }
+  return py::make_tuple(out.ids, out.scores);
+}
+
+// Hands a vector's buffer to NumPy without copying; the capsule frees it
+// when the array is collected.
+template <typename T>
+py::array_t<T> to_numpy(std::vector<T>&& v) {
+  auto* owned = new std::vector<T>(std::move(v));
+  py::capsule free_when_done(owned, [](void* p) { delete static_cast<std::vector<T>*>(p); });
+  return py::array_t<T>(static_cast<py::ssize_t>(owned->size()), owned->data(), free_when_done);
+}
+
+// Shared range_search binding for q of shape (dim,) or (m, dim); a 1D query
+// is a batch of one. Returns (offsets, ids, scores) in CSR form: the hits of
+// query i are ids[offsets[i]:offsets[i + 1]], best first.
+template <typename Index>
+py::tuple run_range_search(const Index& self, const py::array& q, float radius, std::size_t num_threads,
+                           const vectorcore::SearchFilter* filter) {
+  py::buffer_info info = q.request();
+
+  const float* data = nullptr;
+  std::size_t m_queries = 0;
+  if (info.ndim == 1) {
+    data = as_float32_vector_view(q, self.dim()).data;
+    m_queries = 1;
+  } else if (info.ndim == 2) {
+    auto mat = as_float32_matrix_view(q, self.dim());
+    data = mat.data;
+    m_queries = mat.rows;
+  } else {
+    throw std::invalid_argument("q must be 1D (dim,) or 2D (m, dim)");
+  }
+
+  vectorcore::RangeSearchResult result;
+  {
+    py::gil_scoped_release release;
+    self.range_search(data, m_queries, radius, result, num_threads, filter);
+  }
+  return py::make_tuple(to_numpy(std::move(result.offsets)), to_numpy(std::move(result.ids)),
+                        to_numpy(std::move(result.scores)));
+}
+
+// SearchService from Python. Each submit() gets a concurrent.futures.Future
+// (asyncio.wrap_future() makes it awaitable). The dispatcher thread takes
+// the GIL once per batch to resolve that batch's futures.
+
+// The Python exception pybind would raise for a C++ one.
+py::object python_exception(std::exception_ptr error) {
+  try {
+    std::rethrow_exception(error);
+  } catch (const std::invalid_argument& e) {
+    return py::reinterpret_borrow<py::object>(PyExc_ValueError)(e.what());
+  } catch (const std::length_error& e) {
+    return py::reinterpret_borrow<py::object>(PyExc_ValueError)(e.what());
+  } catch (const std::out_of_range& e) {
+    return py::reinterpret_borrow<py::object>(PyExc_IndexError)(e.what());
+  } catch (const std::bad_alloc& e) {
+    return py::reinterpret_borrow<py::object>(PyExc_MemoryError)(e.what());
+  } catch (const std::exception& e) {
+    return py::reinterpret_borrow<py::object>(PyExc_RuntimeError)(e.what());
+  } catch (...) {
+    return py::reinterpret_borrow<py::object>(PyExc_RuntimeError)("unknown C++ exception");
+  }
+}
+
+vectorcore::SearchServiceOptions service_options(std::size_t max_batch, double max_delay_us,
+                                                 std::size_t num_threads) {
+  if (max_delay_us < 0) {
+    throw std::invalid_argument("max_delay_us must be >= 0");
+  }
+  vectorcore::SearchServiceOptions options;
+  options.max_batch = max_batch;
+  options.max_delay = std::chrono::microseconds(static_cast<std::int64_t>(max_delay_us));
+  options.num_threads = num_threads;
+  options.completion_scope = [](const std::function<void()>& complete) {
+    if (!Py_IsInitialized()) {
+      return; // interpreter gone: nobody is left to wait on the futures
+    }
+    py::gil_scoped_acquire gil;
+    complete();
+  };
+  return options;
+}
+
+// Stops the dispatcher with the GIL released: it may be waiting for the
+// GIL to resolve the last batch.
+struct SearchServiceDeleter {
+  void operator()(vectorcore::SearchService* service) const {
+    if (Py_IsInitialized() && PyGILState_Check()) {
+      py::gil_scoped_release release;
+      service->shutdown();
+    }
+    delete service;
+  }
+};
+
+using PySearchService = py::class_<vectorcore::SearchService, std::unique_ptr<vectorcore::SearchService,
+                                                                              SearchServiceDeleter>>;
+
+py::object submit_to_service(vectorcore::SearchService& self, const py::array& q, std::size_t k) {
+  // One float32 (or float16 / bfloat16) vector; it is copied on submit.
+  py::buffer_info info = q.request();
+  const auto half = half_format(info);
+  std::vector<float> widened;
+  const float* data = nullptr;
+  if (half) {
+    if (info.ndim != 1 || half_rows(info, self.dim()) != 1) {
+      throw std::invalid_argument("Expected a 1D array of shape (dim,)");
+    }
+    widened.resize(self.dim());
+    vectorcore::widen_to_float(*half, static_cast<const std::uint16_t*>(info.ptr), widened.data(), self.dim());
+    data = widened.data();
+  } else {
+    data = as_float32_vector_view(q, self.dim()).data;
+  }
+
+  // Marked running up front: a submitted query cannot be cancelled, and
+  // set_result() below then never meets a cancelled future.
+  py::object future = py::module_::import("concurrent.futures").attr("Future")();
+  future.attr("set_running_or_notify_cancel")();
+  auto shared = shared_py_object(future);
+  self.submit(data, k, [shared](std::exception_ptr error, vectorcore::SearchService::Result result) {
+    // Runs inside completion_scope, with the GIL held.
+    try {
+      if (error) {
+        shared->attr("set_exception")(python_exception(error));
+      } else {
+        shared->attr("set_result")(
+            py::make_tuple(to_numpy(std::move(result.ids)), to_numpy(std::move(result.scores))));
+      }
+    } catch (py::error_already_set& e) {
+      e.discard_as_unraisable("vectorcore.SearchService");
+    }
+  });
+  return future;
+}
+
+// add / remove / search / shard introspection shared by the sharded
+// classes. Shards hold locks (HnswIndex) and pinned pools, so pybind gets a
+// pointer.
+template <typename Inner>
+void bind_sharded(py::class_<vectorcore::ShardedIndex<Inner>>& cls) {
+  using Sharded = vectorcore::ShardedIndex<Inner>;
+  cls.def_property_readonly("dim", &Sharded::dim)
+      .def_property_readonly("size", &Sharded::size)
+      .def_property_readonly("num_shards", &Sharded::num_shards)
+      .def_property_readonly("num_nodes", &Sharded::num_nodes)
+      .def_property_readonly("routing", [](const Sharded& self) {
+        return std::string(self.routing() == vectorcore::ShardRouting::HASH ? "hash" : "round_robin");
+      })
+      .def("shard_sizes", [](const Sharded& self) {
+        std::vector<std::size_t> sizes(self.num_shards());
+        for (std::size_t s = 0; s < sizes.size(); ++s) {
+          sizes[s] = self.shard(s).size();
+        }
+        return sizes;
+      })
+      .def("shard_nodes", [](const Sharded& self) {
+        // NUMA node per shard; -1 when unplaced.
+        std::vector<int> nodes(self.num_shards());
+        for (std::size_t s = 0; s < nodes.size(); ++s) {
+          nodes[s] = self.shard_node(s);
+        }
+        return nodes;
+      })
+      .def("add", [](Sharded& self, const py::array& x, py::object ids_obj, std::size_t num_threads) {
+        auto view = as_input_matrix_view(x, self.dim());
+        const auto ids = as_uint64_ids(ids_obj, view.rows);
+        py::gil_scoped_release release;
+        // Rows are split across shards first, so a 16-bit batch is widened
+        // into one temporary.
+        std::vector<float> widened;
+        if (view.half) {
+          widened.resize(view.rows * self.dim());
+          vectorcore::widen_to_float(view.format, view.half, widened.data(), widened.size());
+          view.data = widened.data();
+        }
+        self.add(view.data, view.rows, ids.data, num_threads);
+      }, py::arg("x"), py::arg("ids") = py::none(), py::arg("num_threads") = 0)
+      .def("remove", [](Sharded& self, const py::object& ids_obj) {
+        // Returns how many of the ids were present on any shard.
+        const auto ids = as_uint64_array(ids_obj);
+        py::gil_scoped_release release;
+        return self.remove(ids.data, ids.size);
+      }, py::arg("ids"))
+      .def("search", [](const Sharded& self, const py::array& q, std::size_t k, std::size_t num_threads,
+                        const py::object& allow_ids, const py::object& out_ids, const py::object& out_scores) {
+        // Every shard is searched, on its node's threads, and the per-shard
+        // top-k lists are merged. Bitmaps address one shard's rows, so only
+        // id allow-lists are taken.
+        const auto filter = as_search_filter(allow_ids, py::none());
+        return run_search(self, q, k, num_threads, filter.get(), out_ids, out_scores);
+      }, py::arg("q"), py::arg("k"), py::arg("num_threads") = 0, py::arg("allow_ids") = py::none(),
+         py::arg("out_ids") = py::none(), py::arg("out_scores") = py::none());
+}
+
 } // namespace
 
 PYBIND11_MODULE(vectorcore, m) {
   m.doc() = "VectorCore: high-performance vector search engine (C++17 + pybind11)";
-  m.attr("__version__") = vectorcore_VERSION;
+  m.attr("__version__") = VECTORCORE_VERSION;
+
+  m.def("active_kernel", []() { return std::string(vectorcore::active_kernel()); },
+        "Name of the distance kernel family selected for this CPU (scalar/avx2/avx512/neon).");
+  m.def("supported_kernels", []() {
+        std::vector<std::string> names;
+        for (const auto& k : vectorcore::supported_distance_kernels()) {
+          names.emplace_back(k.name);
+        }
+        return names;
+      }, "Kernel families compiled in and supported by this CPU, best last.");
+  m.def("numa_nodes", []() { return vectorcore::numa_node_count(); },
+        "NUMA nodes on this host, for the numa_node= index argument (1 without NUMA).");
+  m.def("num_threads", []() { return vectorcore::ThreadPool::global().num_threads(); },
+        "Threads in the built-in search pool (num_threads=0 uses all of them).");
+  m.def("last_query_stats", []() { return query_stats_dict(vectorcore::SearchStats::last_query()); },
+        "Counters of the last query this thread ran with stats_enabled (single-query search only).");
 
   py::enum_<vectorcore::Metric>(m, "Metric")
       .value("L2_SQUARED", vectorcore::Metric::L2_SQUARED)
-      .value("INNER_PRODUCT", vectorcore::Metric::INNER_PRODUCT);
+      .value("INNER_PRODUCT", vectorcore::Metric::INNER_PRODUCT)
+      .value("COSINE", vectorcore::Metric::COSINE);
 
   py::class_<vectorcore::BruteForceIndex>(m, "BruteForceIndex")
-      .def(py::init([](std::size_t dim, const std::string& metric) {
-             return vectorcore::BruteForceIndex(dim, parse_metric(metric));
+      .def(py::init([](std::size_t dim, const std::string& metric, const std::string& storage,
+                       std::size_t rerank_factor, const std::string& huge_pages, int numa_node) {
+             return vectorcore::BruteForceIndex(dim, parse_metric(metric), parse_storage(storage), rerank_factor,
+                                                parse_memory_policy(huge_pages, numa_node));
            }),
-           py::arg("dim"), py::arg("metric") = "l2")
+           py::arg("dim"), py::arg("metric") = "l2", py::arg("storage") = "fp32",
+           py::arg("rerank_factor") = 0, py::arg("huge_pages") = "none", py::arg("numa_node") = -1)
       .def_property_readonly("dim", &vectorcore::BruteForceIndex::dim)
+      .def_property_readonly("huge_pages", [](const vectorcore::BruteForceIndex& self) {
+        return huge_pages_name(self.memory_policy().huge_pages);
+      })
+      .def_property_readonly("numa_node", [](const vectorcore::BruteForceIndex& self) {
+        return self.memory_policy().numa_node;
+      })
       .def_property_readonly("size", &vectorcore::BruteForceIndex::size)
-      .def("add", [](vectorcore::BruteForceIndex& self, const py::array& x, py::object ids_obj) {
+      .def_property_readonly("storage", [](const vectorcore::BruteForceIndex& self) {
+        return storage_name(self.storage());
+      })
+      .def_property_readonly("rerank_factor", &vectorcore::BruteForceIndex::rerank_factor)
+      .def("train", [](vectorcore::BruteForceIndex& self, const py::array& x) {
+        // INT8 only: learn per-dimension ranges before the first add().
         auto view = as_float32_matrix_view(x, self.dim());
+        self.train(view.data, view.rows);
+      }, py::arg("x"))
+      .def("add", [](vectorcore::BruteForceIndex& self, const py::array& x, py::object ids_obj) {
+        // float16 / bfloat16 (uint16) rows are widened straight into the index.
+        auto view = as_input_matrix_view(x, self.dim());
 
-        const std::uint64_t* ids_ptr = nullptr;
-        std::vector<std::uint64_t> ids_tmp;
-
-        if (!ids_obj.is_none()) {
-          py::array ids_arr = py::cast<py::array>(ids_obj);
-          py::buffer_info ids_info = ids_arr.request();
-
-          if (ids_info.ndim != 1) {
-            throw std::invalid_argument("ids must be a 1D array");
-          }
-          if (static_cast<std::size_t>(ids_info.shape[0]) != view.rows) {
-            throw std::invalid_argument("ids length must match x.shape[0]");
-          }
-          if (ids_info.itemsize != sizeof(std::uint64_t) ||
-              ids_info.format != py::format_descriptor<std::uint64_t>::format()) {
-            throw std::invalid_argument("ids must be uint64");
-          }
-          if (ids_info.strides[0] != static_cast<py::ssize_t>(sizeof(std::uint64_t))) {
-            throw std::invalid_argument("ids must be contiguous");
-          }
-
-          ids_ptr = static_cast<const std::uint64_t*>(ids_info.ptr);
-        }
-
-        self.add(view.data, view.rows, ids_ptr);
-      }, py::arg("x"), py::arg("ids") = py::none())
-      .def("search", [](const vectorcore::BruteForceIndex& self, const py::array& q, std::size_t k) {
-        // Support q shape (dim,) or (m, dim)
-        py::buffer_info info = q.request();
+        const auto ids = as_uint64_ids(ids_obj, view.rows);
 
-        if (info.itemsize != sizeof(float) || info.format != py::format_descriptor<float>::format()) {
-          throw std::invalid_argument("Expected float32 queries");
+        // Within the ingest capacity, other Python threads search meanwhile.
+        std::optional<py::gil_scoped_release> release;
+        std::unique_lock<std::mutex> lock;
+        if (add_can_release_gil(self, view.rows)) {
+          release.emplace();
+          lock = std::unique_lock<std::mutex>(ingest_mutex());
         }
-
-        if (info.ndim == 1) {
-          auto v = as_float32_vector_view(q, self.dim());
-          py::array_t<std::uint64_t> out_ids(k);
-          py::array_t<float> out_scores(k);
-
-          self.search(v.data, k,
-                      static_cast<std::uint64_t*>(out_ids.request().ptr),
-                      static_cast<float*>(out_scores.request().ptr));
-          return py::make_tuple(out_ids, out_scores);
+        if (view.half) {
+          self.add_half(view.half, view.rows, view.format, ids.data);
+        } else {
+          self.add(view.data, view.rows, ids.data);
         }
-
-        if (info.ndim == 2) {
-          auto mat = as_float32_matrix_view(q, self.dim());
-          const std::size_t m_queries = mat.rows;
-
-          py::array_t<std::uint64_t> out_ids({m_queries, k});
-          py::array_t<float> out_scores({m_queries, k});
-
-          auto ids_buf = out_ids.request();
-          auto sc_buf = out_scores.request();
-
-          auto* ids_ptr = static_cast<std::uint64_t*>(ids_buf.ptr);
-          auto* sc_ptr = static_cast<float*>(sc_buf.ptr);
-
-          for (std::size_t i = 0; i < m_queries; ++i) {
-            const float* qi = mat.data + (i * self.dim());
-            self.search(qi, k, ids_ptr + (i * k), sc_ptr + (i * k));
-          }
-
-          return py::make_tuple(out_ids, out_scores);
+      }, py::arg("x"), py::arg("ids") = py::none())
+      .def("attach", [](vectorcore::BruteForceIndex& self, const py::array& x, py::object ids_obj) {
+        // Indexes x in place (no copy); the index keeps x alive. x must stay
+        // unchanged, e.g. a read-only np.memmap.
+        auto view = as_float32_matrix_view(x, self.dim());
+        const auto ids = as_uint64_ids(ids_obj, view.rows);
+        self.attach(view.data, view.rows, keep_alive(x), ids.data);
+      }, py::arg("x"), py::arg("ids") = py::none())
+      .def("load_from_file", [](vectorcore::BruteForceIndex& self, const std::string& path,
+                                const std::string& format, std::size_t batch_size, std::size_t num_threads) {
+        // Streams the file in batches without materializing it in Python.
+        return run_load_from_file(self, path, format, batch_size, num_threads);
+      }, py::arg("path"), py::arg("format") = "auto", py::arg("batch_size") = 16384, py::arg("num_threads") = 0)
+      .def_property_readonly("is_view", &vectorcore::BruteForceIndex::is_view)
+      .def_property("stats_enabled", &vectorcore::BruteForceIndex::stats_enabled,
+                    &vectorcore::BruteForceIndex::set_stats_enabled)
+      .def("stats", [](const vectorcore::BruteForceIndex& self) { return search_stats_dict(self.stats()); })
+      .def("reset_stats", &vectorcore::BruteForceIndex::reset_stats)
+      .def_property_readonly("num_deleted", &vectorcore::BruteForceIndex::num_deleted)
+      .def_property("compact_threshold", &vectorcore::BruteForceIndex::compact_threshold,
+                    &vectorcore::BruteForceIndex::set_compact_threshold)
+      .def_property("ingest_capacity", &vectorcore::BruteForceIndex::ingest_capacity,
+                    &vectorcore::BruteForceIndex::set_ingest_capacity)
+      .def_property("prefetch_distance", &vectorcore::BruteForceIndex::prefetch_distance,
+                    &vectorcore::BruteForceIndex::set_prefetch_distance)
+      .def("remove", [](vectorcore::BruteForceIndex& self, const py::object& ids_obj) {
+        // Returns how many of the ids were present.
+        const auto ids = as_uint64_array(ids_obj);
+        return self.remove(ids.data, ids.size);
+      }, py::arg("ids"))
+      .def("upsert", [](vectorcore::BruteForceIndex& self, const py::array& x, const py::object& ids_obj) {
+        auto view = as_float32_matrix_view(x, self.dim());
+        if (ids_obj.is_none()) {
+          throw std::invalid_argument("upsert() needs ids");
         }
-
-        throw std::invalid_argument("q must be 1D (dim,) or 2D (m, dim)");
-      }, py::arg("q"), py::arg("k"))
+        const auto ids = as_uint64_ids(ids_obj, view.rows);
+        self.upsert(view.data, view.rows, ids.data);
+      }, py::arg("x"), py::arg("ids"))
+      .def("compact", [](vectorcore::BruteForceIndex& self) {
+        py::gil_scoped_release release;
+        self.compact();
+      })
+      .def("save", [](const vectorcore::BruteForceIndex& self, const std::string& path) {
+        py::gil_scoped_release release;
+        self.save(path);
+      }, py::arg("path"))
+      .def_static("load", [](const std::string& path, bool mmap) {
+        py::gil_scoped_release release;
+        return vectorcore::BruteForceIndex::load(path, mmap);
+      }, py::arg("path"), py::arg("mmap") = true)
+      .def("search", [](const vectorcore::BruteForceIndex& self, const py::array& q, std::size_t k,
+                        std::size_t num_threads, const py::object& allow_ids, const py::object& allow_bitmap,
+                        const py::object& out_ids, const py::object& out_scores) {
+        // 1D: one scan, split across threads when the index is large.
+        // 2D: blocked multi-query scan with query ranges spread across threads.
+        // A filter skips rejected rows before they are scored.
+        const auto filter = as_search_filter(allow_ids, allow_bitmap);
+        return run_search(self, q, k, num_threads, filter.get(), out_ids, out_scores);
+      }, py::arg("q"), py::arg("k"), py::arg("num_threads") = 0, py::arg("allow_ids") = py::none(),
+         py::arg("allow_bitmap") = py::none(), py::arg("out_ids") = py::none(), py::arg("out_scores") = py::none())
+      .def("range_search", [](const vectorcore::BruteForceIndex& self, const py::array& q, float radius,
+                              std::size_t num_threads, const py::object& allow_ids, const py::object& allow_bitmap) {
+        // L2: squared distance <= radius. IP / cosine: similarity >= radius.
+        const auto filter = as_search_filter(allow_ids, allow_bitmap);
+        return run_range_search(self, q, radius, num_threads, filter.get());
+      }, py::arg("q"), py::arg("radius"), py::arg("num_threads") = 0, py::arg("allow_ids") = py::none(),
+         py::arg("allow_bitmap") = py::none())
       ;
 
   py::class_<vectorcore::HnswIndex>(m, "HnswIndex")
-      .def(py::init([](std::size_t dim, std::size_t M, const std::string& metric) {
-             return vectorcore::HnswIndex(dim, M, parse_metric(metric));
+      .def(py::init([](std::size_t dim, std::size_t M, const std::string& metric,
+                       std::size_t ef_construction, const std::string& storage, std::size_t rerank_factor,
+                       std::size_t pq_m, const std::string& huge_pages, int numa_node) {
+             // HnswIndex owns locks and atomics and cannot be moved; hand pybind a pointer.
+             return std::make_unique<vectorcore::HnswIndex>(dim, M, parse_metric(metric), ef_construction, 100,
+                                                            parse_storage(storage), rerank_factor, pq_m,
+                                                            parse_memory_policy(huge_pages, numa_node));
            }),
-           py::arg("dim"), py::arg("M") = 16, py::arg("metric") = "l2")
+           py::arg("dim"), py::arg("M") = 16, py::arg("metric") = "l2",
+           py::arg("ef_construction") = 200, py::arg("storage") = "fp32", py::arg("rerank_factor") = 0,
+           py::arg("pq_m") = 0, py::arg("huge_pages") = "none", py::arg("numa_node") = -1)
       .def_property_readonly("dim", &vectorcore::HnswIndex::dim)
+      .def_property_readonly("huge_pages", [](const vectorcore::HnswIndex& self) {
+        return huge_pages_name(self.memory_policy().huge_pages);
+      })
+      .def_property_readonly("numa_node", [](const vectorcore::HnswIndex& self) {
+        return self.memory_policy().numa_node;
+      })
       .def_property_readonly("size", &vectorcore::HnswIndex::size)
-      .def("add", [](vectorcore::HnswIndex& self, const py::array& x, py::object ids_obj) {
+      .def_property_readonly("M", &vectorcore::HnswIndex::M)
+      .def_property_readonly("ef_construction", &vectorcore::HnswIndex::ef_construction)
+      .def_property_readonly("max_level", &vectorcore::HnswIndex::max_level)
+      .def_property_readonly("storage", [](const vectorcore::HnswIndex& self) {
+        return storage_name(self.storage());
+      })
+      .def_property_readonly("rerank_factor", &vectorcore::HnswIndex::rerank_factor)
+      .def_property("ef_search", &vectorcore::HnswIndex::ef_search, &vectorcore::HnswIndex::set_ef_search)
+      .def_property("prefetch_distance", &vectorcore::HnswIndex::prefetch_distance,
+                    &vectorcore::HnswIndex::set_prefetch_distance)
+      .def("add", [](vectorcore::HnswIndex& self, const py::array& x, py::object ids_obj,
+                     std::size_t num_threads) {
+        auto view = as_input_matrix_view(x, self.dim());
+        const auto ids = as_uint64_ids(ids_obj, view.rows);
+
+        // Within the ingest capacity, other Python threads search meanwhile;
+        // otherwise the GIL keeps them out while the graph arrays grow.
+        std::optional<py::gil_scoped_release> release;
+        std::unique_lock<std::mutex> lock;
+        if (add_can_release_gil(self, view.rows)) {
+          release.emplace();
+          lock = std::unique_lock<std::mutex>(ingest_mutex());
+        }
+        if (view.half) {
+          self.add_half(view.half, view.rows, view.format, ids.data, num_threads);
+        } else {
+          self.add(view.data, view.rows, ids.data, num_threads);
+        }
+      }, py::arg("x"), py::arg("ids") = py::none(), py::arg("num_threads") = 0)
+      .def("attach", [](vectorcore::HnswIndex& self, const py::array& x, py::object ids_obj,
+                        std::size_t num_threads) {
+        // Builds the graph over x in place (no copy); the index keeps x
+        // alive. x must stay unchanged, e.g. a read-only np.memmap.
+        auto view = as_float32_matrix_view(x, self.dim());
+        const auto ids = as_uint64_ids(ids_obj, view.rows);
+        auto owner = keep_alive(x);
+        py::gil_scoped_release release;
+        self.attach(view.data, view.rows, std::move(owner), ids.data, num_threads);
+      }, py::arg("x"), py::arg("ids") = py::none(), py::arg("num_threads") = 0)
+      .def("load_from_file", [](vectorcore::HnswIndex& self, const std::string& path, const std::string& format,
+                                std::size_t batch_size, std::size_t num_threads) {
+        // Reading the next batch overlaps with inserting this one on
+        // num_threads pool threads (0 = all).
+        return run_load_from_file(self, path, format, batch_size, num_threads);
+      }, py::arg("path"), py::arg("format") = "auto", py::arg("batch_size") = 16384, py::arg("num_threads") = 0)
+      .def_property_readonly("is_view", &vectorcore::HnswIndex::is_view)
+      .def_property("stats_enabled", &vectorcore::HnswIndex::stats_enabled,
+                    &vectorcore::HnswIndex::set_stats_enabled)
+      .def("stats", [](const vectorcore::HnswIndex& self) { return search_stats_dict(self.stats()); })
+      .def("reset_stats", &vectorcore::HnswIndex::reset_stats)
+      .def_property_readonly("num_deleted", &vectorcore::HnswIndex::num_deleted)
+      .def_property("compact_threshold", &vectorcore::HnswIndex::compact_threshold,
+                    &vectorcore::HnswIndex::set_compact_threshold)
+      .def_property("ingest_capacity", &vectorcore::HnswIndex::ingest_capacity,
+                    &vectorcore::HnswIndex::set_ingest_capacity)
+      .def("remove", [](vectorcore::HnswIndex& self, const py::object& ids_obj) {
+        // Returns how many of the ids were present; their neighbors are relinked.
+        const auto ids = as_uint64_array(ids_obj);
+        py::gil_scoped_release release;
+        return self.remove(ids.data, ids.size);
+      }, py::arg("ids"))
+      .def("upsert", [](vectorcore::HnswIndex& self, const py::array& x, const py::object& ids_obj,
+                        std::size_t num_threads) {
         auto view = as_float32_matrix_view(x, self.dim());
+        if (ids_obj.is_none()) {
+          throw std::invalid_argument("upsert() needs ids");
+        }
+        const auto ids = as_uint64_ids(ids_obj, view.rows);
+        py::gil_scoped_release release;
+        self.upsert(view.data, view.rows, ids.data, num_threads);
+      }, py::arg("x"), py::arg("ids"), py::arg("num_threads") = 0)
+      .def("compact", [](vectorcore::HnswIndex& self) {
+        py::gil_scoped_release release;
+        self.compact();
+      })
+      .def("reorder", [](vectorcore::HnswIndex& self, const std::string& method) {
+        // Renumbers nodes for cache locality (bfs or rcm); results are unchanged.
+        const auto m = parse_reorder(method);
+        py::gil_scoped_release release;
+        self.reorder(m);
+      }, py::arg("method") = "bfs")
+      .def("save", [](const vectorcore::HnswIndex& self, const std::string& path) {
+        py::gil_scoped_release release;
+        self.save(path);
+      }, py::arg("path"))
+      .def_static("load", [](const std::string& path, bool mmap) {
+        // mmap=True serves rows and links straight from the page cache.
+        py::gil_scoped_release release;
+        return vectorcore::HnswIndex::load(path, mmap);
+      }, py::arg("path"), py::arg("mmap") = true)
+      .def("search", [](const vectorcore::HnswIndex& self, const py::array& q, std::size_t k,
+                        std::size_t num_threads, const py::object& allow_ids, const py::object& allow_bitmap,
+                        const py::object& out_ids, const py::object& out_scores) {
+        // 2D query matrices are spread across threads, one graph walk per row.
+        // A filter keeps rejected nodes out of the results; very selective
+        // ones switch to a scan of the allowed nodes.
+        const auto filter = as_search_filter(allow_ids, allow_bitmap);
+        return run_search(self, q, k, num_threads, filter.get(), out_ids, out_scores);
+      }, py::arg("q"), py::arg("k"), py::arg("num_threads") = 0, py::arg("allow_ids") = py::none(),
+         py::arg("allow_bitmap") = py::none(), py::arg("out_ids") = py::none(), py::arg("out_scores") = py::none())
+      .def("range_search", [](const vectorcore::HnswIndex& self, const py::array& q, float radius,
+                              std::size_t num_threads, const py::object& allow_ids, const py::object& allow_bitmap) {
+        // Beam search to the ball, then a flood fill inside it (approximate).
+        const auto filter = as_search_filter(allow_ids, allow_bitmap);
+        return run_range_search(self, q, radius, num_threads, filter.get());
+      }, py::arg("q"), py::arg("radius"), py::arg("num_threads") = 0, py::arg("allow_ids") = py::none(),
+         py::arg("allow_bitmap") = py::none())
+      ;
 
-        const std::uint64_t* ids_ptr = nullptr;
-        if (!ids_obj.is_none()) {
-          py::array ids_arr = py::cast<py::array>(ids_obj);
-          py::buffer_info ids_info = ids_arr.request();
-
-          if (ids_info.ndim != 1) {
-            throw std::invalid_argument("ids must be a 1D array");
-          }
-          if (static_cast<std::size_t>(ids_info.shape[0]) != view.rows) {
-            throw std::invalid_argument("ids length must match x.shape[0]");
-          }
-          if (ids_info.itemsize != sizeof(std::uint64_t) ||
-              ids_info.format != py::format_descriptor<std::uint64_t>::format()) {
-            throw std::invalid_argument("ids must be uint64");
-          }
-          if (ids_info.strides[0] != static_cast<py::ssize_t>(sizeof(std::uint64_t))) {
-            throw std::invalid_argument("ids must be contiguous");
-          }
-          ids_ptr = static_cast<const std::uint64_t*>(ids_info.ptr);
+  py::class_<vectorcore::IvfIndex>(m, "IvfIndex")
+      .def(py::init([](std::size_t dim, std::size_t nlist, const std::string& metric, std::size_t pq_m,
+                       std::size_t rerank_factor) {
+             // pq_m > 0 stores residual PQ codes (IVF-PQ) instead of fp32 rows.
+             return vectorcore::IvfIndex(dim, nlist, parse_metric(metric), 100, pq_m, rerank_factor);
+           }),
+           py::arg("dim"), py::arg("nlist"), py::arg("metric") = "l2", py::arg("pq_m") = 0,
+           py::arg("rerank_factor") = 0)
+      .def_property_readonly("dim", &vectorcore::IvfIndex::dim)
+      .def_property_readonly("size", &vectorcore::IvfIndex::size)
+      .def_property_readonly("nlist", &vectorcore::IvfIndex::nlist)
+      .def_property_readonly("is_trained", &vectorcore::IvfIndex::trained)
+      .def_property_readonly("pq_m", &vectorcore::IvfIndex::pq_m)
+      .def_property_readonly("rerank_factor", &vectorcore::IvfIndex::rerank_factor)
+      .def_property("nprobe", &vectorcore::IvfIndex::nprobe, &vectorcore::IvfIndex::set_nprobe)
+      .def("train", [](vectorcore::IvfIndex& self, const py::array& x, std::size_t num_threads,
+                       std::size_t niter) {
+        auto view = as_float32_matrix_view(x, self.dim());
+        py::gil_scoped_release release;
+        self.train(view.data, view.rows, num_threads, niter);
+      }, py::arg("x"), py::arg("num_threads") = 0, py::arg("niter") = 20)
+      .def("add", [](vectorcore::IvfIndex& self, const py::array& x, py::object ids_obj,
+                     std::size_t num_threads) {
+        auto view = as_input_matrix_view(x, self.dim());
+        const auto ids = as_uint64_ids(ids_obj, view.rows);
+        py::gil_scoped_release release;
+        // Rows are scattered into their lists after cell assignment, so a
+        // 16-bit batch is widened into one temporary first.
+        std::vector<float> widened;
+        if (view.half) {
+          widened.resize(view.rows * self.dim());
+          vectorcore::widen_to_float(view.format, view.half, widened.data(), widened.size());
+          view.data = widened.data();
         }
+        self.add(view.data, view.rows, ids.data, num_threads);
+      }, py::arg("x"), py::arg("ids") = py::none(), py::arg("num_threads") = 0)
+      .def("list_sizes", [](const vectorcore::IvfIndex& self) {
+        std::vector<std::size_t> sizes(self.nlist());
+        for (std::size_t i = 0; i < sizes.size(); ++i) {
+          sizes[i] = self.list_size(i);
+        }
+        return sizes;
+      })
+      .def("search", [](const vectorcore::IvfIndex& self, const py::array& q, std::size_t k, std::size_t nprobe,
+                        std::size_t num_threads, const py::object& out_ids, const py::object& out_scores) {
+        // nprobe=0 uses the `nprobe` property.
+        return run_search(IvfSearch{self, nprobe}, q, k, num_threads, nullptr, out_ids, out_scores);
+      }, py::arg("q"), py::arg("k"), py::arg("nprobe") = 0, py::arg("num_threads") = 0,
+         py::arg("out_ids") = py::none(), py::arg("out_scores") = py::none())
+      ;
 
-        self.add(view.data, view.rows, ids_ptr);
-      }, py::arg("x"), py::arg("ids") = py::none())
-      .def("search", [](const vectorcore::HnswIndex& self, const py::array& q, std::size_t k) {
-        auto v = as_float32_vector_view(q, self.dim());
+  py::class_<vectorcore::ShardedIndex<vectorcore::BruteForceIndex>> sharded_bf(m, "ShardedBruteForceIndex");
+  sharded_bf.def(py::init([](std::size_t dim, std::size_t num_shards, const std::string& metric,
+                             const std::string& storage, std::size_t rerank_factor, const std::string& routing,
+                             bool numa, const std::string& huge_pages) {
+               const auto metric_kind = parse_metric(metric);
+               const auto st = parse_storage(storage);
+               return std::make_unique<vectorcore::ShardedIndex<vectorcore::BruteForceIndex>>(
+                   num_shards, [=](std::size_t, const vectorcore::MemoryPolicy& memory) {
+                     return std::make_unique<vectorcore::BruteForceIndex>(dim, metric_kind, st, rerank_factor,
+                                                                          memory);
+                   }, parse_shard_options(routing, numa, huge_pages));
+             }),
+             py::arg("dim"), py::arg("num_shards"), py::arg("metric") = "l2", py::arg("storage") = "fp32",
+             py::arg("rerank_factor") = 0, py::arg("routing") = "round_robin", py::arg("numa") = true,
+             py::arg("huge_pages") = "none");
+  bind_sharded(sharded_bf);
 
-        py::array_t<std::uint64_t> out_ids(k);
-        py::array_t<float> out_scores(k);
+  py::class_<vectorcore::ShardedIndex<vectorcore::HnswIndex>> sharded_hnsw(m, "ShardedHnswIndex");
+  sharded_hnsw.def(py::init([](std::size_t dim, std::size_t num_shards, std::size_t M, const std::string& metric,
+                               std::size_t ef_construction, const std::string& storage, std::size_t rerank_factor,
+                               std::size_t pq_m, const std::string& routing, bool numa,
+                               const std::string& huge_pages) {
+                 const auto metric_kind = parse_metric(metric);
+                 const auto st = parse_storage(storage);
+                 return std::make_unique<vectorcore::ShardedIndex<vectorcore::HnswIndex>>(
+                     num_shards, [=](std::size_t shard, const vectorcore::MemoryPolicy& memory) {
+                       // One seed per shard, so the shards' level draws are independent.
+                       return std::make_unique<vectorcore::HnswIndex>(dim, M, metric_kind, ef_construction,
+                                                                      100 + shard, st, rerank_factor, pq_m, memory);
+                     }, parse_shard_options(routing, numa, huge_pages));
+               }),
+               py::arg("dim"), py::arg("num_shards"), py::arg("M") = 16, py::arg("metric") = "l2",
+               py::arg("ef_construction") = 200, py::arg("storage") = "fp32", py::arg("rerank_factor") = 0,
+               py::arg("pq_m") = 0, py::arg("routing") = "round_robin", py::arg("numa") = true,
+               py::arg("huge_pages") = "none")
+      .def_property("ef_search", [](const vectorcore::ShardedIndex<vectorcore::HnswIndex>& self) {
+        return self.shard(0).ef_search();
+      }, [](vectorcore::ShardedIndex<vectorcore::HnswIndex>& self, std::size_t ef) {
+        for (std::size_t s = 0; s < self.num_shards(); ++s) {
+          self.shard(s).set_ef_search(ef);
+        }
+      });
+  bind_sharded(sharded_hnsw);
 
-        self.search(v.data, k,
-                    static_cast<std::uint64_t*>(out_ids.request().ptr),
-                    static_cast<float*>(out_scores.request().ptr));
-        return py::make_tuple(out_ids, out_scores);
+  PySearchService(m, "SearchService")
+      .def(py::init([](const vectorcore::BruteForceIndex& index, std::size_t max_batch, double max_delay_us,
+                       std::size_t num_threads) {
+             return new vectorcore::SearchService(index, service_options(max_batch, max_delay_us, num_threads));
+           }),
+           py::arg("index"), py::arg("max_batch") = 64, py::arg("max_delay_us") = 200.0,
+           py::arg("num_threads") = 0, py::keep_alive<1, 2>())
+      .def(py::init([](const vectorcore::HnswIndex& index, std::size_t max_batch, double max_delay_us,
+                       std::size_t num_threads) {
+             return new vectorcore::SearchService(index, service_options(max_batch, max_delay_us, num_threads));
+           }),
+           py::arg("index"), py::arg("max_batch") = 64, py::arg("max_delay_us") = 200.0,
+           py::arg("num_threads") = 0, py::keep_alive<1, 2>())
+      .def(py::init([](const vectorcore::IvfIndex& index, std::size_t max_batch, double max_delay_us,
+                       std::size_t num_threads) {
+             // nprobe follows the index's `nprobe` property at search time.
+             return new vectorcore::SearchService(
+                 index.dim(),
+                 [&index, num_threads](const float* q, std::size_t n, std::size_t k, std::uint64_t* ids,
+                                       float* scores) { index.search_batch(q, n, k, ids, scores, 0, num_threads); },
+                 service_options(max_batch, max_delay_us, num_threads));
+           }),
+           py::arg("index"), py::arg("max_batch") = 64, py::arg("max_delay_us") = 200.0,
+           py::arg("num_threads") = 0, py::keep_alive<1, 2>())
+      .def(py::init([](const vectorcore::ShardedIndex<vectorcore::BruteForceIndex>& index, std::size_t max_batch,
+                       double max_delay_us, std::size_t num_threads) {
+             return new vectorcore::SearchService(index, service_options(max_batch, max_delay_us, num_threads));
+           }),
+           py::arg("index"), py::arg("max_batch") = 64, py::arg("max_delay_us") = 200.0,
+           py::arg("num_threads") = 0, py::keep_alive<1, 2>())
+      .def(py::init([](const vectorcore::ShardedIndex<vectorcore::HnswIndex>& index, std::size_t max_batch,
+                       double max_delay_us, std::size_t num_threads) {
+             return new vectorcore::SearchService(index, service_options(max_batch, max_delay_us, num_threads));
+           }),
+           py::arg("index"), py::arg("max_batch") = 64, py::arg("max_delay_us") = 200.0,
+           py::arg("num_threads") = 0, py::keep_alive<1, 2>())
+      .def_property_readonly("dim", &vectorcore::SearchService::dim)
+      .def_property_readonly("max_batch", [](const vectorcore::SearchService& self) {
+        return self.options().max_batch;
+      })
+      .def_property_readonly("max_delay_us", [](const vectorcore::SearchService& self) {
+        return static_cast<double>(self.options().max_delay.count());
+      })
+      .def_property_readonly("batches", &vectorcore::SearchService::batches)
+      .def_property_readonly("queries", &vectorcore::SearchService::queries)
+      .def("submit", &submit_to_service, py::arg("q"), py::arg("k"))
+      .def("search_async", [](vectorcore::SearchService& self, const py::array& q, std::size_t k) {
+        // Awaitable on the running event loop: `ids, scores = await service.search_async(q, 10)`.
+        return py::module_::import("asyncio").attr("wrap_future")(submit_to_service(self, q, k));
       }, py::arg("q"), py::arg("k"))
+      .def("close", [](vectorcore::SearchService& self) {
+        // Serves what is pending, then stops; later submits raise.
+        py::gil_scoped_release release;
+        self.shutdown();
+      })
+      .def("__enter__", [](py::object self) { return self; })
+      .def("__exit__", [](vectorcore::SearchService& self, const py::args&) {
+        py::gil_scoped_release release;
+        self.shutdown();
+      })
       ;
 }
@@ -0,0 +1,193 @@
+#include "vectorcore/scalar_quantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "vectorcore/float16.h"
+
+namespace vectorcore {
+
+namespace {
+
+// Sets bit d (LSB first within each byte) of a zeroed code for x[d] > 0.
+void encode_bits(const float* x, std::size_t dim, std::uint8_t* code) noexcept {
+  for (std::size_t d = 0; d < dim; ++d) {
+    if (x[d] > 0.0f) {
+      code[d / 8] |= static_cast<std::uint8_t>(1u << (d % 8));
+    }
+  }
+}
+
+} // namespace
+
+ScalarQuantizer::ScalarQuantizer(Storage storage, std::size_t dim, Metric metric)
+    : storage_(storage), dim_(dim), metric_(metric), trained_(storage != Storage::INT8) {
+  if (dim_ == 0) {
+    throw std::invalid_argument("dim must be > 0");
+  }
+  if (storage_ == Storage::PQ) {
+    throw std::invalid_argument("PQ storage is handled by ProductQuantizer");
+  }
+}
+
+std::size_t ScalarQuantizer::code_size() const noexcept {
+  switch (storage_) {
+    case Storage::FP16:
+      return dim_ * sizeof(std::uint16_t);
+    case Storage::INT8:
+      return dim_;
+    case Storage::BINARY:
+      return ((dim_ + 63) / 64) * sizeof(std::uint64_t);
+    case Storage::FP32:
+    default:
+      return dim_ * sizeof(float);
+  }
+}
+
+void ScalarQuantizer::train(const float* x, std::size_t n) {
+  if (storage_ != Storage::INT8) {
+    return;
+  }
+  if (!x || n == 0) {
+    throw std::invalid_argument("INT8 storage needs at least one training vector");
+  }
+
+  std::vector<float> vmax(dim_, -std::numeric_limits<float>::infinity());
+  vmin_.assign(dim_, std::numeric_limits<float>::infinity());
+  for (std::size_t i = 0; i < n; ++i) {
+    const float* row = x + (i * dim_);
+    for (std::size_t d = 0; d < dim_; ++d) {
+      vmin_[d] = std::min(vmin_[d], row[d]);
+      vmax[d] = std::max(vmax[d], row[d]);
+    }
+  }
+
+  // 256 levels per dimension. A constant dimension gets scale 0 and decodes
+  // to vmin exactly.
+  scale_.resize(dim_);
+  for (std::size_t d = 0; d < dim_; ++d) {
+    scale_[d] = (vmax[d] - vmin_[d]) / 255.0f;
+  }
+  trained_ = true;
+}
+
+void ScalarQuantizer::restore(std::vector<float> vmin, std::vector<float> scale) {
+  if (storage_ != Storage::INT8) {
+    return;
+  }
+  if (vmin.size() != dim_ || scale.size() != dim_) {
+    throw std::invalid_argument("INT8 ranges must have dim entries");
+  }
+  vmin_ = std::move(vmin);
+  scale_ = std::move(scale);
+  trained_ = true;
+}
+
+void ScalarQuantizer::encode(const float* x, std::size_t n, std::uint8_t* codes) const {
+  if (!trained_) {
+    throw std::logic_error("ScalarQuantizer must be trained before encode()");
+  }
+
+  switch (storage_) {
+    case Storage::FP32:
+    default:
+      std::memcpy(codes, x, n * dim_ * sizeof(float));
+      return;
+
+    case Storage::FP16:
+      for (std::size_t i = 0; i < n * dim_; ++i) {
+        const std::uint16_t h = float_to_half(x[i]);
+        std::memcpy(codes + (i * sizeof(h)), &h, sizeof(h));
+      }
+      return;
+
+    case Storage::INT8:
+      for (std::size_t i = 0; i < n; ++i) {
+        const float* row = x + (i * dim_);
+        std::uint8_t* code = codes + (i * dim_);
+        for (std::size_t d = 0; d < dim_; ++d) {
+          const float c = (scale_[d] > 0.0f) ? std::nearbyint((row[d] - vmin_[d]) / scale_[d]) : 0.0f;
+          code[d] = static_cast<std::uint8_t>(std::min(255.0f, std::max(0.0f, c)));
+        }
+      }
+      return;
+
+    case Storage::BINARY: {
+      const std::size_t bytes = code_size();
+      std::memset(codes, 0, n * bytes);
+      for (std::size_t i = 0; i < n; ++i) {
+        encode_bits(x + (i * dim_), dim_, codes + (i * bytes));
+      }
+      return;
+    }
+  }
+}
+
+void ScalarQuantizer::decode(const std::uint8_t* code, float* out) const {
+  switch (storage_) {
+    case Storage::FP32:
+    default:
+      std::memcpy(out, code, dim_ * sizeof(float));
+      return;
+
+    case Storage::FP16:
+      for (std::size_t d = 0; d < dim_; ++d) {
+        std::uint16_t h;
+        std::memcpy(&h, code + (d * sizeof(h)), sizeof(h));
+        out[d] = half_to_float(h);
+      }
+      return;
+
+    case Storage::INT8:
+      for (std::size_t d = 0; d < dim_; ++d) {
+        out[d] = vmin_[d] + scale_[d] * static_cast<float>(code[d]);
+      }
+      return;
+
+    case Storage::BINARY:
+      for (std::size_t d = 0; d < dim_; ++d) {
+        out[d] = ((code[d / 8] >> (d % 8)) & 1u) ? 1.0f : -1.0f;
+      }
+      return;
+  }
+}
+
+void ScalarQuantizer::prepare(const float* q, PreparedQuery& out) const {
+  out.q = q;
+  if (storage_ == Storage::BINARY) {
+    out.bits.assign(code_size(), 0);
+    encode_bits(q, dim_, out.bits.data());
+    return;
+  }
+  if (storage_ != Storage::INT8) {
+    return;
+  }
+
+  // Fold the affine offset into the query once:
+  //   L2: |q - (vmin + s*c)|^2 = |(q - vmin) - s*c|^2
+  //   IP: q . (vmin + s*c)     = q . vmin + (q*s) . c
+  out.a.resize(dim_);
+  if (metric_ == Metric::L2_SQUARED) {
+    for (std::size_t d = 0; d < dim_; ++d) {
+      out.a[d] = q[d] - vmin_[d];
+    }
+    out.bias = 0.0f;
+  } else {
+    for (std::size_t d = 0; d < dim_; ++d) {
+      out.a[d] = q[d] * scale_[d];
+    }
+    out.bias = inner_product(q, vmin_.data(), dim_);
+  }
+}
+
+void ScalarQuantizer::prepare_code(const std::uint8_t* code, PreparedQuery& out) const {
+  out.decoded.resize(dim_);
+  decode(code, out.decoded.data());
+  prepare(out.decoded.data(), out);
+}
+
+} // namespace vectorcore
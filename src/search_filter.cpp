@@ -0,0 +1,80 @@
+#include "vectorcore/search_filter.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace vectorcore {
+
+namespace {
+// Rows sampled to estimate a predicate's selectivity.
+constexpr std::size_t kPredicateSamples = 256;
+} // namespace
+
+SearchFilter SearchFilter::bitmap(const std::uint64_t* words, std::size_t num_bits) {
+  if (!words && num_bits > 0) {
+    throw std::invalid_argument("bitmap pointer is null");
+  }
+  SearchFilter f;
+  f.kind_ = Kind::BITMAP;
+  f.words_ = words;
+  f.size_ = num_bits;
+  return f;
+}
+
+SearchFilter SearchFilter::allow_list(const std::uint64_t* sorted_ids, std::size_t n) {
+  if (!sorted_ids && n > 0) {
+    throw std::invalid_argument("allow-list pointer is null");
+  }
+  if (!std::is_sorted(sorted_ids, sorted_ids + n)) {
+    throw std::invalid_argument("allow-list ids must be sorted ascending");
+  }
+  SearchFilter f;
+  f.kind_ = Kind::ALLOW_LIST;
+  f.words_ = sorted_ids;
+  f.size_ = n;
+  return f;
+}
+
+SearchFilter SearchFilter::predicate(std::function<bool(std::uint64_t)> fn) {
+  if (!fn) {
+    throw std::invalid_argument("predicate is empty");
+  }
+  SearchFilter f;
+  f.kind_ = Kind::PREDICATE;
+  f.fn_ = std::move(fn);
+  return f;
+}
+
+double SearchFilter::selectivity(const std::uint64_t* ids, std::size_t rows) const {
+  if (rows == 0) {
+    return 0.0;
+  }
+  std::size_t pass = 0;
+  switch (kind_) {
+    case Kind::BITMAP: {
+      const std::size_t bits = std::min(size_, rows);
+      for (std::size_t w = 0; w < bits / 64; ++w) {
+        for (std::uint64_t x = words_[w]; x != 0; x &= x - 1) {
+          ++pass;
+        }
+      }
+      for (std::size_t r = (bits / 64) * 64; r < bits; ++r) {
+        pass += allows(r, 0) ? 1 : 0;
+      }
+      return static_cast<double>(pass) / static_cast<double>(rows);
+    }
+    case Kind::ALLOW_LIST:
+      return std::min(1.0, static_cast<double>(size_) / static_cast<double>(rows));
+    case Kind::PREDICATE:
+    default: {
+      const std::size_t samples = std::min(rows, kPredicateSamples);
+      for (std::size_t i = 0; i < samples; ++i) {
+        const std::size_t r = (i * rows) / samples;
+        pass += fn_(ids[r]) ? 1 : 0;
+      }
+      return static_cast<double>(pass) / static_cast<double>(samples);
+    }
+  }
+}
+
+} // namespace vectorcore
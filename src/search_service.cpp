@@ -0,0 +1,189 @@
+#include "vectorcore/search_service.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace vectorcore {
+
+SearchService::SearchService(std::size_t dim, BatchFn search_batch, const SearchServiceOptions& options)
+    : dim_(dim), search_batch_(std::move(search_batch)), options_(options) {
+  if (dim_ == 0) {
+    throw std::invalid_argument("dim must be > 0");
+  }
+  if (!search_batch_) {
+    throw std::invalid_argument("search_batch is empty");
+  }
+  if (options_.max_batch == 0) {
+    throw std::invalid_argument("max_batch must be > 0");
+  }
+  if (options_.max_delay.count() < 0) {
+    throw std::invalid_argument("max_delay must be >= 0");
+  }
+  dispatcher_ = std::thread([this] { dispatch_loop(); });
+}
+
+SearchService::~SearchService() {
+  shutdown();
+}
+
+void SearchService::shutdown() {
+  std::call_once(shutdown_once_, [this] {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    dispatcher_.join();
+  });
+}
+
+std::future<SearchService::Result> SearchService::submit(const float* query, std::size_t k) {
+  // std::function needs a copyable callable, hence the shared promise.
+  auto promise = std::make_shared<std::promise<Result>>();
+  std::future<Result> future = promise->get_future();
+  submit(query, k, [promise](std::exception_ptr error, Result result) {
+    if (error) {
+      promise->set_exception(error);
+    } else {
+      promise->set_value(std::move(result));
+    }
+  });
+  return future;
+}
+
+void SearchService::submit(const float* query, std::size_t k, Callback done) {
+  if (!query) {
+    throw std::invalid_argument("query pointer is null");
+  }
+  if (!done) {
+    throw std::invalid_argument("callback is empty");
+  }
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (stop_) {
+      throw std::logic_error("SearchService is shut down");
+    }
+    pending_queries_.insert(pending_queries_.end(), query, query + dim_);
+    pending_.push_back(Request{k, std::move(done), std::chrono::steady_clock::now()});
+
+    // The dispatcher only cares when a batch opens (its deadline starts)
+    // or fills up; other arrivals need no wake-up.
+    wake = pending_.size() == 1 || pending_.size() == options_.max_batch;
+  }
+  if (wake) {
+    cv_.notify_one();
+  }
+}
+
+void SearchService::dispatch_loop() {
+  std::vector<Request> batch;
+  std::vector<float> queries;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        return; // stopped and drained
+      }
+
+      // Hold the batch open until it fills or its oldest query has waited
+      // max_delay. After a long search the deadline has usually passed.
+      const auto deadline = pending_.front().arrival + options_.max_delay;
+      cv_.wait_until(lock, deadline, [this] { return stop_ || pending_.size() >= options_.max_batch; });
+
+      const std::size_t m = std::min(pending_.size(), options_.max_batch);
+      batch.assign(std::make_move_iterator(pending_.begin()), std::make_move_iterator(pending_.begin() + m));
+      pending_.erase(pending_.begin(), pending_.begin() + m);
+      const auto rows_end = pending_queries_.begin() + static_cast<std::ptrdiff_t>(m * dim_);
+      queries.assign(pending_queries_.begin(), rows_end);
+      pending_queries_.erase(pending_queries_.begin(), rows_end);
+    }
+
+    run_batch(batch, queries);
+    batch.clear();
+  }
+}
+
+void SearchService::run_batch(std::vector<Request>& batch, const std::vector<float>& queries) {
+  const std::size_t m = batch.size();
+  std::vector<Result> results(m);
+  std::vector<std::exception_ptr> errors(m);
+
+  // Usually one k for the whole batch; otherwise one search per distinct k.
+  std::vector<std::size_t> order(m);
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) { return batch[a].k < batch[b].k; });
+
+  std::vector<float> gathered;
+  std::vector<std::uint64_t> ids;
+  std::vector<float> scores;
+  for (std::size_t g0 = 0; g0 < m;) {
+    const std::size_t k = batch[order[g0]].k;
+    std::size_t g1 = g0 + 1;
+    while (g1 < m && batch[order[g1]].k == k) {
+      ++g1;
+    }
+    const std::size_t count = g1 - g0;
+
+    const float* rows = queries.data();
+    if (count != m) {
+      gathered.resize(count * dim_);
+      for (std::size_t j = 0; j < count; ++j) {
+        std::copy_n(queries.data() + (order[g0 + j] * dim_), dim_, gathered.data() + (j * dim_));
+      }
+      rows = gathered.data();
+    }
+
+    ids.resize(count * k);
+    scores.resize(count * k);
+    std::exception_ptr error;
+    try {
+      if (k > 0) {
+        search_batch_(rows, count, k, ids.data(), scores.data());
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    for (std::size_t j = 0; j < count; ++j) {
+      const std::size_t r = order[g0 + j];
+      errors[r] = error;
+      if (!error) {
+        results[r].ids.assign(ids.begin() + (j * k), ids.begin() + ((j + 1) * k));
+        results[r].scores.assign(scores.begin() + (j * k), scores.begin() + ((j + 1) * k));
+      }
+    }
+    g0 = g1;
+  }
+
+  batches_.fetch_add(1, std::memory_order_relaxed);
+  queries_.fetch_add(m, std::memory_order_relaxed);
+
+  // Each callback is moved out and destroyed right after it runs, inside
+  // the completion scope. An exception from a callback is dropped: there is
+  // nobody on this thread to report it to.
+  const std::function<void()> complete = [&] {
+    for (std::size_t i = 0; i < m; ++i) {
+      Callback done = std::move(batch[i].done);
+      try {
+        done(errors[i], std::move(results[i]));
+      } catch (...) {
+      }
+    }
+  };
+  if (options_.completion_scope) {
+    options_.completion_scope(complete);
+  } else {
+    complete();
+  }
+}
+
+} // namespace vectorcore
@@ -0,0 +1,122 @@
+#include "vectorcore/search_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vectorcore {
+
+namespace {
+
+constexpr std::size_t kSubBuckets = std::size_t{1} << LatencyHistogram::kSubBits;
+
+inline unsigned highest_bit(std::uint64_t v) noexcept {
+#if defined(_MSC_VER)
+  unsigned long i = 0;
+  _BitScanReverse64(&i, v);
+  return static_cast<unsigned>(i);
+#else
+  return 63u - static_cast<unsigned>(__builtin_clzll(v));
+#endif
+}
+
+thread_local QueryStats t_last_query;
+
+} // namespace
+
+std::size_t LatencyHistogram::bucket_of(std::uint64_t value) noexcept {
+  if (value < kSubBuckets) {
+    return static_cast<std::size_t>(value);
+  }
+  // Group g >= 1 holds [2^(g + kSubBits - 1), 2^(g + kSubBits)), split by
+  // the kSubBits bits below the leading one.
+  const unsigned e = highest_bit(value);
+  const std::size_t group = e - kSubBits + 1;
+  const std::size_t sub = static_cast<std::size_t>(value >> (e - kSubBits)) & (kSubBuckets - 1);
+  return (group << kSubBits) + sub;
+}
+
+std::uint64_t LatencyHistogram::upper_bound(std::size_t bucket) noexcept {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  const std::size_t group = bucket >> kSubBits;
+  const std::uint64_t sub = bucket & (kSubBuckets - 1);
+  const unsigned shift = static_cast<unsigned>(group - 1);
+  const std::uint64_t lower = (kSubBuckets + sub) << shift;
+  return lower + ((std::uint64_t{1} << shift) - 1);
+}
+
+std::uint64_t LatencyHistogram::total() const noexcept {
+  std::uint64_t n = 0;
+  for (const auto& c : counts_) {
+    n += c.load(std::memory_order_relaxed);
+  }
+  return n;
+}
+
+std::uint64_t LatencyHistogram::percentile(double p) const noexcept {
+  const std::uint64_t n = total();
+  if (n == 0) {
+    return 0;
+  }
+  const double clamped = std::min(1.0, std::max(0.0, p));
+  const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped * static_cast<double>(n))));
+  std::uint64_t seen = 0;
+  for (std::size_t b = 0; b < kBuckets; ++b) {
+    seen += count(b);
+    if (seen >= target) {
+      return upper_bound(b);
+    }
+  }
+  return upper_bound(kBuckets - 1);
+}
+
+void LatencyHistogram::reset() noexcept {
+  for (auto& c : counts_) {
+    c.store(0, std::memory_order_relaxed);
+  }
+}
+
+void SearchStats::record(const QueryStats& query, std::uint64_t latency_ns) noexcept {
+  queries_.fetch_add(1, std::memory_order_relaxed);
+  distances_.fetch_add(query.distances, std::memory_order_relaxed);
+  visited_.fetch_add(query.visited, std::memory_order_relaxed);
+  hops_.fetch_add(query.hops, std::memory_order_relaxed);
+  heap_ops_.fetch_add(query.heap_ops, std::memory_order_relaxed);
+  cycles_.fetch_add(query.cycles, std::memory_order_relaxed);
+  total_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+
+  std::uint64_t seen = max_ns_.load(std::memory_order_relaxed);
+  while (latency_ns > seen && !max_ns_.compare_exchange_weak(seen, latency_ns, std::memory_order_relaxed)) {
+  }
+  latency_.record(latency_ns);
+  t_last_query = query;
+}
+
+QueryStats SearchStats::totals() const noexcept {
+  QueryStats t;
+  t.distances = distances_.load(std::memory_order_relaxed);
+  t.visited = visited_.load(std::memory_order_relaxed);
+  t.hops = hops_.load(std::memory_order_relaxed);
+  t.heap_ops = heap_ops_.load(std::memory_order_relaxed);
+  t.cycles = cycles_.load(std::memory_order_relaxed);
+  return t;
+}
+
+void SearchStats::reset() noexcept {
+  queries_.store(0, std::memory_order_relaxed);
+  distances_.store(0, std::memory_order_relaxed);
+  visited_.store(0, std::memory_order_relaxed);
+  hops_.store(0, std::memory_order_relaxed);
+  heap_ops_.store(0, std::memory_order_relaxed);
+  cycles_.store(0, std::memory_order_relaxed);
+  total_ns_.store(0, std::memory_order_relaxed);
+  max_ns_.store(0, std::memory_order_relaxed);
+  latency_.reset();
+}
+
+QueryStats SearchStats::last_query() noexcept {
+  return t_last_query;
+}
+
+} // namespace vectorcore
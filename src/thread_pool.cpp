@@ -0,0 +1,186 @@
+#include "vectorcore/thread_pool.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+namespace vectorcore {
+
+namespace {
+// The pool whose loop this thread is working on: set on pool worker
+// threads, and on the caller while it runs its share of a loop, so nested
+// parallel_for calls into the same pool run inline instead of deadlocking
+// on submit_mu_.
+thread_local const ThreadPool* t_current_pool = nullptr;
+
+void pin_current_thread(const std::vector<int>& cpus) noexcept {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  if (CPU_COUNT(&set) > 0) {
+    (void)pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+#else
+  (void)cpus;
+#endif
+}
+} // namespace
+
+ThreadPool::ThreadPool(std::size_t num_threads) {
+  start(num_threads, {});
+}
+
+ThreadPool::ThreadPool(std::size_t num_threads, const std::vector<int>& cpus) {
+  start(num_threads, cpus);
+}
+
+void ThreadPool::start(std::size_t num_threads, const std::vector<int>& cpus) {
+  if (num_threads == 0) {
+    num_threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  }
+
+  workers_.reserve(num_threads - 1);
+  for (std::size_t w = 1; w < num_threads; ++w) {
+    workers_.emplace_back([this, w, cpus] { worker_loop(w, cpus); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stop_ = true;
+  }
+  wake_cv_.notify_all();
+  for (std::thread& t : workers_) {
+    t.join();
+  }
+}
+
+ThreadPool& ThreadPool::global() {
+  static ThreadPool pool;
+  return pool;
+}
+
+std::size_t ThreadPool::participants(std::size_t n, std::size_t grain, std::size_t max_threads) const noexcept {
+  grain = std::max<std::size_t>(1, grain);
+  const std::size_t chunks = (n + grain - 1) / grain;
+  std::size_t p = num_threads();
+  if (max_threads != 0) {
+    p = std::min(p, max_threads);
+  }
+  return std::max<std::size_t>(1, std::min(p, chunks));
+}
+
+void ThreadPool::run_chunks(Job& job, std::size_t worker) noexcept {
+  for (;;) {
+    const std::size_t begin = job.next.fetch_add(job.grain, std::memory_order_relaxed);
+    if (begin >= job.n) {
+      return;
+    }
+    const std::size_t end = std::min(job.n, begin + job.grain);
+
+    try {
+      (*job.fn)(begin, end, worker);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(job.error_mu);
+      if (!job.error) {
+        job.error = std::current_exception();
+      }
+      // Drain the cursor so every worker stops early.
+      job.next.store(job.n, std::memory_order_relaxed);
+      return;
+    }
+  }
+}
+
+void ThreadPool::parallel_for(std::size_t n, std::size_t grain, const RangeFn& fn, std::size_t max_threads) {
+  if (n == 0) {
+    return;
+  }
+  grain = std::max<std::size_t>(1, grain);
+
+  const std::size_t p = participants(n, grain, max_threads);
+  if (p == 1 || t_current_pool == this) {
+    fn(0, n, 0);
+    return;
+  }
+
+  std::lock_guard<std::mutex> submit(submit_mu_);
+
+  Job job;
+  job.fn = &fn;
+  job.n = n;
+  job.grain = grain;
+  job.participants = p;
+
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    job_ = &job;
+    pending_ = p - 1;
+    ++generation_;
+  }
+  wake_cv_.notify_all();
+
+  const ThreadPool* const outer = t_current_pool;
+  t_current_pool = this;
+  run_chunks(job, 0);
+  t_current_pool = outer;
+
+  {
+    std::unique_lock<std::mutex> lock(mu_);
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+    job_ = nullptr;
+  }
+
+  if (job.error) {
+    std::rethrow_exception(job.error);
+  }
+}
+
+void ThreadPool::worker_loop(std::size_t worker, const std::vector<int>& cpus) {
+  pin_current_thread(cpus);
+  t_current_pool = this;
+  std::uint64_t seen = 0;
+
+  for (;;) {
+    Job* job = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      wake_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+
+      // Workers beyond the participant count sit this job out and are not
+      // counted in pending_. Decide under the lock: once pending_ reaches 0
+      // the caller may destroy the job.
+      if (job_ && worker < job_->participants) {
+        job = job_;
+      }
+    }
+
+    if (!job) {
+      continue;
+    }
+
+    run_chunks(*job, worker);
+
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (--pending_ == 0) {
+        done_cv_.notify_one();
+      }
+    }
+  }
+}
+
+} // namespace vectorcore
@@ -0,0 +1,173 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+
+#include "test_util.h"
+
+namespace {
+
+constexpr std::size_t kDim = 32;
+constexpr std::size_t kRows = 1000;
+constexpr std::size_t kQueries = 10;
+constexpr std::size_t kK = 10;
+
+std::shared_ptr<std::vector<float>> random_rows(std::size_t rows, std::size_t dim, unsigned seed) {
+  return std::make_shared<std::vector<float>>(vectorcore::test::random_matrix(rows, dim, seed));
+}
+
+template <typename Index>
+void search_all(const Index& index, const std::vector<float>& queries, std::vector<std::uint64_t>& ids,
+                std::vector<float>& scores) {
+  ids.assign(kQueries * kK, 0);
+  scores.assign(kQueries * kK, 0.f);
+  for (std::size_t i = 0; i < kQueries; ++i) {
+    index.search(queries.data() + i * kDim, kK, ids.data() + i * kK, scores.data() + i * kK);
+  }
+}
+
+template <typename Index>
+void expect_rejected(Index& index, const float* rows) {
+  bool threw = false;
+  try {
+    index.attach(rows, kRows, nullptr);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw);
+}
+
+void test_bruteforce() {
+  auto rows = random_rows(kRows, kDim, 1);
+  const auto queries = random_rows(kQueries, kDim, 2);
+  std::vector<std::uint64_t> ids(kRows);
+  for (std::size_t i = 0; i < kRows; ++i) {
+    ids[i] = 1000 + i;
+  }
+
+  std::weak_ptr<std::vector<float>> watch = rows;
+  std::vector<std::uint64_t> got_ids, want_ids;
+  std::vector<float> got_scores, want_scores;
+  {
+    vectorcore::BruteForceIndex copied(kDim);
+    copied.add(rows->data(), kRows, ids.data());
+    assert(!copied.is_view());
+
+    vectorcore::BruteForceIndex viewed(kDim);
+    viewed.attach(rows->data(), kRows, rows, ids.data());
+    rows.reset(); // the index now holds the only reference
+    assert(!watch.expired());
+    assert(viewed.is_view() && viewed.size() == kRows);
+
+    search_all(copied, *queries, want_ids, want_scores);
+    search_all(viewed, *queries, got_ids, got_scores);
+    assert(got_ids == want_ids && got_scores == want_scores);
+
+    // Non-empty index.
+    bool threw = false;
+    try {
+      viewed.attach(watch.lock()->data(), kRows, nullptr);
+    } catch (const std::logic_error&) {
+      threw = true;
+    }
+    assert(threw);
+
+    // remove() keeps the view; add() copies it and lets the backing go.
+    const std::uint64_t gone = 1000;
+    assert(viewed.remove(&gone, 1) == 1 && viewed.is_view());
+    const auto extra = random_rows(1, kDim, 3);
+    viewed.add(extra->data(), 1);
+    assert(!viewed.is_view() && viewed.size() == kRows);
+    assert(watch.expired());
+
+    copied.remove(&gone, 1);
+    copied.add(extra->data(), 1);
+    search_all(copied, *queries, want_ids, want_scores);
+    search_all(viewed, *queries, got_ids, got_scores);
+    assert(got_ids == want_ids && got_scores == want_scores);
+  }
+
+  // Rows it would have to normalize or would never read.
+  const auto other = random_rows(kRows, kDim, 4);
+  vectorcore::BruteForceIndex cosine(kDim, vectorcore::Metric::COSINE);
+  expect_rejected(cosine, other->data());
+  vectorcore::BruteForceIndex int8(kDim, vectorcore::Metric::L2_SQUARED, vectorcore::Storage::INT8);
+  expect_rejected(int8, other->data());
+
+  // Compressed scan over a view, reranked against the viewed rows.
+  vectorcore::BruteForceIndex reranked(kDim, vectorcore::Metric::INNER_PRODUCT, vectorcore::Storage::INT8, 4);
+  reranked.attach(other->data(), kRows, other);
+  assert(reranked.is_view() && reranked.size() == kRows);
+  std::vector<std::uint64_t> top(kK);
+  std::vector<float> sc(kK);
+  reranked.search(other->data() + 7 * kDim, kK, top.data(), sc.data());
+  assert(sc[0] >= sc[kK - 1]);
+}
+
+void test_hnsw() {
+  auto rows = random_rows(kRows, kDim, 5);
+  const auto queries = random_rows(kQueries, kDim, 6);
+  std::weak_ptr<std::vector<float>> watch = rows;
+
+  std::vector<std::uint64_t> got_ids, want_ids;
+  std::vector<float> got_scores, want_scores;
+  {
+    // Same seed and serial inserts: identical graphs.
+    vectorcore::HnswIndex copied(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 7);
+    copied.add(rows->data(), kRows);
+    vectorcore::HnswIndex viewed(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 7);
+    viewed.attach(rows->data(), kRows, rows);
+    rows.reset();
+    assert(viewed.is_view() && viewed.size() == kRows && !watch.expired());
+
+    search_all(copied, *queries, want_ids, want_scores);
+    search_all(viewed, *queries, got_ids, got_scores);
+    assert(got_ids == want_ids && got_scores == want_scores);
+
+    // Parallel build over a view.
+    vectorcore::HnswIndex parallel(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 7);
+    parallel.attach(watch.lock()->data(), kRows, watch.lock(), nullptr, 0);
+    assert(parallel.is_view() && parallel.size() == kRows);
+
+    const auto extra = random_rows(1, kDim, 8);
+    viewed.add(extra->data(), 1);
+    assert(!viewed.is_view() && viewed.size() == kRows + 1);
+    std::uint64_t id = 0;
+    float score = 0.f;
+    viewed.search(extra->data(), 1, &id, &score);
+    assert(id == kRows && score == 0.f);
+  }
+  assert(watch.expired());
+
+  const auto other = random_rows(kRows, kDim, 9);
+  vectorcore::HnswIndex cosine(kDim, 16, vectorcore::Metric::COSINE);
+  expect_rejected(cosine, other->data());
+  vectorcore::HnswIndex fp16(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 100, vectorcore::Storage::FP16);
+  expect_rejected(fp16, other->data());
+
+  // A failed attach leaves the index empty and owning nothing.
+  vectorcore::HnswIndex pq(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 100, vectorcore::Storage::PQ, 2, 8);
+  bool threw = false;
+  try {
+    pq.attach(other->data(), 100, other);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw && pq.size() == 0 && !pq.is_view());
+  assert(other.use_count() == 1);
+}
+
+} // namespace
+
+int main() {
+  test_bruteforce();
+  test_hnsw();
+  return 0;
+}
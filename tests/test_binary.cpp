@@ -0,0 +1,154 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/scalar_quantizer.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::gaussian_matrix;
+using vectorcore::test::recall;
+
+// One sign bit per dimension, padded to whole words; scores are the exact
+// L2 / IP between the +-1 reconstructions.
+void check_quantizer(vectorcore::Metric metric) {
+  constexpr std::size_t dim = 70;
+  constexpr std::size_t n = 100;
+  const auto data = gaussian_matrix(n, dim, 1);
+  const auto queries = gaussian_matrix(5, dim, 2);
+
+  vectorcore::ScalarQuantizer sq(vectorcore::Storage::BINARY, dim, metric);
+  assert(sq.trained() && sq.code_size() == 16);
+
+  std::vector<std::uint8_t> codes(n * sq.code_size());
+  sq.encode(data.data(), n, codes.data());
+
+  std::vector<float> decoded(dim), signs(dim);
+  vectorcore::PreparedQuery pq;
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::uint8_t* code = codes.data() + i * sq.code_size();
+    sq.decode(code, decoded.data());
+    for (std::size_t d = 0; d < dim; ++d) {
+      assert(decoded[d] == (data[i * dim + d] > 0.f ? 1.f : -1.f));
+    }
+    for (std::size_t b = (dim + 7) / 8; b < sq.code_size(); ++b) {
+      assert(code[b] == 0);
+    }
+    assert((code[dim / 8] >> (dim % 8)) == 0);
+
+    for (std::size_t qi = 0; qi < 5; ++qi) {
+      const float* q = queries.data() + qi * dim;
+      sq.prepare(q, pq);
+      for (std::size_t d = 0; d < dim; ++d) {
+        signs[d] = q[d] > 0.f ? 1.f : -1.f;
+      }
+      const float ref = (metric == vectorcore::Metric::L2_SQUARED)
+                            ? vectorcore::l2_squared_scalar(signs.data(), decoded.data(), dim)
+                            : vectorcore::inner_product_scalar(signs.data(), decoded.data(), dim);
+      assert(sq.score(pq, code) == ref);
+    }
+
+    // Row-to-row scoring goes through the decoded signs.
+    sq.prepare_code(code, pq);
+    assert(sq.score(pq, code) == (metric == vectorcore::Metric::L2_SQUARED ? 0.f : static_cast<float>(dim)));
+  }
+}
+
+// Like real embeddings, the rows span few directions: a fixed random
+// projection of kLatent-dimensional points into 256 dimensions. On
+// isotropic noise every neighbor is equally far and no filter works.
+constexpr std::size_t kLatent = 16;
+
+std::vector<float> embed(const std::vector<float>& latent, std::size_t n) {
+  constexpr std::size_t dim = 256;
+  const auto basis = gaussian_matrix(kLatent, dim, 99);
+  std::vector<float> out(n * dim, 0.f);
+  for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t l = 0; l < kLatent; ++l) {
+      for (std::size_t d = 0; d < dim; ++d) {
+        out[i * dim + d] += latent[i * kLatent + l] * basis[l * dim + d];
+      }
+    }
+  }
+  return out;
+}
+
+// The Hamming scan is a coarse filter; with enough candidates reranked in
+// fp32 the results match the exact search.
+void check_index(vectorcore::Metric metric) {
+  constexpr std::size_t dim = 256;
+  constexpr std::size_t n = 3000;
+  constexpr std::size_t m = 30;
+  constexpr std::size_t k = 10;
+
+  const auto data = embed(gaussian_matrix(n, kLatent, 3), n);
+  const auto queries = embed(gaussian_matrix(m, kLatent, 4), m);
+
+  vectorcore::BruteForceIndex exact(dim, metric);
+  exact.add(data.data(), n);
+  std::vector<std::uint64_t> truth(m * k);
+  std::vector<float> truth_scores(m * k);
+  exact.search_batch(queries.data(), m, k, truth.data(), truth_scores.data());
+
+  std::vector<std::uint64_t> ids(m * k);
+  std::vector<float> scores(m * k);
+
+  vectorcore::BruteForceIndex coarse(dim, metric, vectorcore::Storage::BINARY);
+  coarse.add(data.data(), n);
+  coarse.search_batch(queries.data(), m, k, ids.data(), scores.data());
+  assert(recall(ids, truth, k) >= 0.25);
+
+  vectorcore::BruteForceIndex reranked(dim, metric, vectorcore::Storage::BINARY, 20);
+  reranked.add(data.data(), n);
+  reranked.search_batch(queries.data(), m, k, ids.data(), scores.data());
+  assert(recall(ids, truth, k) >= 0.95);
+  for (std::size_t i = 0; i < m * k; ++i) {
+    if (ids[i] == truth[i]) {
+      assert(std::fabs(scores[i] - truth_scores[i]) <= 1e-3f * (1.f + std::fabs(truth_scores[i])));
+    }
+  }
+
+  // The codes round-trip through save() / load().
+  const std::string path = "vectorcore_test_binary.vci";
+  reranked.save(path);
+  const auto loaded = vectorcore::BruteForceIndex::load(path);
+  assert(loaded.storage() == vectorcore::Storage::BINARY);
+  std::vector<std::uint64_t> loaded_ids(m * k);
+  std::vector<float> loaded_scores(m * k);
+  loaded.search_batch(queries.data(), m, k, loaded_ids.data(), loaded_scores.data());
+  assert(loaded_ids == ids && loaded_scores == scores);
+  std::remove(path.c_str());
+}
+
+void check_hnsw_rejects_binary() {
+  bool threw = false;
+  try {
+    vectorcore::HnswIndex index(64, 16, vectorcore::Metric::L2_SQUARED, 100, 1, vectorcore::Storage::BINARY);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw);
+}
+
+} // namespace
+
+int main() {
+  for (auto metric : {vectorcore::Metric::L2_SQUARED, vectorcore::Metric::INNER_PRODUCT,
+                      vectorcore::Metric::COSINE}) {
+    check_quantizer(metric);
+    check_index(metric);
+  }
+  check_hnsw_rejects_binary();
+  return 0;
+}
@@ -0,0 +1,175 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/float16.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::gaussian_matrix;
+
+// search_batch must agree with per-query search (up to float rounding).
+void check_batch_matches_single(vectorcore::Metric metric) {
+  constexpr std::size_t dim = 48;
+  constexpr std::size_t n = 3000;
+  constexpr std::size_t m = 150; // more than one query block
+  constexpr std::size_t k = 5;
+
+  const auto data = gaussian_matrix(n, dim, 1);
+  const auto queries = gaussian_matrix(m, dim, 2);
+
+  vectorcore::BruteForceIndex index(dim, metric);
+  index.add(data.data(), n);
+
+  std::vector<std::uint64_t> batch_ids(m * k);
+  std::vector<float> batch_scores(m * k);
+  index.search_batch(queries.data(), m, k, batch_ids.data(), batch_scores.data());
+
+  std::vector<std::uint64_t> ids(k);
+  std::vector<float> scores(k);
+  for (std::size_t qi = 0; qi < m; ++qi) {
+    index.search(queries.data() + qi * dim, k, ids.data(), scores.data());
+    assert(batch_ids[qi * k] == ids[0]);
+    for (std::size_t j = 0; j < k; ++j) {
+      assert(std::fabs(batch_scores[qi * k + j] - scores[j]) <= 1e-3f * (1.f + std::fabs(scores[j])));
+    }
+  }
+}
+
+// Threaded paths must return exactly what the serial paths return.
+void check_threaded_matches_serial() {
+  constexpr std::size_t dim = 16;
+  constexpr std::size_t n = 70000; // large enough to split a single query
+  constexpr std::size_t m = 40;
+  constexpr std::size_t k = 8;
+
+  const auto data = gaussian_matrix(n, dim, 3);
+  const auto queries = gaussian_matrix(m, dim, 4);
+
+  vectorcore::BruteForceIndex index(dim);
+  index.add(data.data(), n);
+
+  std::vector<std::uint64_t> serial_ids(m * k), threaded_ids(m * k);
+  std::vector<float> serial_scores(m * k), threaded_scores(m * k);
+
+  index.search_batch(queries.data(), m, k, serial_ids.data(), serial_scores.data(), 1);
+  index.search_batch(queries.data(), m, k, threaded_ids.data(), threaded_scores.data(), 0);
+  assert(serial_ids == threaded_ids);
+
+  for (std::size_t qi = 0; qi < m; ++qi) {
+    const float* q = queries.data() + qi * dim;
+    index.search(q, k, serial_ids.data(), serial_scores.data(), 1);
+    index.search(q, k, threaded_ids.data(), threaded_scores.data(), 4);
+    for (std::size_t j = 0; j < k; ++j) {
+      assert(serial_ids[j] == threaded_ids[j]);
+      assert(serial_scores[j] == threaded_scores[j]);
+    }
+  }
+}
+
+// Rows long enough to be prefetched: every prefetch distance, on fp32 and
+// code scans, returns the same results as no prefetching.
+void check_prefetch_preserves_results() {
+  constexpr std::size_t dim = 384;
+  constexpr std::size_t n = 1000;
+  constexpr std::size_t k = 8;
+  static_assert(dim * sizeof(float) >= vectorcore::BruteForceIndex::kPrefetchMinRowBytes, "rows too short");
+
+  const auto data = gaussian_matrix(n, dim, 5);
+  const auto query = gaussian_matrix(1, dim, 6);
+  for (const auto storage : {vectorcore::Storage::FP32, vectorcore::Storage::FP16}) {
+    vectorcore::BruteForceIndex index(dim, vectorcore::Metric::L2_SQUARED, storage);
+    index.add(data.data(), n);
+
+    std::vector<std::uint64_t> want_ids(k), ids(k);
+    std::vector<float> want_scores(k), scores(k);
+    index.set_prefetch_distance(0);
+    index.search(query.data(), k, want_ids.data(), want_scores.data());
+    for (const std::size_t d : {std::size_t{1}, std::size_t{4}, n + 10}) {
+      index.set_prefetch_distance(d);
+      index.search(query.data(), k, ids.data(), scores.data());
+      assert(ids == want_ids && scores == want_scores);
+    }
+  }
+}
+
+// add_half() must index exactly what add() of the widened rows does, with
+// the rows kept (FP32, COSINE normalized in place) or only encoded (INT8).
+void check_add_half_matches_add() {
+  constexpr std::size_t dim = 37; // not a multiple of any SIMD width
+  constexpr std::size_t n = 500;
+  constexpr std::size_t k = 10;
+
+  const auto data = gaussian_matrix(n, dim, 7);
+  const auto query = gaussian_matrix(1, dim, 8);
+  struct Layout {
+    vectorcore::Metric metric;
+    vectorcore::Storage storage;
+  };
+  for (const auto format : {vectorcore::HalfFormat::FP16, vectorcore::HalfFormat::BF16}) {
+    std::vector<std::uint16_t> halves(n * dim);
+    for (std::size_t i = 0; i < halves.size(); ++i) {
+      halves[i] = format == vectorcore::HalfFormat::FP16 ? vectorcore::float_to_half(data[i])
+                                                          : vectorcore::float_to_bfloat16(data[i]);
+    }
+    std::vector<float> widened(n * dim);
+    for (std::size_t i = 0; i < halves.size(); ++i) {
+      widened[i] = format == vectorcore::HalfFormat::FP16 ? vectorcore::half_to_float(halves[i])
+                                                           : vectorcore::bfloat16_to_float(halves[i]);
+    }
+
+    for (const Layout layout : {Layout{vectorcore::Metric::L2_SQUARED, vectorcore::Storage::FP32},
+                                Layout{vectorcore::Metric::COSINE, vectorcore::Storage::FP32},
+                                Layout{vectorcore::Metric::INNER_PRODUCT, vectorcore::Storage::INT8}}) {
+      vectorcore::BruteForceIndex want(dim, layout.metric, layout.storage);
+      vectorcore::BruteForceIndex got(dim, layout.metric, layout.storage);
+      if (layout.storage == vectorcore::Storage::INT8) {
+        // Same ranges for both, rather than each learning them from its first batch.
+        want.train(widened.data(), n);
+        got.train(widened.data(), n);
+      }
+      want.add(widened.data(), n);
+      got.add_half(halves.data(), n / 2, format);
+      got.add_half(halves.data() + (n / 2) * dim, n - n / 2, format);
+      assert(got.size() == n);
+
+      std::vector<std::uint64_t> want_ids(k), ids(k);
+      std::vector<float> want_scores(k), scores(k);
+      want.search(query.data(), k, want_ids.data(), want_scores.data());
+      got.search(query.data(), k, ids.data(), scores.data());
+      assert(ids == want_ids && scores == want_scores);
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  check_batch_matches_single(vectorcore::Metric::L2_SQUARED);
+  check_batch_matches_single(vectorcore::Metric::INNER_PRODUCT);
+  check_threaded_matches_serial();
+  check_prefetch_preserves_results();
+  check_add_half_matches_add();
+
+  // k > size pads with sentinels.
+  constexpr std::size_t dim = 4;
+  const float data[] = {0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f};
+  vectorcore::BruteForceIndex index(dim);
+  index.add(data, 2);
+
+  std::uint64_t ids[2 * 3];
+  float scores[2 * 3];
+  index.search_batch(data, 2, 3, ids, scores);
+  assert(ids[0] == 0 && ids[1] == 1 && ids[2] == UINT64_MAX);
+  assert(ids[3] == 1 && ids[4] == 0 && ids[5] == UINT64_MAX);
+  assert(scores[0] == 0.f && scores[3] == 0.f);
+
+  return 0;
+}
@@ -0,0 +1,236 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/bulk_loader.h"
+#include "vectorcore/float16.h"
+#include "vectorcore/hnsw_index.h"
+
+namespace {
+
+constexpr std::size_t kDim = 16;
+constexpr std::size_t kRows = 1000;
+
+// Small integers, exact in fp32, fp16 and uint8 alike.
+std::vector<float> random_rows(std::size_t rows, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> value(0, 255);
+  std::vector<float> out(rows * kDim);
+  for (float& x : out) {
+    x = static_cast<float>(value(rng));
+  }
+  return out;
+}
+
+void write_bytes(const std::string& path, const std::vector<char>& bytes) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+template <typename T>
+void append(std::vector<char>& out, const T& v) {
+  const char* p = reinterpret_cast<const char*>(&v);
+  out.insert(out.end(), p, p + sizeof(T));
+}
+
+// .fvecs (value = float) or .bvecs (value = uint8).
+template <typename Value>
+void write_vecs(const std::string& path, const std::vector<float>& rows, std::size_t n) {
+  std::vector<char> bytes;
+  for (std::size_t i = 0; i < n; ++i) {
+    append(bytes, static_cast<std::int32_t>(kDim));
+    for (std::size_t d = 0; d < kDim; ++d) {
+      append(bytes, static_cast<Value>(rows[i * kDim + d]));
+    }
+  }
+  write_bytes(path, bytes);
+}
+
+// A version-`major` .npy of [n, kDim] values with dtype `descr`.
+void write_npy(const std::string& path, const std::vector<float>& rows, std::size_t n, const char* descr,
+               int major = 1, const char* fortran = "False") {
+  std::string header = std::string("{'descr': '") + descr + "', 'fortran_order': " + fortran +
+                       ", 'shape': (" + std::to_string(n) + ", " + std::to_string(kDim) + "), }";
+  const std::size_t prefix = (major == 1) ? 10 : 12;
+  header.append(63 - (prefix + header.size()) % 64, ' ');
+  header.push_back('\n');
+
+  std::vector<char> bytes = {'\x93', 'N', 'U', 'M', 'P', 'Y', static_cast<char>(major), 0};
+  if (major == 1) {
+    append(bytes, static_cast<std::uint16_t>(header.size()));
+  } else {
+    append(bytes, static_cast<std::uint32_t>(header.size()));
+  }
+  bytes.insert(bytes.end(), header.begin(), header.end());
+  for (std::size_t i = 0; i < n * kDim; ++i) {
+    if (std::strcmp(descr, "<f2") == 0) {
+      append(bytes, vectorcore::float_to_half(rows[i]));
+    } else if (std::strcmp(descr, "|u1") == 0) {
+      append(bytes, static_cast<std::uint8_t>(rows[i]));
+    } else {
+      append(bytes, rows[i]);
+    }
+  }
+  write_bytes(path, bytes);
+}
+
+// Every format reads back the same rows, in batches of any size.
+void check_reader(const std::string& path, vectorcore::FileFormat format, const std::vector<float>& want) {
+  vectorcore::VectorFileReader reader(path, format);
+  assert(reader.dim() == kDim && reader.rows() == kRows);
+  std::vector<float> got(kRows * kDim);
+  std::size_t rows = 0;
+  for (const std::size_t batch : {std::size_t{1}, std::size_t{7}, std::size_t{300}, kRows}) {
+    rows += reader.read(got.data() + rows * kDim, batch);
+  }
+  assert(rows == kRows && got == want);
+  assert(reader.read(got.data(), 10) == 0);
+}
+
+template <typename Fn>
+bool throws_runtime(Fn fn) {
+  try {
+    fn();
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+void test_formats() {
+  const auto rows = random_rows(kRows, 1);
+  const std::string path = "vectorcore_test_bulk_loader.bin";
+
+  write_vecs<float>(path, rows, kRows);
+  check_reader(path, vectorcore::FileFormat::FVECS, rows);
+  write_vecs<std::uint8_t>(path, rows, kRows);
+  check_reader(path, vectorcore::FileFormat::BVECS, rows);
+  write_npy(path, rows, kRows, "<f4");
+  check_reader(path, vectorcore::FileFormat::NPY, rows);
+  write_npy(path, rows, kRows, "<f2", 2);
+  check_reader(path, vectorcore::FileFormat::NPY, rows);
+  write_npy(path, rows, kRows, "|u1", 3);
+  check_reader(path, vectorcore::FileFormat::NPY, rows);
+
+  // Malformed files fail on open, naming the file.
+  const auto opens = [&](vectorcore::FileFormat format) {
+    return [&path, format] { vectorcore::VectorFileReader reader(path, format); };
+  };
+  write_npy(path, rows, kRows, "<f8");
+  assert(throws_runtime(opens(vectorcore::FileFormat::NPY)));
+  write_npy(path, rows, kRows, "<f4", 1, "True");
+  assert(throws_runtime(opens(vectorcore::FileFormat::NPY)));
+  write_vecs<float>(path, rows, kRows);
+  assert(throws_runtime(opens(vectorcore::FileFormat::NPY)));
+  {
+    std::ofstream append_byte(path, std::ios::binary | std::ios::app);
+    append_byte.put('\0');
+  }
+  assert(throws_runtime(opens(vectorcore::FileFormat::FVECS)));
+  write_bytes(path, {});
+  assert(throws_runtime(opens(vectorcore::FileFormat::BVECS)));
+  std::remove(path.c_str());
+  assert(throws_runtime(opens(vectorcore::FileFormat::FVECS)));
+
+  // A row whose dimension prefix disagrees is caught when it is read.
+  write_vecs<float>(path, rows, kRows);
+  {
+    std::fstream patch(path, std::ios::binary | std::ios::in | std::ios::out);
+    patch.seekp(static_cast<std::streamoff>(500 * (4 + kDim * sizeof(float))));
+    const std::int32_t bad = 3;
+    patch.write(reinterpret_cast<const char*>(&bad), sizeof(bad));
+  }
+  vectorcore::BruteForceIndex index(kDim);
+  assert(throws_runtime([&] { vectorcore::load_from_file(index, path, vectorcore::FileFormat::FVECS, 100); }));
+  assert(index.size() == 500); // the batches before it were added
+  std::remove(path.c_str());
+}
+
+void test_load() {
+  const auto rows = random_rows(kRows, 2);
+  const auto queries = random_rows(20, 3);
+  const std::string path = "vectorcore_test_bulk_loader.npy";
+  write_npy(path, rows, kRows, "<f4");
+
+  // Streaming in batches matches one add() of the whole matrix.
+  vectorcore::BruteForceIndex streamed(kDim);
+  assert(vectorcore::load_from_file(streamed, path, vectorcore::FileFormat::NPY, 64) == kRows);
+  vectorcore::BruteForceIndex direct(kDim);
+  direct.add(rows.data(), kRows);
+  std::vector<std::uint64_t> a_ids(20 * 10), b_ids(20 * 10);
+  std::vector<float> a_scores(20 * 10), b_scores(20 * 10);
+  streamed.search_batch(queries.data(), 20, 10, a_ids.data(), a_scores.data());
+  direct.search_batch(queries.data(), 20, 10, b_ids.data(), b_scores.data());
+  assert(a_ids == b_ids && a_scores == b_scores);
+
+  // A second load appends, with ids continuing from the first.
+  assert(vectorcore::load_from_file(streamed, path, vectorcore::FileFormat::NPY) == kRows);
+  assert(streamed.size() == 2 * kRows);
+
+  // HNSW inserts each batch on the given pool threads, or serially; every
+  // row finds itself either way.
+  for (const std::size_t num_threads : {std::size_t{4}, std::size_t{1}}) {
+    vectorcore::HnswIndex hnsw(kDim, 12, vectorcore::Metric::L2_SQUARED, 100);
+    assert(vectorcore::load_from_file(hnsw, path, vectorcore::FileFormat::NPY, 150, num_threads) == kRows);
+    assert(hnsw.size() == kRows);
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < kRows; i += 10) {
+      std::uint64_t id = 0;
+      float score = 0.f;
+      hnsw.search(rows.data() + i * kDim, 1, &id, &score);
+      found += (score == 0.f);
+    }
+    assert(found >= 95);
+  }
+
+  // Wrong dimension or batch size: nothing is added.
+  vectorcore::BruteForceIndex wrong(kDim + 1);
+  bool threw = false;
+  try {
+    vectorcore::load_from_file(wrong, path, vectorcore::FileFormat::NPY);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw && wrong.size() == 0);
+  threw = false;
+  try {
+    vectorcore::load_from_file(direct, path, vectorcore::FileFormat::NPY, 0);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw && direct.size() == kRows);
+
+  // An add() that throws stops the reader and surfaces here.
+  vectorcore::BruteForceIndex capped(kDim);
+  capped.set_ingest_capacity(300);
+  threw = false;
+  try {
+    vectorcore::load_from_file(capped, path, vectorcore::FileFormat::NPY, 100);
+  } catch (const std::length_error&) {
+    threw = true;
+  }
+  assert(threw && capped.size() == 300);
+
+  // An empty array loads nothing.
+  write_npy(path, rows, 0, "<f4");
+  assert(vectorcore::load_from_file(direct, path, vectorcore::FileFormat::NPY) == 0);
+  std::remove(path.c_str());
+}
+
+} // namespace
+
+int main() {
+  test_formats();
+  test_load();
+  return 0;
+}
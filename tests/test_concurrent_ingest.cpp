@@ -0,0 +1,203 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+constexpr std::size_t kDim = 16;
+constexpr std::size_t kRows = 4000;
+constexpr std::size_t kBatch = 250;
+constexpr std::size_t kQueries = 40;
+constexpr std::size_t kK = 10;
+constexpr std::uint64_t kPad = std::numeric_limits<std::uint64_t>::max();
+
+float l2(const float* a, const float* b) {
+  float s = 0.f;
+  for (std::size_t d = 0; d < kDim; ++d) {
+    s += (a[d] - b[d]) * (a[d] - b[d]);
+  }
+  return s;
+}
+
+// Row i carries id 1000 + i, so a torn or unpublished row shows up as a
+// score that does not match its id's row.
+std::vector<std::uint64_t> row_ids() {
+  std::vector<std::uint64_t> ids(kRows);
+  for (std::size_t i = 0; i < kRows; ++i) {
+    ids[i] = 1000 + i;
+  }
+  return ids;
+}
+
+// One writer adds batches while readers search; every result a reader sees
+// is a fully written row with its exact score, best first.
+template <typename Index>
+void check_search_during_add(Index& index, const std::vector<float>& data, const std::vector<float>& queries) {
+  const auto ids = row_ids();
+  std::atomic<bool> done{false};
+  std::atomic<std::size_t> checked{0};
+
+  auto reader = [&] {
+    std::vector<std::uint64_t> out_ids(kQueries * kK);
+    std::vector<float> out_scores(kQueries * kK);
+    while (!done.load()) {
+      const std::size_t seen = index.size();
+      index.search_batch(queries.data(), kQueries, kK, out_ids.data(), out_scores.data());
+      for (std::size_t q = 0; q < kQueries; ++q) {
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < kK; ++i) {
+          const std::uint64_t id = out_ids[q * kK + i];
+          if (id == kPad) {
+            continue;
+          }
+          ++found;
+          assert(id >= 1000 && id < 1000 + kRows);
+          const float want = l2(queries.data() + q * kDim, data.data() + (id - 1000) * kDim);
+          assert(std::abs(out_scores[q * kK + i] - want) <= 1e-4f * (1.f + want));
+          if (i > 0 && out_ids[q * kK + i - 1] != kPad) {
+            assert(out_scores[q * kK + i - 1] <= out_scores[q * kK + i]);
+          }
+        }
+        // Rows published before the search started are all visible to it.
+        assert(found >= std::min(kK, seen) * 9 / 10);
+      }
+      checked.fetch_add(kQueries);
+    }
+  };
+
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; ++t) {
+    readers.emplace_back(reader);
+  }
+  for (std::size_t r = 0; r < kRows; r += kBatch) {
+    // Let a search pass in between, or a fast writer finishes first.
+    const std::size_t before = checked.load();
+    while (checked.load() == before) {
+      std::this_thread::yield();
+    }
+    index.add(data.data() + r * kDim, kBatch, ids.data() + r);
+  }
+  done = true;
+  for (auto& t : readers) {
+    t.join();
+  }
+  assert(index.size() == kRows);
+  assert(checked.load() > 0);
+}
+
+template <typename Index>
+void check_same_results(const Index& a, const Index& b, const std::vector<float>& queries) {
+  std::vector<std::uint64_t> a_ids(kQueries * kK), b_ids(kQueries * kK);
+  std::vector<float> a_scores(kQueries * kK), b_scores(kQueries * kK);
+  a.search_batch(queries.data(), kQueries, kK, a_ids.data(), a_scores.data());
+  b.search_batch(queries.data(), kQueries, kK, b_ids.data(), b_scores.data());
+  assert(a_ids == b_ids && a_scores == b_scores);
+}
+
+// Past the capacity add() throws and changes nothing.
+template <typename Index>
+void check_capacity(Index& index, const std::vector<float>& data) {
+  const std::size_t before = index.size();
+  bool threw = false;
+  try {
+    index.add(data.data(), 1);
+  } catch (const std::length_error&) {
+    threw = true;
+  }
+  assert(threw && index.size() == before);
+
+  threw = false;
+  try {
+    index.set_ingest_capacity(before - 1);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw && index.ingest_capacity() == kRows);
+
+  // Raising the capacity (no searches running) lets add() continue.
+  index.set_ingest_capacity(kRows + kBatch);
+  index.add(data.data(), kBatch);
+  assert(index.size() == before + kBatch);
+  index.set_ingest_capacity(0);
+  index.add(data.data(), 1);
+  assert(index.size() == before + kBatch + 1);
+}
+
+void test_bruteforce() {
+  const auto data = random_matrix(kRows, kDim, 1);
+  const auto queries = random_matrix(kQueries, kDim, 2);
+  const auto ids = row_ids();
+
+  vectorcore::BruteForceIndex index(kDim);
+  index.set_ingest_capacity(kRows);
+  assert(index.ingest_capacity() == kRows);
+  check_search_during_add(index, data, queries);
+
+  vectorcore::BruteForceIndex plain(kDim);
+  plain.add(data.data(), kRows, ids.data());
+  check_same_results(index, plain, queries);
+  check_capacity(index, data);
+
+  // INT8 ranges would be learned under the readers' feet.
+  vectorcore::BruteForceIndex int8(kDim, vectorcore::Metric::L2_SQUARED, vectorcore::Storage::INT8);
+  bool threw = false;
+  try {
+    int8.set_ingest_capacity(kRows);
+  } catch (const std::logic_error&) {
+    threw = true;
+  }
+  assert(threw);
+  int8.train(data.data(), kRows);
+  int8.set_ingest_capacity(kRows);
+}
+
+void test_hnsw() {
+  const auto data = random_matrix(kRows, kDim, 3);
+  const auto queries = random_matrix(kQueries, kDim, 4);
+  const auto ids = row_ids();
+
+  vectorcore::HnswIndex index(kDim, 8, vectorcore::Metric::L2_SQUARED, 64);
+  index.set_ingest_capacity(kRows);
+  check_search_during_add(index, data, queries);
+
+  // Serial inserts under the stripe locks build the same graph.
+  vectorcore::HnswIndex plain(kDim, 8, vectorcore::Metric::L2_SQUARED, 64);
+  for (std::size_t r = 0; r < kRows; r += kBatch) {
+    plain.add(data.data() + r * kDim, kBatch, ids.data() + r);
+  }
+  check_same_results(index, plain, queries);
+  check_capacity(index, data);
+
+  // Compaction keeps the reservation.
+  vectorcore::HnswIndex compacted(kDim, 8);
+  compacted.set_ingest_capacity(kRows);
+  compacted.add(data.data(), kBatch, ids.data());
+  assert(compacted.remove(ids.data(), 10) == 10);
+  compacted.compact();
+  compacted.add(data.data() + kBatch * kDim, kRows - kBatch, ids.data() + kBatch);
+  assert(compacted.size() == kRows - 10);
+}
+
+} // namespace
+
+int main() {
+  test_bruteforce();
+  test_hnsw();
+  return 0;
+}
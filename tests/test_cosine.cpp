@@ -0,0 +1,177 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/distance.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/ivf_index.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+constexpr std::size_t kDim = 24;
+constexpr std::size_t kRows = 600;
+constexpr std::size_t kQueries = 10;
+constexpr std::size_t kK = 5;
+
+// Every row scaled by a different positive factor; cosine ignores it.
+std::vector<float> rescaled(const std::vector<float>& x, std::size_t dim) {
+  std::vector<float> out(x);
+  for (std::size_t i = 0; i < out.size() / dim; ++i) {
+    const float s = 0.25f + static_cast<float>(i % 7);
+    for (std::size_t d = 0; d < dim; ++d) {
+      out[i * dim + d] *= s;
+    }
+  }
+  return out;
+}
+
+template <typename Search>
+void search_all(Search search, const std::vector<float>& queries, std::vector<std::uint64_t>& ids,
+                std::vector<float>& scores) {
+  ids.assign(kQueries * kK, 0);
+  scores.assign(kQueries * kK, 0.f);
+  for (std::size_t i = 0; i < kQueries; ++i) {
+    search(queries.data() + i * kDim, ids.data() + i * kK, scores.data() + i * kK);
+  }
+}
+
+void assert_close(const std::vector<float>& a, const std::vector<float>& b) {
+  assert(a.size() == b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    assert(std::fabs(a[i] - b[i]) < 1e-4f);
+  }
+}
+
+} // namespace
+
+int main() {
+  const auto data = random_matrix(kRows, kDim, 1);
+  const auto queries = random_matrix(kQueries, kDim, 2);
+  const auto scaled = rescaled(data, kDim);
+  const auto scaled_queries = rescaled(queries, kDim);
+
+  auto unit = data;
+  vectorcore::normalize_rows(unit.data(), kRows, kDim);
+  auto unit_queries = queries;
+  vectorcore::normalize_rows(unit_queries.data(), kQueries, kDim);
+  for (std::size_t i = 0; i < kRows; ++i) {
+    const float n = vectorcore::inner_product(unit.data() + i * kDim, unit.data() + i * kDim, kDim);
+    assert(std::fabs(n - 1.f) < 1e-5f);
+  }
+
+  // A zero vector stays zero instead of turning into NaN.
+  std::vector<float> zero(kDim, 0.f);
+  vectorcore::normalize(zero.data(), kDim);
+  for (float x : zero) {
+    assert(x == 0.f);
+  }
+
+  // Brute force: cosine on raw rows == IP on unit rows, and scale-invariant.
+  {
+    vectorcore::BruteForceIndex ip(kDim, vectorcore::Metric::INNER_PRODUCT);
+    ip.add(unit.data(), kRows);
+    vectorcore::BruteForceIndex cos(kDim, vectorcore::Metric::COSINE);
+    cos.add(scaled.data(), kRows);
+
+    std::vector<std::uint64_t> ids_ip, ids_cos;
+    std::vector<float> scores_ip, scores_cos;
+    search_all([&](const float* q, std::uint64_t* i, float* s) { ip.search(q, kK, i, s); }, unit_queries, ids_ip,
+               scores_ip);
+    search_all([&](const float* q, std::uint64_t* i, float* s) { cos.search(q, kK, i, s); }, scaled_queries,
+               ids_cos, scores_cos);
+    assert(ids_ip == ids_cos);
+    assert_close(scores_ip, scores_cos);
+    for (float s : scores_cos) {
+      assert(s <= 1.f + 1e-5f && s >= -1.f - 1e-5f);
+    }
+
+    std::vector<std::uint64_t> batch_ids(kQueries * kK);
+    std::vector<float> batch_scores(kQueries * kK);
+    cos.search_batch(scaled_queries.data(), kQueries, kK, batch_ids.data(), batch_scores.data());
+    assert(batch_ids == ids_cos);
+    assert_close(batch_scores, scores_cos);
+
+    // Compressed storage normalizes before encoding.
+    vectorcore::BruteForceIndex cos8(kDim, vectorcore::Metric::COSINE, vectorcore::Storage::INT8, 4);
+    cos8.train(scaled.data(), kRows);
+    cos8.add(scaled.data(), kRows);
+    std::vector<std::uint64_t> ids8;
+    std::vector<float> scores8;
+    search_all([&](const float* q, std::uint64_t* i, float* s) { cos8.search(q, kK, i, s); }, scaled_queries, ids8,
+               scores8);
+    assert(scores8[0] <= 1.f + 1e-5f);
+
+    // The metric survives a save / load round trip.
+    const std::string path = "vectorcore_test_cosine.vci";
+    cos.save(path);
+    const auto loaded = vectorcore::BruteForceIndex::load(path);
+    assert(loaded.metric() == vectorcore::Metric::COSINE);
+    std::vector<std::uint64_t> ids_loaded;
+    std::vector<float> scores_loaded;
+    search_all([&](const float* q, std::uint64_t* i, float* s) { loaded.search(q, kK, i, s); }, scaled_queries,
+               ids_loaded, scores_loaded);
+    assert(ids_loaded == ids_cos && scores_loaded == scores_cos);
+    std::remove(path.c_str());
+
+    // A zero query scores 0 against everything, not NaN.
+    std::uint64_t id = 0;
+    float score = 1.f;
+    cos.search(zero.data(), 1, &id, &score);
+    assert(score == 0.f);
+  }
+
+  // HNSW builds the same graph from raw rows as IP does from unit rows.
+  {
+    vectorcore::HnswIndex ip(kDim, 8, vectorcore::Metric::INNER_PRODUCT, 64);
+    ip.add(unit.data(), kRows);
+    vectorcore::HnswIndex cos(kDim, 8, vectorcore::Metric::COSINE, 64);
+    cos.add(scaled.data(), kRows);
+    assert(cos.metric() == vectorcore::Metric::COSINE);
+
+    std::vector<std::uint64_t> ids_ip, ids_cos;
+    std::vector<float> scores_ip, scores_cos;
+    search_all([&](const float* q, std::uint64_t* i, float* s) { ip.search(q, kK, i, s); }, unit_queries, ids_ip,
+               scores_ip);
+    search_all([&](const float* q, std::uint64_t* i, float* s) { cos.search(q, kK, i, s); }, scaled_queries,
+               ids_cos, scores_cos);
+    std::size_t same = 0;
+    for (std::size_t i = 0; i < ids_ip.size(); ++i) {
+      same += (ids_ip[i] == ids_cos[i]) ? 1 : 0;
+    }
+    assert(same * 10 >= ids_ip.size() * 9);
+    for (float s : scores_cos) {
+      assert(s <= 1.f + 1e-5f);
+    }
+  }
+
+  // IVF with nprobe == nlist is exact cosine search.
+  {
+    vectorcore::BruteForceIndex exact(kDim, vectorcore::Metric::COSINE);
+    exact.add(data.data(), kRows);
+    vectorcore::IvfIndex cos(kDim, 8, vectorcore::Metric::COSINE);
+    cos.train(scaled.data(), kRows);
+    cos.add(scaled.data(), kRows);
+
+    std::vector<std::uint64_t> ids_exact, ids_cos;
+    std::vector<float> scores_exact, scores_cos;
+    search_all([&](const float* q, std::uint64_t* i, float* s) { exact.search(q, kK, i, s); }, queries, ids_exact,
+               scores_exact);
+    search_all([&](const float* q, std::uint64_t* i, float* s) { cos.search(q, kK, i, s, 8); }, scaled_queries,
+               ids_cos, scores_cos);
+    assert(ids_exact == ids_cos);
+    assert_close(scores_exact, scores_cos);
+  }
+
+  return 0;
+}
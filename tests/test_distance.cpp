@@ -0,0 +1,188 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "vectorcore/distance.h"
+#include "vectorcore/float16.h"
+
+namespace {
+
+bool close(float a, float b) {
+  return std::fabs(a - b) <= 1e-4f * std::max(1.0f, std::fabs(b));
+}
+
+// For sums with heavy cancellation: error relative to the sum of |terms|.
+bool close_abs(float a, float b, float magnitude) {
+  return std::fabs(a - b) <= 1e-5f * std::max(1.0f, magnitude);
+}
+
+} // namespace
+
+int main() {
+  const auto kernels = vectorcore::supported_distance_kernels();
+  assert(!kernels.empty());
+  assert(std::strcmp(kernels.front().name, "scalar") == 0);
+  assert(std::strcmp(kernels.back().name, vectorcore::active_kernel()) == 0);
+
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> uni(-1.f, 1.f);
+
+  // +1 offset exercises unaligned loads; dims cover every tail length.
+  std::vector<float> a(1 + 300), b(1 + 300);
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    a[i] = uni(rng);
+    b[i] = uni(rng);
+  }
+
+  for (std::size_t dim = 1; dim <= 300; ++dim) {
+    const float l2_ref = vectorcore::l2_squared_scalar(a.data() + 1, b.data() + 1, dim);
+    const float ip_ref = vectorcore::inner_product_scalar(a.data() + 1, b.data() + 1, dim);
+
+    for (const auto& k : kernels) {
+      assert(close(k.l2_squared(a.data() + 1, b.data() + 1, dim), l2_ref));
+      assert(close(k.inner_product(a.data() + 1, b.data() + 1, dim), ip_ref));
+    }
+
+    assert(close(vectorcore::l2_squared(a.data() + 1, b.data() + 1, dim), l2_ref));
+    assert(close(vectorcore::inner_product(a.data() + 1, b.data() + 1, dim), ip_ref));
+  }
+
+  // Compressed-row kernels against their scalar references.
+  std::vector<float> scale(1 + 300), a_abs(1 + 300);
+  std::vector<std::uint8_t> u8(1 + 300);
+  std::vector<std::uint16_t> f16(1 + 300);
+  std::uniform_int_distribution<int> byte(0, 255);
+  for (std::size_t i = 0; i < u8.size(); ++i) {
+    scale[i] = 0.01f * (1.0f + uni(rng));
+    a_abs[i] = std::fabs(a[i]);
+    u8[i] = static_cast<std::uint8_t>(byte(rng));
+    f16[i] = vectorcore::float_to_half(b[i]);
+  }
+
+  for (std::size_t dim = 1; dim <= 300; ++dim) {
+    const float* qa = a.data() + 1;
+    const float sq8_l2_ref = vectorcore::l2_squared_sq8_scalar(qa, scale.data() + 1, u8.data() + 1, dim);
+    const float sq8_ip_ref = vectorcore::inner_product_sq8_scalar(qa, u8.data() + 1, dim);
+    const float f16_l2_ref = vectorcore::l2_squared_fp16_scalar(qa, f16.data() + 1, dim);
+    const float f16_ip_ref = vectorcore::inner_product_fp16_scalar(qa, f16.data() + 1, dim);
+    const float sq8_ip_mag = vectorcore::inner_product_sq8_scalar(a_abs.data() + 1, u8.data() + 1, dim);
+    const float f16_ip_mag = vectorcore::inner_product_scalar(a_abs.data() + 1, a_abs.data() + 1, dim) +
+                             vectorcore::inner_product_scalar(b.data() + 1, b.data() + 1, dim);
+
+    for (const auto& k : kernels) {
+      assert(close(k.l2_squared_sq8(qa, scale.data() + 1, u8.data() + 1, dim), sq8_l2_ref));
+      assert(close_abs(k.inner_product_sq8(qa, u8.data() + 1, dim), sq8_ip_ref, sq8_ip_mag));
+      assert(close(k.l2_squared_fp16(qa, f16.data() + 1, dim), f16_l2_ref));
+      assert(close_abs(k.inner_product_fp16(qa, f16.data() + 1, dim), f16_ip_ref, f16_ip_mag));
+    }
+  }
+
+  // PQ ADC: m table lookups, one 256-entry row per sub-space.
+  std::vector<float> table(300 * 256);
+  for (float& t : table) {
+    t = 1.0f + uni(rng);
+  }
+  for (std::size_t m = 1; m <= 300; ++m) {
+    const float ref = vectorcore::pq_adc_scalar(table.data(), u8.data() + 1, m);
+    for (const auto& k : kernels) {
+      assert(close(k.pq_adc(table.data(), u8.data() + 1, m), ref));
+    }
+  }
+
+  // Dimension-specialized fp32 kernels: bit-identical to the family's
+  // generic kernel, and absent for other dimensions.
+  std::vector<float> x(1 + 1536), y(1 + 1536);
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    x[i] = uni(rng);
+    y[i] = uni(rng);
+  }
+  for (const std::size_t dim : {128, 256, 384, 512, 768, 1024, 1536}) {
+    const float* xa = x.data() + 1;
+    const float* ya = y.data() + 1;
+    for (const auto& k : kernels) {
+      const vectorcore::DistanceFn l2 = k.l2_squared_for(dim);
+      const vectorcore::DistanceFn ip = k.inner_product_for(dim);
+      assert(l2(xa, ya, dim) == k.l2_squared(xa, ya, dim));
+      assert(ip(xa, ya, dim) == k.inner_product(xa, ya, dim));
+      assert(close(l2(xa, ya, dim), vectorcore::l2_squared_scalar(xa, ya, dim)));
+      assert(close(ip(xa, ya, dim), vectorcore::inner_product_scalar(xa, ya, dim)));
+      if (k.l2_squared_fixed) {
+        assert(l2 != k.l2_squared && ip != k.inner_product);
+      }
+      assert(k.fp32_for(vectorcore::Metric::COSINE, dim) == ip);
+    }
+  }
+  for (const auto& k : kernels) {
+    assert(k.l2_squared_for(100) == k.l2_squared);
+    assert(k.inner_product_for(1000) == k.inner_product);
+  }
+
+  // Input widening: every fp16 / bf16 bit pattern, bit-identical to the
+  // scalar conversion (NaNs only need to stay NaN), at every tail length.
+  std::vector<std::uint16_t> halves(1 + 65536);
+  for (std::size_t i = 0; i < 65536; ++i) {
+    halves[1 + i] = static_cast<std::uint16_t>(i);
+  }
+  const auto same = [](float got, float want) {
+    return std::isnan(want) ? std::isnan(got) : std::memcmp(&got, &want, sizeof(float)) == 0;
+  };
+  std::vector<float> widened(65536);
+  for (const auto& k : kernels) {
+    for (const std::size_t n : {std::size_t{0}, std::size_t{1}, std::size_t{7}, std::size_t{15}, std::size_t{17},
+                                std::size_t{31}, std::size_t{33}, std::size_t{65536}}) {
+      std::fill(widened.begin(), widened.end(), -1.f);
+      k.fp16_to_fp32(halves.data() + 1, widened.data(), n);
+      for (std::size_t i = 0; i < n; ++i) {
+        assert(same(widened[i], vectorcore::half_to_float(halves[1 + i])));
+      }
+      assert(n == widened.size() || widened[n] == -1.f); // nothing written past n
+
+      std::fill(widened.begin(), widened.end(), -1.f);
+      k.bf16_to_fp32(halves.data() + 1, widened.data(), n);
+      for (std::size_t i = 0; i < n; ++i) {
+        assert(same(widened[i], vectorcore::bfloat16_to_float(halves[1 + i])));
+      }
+      assert(n == widened.size() || widened[n] == -1.f);
+    }
+  }
+  // Hamming distance: every family matches the scalar popcount at every
+  // length up to a few vector widths, from unaligned starts.
+  std::vector<std::uint8_t> bits_a(3 + 300), bits_b(3 + 300);
+  for (std::size_t i = 0; i < bits_a.size(); ++i) {
+    bits_a[i] = static_cast<std::uint8_t>(byte(rng));
+    bits_b[i] = static_cast<std::uint8_t>(byte(rng));
+  }
+  for (std::size_t offset = 0; offset < 3; ++offset) {
+    for (std::size_t n = 0; n <= 300; ++n) {
+      std::uint32_t want = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        for (unsigned x = bits_a[offset + i] ^ bits_b[offset + i]; x != 0; x &= x - 1) {
+          ++want;
+        }
+      }
+      for (const auto& k : kernels) {
+        assert(k.hamming(bits_a.data() + offset, bits_b.data() + offset, n) == want);
+      }
+    }
+  }
+  const std::vector<std::uint8_t> ones(256, 0xFF), zeros(256, 0);
+  for (const auto& k : kernels) {
+    assert(k.hamming(ones.data(), zeros.data(), 256) == 2048);
+    assert(k.hamming(ones.data(), ones.data(), 256) == 0);
+  }
+
+  for (const float v : {0.f, -0.f, 1.f, -2.5f, 3.14159f, 1e-30f, 65504.f, 1e30f}) {
+    const std::uint16_t b = vectorcore::float_to_bfloat16(v);
+    assert(std::fabs(vectorcore::bfloat16_to_float(b) - v) <= std::fabs(v) * (1.f / 256));
+  }
+  assert(vectorcore::float_to_bfloat16(1.00390625f) == 0x3F80); // tie rounds to even
+  assert(vectorcore::float_to_bfloat16(1.01171875f) == 0x3F82);
+
+  return 0;
+}
@@ -0,0 +1,187 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/search_filter.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+using vectorcore::test::recall;
+
+constexpr std::size_t kDim = 16;
+constexpr std::size_t kRows = 3000;
+constexpr std::size_t kQueries = 40;
+constexpr std::size_t kK = 10;
+
+// Rows with row % modulus == 0 form the allowed "tenant". Ids are row + 1000.
+struct Tenant {
+  std::vector<std::uint64_t> words;
+  std::vector<std::uint64_t> ids;
+};
+
+Tenant tenant(std::size_t modulus) {
+  Tenant t;
+  t.words.assign((kRows + 63) / 64, 0);
+  for (std::size_t r = 0; r < kRows; r += modulus) {
+    t.words[r / 64] |= std::uint64_t{1} << (r % 64);
+    t.ids.push_back(r + 1000);
+  }
+  return t;
+}
+
+// Exact index over the tenant's rows only.
+vectorcore::BruteForceIndex reference(const std::vector<float>& data, const Tenant& t) {
+  vectorcore::BruteForceIndex index(kDim);
+  for (const std::uint64_t id : t.ids) {
+    index.add(data.data() + (id - 1000) * kDim, 1, &id);
+  }
+  return index;
+}
+
+template <typename Index>
+void search_all(const Index& index, const std::vector<float>& queries, const vectorcore::SearchFilter& filter,
+                std::vector<std::uint64_t>& ids, std::vector<float>& scores) {
+  ids.assign(kQueries * kK, 0);
+  scores.assign(kQueries * kK, 0.f);
+  for (std::size_t i = 0; i < kQueries; ++i) {
+    index.search(queries.data() + i * kDim, kK, ids.data() + i * kK, scores.data() + i * kK, &filter);
+  }
+}
+
+// BruteForceIndex::search takes num_threads before the filter.
+void search_all(const vectorcore::BruteForceIndex& index, const std::vector<float>& queries,
+                const vectorcore::SearchFilter& filter, std::vector<std::uint64_t>& ids, std::vector<float>& scores) {
+  ids.assign(kQueries * kK, 0);
+  scores.assign(kQueries * kK, 0.f);
+  for (std::size_t i = 0; i < kQueries; ++i) {
+    index.search(queries.data() + i * kDim, kK, ids.data() + i * kK, scores.data() + i * kK, 1, &filter);
+  }
+}
+
+void assert_allowed(const std::vector<std::uint64_t>& ids, const Tenant& t) {
+  for (const std::uint64_t id : ids) {
+    assert(id == UINT64_MAX || std::binary_search(t.ids.begin(), t.ids.end(), id));
+  }
+}
+
+} // namespace
+
+int main() {
+  const auto data = random_matrix(kRows, kDim, 1);
+  const auto queries = random_matrix(kQueries, kDim, 2);
+  std::vector<std::uint64_t> row_ids(kRows);
+  for (std::size_t r = 0; r < kRows; ++r) {
+    row_ids[r] = r + 1000;
+  }
+
+  const Tenant third = tenant(3);
+  const auto truth_index = reference(data, third);
+  std::vector<std::uint64_t> truth;
+  std::vector<float> truth_scores;
+  {
+    const auto all = vectorcore::SearchFilter::predicate([](std::uint64_t) { return true; });
+    search_all(truth_index, queries, all, truth, truth_scores);
+  }
+
+  const auto by_bitmap = vectorcore::SearchFilter::bitmap(third.words.data(), kRows);
+  const auto by_list = vectorcore::SearchFilter::allow_list(third.ids.data(), third.ids.size());
+  const auto by_predicate =
+      vectorcore::SearchFilter::predicate([](std::uint64_t id) { return (id - 1000) % 3 == 0; });
+
+  assert(by_bitmap.selectivity(row_ids.data(), kRows) == static_cast<double>(third.ids.size()) / kRows);
+  const double sampled = by_predicate.selectivity(row_ids.data(), kRows);
+  assert(sampled > 0.25 && sampled < 0.42);
+
+  // Brute force: every filter form gives the exact top-k of the tenant.
+  for (auto storage : {vectorcore::Storage::FP32, vectorcore::Storage::INT8}) {
+    const bool fp32 = storage == vectorcore::Storage::FP32;
+    vectorcore::BruteForceIndex index(kDim, vectorcore::Metric::L2_SQUARED, storage, fp32 ? 0 : 8);
+    index.add(data.data(), kRows, row_ids.data());
+
+    for (const auto* filter : {&by_bitmap, &by_list, &by_predicate}) {
+      std::vector<std::uint64_t> ids;
+      std::vector<float> scores;
+      search_all(index, queries, *filter, ids, scores);
+      assert(ids == truth);
+      assert(scores == truth_scores);
+
+      for (std::size_t threads : {1u, 0u}) {
+        std::vector<std::uint64_t> batch_ids(kQueries * kK);
+        std::vector<float> batch_scores(kQueries * kK);
+        index.search_batch(queries.data(), kQueries, kK, batch_ids.data(), batch_scores.data(), threads, filter);
+        assert(recall(batch_ids, truth, kK) == 1.0);
+        assert_allowed(batch_ids, third);
+      }
+    }
+
+    // Fewer allowed rows than k pads the tail.
+    const std::uint64_t two_ids[] = {1000, 1003};
+    const auto two = vectorcore::SearchFilter::allow_list(two_ids, 2);
+    std::uint64_t out[4];
+    float out_scores[4];
+    index.search(queries.data(), 4, out, out_scores, 1, &two);
+    assert(out[2] == UINT64_MAX && out[3] == UINT64_MAX);
+    assert(std::min(out[0], out[1]) == 1000 && std::max(out[0], out[1]) == 1003);
+
+    // Filters and removals combine.
+    const std::uint64_t gone[] = {1000};
+    index.remove(gone, 1);
+    index.search(queries.data(), 4, out, out_scores, 1, &two);
+    assert(out[0] == 1003 && out[1] == UINT64_MAX);
+  }
+
+  // HNSW: a broad filter is walked and only admits allowed nodes.
+  vectorcore::HnswIndex hnsw(kDim, 12, vectorcore::Metric::L2_SQUARED, 100);
+  hnsw.add(data.data(), kRows, row_ids.data());
+  hnsw.set_ef_search(100);
+  for (const auto* filter : {&by_bitmap, &by_list, &by_predicate}) {
+    std::vector<std::uint64_t> ids;
+    std::vector<float> scores;
+    search_all(hnsw, queries, *filter, ids, scores);
+    assert_allowed(ids, third);
+    assert(recall(ids, truth, kK) >= 0.9);
+
+    std::vector<std::uint64_t> batch_ids(kQueries * kK);
+    std::vector<float> batch_scores(kQueries * kK);
+    hnsw.search_batch(queries.data(), kQueries, kK, batch_ids.data(), batch_scores.data(), 0, filter);
+    assert(batch_ids == ids);
+  }
+
+  // A very selective filter falls back to an exact scan of the allowed nodes.
+  {
+    const Tenant rare = tenant(97);
+    const auto rare_filter = vectorcore::SearchFilter::bitmap(rare.words.data(), kRows);
+    assert(rare_filter.selectivity(row_ids.data(), kRows) < vectorcore::HnswIndex::kFilterScanSelectivity);
+
+    const auto rare_truth_index = reference(data, rare);
+    const auto all = vectorcore::SearchFilter::predicate([](std::uint64_t) { return true; });
+    std::vector<std::uint64_t> rare_truth, ids;
+    std::vector<float> rare_scores, scores;
+    search_all(rare_truth_index, queries, all, rare_truth, rare_scores);
+    search_all(hnsw, queries, rare_filter, ids, scores);
+    assert(ids == rare_truth);
+    assert(scores == rare_scores);
+  }
+
+  // An allow-list must be sorted.
+  bool threw = false;
+  try {
+    const std::uint64_t unsorted[] = {3, 1};
+    vectorcore::SearchFilter::allow_list(unsorted, 2);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw);
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/float16.h"
+#include "vectorcore/hnsw_index.h"
+
+#include "test_util.h"
+
+int main() {
+  constexpr std::size_t dim = 32;
+  constexpr std::size_t n = 2000;
+  constexpr std::size_t n_queries = 50;
+  constexpr std::size_t k = 10;
+
+  const auto data = vectorcore::test::gaussian_matrix(n, dim, 42);
+
+  vectorcore::BruteForceIndex exact(dim, vectorcore::Metric::L2_SQUARED);
+  exact.add(data.data(), n);
+
+  vectorcore::HnswIndex hnsw(dim, 16, vectorcore::Metric::L2_SQUARED, 100);
+  // Two batches so the second add links against an existing graph.
+  hnsw.add(data.data(), n / 2);
+  hnsw.add(data.data() + (n / 2) * dim, n - n / 2);
+  assert(hnsw.size() == n);
+  assert(hnsw.max_level() >= 1);
+
+  std::size_t hits = 0;
+  std::vector<std::uint64_t> gt_ids(k), ids(k);
+  std::vector<float> gt_scores(k), scores(k);
+
+  for (std::size_t qi = 0; qi < n_queries; ++qi) {
+    const float* q = data.data() + (qi * 37 % n) * dim;
+
+    exact.search(q, k, gt_ids.data(), gt_scores.data());
+    hnsw.search(q, k, ids.data(), scores.data());
+
+    // A stored vector must find itself first.
+    assert(ids[0] == gt_ids[0]);
+    assert(scores[0] == 0.f);
+
+    const std::unordered_set<std::uint64_t> truth(gt_ids.begin(), gt_ids.end());
+    for (const std::uint64_t id : ids) {
+      hits += truth.count(id);
+    }
+  }
+
+  const double recall = static_cast<double>(hits) / static_cast<double>(n_queries * k);
+  assert(recall >= 0.9);
+
+  // Threaded batch search returns the same rows as one search() per query.
+  std::vector<std::uint64_t> batch_ids(n_queries * k);
+  std::vector<float> batch_scores(n_queries * k);
+  hnsw.search_batch(data.data(), n_queries, k, batch_ids.data(), batch_scores.data(), 0);
+  for (std::size_t qi = 0; qi < n_queries; ++qi) {
+    hnsw.search(data.data() + qi * dim, k, ids.data(), scores.data());
+    for (std::size_t j = 0; j < k; ++j) {
+      assert(batch_ids[qi * k + j] == ids[j]);
+    }
+  }
+
+  // Prefetching is only a hint: any distance gives the same results.
+  for (const std::size_t d : {std::size_t{0}, std::size_t{1}, std::size_t{64}}) {
+    hnsw.set_prefetch_distance(d);
+    for (std::size_t qi = 0; qi < n_queries; ++qi) {
+      hnsw.search(data.data() + qi * dim, k, ids.data(), scores.data());
+      for (std::size_t j = 0; j < k; ++j) {
+        assert(batch_ids[qi * k + j] == ids[j]);
+      }
+    }
+  }
+  hnsw.set_prefetch_distance(vectorcore::HnswIndex::kDefaultPrefetchDistance);
+
+  // Parallel build: same recall bar as the serial build.
+  vectorcore::HnswIndex parallel(dim, 16, vectorcore::Metric::L2_SQUARED, 100);
+  parallel.add(data.data(), n, nullptr, 0);
+  assert(parallel.size() == n);
+
+  hits = 0;
+  for (std::size_t qi = 0; qi < n_queries; ++qi) {
+    const float* q = data.data() + (qi * 37 % n) * dim;
+    exact.search(q, k, gt_ids.data(), gt_scores.data());
+    parallel.search(q, k, ids.data(), scores.data());
+
+    const std::unordered_set<std::uint64_t> truth(gt_ids.begin(), gt_ids.end());
+    for (const std::uint64_t id : ids) {
+      hits += truth.count(id);
+    }
+  }
+  assert(static_cast<double>(hits) / static_cast<double>(n_queries * k) >= 0.9);
+
+  // Asking for more than size() pads with sentinels.
+  vectorcore::HnswIndex tiny(dim);
+  tiny.add(data.data(), 3);
+  tiny.search(data.data(), k, ids.data(), scores.data());
+  assert(ids[2] != UINT64_MAX);
+  assert(ids[3] == UINT64_MAX);
+
+  // add_half() builds the same graph as add() of the widened rows.
+  {
+    std::vector<std::uint16_t> halves(500 * dim);
+    std::vector<float> widened(halves.size());
+    for (std::size_t i = 0; i < halves.size(); ++i) {
+      halves[i] = vectorcore::float_to_bfloat16(data[i]);
+      widened[i] = vectorcore::bfloat16_to_float(halves[i]);
+    }
+    vectorcore::HnswIndex want(dim, 16, vectorcore::Metric::COSINE, 100, 11);
+    want.add(widened.data(), 500);
+    vectorcore::HnswIndex got(dim, 16, vectorcore::Metric::COSINE, 100, 11);
+    got.add_half(halves.data(), 500, vectorcore::HalfFormat::BF16);
+
+    std::vector<std::uint64_t> want_ids(k);
+    std::vector<float> want_scores(k);
+    want.search(data.data(), k, want_ids.data(), want_scores.data());
+    got.search(data.data(), k, ids.data(), scores.data());
+    assert(ids == want_ids && scores == want_scores);
+  }
+
+  // Enough searches to wrap the 16-bit visited epoch at least once.
+  for (std::size_t i = 0; i < 70000; ++i) {
+    tiny.search(data.data() + dim, 3, ids.data(), scores.data());
+    assert(ids[0] == 1 && ids[1] != ids[2]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/ivf_index.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::clustered_matrix;
+using vectorcore::test::recall;
+
+double recall_at_k(vectorcore::Metric metric, std::size_t nprobe, std::size_t num_threads) {
+  constexpr std::size_t dim = 24;
+  constexpr std::size_t n = 6000;
+  constexpr std::size_t m = 60;
+  constexpr std::size_t k = 10;
+
+  const auto data = clustered_matrix(n, dim, 40, 5);
+  const auto queries = clustered_matrix(m, dim, 40, 5); // same centers, fresh noise
+
+  vectorcore::BruteForceIndex exact(dim, metric);
+  exact.add(data.data(), n);
+  std::vector<std::uint64_t> truth(m * k);
+  std::vector<float> truth_scores(m * k);
+  exact.search_batch(queries.data(), m, k, truth.data(), truth_scores.data());
+
+  vectorcore::IvfIndex ivf(dim, 32, metric);
+  ivf.train(data.data(), n, num_threads);
+  assert(ivf.trained());
+  ivf.add(data.data(), n, nullptr, num_threads);
+  assert(ivf.size() == n);
+
+  std::size_t total = 0;
+  for (std::size_t c = 0; c < ivf.nlist(); ++c) {
+    total += ivf.list_size(c);
+  }
+  assert(total == n);
+
+  std::vector<std::uint64_t> ids(m * k);
+  std::vector<float> scores(m * k);
+  ivf.search_batch(queries.data(), m, k, ids.data(), scores.data(), nprobe, num_threads);
+
+  // Probing every list is exact search.
+  if (nprobe == ivf.nlist()) {
+    for (std::size_t i = 0; i < m * k; ++i) {
+      assert(std::fabs(scores[i] - truth_scores[i]) <= 1e-3f * (1.f + std::fabs(truth_scores[i])));
+    }
+  }
+
+  return recall(ids, truth, k);
+}
+
+} // namespace
+
+int main() {
+  for (auto metric : {vectorcore::Metric::L2_SQUARED, vectorcore::Metric::INNER_PRODUCT}) {
+    assert(recall_at_k(metric, 32, 1) >= 0.999);
+  }
+  const double r1 = recall_at_k(vectorcore::Metric::L2_SQUARED, 1, 1);
+  const double r8 = recall_at_k(vectorcore::Metric::L2_SQUARED, 8, 0);
+  assert(r8 >= 0.95);
+  assert(r8 >= r1);
+
+  // Untrained indexes reject add(); empty ones pad every result.
+  vectorcore::IvfIndex ivf(4, 2);
+  const float row[8] = {0.f, 0.f, 0.f, 0.f, 1.f, 1.f, 1.f, 1.f};
+  bool threw = false;
+  try {
+    ivf.add(row, 2);
+  } catch (const std::logic_error&) {
+    threw = true;
+  }
+  assert(threw);
+
+  std::uint64_t ids[3];
+  float scores[3];
+  ivf.search(row, 3, ids, scores);
+  assert(ids[0] == UINT64_MAX && std::isinf(scores[0]));
+
+  ivf.train(row, 2);
+  ivf.add(row, 2);
+  ivf.search(row + 4, 3, ids, scores, 2);
+  assert(ids[0] == 1 && scores[0] == 0.f);
+  assert(ids[1] == 0);
+  assert(ids[2] == UINT64_MAX);
+
+  return 0;
+}
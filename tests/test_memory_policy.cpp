@@ -0,0 +1,151 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "vectorcore/aligned_allocator.h"
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/flat_array.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/memory_policy.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+constexpr std::size_t kDim = 64;
+constexpr std::size_t kRows = 2000;
+constexpr std::size_t kK = 10;
+
+std::vector<vectorcore::MemoryPolicy> policies() {
+  std::vector<vectorcore::MemoryPolicy> out;
+  for (const auto h : {vectorcore::HugePages::NONE, vectorcore::HugePages::TRANSPARENT,
+                       vectorcore::HugePages::HUGETLB_2MB, vectorcore::HugePages::HUGETLB_1GB}) {
+    out.push_back({h, -1});
+    out.push_back({h, 0}); // node 0 exists on every host
+  }
+  return out;
+}
+
+bool aligned(const void* p, std::size_t a) {
+  return reinterpret_cast<std::uintptr_t>(p) % a == 0;
+}
+
+void test_allocator() {
+  for (const auto& policy : policies()) {
+    // Small and huge-page-sized allocations, grown through reallocation.
+    using Alloc = vectorcore::AlignedAllocator<float, 32>;
+    std::vector<float, Alloc> v{Alloc(policy)};
+    for (std::size_t i = 0; i < (std::size_t{3} << 20) / sizeof(float); ++i) {
+      v.push_back(static_cast<float>(i));
+    }
+    assert(v.get_allocator().policy() == policy);
+    assert(aligned(v.data(), 32));
+    if (!policy.is_default()) {
+      assert(aligned(v.data(), 4096));
+    }
+    for (std::size_t i = 0; i < v.size(); i += 4099) {
+      assert(v[i] == static_cast<float>(i));
+    }
+
+    // The policy travels with moved and swapped storage.
+    std::vector<float, Alloc> moved = std::move(v);
+    assert(moved.get_allocator().policy() == policy);
+    std::vector<float, Alloc> other;
+    other.swap(moved);
+    assert(other.get_allocator().policy() == policy && moved.get_allocator().policy().is_default());
+  }
+}
+
+void test_one_gb_below_one_gb() {
+  // Under 1 GB the 1 GB policy still gets 2 MB pages, not base pages.
+  const vectorcore::MemoryPolicy policy{vectorcore::HugePages::HUGETLB_1GB, -1};
+  const std::size_t bytes = std::size_t{5} << 20;
+  void* p = vectorcore::allocate_pages(bytes, policy);
+#if defined(__linux__)
+  assert(aligned(p, std::size_t{1} << 21));
+#endif
+  static_cast<char*>(p)[bytes - 1] = 1;
+  vectorcore::free_pages(p, bytes, policy);
+}
+
+void test_flat_array() {
+  const vectorcore::MemoryPolicy policy{vectorcore::HugePages::TRANSPARENT, -1};
+  const auto rows = random_matrix(100, kDim, 1);
+
+  vectorcore::FlatArray<float> a;
+  a.append(rows.data(), rows.data() + rows.size());
+  a.set_memory_policy(policy);
+  assert(a.memory_policy() == policy && a.size() == rows.size() && a[17] == rows[17]);
+
+  // attach() and copy on write keep the policy.
+  a.attach(rows.data(), rows.size(), nullptr);
+  assert(a.is_view() && a.memory_policy() == policy);
+  a.push_back(1.f);
+  assert(!a.is_view() && a.memory_policy() == policy && a[5] == rows[5]);
+  a.clear();
+  assert(a.memory_policy() == policy);
+}
+
+void test_indexes() {
+  const auto rows = random_matrix(kRows, kDim, 2);
+  const auto query = random_matrix(1, kDim, 3);
+
+  std::vector<std::uint64_t> want_ids(kK), ids(kK);
+  std::vector<float> want_scores(kK), scores(kK);
+  vectorcore::BruteForceIndex plain(kDim);
+  plain.add(rows.data(), kRows);
+  plain.search(query.data(), kK, want_ids.data(), want_scores.data());
+
+  vectorcore::HnswIndex graph(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 7);
+  graph.add(rows.data(), kRows);
+  std::vector<std::uint64_t> want_graph_ids(kK);
+  std::vector<float> want_graph_scores(kK);
+  graph.search(query.data(), kK, want_graph_ids.data(), want_graph_scores.data());
+
+  for (const auto& policy : policies()) {
+    vectorcore::BruteForceIndex bf(kDim, vectorcore::Metric::L2_SQUARED, vectorcore::Storage::FP32, 0, policy);
+    assert(bf.memory_policy() == policy);
+    bf.add(rows.data(), kRows);
+    bf.search(query.data(), kK, ids.data(), scores.data());
+    assert(ids == want_ids && scores == want_scores);
+
+    // Same seed and serial inserts: the same graph wherever it lives.
+    vectorcore::HnswIndex hnsw(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 7, vectorcore::Storage::FP32, 0, 0,
+                               policy);
+    hnsw.add(rows.data(), kRows);
+    hnsw.search(query.data(), kK, ids.data(), scores.data());
+    assert(ids == want_graph_ids && scores == want_graph_scores);
+
+    // compact() rebuilds the link arrays under the same policy.
+    const std::uint64_t gone[] = {0, 1, 2};
+    hnsw.remove(gone, 3);
+    hnsw.compact();
+    assert(hnsw.memory_policy() == policy && hnsw.size() == kRows - 3);
+  }
+
+  bool threw = false;
+  try {
+    vectorcore::BruteForceIndex bad(kDim, vectorcore::Metric::L2_SQUARED, vectorcore::Storage::FP32, 0,
+                                    {vectorcore::HugePages::NONE, static_cast<int>(vectorcore::numa_node_count())});
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw);
+}
+
+} // namespace
+
+int main() {
+  assert(vectorcore::numa_node_count() >= 1);
+  test_allocator();
+  test_one_gb_below_one_gb();
+  test_flat_array();
+  test_indexes();
+  return 0;
+}
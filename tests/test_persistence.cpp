@@ -0,0 +1,201 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/index_io.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+constexpr std::size_t kDim = 16;
+constexpr std::size_t kRows = 1000;
+constexpr std::size_t kQueries = 20;
+constexpr std::size_t kK = 5;
+
+template <typename Index>
+void search_all(const Index& index, const std::vector<float>& queries, std::vector<std::uint64_t>& ids,
+                std::vector<float>& scores) {
+  ids.assign(kQueries * kK, 0);
+  scores.assign(kQueries * kK, 0.f);
+  for (std::size_t i = 0; i < kQueries; ++i) {
+    index.search(queries.data() + i * kDim, kK, ids.data() + i * kK, scores.data() + i * kK);
+  }
+}
+
+template <typename Index>
+void assert_same_results(const Index& a, const Index& b, const std::vector<float>& queries) {
+  std::vector<std::uint64_t> ids_a, ids_b;
+  std::vector<float> scores_a, scores_b;
+  search_all(a, queries, ids_a, scores_a);
+  search_all(b, queries, ids_b, scores_b);
+  assert(ids_a == ids_b);
+  assert(scores_a == scores_b);
+}
+
+template <typename Fn>
+bool throws_runtime_error(Fn fn) {
+  try {
+    fn();
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+std::vector<char> read_file(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const std::vector<char>& bytes) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// Pointer to element `i` of section `tag` inside a saved file's bytes.
+template <typename T>
+T* section_at(std::vector<char>& bytes, vectorcore::Section tag, std::size_t i) {
+  vectorcore::IndexFileHeader h;
+  std::memcpy(&h, bytes.data(), sizeof(h));
+  for (std::uint32_t s = 0; s < h.num_sections; ++s) {
+    vectorcore::SectionEntry e;
+    std::memcpy(&e, bytes.data() + sizeof(h) + s * sizeof(e), sizeof(e));
+    if (e.tag == static_cast<std::uint32_t>(tag)) {
+      return reinterpret_cast<T*>(bytes.data() + e.offset) + i;
+    }
+  }
+  assert(false);
+  return nullptr;
+}
+
+// Each graph array damaged on its own must fail load(), not a later search.
+void check_corrupt_graph(const std::string& path) {
+  const auto good = read_file(path);
+  std::vector<char> bad;
+
+  // A level-0 neighbor past the last row.
+  bad = good;
+  section_at<std::uint32_t>(bad, vectorcore::Section::LINKS0, 1)[0] = kRows;
+  write_file(path, bad);
+  assert(throws_runtime_error([&] { vectorcore::HnswIndex::load(path); }));
+
+  // A level-0 neighbor count above the block capacity.
+  bad = good;
+  section_at<std::uint32_t>(bad, vectorcore::Section::LINKS0, 0)[0] = 1000;
+  write_file(path, bad);
+  assert(throws_runtime_error([&] { vectorcore::HnswIndex::load(path); }));
+
+  // An upper-level node whose blocks run past the side table.
+  bad = good;
+  std::size_t upper = 0;
+  while (*section_at<std::uint8_t>(bad, vectorcore::Section::LEVELS, upper) == 0) {
+    ++upper;
+  }
+  *section_at<std::uint32_t>(bad, vectorcore::Section::UPPER_BLOCK, upper) = 0xFFFFFFF0u;
+  write_file(path, bad);
+  assert(throws_runtime_error([&] { vectorcore::HnswIndex::load(path, false); }));
+
+  // An entry point whose packed level disagrees with its node's level.
+  bad = good;
+  vectorcore::IndexFileHeader h;
+  std::memcpy(&h, bad.data(), sizeof(h));
+  h.params[3] += std::uint64_t{1} << 32;
+  std::memcpy(bad.data(), &h, sizeof(h));
+  write_file(path, bad);
+  assert(throws_runtime_error([&] { vectorcore::HnswIndex::load(path); }));
+
+  write_file(path, good);
+  assert(vectorcore::HnswIndex::load(path)->size() == kRows);
+}
+
+} // namespace
+
+int main() {
+  const auto data = random_matrix(kRows, kDim, 1);
+  const auto queries = random_matrix(kQueries, kDim, 2);
+  const std::string path = "vectorcore_test_persistence.vci";
+
+  // Brute force: fp32 and INT8 with rerank, mapped and read.
+  for (auto storage : {vectorcore::Storage::FP32, vectorcore::Storage::INT8}) {
+    vectorcore::BruteForceIndex index(kDim, vectorcore::Metric::L2_SQUARED, storage,
+                                      storage == vectorcore::Storage::FP32 ? 0 : 4);
+    index.add(data.data(), kRows);
+    index.save(path);
+
+    for (bool mmap : {true, false}) {
+      const auto loaded = vectorcore::BruteForceIndex::load(path, mmap);
+      assert(loaded.size() == kRows && loaded.dim() == kDim);
+      assert(loaded.storage() == storage && loaded.rerank_factor() == index.rerank_factor());
+      assert_same_results(index, loaded, queries);
+
+      std::vector<std::uint64_t> a(kQueries * kK), b(kQueries * kK);
+      std::vector<float> sa(kQueries * kK), sb(kQueries * kK);
+      index.search_batch(queries.data(), kQueries, kK, a.data(), sa.data());
+      loaded.search_batch(queries.data(), kQueries, kK, b.data(), sb.data());
+      assert(a == b);
+    }
+  }
+
+  // HNSW: graph, entry point and ef_search survive; fp32 and PQ + rerank.
+  for (auto storage : {vectorcore::Storage::FP32, vectorcore::Storage::PQ}) {
+    vectorcore::HnswIndex index(kDim, 8, vectorcore::Metric::INNER_PRODUCT, 64, 100, storage,
+                                storage == vectorcore::Storage::PQ ? 4 : 0, 4);
+    index.add(data.data(), kRows);
+    index.set_ef_search(40);
+    index.save(path);
+
+    for (bool mmap : {true, false}) {
+      auto loaded = vectorcore::HnswIndex::load(path, mmap);
+      assert(loaded->size() == kRows && loaded->M() == 8 && loaded->ef_search() == 40);
+      assert(loaded->max_level() == index.max_level());
+      assert_same_results(index, *loaded, queries);
+    }
+
+    // Adding to a mapped index copies it first and leaves the file alone.
+    auto grown = vectorcore::HnswIndex::load(path, true);
+    grown->add(data.data(), 10);
+    assert(grown->size() == kRows + 10);
+    assert(vectorcore::HnswIndex::load(path, true)->size() == kRows);
+
+    check_corrupt_graph(path);
+  }
+
+  // An empty index round-trips.
+  vectorcore::HnswIndex empty(kDim);
+  empty.save(path);
+  auto loaded_empty = vectorcore::HnswIndex::load(path);
+  assert(loaded_empty->size() == 0);
+  std::uint64_t id = 0;
+  float score = 0.f;
+  loaded_empty->search(queries.data(), 1, &id, &score);
+  assert(id == UINT64_MAX);
+
+  // Wrong index type, garbage and missing files are rejected.
+  assert(throws_runtime_error([&] { vectorcore::BruteForceIndex::load(path); }));
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    const std::string junk(8192, 'x');
+    out.write(junk.data(), static_cast<std::streamsize>(junk.size()));
+  }
+  assert(throws_runtime_error([&] { vectorcore::HnswIndex::load(path); }));
+  assert(throws_runtime_error([&] { vectorcore::HnswIndex::load(path, false); }));
+  std::remove(path.c_str());
+  assert(throws_runtime_error([&] { vectorcore::BruteForceIndex::load(path); }));
+
+  return 0;
+}
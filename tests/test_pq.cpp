@@ -0,0 +1,156 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/ivf_index.h"
+#include "vectorcore/product_quantizer.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::clustered_matrix;
+using vectorcore::test::recall;
+
+constexpr std::size_t kDim = 32;
+constexpr std::size_t kRows = 5000;
+constexpr std::size_t kQueries = 50;
+constexpr std::size_t kK = 10;
+
+std::vector<std::uint64_t> exact_topk(vectorcore::Metric metric, const std::vector<float>& data,
+                                      const std::vector<float>& queries) {
+  vectorcore::BruteForceIndex exact(kDim, metric);
+  exact.add(data.data(), kRows);
+  std::vector<std::uint64_t> ids(kQueries * kK);
+  std::vector<float> scores(kQueries * kK);
+  exact.search_batch(queries.data(), kQueries, kK, ids.data(), scores.data());
+  return ids;
+}
+
+void test_codec(const std::vector<float>& data) {
+  vectorcore::ProductQuantizer pq(kDim, 8, vectorcore::Metric::L2_SQUARED);
+  assert(!pq.trained());
+  assert(pq.dsub() == 4 && pq.code_size() == 8);
+  pq.train(data.data(), kRows);
+  assert(pq.trained());
+
+  std::vector<std::uint8_t> codes(kRows * pq.code_size());
+  pq.encode(data.data(), kRows, codes.data(), 0);
+
+  // Reconstruction error is a small fraction of the data's spread.
+  double err = 0.0;
+  double energy = 0.0;
+  std::vector<float> decoded(kDim);
+  for (std::size_t i = 0; i < kRows; ++i) {
+    pq.decode(codes.data() + i * pq.code_size(), decoded.data());
+    for (std::size_t d = 0; d < kDim; ++d) {
+      const double diff = decoded[d] - data[i * kDim + d];
+      err += diff * diff;
+      energy += static_cast<double>(data[i * kDim + d]) * data[i * kDim + d];
+    }
+  }
+  assert(err < 0.1 * energy);
+
+  // The ADC table, direct scoring and decode-then-score all agree.
+  vectorcore::PreparedQuery q;
+  pq.prepare(data.data(), q);
+  assert(q.table.size() == 8 * 256);
+  for (std::size_t i = 0; i < 100; ++i) {
+    const std::uint8_t* code = codes.data() + i * pq.code_size();
+    pq.decode(code, decoded.data());
+    const float ref = vectorcore::l2_squared(data.data(), decoded.data(), kDim);
+    assert(std::fabs(pq.score(q, code) - ref) <= 1e-3f * (1.f + ref));
+    assert(std::fabs(pq.score_direct(data.data(), code) - ref) <= 1e-3f * (1.f + ref));
+  }
+
+  bool threw = false;
+  try {
+    vectorcore::ProductQuantizer bad(kDim, 5, vectorcore::Metric::L2_SQUARED);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw);
+}
+
+double ivf_pq_recall(vectorcore::Metric metric, std::size_t rerank_factor, const std::vector<float>& data,
+                     const std::vector<float>& queries) {
+  vectorcore::IvfIndex ivf(kDim, 16, metric, 100, 8, rerank_factor);
+  ivf.train(data.data(), kRows);
+  ivf.add(data.data(), kRows);
+  assert(ivf.size() == kRows);
+
+  std::vector<std::uint64_t> ids(kQueries * kK);
+  std::vector<float> scores(kQueries * kK);
+  ivf.search_batch(queries.data(), kQueries, kK, ids.data(), scores.data(), 16, 0);
+  for (std::size_t qi = 0; qi < kQueries; ++qi) {
+    for (std::size_t j = 1; j < kK; ++j) {
+      const float prev = scores[qi * kK + j - 1];
+      const float cur = scores[qi * kK + j];
+      assert(metric == vectorcore::Metric::L2_SQUARED ? prev <= cur : prev >= cur);
+    }
+  }
+  return recall(ids, exact_topk(metric, data, queries), kK);
+}
+
+double hnsw_pq_recall(std::size_t rerank_factor, const std::vector<float>& data, const std::vector<float>& queries) {
+  vectorcore::HnswIndex index(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 100, vectorcore::Storage::PQ,
+                              rerank_factor, 8);
+  assert(index.storage() == vectorcore::Storage::PQ);
+  index.add(data.data(), kRows);
+  index.set_ef_search(64);
+
+  std::vector<std::uint64_t> ids(kQueries * kK);
+  std::vector<float> scores(kQueries * kK);
+  index.search_batch(queries.data(), kQueries, kK, ids.data(), scores.data());
+  return recall(ids, exact_topk(vectorcore::Metric::L2_SQUARED, data, queries), kK);
+}
+
+} // namespace
+
+int main() {
+  const auto data = clustered_matrix(kRows, kDim, 20, 11);
+  const auto queries = clustered_matrix(kQueries, kDim, 20, 11);
+
+  test_codec(data);
+
+  for (auto metric : {vectorcore::Metric::L2_SQUARED, vectorcore::Metric::INNER_PRODUCT}) {
+    const double approx = ivf_pq_recall(metric, 0, data, queries);
+    const double reranked = ivf_pq_recall(metric, 8, data, queries);
+    assert(approx >= 0.4);
+    assert(reranked >= 0.95);
+    assert(reranked >= approx);
+  }
+
+  const double hnsw_approx = hnsw_pq_recall(0, data, queries);
+  const double hnsw_reranked = hnsw_pq_recall(8, data, queries);
+  assert(hnsw_approx >= 0.4);
+  assert(hnsw_reranked >= 0.9);
+
+  // PQ needs a codebook-sized first batch; the index stays untouched.
+  vectorcore::HnswIndex small(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 100, vectorcore::Storage::PQ, 0, 8);
+  bool threw = false;
+  try {
+    small.add(data.data(), 100);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw && small.size() == 0);
+
+  vectorcore::IvfIndex ivf(kDim, 4, vectorcore::Metric::L2_SQUARED, 100, 8);
+  threw = false;
+  try {
+    ivf.train(data.data(), 100);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw && !ivf.trained());
+
+  return 0;
+}
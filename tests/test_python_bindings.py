@@ -0,0 +1,103 @@
+"""Checks the pybind11 module end to end: NumPy arrays in, NumPy arrays out.
+
+Run by ctest with PYTHONPATH pointing at the built extension. Exits 77
+(reported as skipped) when NumPy is not installed.
+"""
+
+import sys
+import threading
+
+try:
+    import numpy as np
+except ImportError:
+    sys.exit(77)
+
+import vectorcore
+
+DIM = 16
+ROWS = 500
+K = 5
+
+
+def raises(fn, *args, **kwargs):
+    try:
+        fn(*args, **kwargs)
+    except ValueError:
+        return True
+    return False
+
+
+def check_index(index):
+    rng = np.random.default_rng(0)
+    x = rng.standard_normal((ROWS, DIM)).astype(np.float32)
+    ids = np.arange(1000, 1000 + ROWS, dtype=np.uint64)
+    index.add(x, ids)
+
+    # Default outputs: allocated by the binding, so no dtype check applies.
+    out_ids, scores = index.search(x[0], K)
+    assert out_ids.dtype == np.uint64 and out_ids.shape == (K,)
+    assert scores.dtype == np.float32 and scores.shape == (K,)
+    assert out_ids[0] == 1000
+
+    batch_ids, batch_scores = index.search(x[:4], K)
+    assert batch_ids.shape == (4, K) and batch_scores.shape == (4, K)
+    assert list(batch_ids[:, 0]) == [1000, 1001, 1002, 1003]
+
+    # Caller outputs: plain np.empty(..., np.uint64) must be accepted whatever
+    # buffer format NumPy reports for it ('L' on LP64, 'Q' on Windows).
+    caller_ids = np.empty((4, K), dtype=np.uint64)
+    caller_scores = np.empty((4, K), dtype=np.float32)
+    index.search(x[:4], K, out_ids=caller_ids, out_scores=caller_scores)
+    assert np.array_equal(caller_ids, batch_ids)
+    assert np.array_equal(caller_scores, batch_scores)
+
+    wrong = np.empty((4, K), dtype=np.int32)
+    assert raises(index.search, x[:4], K, out_ids=wrong, out_scores=caller_scores)
+
+    # uint64 filters and remove(ids) go through the same dtype check.
+    allow = np.array([1003, 1007], dtype=np.uint64)
+    filtered, _ = index.search(x[3], 2, allow_ids=allow)
+    assert sorted(filtered) == [1003, 1007]
+    assert index.remove(np.array([1000], dtype=np.uint64)) == 1
+    assert raises(index.remove, np.array([1001], dtype=np.int64))
+
+
+def check_add_during_search(index):
+    # No ingest capacity: add() must keep the GIL while storage grows, so a
+    # search from another thread never sees it mid-reallocation.
+    rng = np.random.default_rng(1)
+    index.add(rng.standard_normal((50, DIM)).astype(np.float32))
+    queries = rng.standard_normal((8, DIM)).astype(np.float32)
+    done = threading.Event()
+    errors = []
+
+    def searcher():
+        try:
+            while not done.is_set():
+                ids, _ = index.search(queries, K)
+                assert ids.shape == (8, K)
+        except Exception as e:  # surfaced in the main thread
+            errors.append(e)
+
+    thread = threading.Thread(target=searcher)
+    thread.start()
+    try:
+        for _ in range(40):
+            index.add(rng.standard_normal((100, DIM)).astype(np.float32))
+    finally:
+        done.set()
+        thread.join()
+    assert not errors, errors
+    assert index.size == 50 + 40 * 100
+
+
+def main():
+    check_index(vectorcore.BruteForceIndex(DIM))
+    check_index(vectorcore.HnswIndex(DIM))
+    check_add_during_search(vectorcore.BruteForceIndex(DIM))
+    check_add_during_search(vectorcore.HnswIndex(DIM))
+    print("python bindings ok")
+
+
+if __name__ == "__main__":
+    main()
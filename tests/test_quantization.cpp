@@ -0,0 +1,154 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/float16.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/scalar_quantizer.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::gaussian_matrix;
+using vectorcore::test::recall;
+
+// Every finite half survives half -> float -> half, and rounding is to nearest even.
+void check_float16() {
+  for (std::uint32_t h = 0; h < 0x10000u; ++h) {
+    const float f = vectorcore::half_to_float(static_cast<std::uint16_t>(h));
+    if (std::isnan(f)) {
+      assert(std::isnan(vectorcore::half_to_float(vectorcore::float_to_half(f))));
+      continue;
+    }
+    assert(vectorcore::float_to_half(f) == h);
+  }
+
+  assert(vectorcore::float_to_half(1.0f) == 0x3C00u);
+  assert(vectorcore::float_to_half(-2.0f) == 0xC000u);
+  assert(vectorcore::float_to_half(65504.0f) == 0x7BFFu);
+  assert(vectorcore::float_to_half(1e6f) == 0x7C00u);
+  assert(vectorcore::float_to_half(1.0f + 1.0f / 2048.0f) == 0x3C00u); // tie -> even
+  assert(vectorcore::float_to_half(5.9604645e-8f) == 0x0001u);          // smallest subnormal
+}
+
+// Asymmetric scores must match scoring the decoded row exactly.
+void check_quantizer(vectorcore::Storage storage, vectorcore::Metric metric) {
+  constexpr std::size_t dim = 37;
+  constexpr std::size_t n = 200;
+  const auto data = gaussian_matrix(n, dim, 11);
+  const auto queries = gaussian_matrix(10, dim, 12);
+
+  vectorcore::ScalarQuantizer sq(storage, dim, metric);
+  sq.train(data.data(), n);
+  assert(sq.trained());
+
+  std::vector<std::uint8_t> codes(n * sq.code_size());
+  sq.encode(data.data(), n, codes.data());
+
+  std::vector<float> decoded(dim);
+  vectorcore::PreparedQuery pq;
+  for (std::size_t qi = 0; qi < 10; ++qi) {
+    const float* q = queries.data() + qi * dim;
+    sq.prepare(q, pq);
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint8_t* code = codes.data() + i * sq.code_size();
+      sq.decode(code, decoded.data());
+
+      // Reconstruction error is bounded by the quantization step.
+      for (std::size_t d = 0; d < dim; ++d) {
+        const float x = data[i * dim + d];
+        const float tol = (storage == vectorcore::Storage::INT8) ? 0.05f : 1e-3f * (1.f + std::fabs(x));
+        assert(std::fabs(decoded[d] - x) <= tol);
+      }
+
+      const float ref = (metric == vectorcore::Metric::L2_SQUARED)
+                            ? vectorcore::l2_squared_scalar(q, decoded.data(), dim)
+                            : vectorcore::inner_product_scalar(q, decoded.data(), dim);
+      assert(std::fabs(sq.score(pq, code) - ref) <= 1e-3f * (1.f + std::fabs(ref)));
+    }
+  }
+}
+
+void check_index_recall(vectorcore::Storage storage, vectorcore::Metric metric) {
+  constexpr std::size_t dim = 32;
+  constexpr std::size_t n = 4000;
+  constexpr std::size_t m = 50;
+  constexpr std::size_t k = 10;
+
+  const auto data = gaussian_matrix(n, dim, 21);
+  const auto queries = gaussian_matrix(m, dim, 22);
+
+  vectorcore::BruteForceIndex exact(dim, metric);
+  exact.add(data.data(), n);
+  std::vector<std::uint64_t> truth(m * k);
+  std::vector<float> truth_scores(m * k);
+  exact.search_batch(queries.data(), m, k, truth.data(), truth_scores.data());
+
+  std::vector<std::uint64_t> ids(m * k);
+  std::vector<float> scores(m * k);
+
+  // Brute force: quantized scan alone, then with exact rerank.
+  vectorcore::BruteForceIndex plain(dim, metric, storage);
+  plain.add(data.data(), n);
+  plain.search_batch(queries.data(), m, k, ids.data(), scores.data());
+  assert(recall(ids, truth, k) >= 0.7);
+
+  vectorcore::BruteForceIndex reranked(dim, metric, storage, 4);
+  reranked.add(data.data(), n);
+  reranked.search_batch(queries.data(), m, k, ids.data(), scores.data(), 0);
+  assert(recall(ids, truth, k) >= 0.98);
+  // Reranked scores are the exact fp32 ones.
+  for (std::size_t i = 0; i < m * k; ++i) {
+    if (ids[i] == truth[i]) {
+      assert(std::fabs(scores[i] - truth_scores[i]) <= 1e-3f * (1.f + std::fabs(truth_scores[i])));
+    }
+  }
+
+  // HNSW on codes, reranked.
+  vectorcore::HnswIndex hnsw(dim, 16, metric, 200, 100, storage, 4);
+  hnsw.add(data.data(), n);
+  hnsw.search_batch(queries.data(), m, k, ids.data(), scores.data());
+  assert(recall(ids, truth, k) >= 0.9);
+
+  // HNSW without fp32 rows at all.
+  vectorcore::HnswIndex compact(dim, 16, metric, 200, 100, storage);
+  compact.add(data.data(), n);
+  compact.search_batch(queries.data(), m, k, ids.data(), scores.data());
+  assert(recall(ids, truth, k) >= 0.6);
+}
+
+} // namespace
+
+int main() {
+  check_float16();
+
+  for (auto metric : {vectorcore::Metric::L2_SQUARED, vectorcore::Metric::INNER_PRODUCT}) {
+    for (auto storage : {vectorcore::Storage::FP32, vectorcore::Storage::FP16, vectorcore::Storage::INT8}) {
+      check_quantizer(storage, metric);
+    }
+    check_index_recall(vectorcore::Storage::FP16, metric);
+    check_index_recall(vectorcore::Storage::INT8, metric);
+  }
+
+  // INT8 needs ranges: train() after add() is rejected.
+  vectorcore::BruteForceIndex index(4, vectorcore::Metric::L2_SQUARED, vectorcore::Storage::INT8);
+  const float row[4] = {1.f, 2.f, 3.f, 4.f};
+  index.add(row, 1);
+  bool threw = false;
+  try {
+    index.train(row, 1);
+  } catch (const std::logic_error&) {
+    threw = true;
+  }
+  assert(threw);
+
+  return 0;
+}
@@ -0,0 +1,192 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/distance.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/range_search.h"
+#include "vectorcore/search_filter.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+// Over two kRangeChunk chunks, with a tail.
+constexpr std::size_t kDim = 136;
+constexpr std::size_t kRows = 2000;
+constexpr std::size_t kQueries = 20;
+
+// Brute-force enumeration: ids of the rows within the radius of query i.
+std::set<std::uint64_t> enumerate(const std::vector<float>& data, const float* q, float radius, bool l2) {
+  std::set<std::uint64_t> ids;
+  for (std::size_t r = 0; r < kRows; ++r) {
+    const float* row = data.data() + r * kDim;
+    double s = 0.0;
+    for (std::size_t d = 0; d < kDim; ++d) {
+      s += l2 ? (q[d] - row[d]) * (q[d] - row[d]) : q[d] * row[d];
+    }
+    if (l2 ? s <= radius : s >= radius) {
+      ids.insert(r);
+    }
+  }
+  return ids;
+}
+
+std::set<std::uint64_t> hits_of(const vectorcore::RangeSearchResult& res, std::size_t i) {
+  return std::set<std::uint64_t>(res.ids.begin() + res.offsets[i], res.ids.begin() + res.offsets[i + 1]);
+}
+
+// Symmetric difference, ignoring rows within `slack` of the boundary.
+std::size_t mismatches(const std::set<std::uint64_t>& got, const std::set<std::uint64_t>& want,
+                       const std::vector<float>& data, const float* q, float radius, float slack) {
+  std::size_t bad = 0;
+  for (std::size_t r = 0; r < kRows; ++r) {
+    if (got.count(r) != want.count(r)) {
+      const float d = vectorcore::l2_squared(q, data.data() + r * kDim, kDim);
+      bad += std::fabs(d - radius) > slack ? 1 : 0;
+    }
+  }
+  return bad;
+}
+
+void assert_well_formed(const vectorcore::RangeSearchResult& res, std::size_t m, bool l2) {
+  assert(res.offsets.size() == m + 1 && res.offsets[0] == 0);
+  assert(res.offsets[m] == res.ids.size() && res.scores.size() == res.ids.size());
+  for (std::size_t i = 0; i < m; ++i) {
+    for (std::uint64_t j = res.offsets[i] + 1; j < res.offsets[i + 1]; ++j) {
+      assert(l2 ? res.scores[j - 1] <= res.scores[j] : res.scores[j - 1] >= res.scores[j]);
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  const auto data = random_matrix(kRows, kDim, 1);
+  // Queries near stored rows so each ball holds a handful of them.
+  auto queries = random_matrix(kQueries, kDim, 2);
+  for (std::size_t i = 0; i < kQueries * kDim; ++i) {
+    queries[i] = data[(i / kDim) * 97 * kDim + (i % kDim)] + 0.1f * queries[i];
+  }
+  // Squared distances between random rows are around kDim * 2 / 3.
+  const float radius = 80.f;
+
+  // Brute force, L2: exact against enumeration, and scores sorted.
+  vectorcore::BruteForceIndex index(kDim);
+  index.add(data.data(), kRows);
+  vectorcore::RangeSearchResult res;
+  index.range_search(queries.data(), kQueries, radius, res);
+  assert_well_formed(res, kQueries, true);
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < kQueries; ++i) {
+    const float* q = queries.data() + i * kDim;
+    const auto want = enumerate(data, q, radius, true);
+    assert(mismatches(hits_of(res, i), want, data, q, radius, 1e-3f) == 0);
+    total += want.size();
+    for (std::uint64_t j = res.offsets[i]; j < res.offsets[i + 1]; ++j) {
+      const float d = vectorcore::l2_squared(q, data.data() + res.ids[j] * kDim, kDim);
+      assert(std::fabs(res.scores[j] - d) <= 1e-3f * std::max(1.f, d));
+    }
+  }
+  assert(total > kQueries); // more than the near-duplicate row per query
+
+  // Threads only change who scans which query.
+  vectorcore::RangeSearchResult threaded;
+  index.range_search(queries.data(), kQueries, radius, threaded, 0);
+  assert(threaded.offsets == res.offsets && threaded.ids == res.ids && threaded.scores == res.scores);
+
+  // Filters and removed rows are left out of the balls.
+  {
+    std::vector<std::uint64_t> even;
+    for (std::uint64_t r = 0; r < kRows; r += 2) {
+      even.push_back(r);
+    }
+    const auto filter = vectorcore::SearchFilter::allow_list(even.data(), even.size());
+    vectorcore::BruteForceIndex pruned(kDim);
+    pruned.add(data.data(), kRows);
+    const std::uint64_t gone[] = {0, 2, 4};
+    pruned.remove(gone, 3);
+
+    vectorcore::RangeSearchResult filtered;
+    pruned.range_search(queries.data(), kQueries, radius, filtered, 1, &filter);
+    for (std::size_t i = 0; i < kQueries; ++i) {
+      std::set<std::uint64_t> want;
+      for (std::uint64_t id : hits_of(res, i)) {
+        if (id % 2 == 0 && id > 4) {
+          want.insert(id);
+        }
+      }
+      assert(hits_of(filtered, i) == want);
+    }
+  }
+
+  // Inner product keeps similarities >= radius, best first.
+  {
+    vectorcore::BruteForceIndex ip(kDim, vectorcore::Metric::INNER_PRODUCT);
+    ip.add(data.data(), kRows);
+    const float min_sim = 25.f;
+    vectorcore::RangeSearchResult ip_res;
+    ip.range_search(queries.data(), kQueries, min_sim, ip_res, 0);
+    assert_well_formed(ip_res, kQueries, false);
+    for (std::size_t i = 0; i < kQueries; ++i) {
+      const auto want = enumerate(data, queries.data() + i * kDim, min_sim, false);
+      const auto got = hits_of(ip_res, i);
+      for (std::uint64_t j = ip_res.offsets[i]; j < ip_res.offsets[i + 1]; ++j) {
+        assert(ip_res.scores[j] >= min_sim);
+      }
+      // Only rows within rounding of the threshold may differ.
+      std::size_t diff = 0;
+      for (std::uint64_t id : want) {
+        diff += got.count(id) ? 0 : 1;
+      }
+      assert(diff <= 1 && got.size() <= want.size() + 1);
+    }
+  }
+
+  // An empty radius and an empty index give empty, well-formed results.
+  {
+    vectorcore::RangeSearchResult empty;
+    index.range_search(queries.data(), kQueries, -1.f, empty);
+    assert_well_formed(empty, kQueries, true);
+    assert(empty.ids.empty());
+
+    vectorcore::HnswIndex none(kDim);
+    none.range_search(queries.data(), 2, radius, empty);
+    assert(empty.offsets.size() == 3 && empty.ids.empty());
+  }
+
+  // HNSW: the flood fill from the beam recovers nearly every ball.
+  {
+    vectorcore::HnswIndex hnsw(kDim, 16, vectorcore::Metric::L2_SQUARED, 100);
+    hnsw.add(data.data(), kRows);
+    hnsw.set_ef_search(64);
+    vectorcore::RangeSearchResult graph;
+    hnsw.range_search(queries.data(), kQueries, radius, graph, 0);
+    assert_well_formed(graph, kQueries, true);
+
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < kQueries; ++i) {
+      const auto want = hits_of(res, i);
+      for (std::uint64_t id : hits_of(graph, i)) {
+        assert(want.count(id) == 1); // never outside the ball
+        ++found;
+      }
+    }
+    assert(static_cast<double>(found) >= 0.9 * static_cast<double>(total));
+
+    vectorcore::RangeSearchResult serial;
+    hnsw.range_search(queries.data(), kQueries, radius, serial);
+    assert(serial.ids == graph.ids);
+  }
+
+  return 0;
+}
@@ -0,0 +1,236 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+using vectorcore::test::recall;
+
+constexpr std::size_t kDim = 16;
+constexpr std::size_t kRows = 2000;
+constexpr std::size_t kQueries = 50;
+constexpr std::size_t kK = 10;
+
+// Every third id, plus a run at the front.
+std::vector<std::uint64_t> removed_ids() {
+  std::vector<std::uint64_t> ids;
+  for (std::uint64_t i = 0; i < kRows; ++i) {
+    if (i % 3 == 0 || i < 50) {
+      ids.push_back(i);
+    }
+  }
+  return ids;
+}
+
+// Exact index over the rows that survive `removed`, with their original ids.
+vectorcore::BruteForceIndex reference(const std::vector<float>& data, const std::vector<std::uint64_t>& removed) {
+  const std::set<std::uint64_t> gone(removed.begin(), removed.end());
+  std::vector<float> rows;
+  std::vector<std::uint64_t> ids;
+  for (std::uint64_t i = 0; i < kRows; ++i) {
+    if (!gone.count(i)) {
+      rows.insert(rows.end(), data.begin() + i * kDim, data.begin() + (i + 1) * kDim);
+      ids.push_back(i);
+    }
+  }
+  vectorcore::BruteForceIndex index(kDim);
+  index.add(rows.data(), ids.size(), ids.data());
+  return index;
+}
+
+template <typename Index>
+void search_all(const Index& index, const std::vector<float>& queries, std::vector<std::uint64_t>& ids,
+                std::vector<float>& scores) {
+  ids.assign(kQueries * kK, 0);
+  scores.assign(kQueries * kK, 0.f);
+  for (std::size_t i = 0; i < kQueries; ++i) {
+    index.search(queries.data() + i * kDim, kK, ids.data() + i * kK, scores.data() + i * kK);
+  }
+}
+
+void assert_none_removed(const std::vector<std::uint64_t>& ids, const std::vector<std::uint64_t>& removed) {
+  const std::set<std::uint64_t> gone(removed.begin(), removed.end());
+  for (std::uint64_t id : ids) {
+    assert(!gone.count(id));
+  }
+}
+
+} // namespace
+
+int main() {
+  const auto data = random_matrix(kRows, kDim, 1);
+  const auto queries = random_matrix(kQueries, kDim, 2);
+  const auto removed = removed_ids();
+  const auto truth_index = reference(data, removed);
+  std::vector<std::uint64_t> truth;
+  std::vector<float> truth_scores;
+  search_all(truth_index, queries, truth, truth_scores);
+
+  // Brute force: removed rows are skipped exactly, before and after compact().
+  for (auto storage : {vectorcore::Storage::FP32, vectorcore::Storage::INT8}) {
+    const bool fp32 = storage == vectorcore::Storage::FP32;
+    vectorcore::BruteForceIndex index(kDim, vectorcore::Metric::L2_SQUARED, storage, fp32 ? 0 : 8);
+    index.add(data.data(), kRows);
+    assert(index.remove(removed.data(), removed.size()) == removed.size());
+    assert(index.remove(removed.data(), 3) == 0); // already gone
+    assert(index.size() == kRows - removed.size() && index.num_deleted() == removed.size());
+
+    std::vector<std::uint64_t> ids;
+    std::vector<float> scores;
+    for (int pass = 0; pass < 2; ++pass) {
+      search_all(index, queries, ids, scores);
+      assert(ids == truth);
+      assert(scores == truth_scores);
+
+      std::vector<std::uint64_t> batch_ids(kQueries * kK);
+      std::vector<float> batch_scores(kQueries * kK);
+      index.search_batch(queries.data(), kQueries, kK, batch_ids.data(), batch_scores.data(), 0);
+      assert(recall(batch_ids, truth, kK) == 1.0);
+
+      index.compact();
+      assert(index.num_deleted() == 0 && index.size() == kRows - removed.size());
+    }
+
+    // Asking for more than the live rows pads instead of returning removed ones.
+    vectorcore::BruteForceIndex small(kDim, vectorcore::Metric::L2_SQUARED, storage, fp32 ? 0 : 8);
+    small.add(data.data(), 4);
+    const std::uint64_t two[] = {1, 2};
+    small.remove(two, 2);
+    std::uint64_t out[4];
+    float out_scores[4];
+    small.search(queries.data(), 4, out, out_scores);
+    assert(out[2] == UINT64_MAX && out[3] == UINT64_MAX);
+    assert((out[0] == 0 && out[1] == 3) || (out[0] == 3 && out[1] == 0));
+  }
+
+  // Brute force upsert: known ids are rewritten in place, new ones appended,
+  // the last of a repeated id wins.
+  {
+    vectorcore::BruteForceIndex index(kDim);
+    index.add(data.data(), kRows);
+    const auto fresh = random_matrix(3, kDim, 9);
+    const std::uint64_t ids[] = {7, 5000, 7};
+    index.upsert(fresh.data(), 3, ids);
+    assert(index.size() == kRows + 1 && index.num_deleted() == 0);
+
+    std::uint64_t id = 0;
+    float score = 1.f;
+    index.search(fresh.data() + 2 * kDim, 1, &id, &score);
+    assert(id == 7 && score == 0.f);
+    index.search(fresh.data() + kDim, 1, &id, &score);
+    assert(id == 5000 && score == 0.f);
+
+    // Default ids count every row ever appended, compacted or not.
+    const std::uint64_t gone[] = {0, 1, 2};
+    index.remove(gone, 3);
+    index.compact();
+    index.add(data.data(), 1);
+    index.search(data.data(), 1, &id, &score);
+    assert(id == kRows + 1);
+  }
+
+  // HNSW: removed nodes never come back, recall holds, and compact() keeps
+  // the graph navigable.
+  {
+    vectorcore::HnswIndex index(kDim, 12, vectorcore::Metric::L2_SQUARED, 100);
+    index.add(data.data(), kRows);
+    index.set_ef_search(80);
+    assert(index.remove(removed.data(), removed.size()) == removed.size());
+    assert(index.size() == kRows - removed.size());
+
+    std::vector<std::uint64_t> ids;
+    std::vector<float> scores;
+    search_all(index, queries, ids, scores);
+    assert_none_removed(ids, removed);
+    assert(recall(ids, truth, kK) >= 0.9);
+
+    // Saved tombstones survive a round trip.
+    const std::string path = "vectorcore_test_remove.vci";
+    index.save(path);
+    auto loaded = vectorcore::HnswIndex::load(path, true);
+    assert(loaded->num_deleted() == removed.size());
+    std::vector<std::uint64_t> loaded_ids;
+    std::vector<float> loaded_scores;
+    search_all(*loaded, queries, loaded_ids, loaded_scores);
+    assert(loaded_ids == ids);
+
+    // Removing from a mapped index copies the links first.
+    const std::uint64_t more[] = {1001, 1003};
+    assert(loaded->remove(more, 2) == 2);
+    std::remove(path.c_str());
+
+    index.compact();
+    assert(index.num_deleted() == 0 && index.size() == kRows - removed.size());
+    search_all(index, queries, ids, scores);
+    assert_none_removed(ids, removed);
+    assert(recall(ids, truth, kK) >= 0.9);
+
+    // Re-adding the removed rows through upsert restores full recall.
+    std::vector<float> back;
+    for (std::uint64_t id : removed) {
+      back.insert(back.end(), data.begin() + id * kDim, data.begin() + (id + 1) * kDim);
+    }
+    index.upsert(back.data(), removed.size(), removed.data());
+    assert(index.size() == kRows);
+    vectorcore::BruteForceIndex full(kDim);
+    full.add(data.data(), kRows);
+    std::vector<std::uint64_t> full_truth;
+    search_all(full, queries, full_truth, scores);
+    search_all(index, queries, ids, scores);
+    assert(recall(ids, full_truth, kK) >= 0.9);
+
+    // Upserting a present id replaces its node.
+    const auto fresh = random_matrix(1, kDim, 11);
+    const std::uint64_t one[] = {42};
+    index.upsert(fresh.data(), 1, one);
+    assert(index.size() == kRows && index.num_deleted() == 1);
+    std::uint64_t id = 0;
+    float score = 1.f;
+    index.search(fresh.data(), 1, &id, &score);
+    assert(id == 42 && score == 0.f);
+  }
+
+  // HNSW: automatic compaction, and removing everything then adding again.
+  {
+    vectorcore::HnswIndex index(kDim, 8, vectorcore::Metric::INNER_PRODUCT, 64);
+    index.set_compact_threshold(0.25);
+    index.add(data.data(), 400);
+    std::vector<std::uint64_t> all(400);
+    for (std::size_t i = 0; i < all.size(); ++i) {
+      all[i] = i;
+    }
+    index.remove(all.data(), 50);
+    assert(index.num_deleted() == 50);
+    index.remove(all.data() + 50, 60);
+    assert(index.num_deleted() == 0 && index.size() == 290);
+
+    index.set_compact_threshold(0.0);
+    index.remove(all.data(), all.size());
+    assert(index.size() == 0);
+    std::uint64_t id = 0;
+    float score = 0.f;
+    index.search(queries.data(), 1, &id, &score);
+    assert(id == UINT64_MAX);
+
+    index.add(data.data(), 100);
+    assert(index.size() == 100 && index.num_deleted() == 0);
+    index.search(data.data() + 5 * kDim, 1, &id, &score);
+    assert(id >= 400);
+  }
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vectorcore/hnsw_index.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+constexpr std::size_t kDim = 24;
+constexpr std::size_t kRows = 3000;
+constexpr std::size_t kQueries = 60;
+constexpr std::size_t kK = 10;
+
+struct Results {
+  std::vector<std::uint64_t> ids;
+  std::vector<float> scores;
+};
+
+Results search_all(const vectorcore::HnswIndex& index, const std::vector<float>& queries) {
+  Results r;
+  r.ids.assign(kQueries * kK, 0);
+  r.scores.assign(kQueries * kK, 0.f);
+  index.search_batch(queries.data(), kQueries, kK, r.ids.data(), r.scores.data());
+  return r;
+}
+
+std::unique_ptr<vectorcore::HnswIndex> build(vectorcore::Metric metric, vectorcore::Storage storage,
+                                             std::size_t rerank, const std::vector<float>& data) {
+  auto index = std::make_unique<vectorcore::HnswIndex>(kDim, 12, metric, 80, 7, storage, rerank);
+  index->add(data.data(), kRows / 2);
+  index->add(data.data() + (kRows / 2) * kDim, kRows - kRows / 2);
+  return index;
+}
+
+// Renumbering keeps every link and the entry point, so the walks visit the
+// same rows in the same order and return exactly what they did before.
+void check_same_results(vectorcore::Metric metric, vectorcore::Storage storage, std::size_t rerank) {
+  const auto data = random_matrix(kRows, kDim, 1);
+  const auto queries = random_matrix(kQueries, kDim, 2);
+
+  for (const auto method : {vectorcore::ReorderMethod::BFS, vectorcore::ReorderMethod::RCM}) {
+    auto index = build(metric, storage, rerank, data);
+    const Results before = search_all(*index, queries);
+    const int levels = index->max_level();
+    index->reorder(method);
+    assert(index->size() == kRows && index->max_level() == levels);
+    const Results after = search_all(*index, queries);
+    assert(after.ids == before.ids && after.scores == before.scores);
+
+    // The index stays fully usable: later adds and removes.
+    const std::vector<float> extra = random_matrix(100, kDim, 3);
+    index->add(extra.data(), 100);
+    assert(index->size() == kRows + 100);
+    const std::uint64_t gone[] = {before.ids[0], before.ids[kK]};
+    assert(index->remove(gone, 2) == 2);
+    const Results removed = search_all(*index, queries);
+    for (const std::uint64_t id : removed.ids) {
+      assert(id != gone[0] && id != gone[1]);
+    }
+  }
+}
+
+void test_removed_and_saved() {
+  const auto data = random_matrix(kRows, kDim, 4);
+  const auto queries = random_matrix(kQueries, kDim, 5);
+
+  // With removed nodes, reorder() starts with the same compaction.
+  auto compacted = build(vectorcore::Metric::L2_SQUARED, vectorcore::Storage::FP32, 0, data);
+  auto reordered = build(vectorcore::Metric::L2_SQUARED, vectorcore::Storage::FP32, 0, data);
+  std::vector<std::uint64_t> ids;
+  for (std::uint64_t id = 0; id < kRows; id += 7) {
+    ids.push_back(id);
+  }
+  compacted->remove(ids.data(), ids.size());
+  reordered->remove(ids.data(), ids.size());
+  compacted->compact();
+  reordered->reorder();
+  assert(reordered->num_deleted() == 0 && reordered->size() == compacted->size());
+  const Results want = search_all(*compacted, queries);
+  assert(search_all(*reordered, queries).ids == want.ids);
+
+  // The layout is what save() writes, and a mapped load walks it in place.
+  const std::string path = "vectorcore_test_reorder.vci";
+  reordered->save(path);
+  const auto loaded = vectorcore::HnswIndex::load(path, true);
+  const Results got = search_all(*loaded, queries);
+  assert(got.ids == want.ids && got.scores == want.scores);
+  std::remove(path.c_str());
+
+  // Too small to reorder is a no-op.
+  vectorcore::HnswIndex tiny(kDim);
+  tiny.reorder(vectorcore::ReorderMethod::RCM);
+  tiny.add(data.data(), 1);
+  tiny.reorder();
+  assert(tiny.size() == 1);
+}
+
+} // namespace
+
+int main() {
+  check_same_results(vectorcore::Metric::L2_SQUARED, vectorcore::Storage::FP32, 0);
+  check_same_results(vectorcore::Metric::COSINE, vectorcore::Storage::FP32, 0);
+  check_same_results(vectorcore::Metric::INNER_PRODUCT, vectorcore::Storage::INT8, 4);
+  test_removed_and_saved();
+  return 0;
+}
@@ -0,0 +1,176 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/search_service.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+constexpr std::size_t kDim = 32;
+constexpr std::size_t kRows = 4000;
+constexpr std::size_t kQueries = 400;
+constexpr std::size_t kK = 10;
+
+// Results from many submitting threads match search_batch() row for row.
+template <typename Index>
+void check_matches_batch(const Index& index, const std::vector<float>& queries) {
+  std::vector<std::uint64_t> want_ids(kQueries * kK);
+  std::vector<float> want_scores(kQueries * kK);
+  index.search_batch(queries.data(), kQueries, kK, want_ids.data(), want_scores.data());
+
+  vectorcore::SearchServiceOptions options;
+  options.max_batch = 32;
+  options.max_delay = std::chrono::microseconds(2000);
+  vectorcore::SearchService service(index, options);
+  assert(service.dim() == kDim);
+
+  std::vector<std::future<vectorcore::SearchService::Result>> futures(kQueries);
+  std::vector<std::thread> clients;
+  for (std::size_t t = 0; t < 8; ++t) {
+    clients.emplace_back([&, t] {
+      for (std::size_t q = t; q < kQueries; q += 8) {
+        futures[q] = service.submit(queries.data() + q * kDim, kK);
+      }
+    });
+  }
+  for (auto& c : clients) {
+    c.join();
+  }
+  for (std::size_t q = 0; q < kQueries; ++q) {
+    const auto result = futures[q].get();
+    assert(result.ids.size() == kK && result.scores.size() == kK);
+    for (std::size_t i = 0; i < kK; ++i) {
+      assert(result.ids[i] == want_ids[q * kK + i]);
+      assert(result.scores[i] == want_scores[q * kK + i]);
+    }
+  }
+
+  // Concurrent submits were coalesced.
+  assert(service.queries() == kQueries);
+  assert(service.batches() < kQueries / 2);
+}
+
+void test_deadline_mixed_k_and_shutdown() {
+  const auto data = random_matrix(kRows, kDim, 3);
+  const auto queries = random_matrix(8, kDim, 4);
+  vectorcore::BruteForceIndex index(kDim);
+  index.add(data.data(), kRows);
+
+  // A lone query goes out once the delay passes, without a full batch.
+  std::atomic<int> scopes{0};
+  vectorcore::SearchServiceOptions options;
+  options.max_batch = 1000;
+  options.max_delay = std::chrono::microseconds(500);
+  options.completion_scope = [&](const std::function<void()>& complete) {
+    ++scopes;
+    complete();
+  };
+  vectorcore::SearchService service(index, options);
+  auto lone = service.submit(queries.data(), kK);
+  assert(lone.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  assert(lone.get().ids.size() == kK && scopes.load() == 1);
+
+  // Mixed k in one batch: each query is answered at its own k.
+  std::vector<std::future<vectorcore::SearchService::Result>> futures;
+  for (std::size_t q = 0; q < 8; ++q) {
+    futures.push_back(service.submit(queries.data() + q * kDim, 1 + q % 3));
+  }
+  for (std::size_t q = 0; q < 8; ++q) {
+    const std::size_t k = 1 + q % 3;
+    std::vector<std::uint64_t> want_ids(k);
+    std::vector<float> want_scores(k);
+    index.search_batch(queries.data() + q * kDim, 1, k, want_ids.data(), want_scores.data());
+    const auto result = futures[q].get();
+    assert(result.ids == want_ids && result.scores == want_scores);
+  }
+
+  // Callbacks; shutdown() serves what is pending before it returns.
+  std::atomic<std::size_t> answered{0};
+  for (std::size_t q = 0; q < 8; ++q) {
+    service.submit(queries.data() + q * kDim, kK, [&](std::exception_ptr error, vectorcore::SearchService::Result r) {
+      if (!error && r.ids.size() == kK) {
+        ++answered;
+      }
+    });
+  }
+  service.shutdown();
+  assert(answered.load() == 8);
+  service.shutdown();
+
+  bool threw = false;
+  try {
+    service.submit(queries.data(), kK);
+  } catch (const std::logic_error&) {
+    threw = true;
+  }
+  assert(threw);
+}
+
+void test_errors() {
+  // A failing batch fails each of its requests, and the service keeps going.
+  std::atomic<bool> fail{true};
+  vectorcore::SearchService service(
+      4, [&](const float*, std::size_t, std::size_t k, std::uint64_t* ids, float* scores) {
+        if (fail) {
+          throw std::runtime_error("backend down");
+        }
+        for (std::size_t i = 0; i < k; ++i) {
+          ids[i] = i;
+          scores[i] = 0.f;
+        }
+      });
+  const float q[4] = {0.f, 1.f, 2.f, 3.f};
+  auto bad = service.submit(q, 2);
+  bool threw = false;
+  try {
+    bad.get();
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  assert(threw);
+  fail = false;
+  assert(service.submit(q, 2).get().ids.size() == 2);
+
+  threw = false;
+  try {
+    vectorcore::SearchServiceOptions options;
+    options.max_batch = 0;
+    vectorcore::SearchService none(4, [](const float*, std::size_t, std::size_t, std::uint64_t*, float*) {}, options);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw);
+}
+
+} // namespace
+
+int main() {
+  const auto data = random_matrix(kRows, kDim, 1);
+  const auto queries = random_matrix(kQueries, kDim, 2);
+
+  vectorcore::BruteForceIndex bf(kDim);
+  bf.add(data.data(), kRows);
+  check_matches_batch(bf, queries);
+
+  vectorcore::HnswIndex hnsw(kDim, 16, vectorcore::Metric::L2_SQUARED, 100);
+  hnsw.add(data.data(), kRows);
+  check_matches_batch(hnsw, queries);
+
+  test_deadline_mixed_k_and_shutdown();
+  test_errors();
+  return 0;
+}
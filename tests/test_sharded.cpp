@@ -0,0 +1,222 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/search_filter.h"
+#include "vectorcore/sharded_index.h"
+#include "vectorcore/thread_pool.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+constexpr std::size_t kDim = 32;
+constexpr std::size_t kRows = 3000;
+constexpr std::size_t kQueries = 50;
+constexpr std::size_t kK = 10;
+
+using ShardedBruteForce = vectorcore::ShardedIndex<vectorcore::BruteForceIndex>;
+using ShardedHnsw = vectorcore::ShardedIndex<vectorcore::HnswIndex>;
+
+ShardedBruteForce sharded_bf(std::size_t shards, vectorcore::Metric metric, vectorcore::ShardRouting routing) {
+  vectorcore::ShardOptions options;
+  options.routing = routing;
+  return ShardedBruteForce(shards, [metric](std::size_t, const vectorcore::MemoryPolicy& memory) {
+    return std::make_unique<vectorcore::BruteForceIndex>(kDim, metric, vectorcore::Storage::FP32, 0, memory);
+  }, options);
+}
+
+template <typename Index>
+void search_all(const Index& index, const std::vector<float>& queries, std::size_t k, std::size_t threads,
+                std::vector<std::uint64_t>& ids, std::vector<float>& scores,
+                const vectorcore::SearchFilter* filter = nullptr) {
+  ids.assign(kQueries * k, 0);
+  scores.assign(kQueries * k, 0.f);
+  index.search_batch(queries.data(), kQueries, k, ids.data(), scores.data(), threads, filter);
+}
+
+// Shards scan disjoint rows with the same kernels, so the merged top-k is
+// the single index's top-k.
+void check_matches_single(vectorcore::Metric metric, vectorcore::ShardRouting routing) {
+  const auto data = random_matrix(kRows, kDim, 1);
+  const auto queries = random_matrix(kQueries, kDim, 2);
+
+  vectorcore::BruteForceIndex single(kDim, metric);
+  single.add(data.data(), kRows);
+
+  ShardedBruteForce sharded = sharded_bf(4, metric, routing);
+  // Uneven batches move the round-robin remainder around.
+  sharded.add(data.data(), 1001);
+  sharded.add(data.data() + 1001 * kDim, 3);
+  sharded.add(data.data() + 1004 * kDim, kRows - 1004);
+  assert(sharded.size() == kRows && sharded.num_shards() == 4 && sharded.dim() == kDim);
+  for (std::size_t s = 0; s < 4; ++s) {
+    if (routing == vectorcore::ShardRouting::ROUND_ROBIN) {
+      assert(sharded.shard(s).size() == kRows / 4);
+    } else {
+      assert(sharded.shard(s).size() > kRows / 8);
+    }
+  }
+
+  std::vector<std::uint64_t> want_ids, ids;
+  std::vector<float> want_scores, scores;
+  search_all(single, queries, kK, 1, want_ids, want_scores);
+  for (const std::size_t threads : {std::size_t{1}, std::size_t{0}}) {
+    search_all(sharded, queries, kK, threads, ids, scores);
+    assert(ids == want_ids);
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      assert(std::abs(scores[i] - want_scores[i]) <= 1e-4f * (1.f + std::abs(want_scores[i])));
+    }
+  }
+
+  // One query takes the per-shard path.
+  std::vector<std::uint64_t> one_ids(kK);
+  std::vector<float> one_scores(kK);
+  sharded.search(queries.data(), kK, one_ids.data(), one_scores.data(), 0);
+  assert(std::equal(one_ids.begin(), one_ids.end(), want_ids.begin()));
+
+  // k past the row count pads like the inner indexes.
+  ShardedBruteForce tiny = sharded_bf(3, metric, routing);
+  tiny.add(data.data(), 5);
+  search_all(tiny, queries, 8, 1, ids, scores);
+  for (std::size_t q = 0; q < kQueries; ++q) {
+    assert(std::count(ids.begin() + q * 8, ids.begin() + q * 8 + 5, std::numeric_limits<std::uint64_t>::max()) == 0);
+    for (std::size_t i = 5; i < 8; ++i) {
+      assert(ids[q * 8 + i] == std::numeric_limits<std::uint64_t>::max());
+      assert(scores[q * 8 + i] == std::numeric_limits<float>::infinity());
+    }
+  }
+}
+
+void test_ids_filters_remove() {
+  const auto data = random_matrix(kRows, kDim, 3);
+  const auto queries = random_matrix(kQueries, kDim, 4);
+  std::vector<std::uint64_t> ids_in(kRows);
+  for (std::size_t i = 0; i < kRows; ++i) {
+    ids_in[i] = 7 * i + 5;
+  }
+
+  vectorcore::BruteForceIndex single(kDim);
+  single.add(data.data(), kRows, ids_in.data());
+  ShardedBruteForce sharded = sharded_bf(3, vectorcore::Metric::L2_SQUARED, vectorcore::ShardRouting::HASH);
+  sharded.add(data.data(), kRows, ids_in.data());
+
+  // Allow-lists and predicates hold on every shard.
+  std::vector<std::uint64_t> allowed;
+  for (std::size_t i = 0; i < kRows; i += 3) {
+    allowed.push_back(ids_in[i]);
+  }
+  const auto allow = vectorcore::SearchFilter::allow_list(allowed.data(), allowed.size());
+  const auto odd = vectorcore::SearchFilter::predicate([](std::uint64_t id) { return id % 2 == 1; });
+  std::vector<std::uint64_t> want_ids, ids;
+  std::vector<float> want_scores, scores;
+  for (const auto* filter : {&allow, &odd}) {
+    search_all(single, queries, kK, 1, want_ids, want_scores, filter);
+    search_all(sharded, queries, kK, 0, ids, scores, filter);
+    assert(ids == want_ids);
+  }
+
+  // Bitmaps name one index's rows.
+  const std::vector<std::uint64_t> words((kRows + 63) / 64, ~std::uint64_t{0});
+  const auto bitmap = vectorcore::SearchFilter::bitmap(words.data(), kRows);
+  bool threw = false;
+  try {
+    search_all(sharded, queries, kK, 1, ids, scores, &bitmap);
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw);
+
+  // remove() finds each id on whichever shard holds it.
+  std::vector<std::uint64_t> gone(want_ids.begin(), want_ids.begin() + kK);
+  gone.push_back(4); // never added
+  assert(single.remove(gone.data(), gone.size()) == kK);
+  assert(sharded.remove(gone.data(), gone.size()) == kK);
+  assert(sharded.size() == kRows - kK);
+  search_all(single, queries, kK, 1, want_ids, want_scores);
+  search_all(sharded, queries, kK, 1, ids, scores);
+  assert(ids == want_ids);
+}
+
+void test_hnsw_shards() {
+  const auto data = random_matrix(kRows, kDim, 5);
+  const auto queries = random_matrix(kQueries, kDim, 6);
+
+  vectorcore::BruteForceIndex exact(kDim);
+  exact.add(data.data(), kRows);
+
+  ShardedHnsw sharded(2, [](std::size_t shard, const vectorcore::MemoryPolicy& memory) {
+    auto index = std::make_unique<vectorcore::HnswIndex>(kDim, 16, vectorcore::Metric::L2_SQUARED, 100, 100 + shard,
+                                                         vectorcore::Storage::FP32, 0, 0, memory);
+    index->set_ef_search(64);
+    return index;
+  });
+  // Sequential ids run across shards as a single index would number them.
+  sharded.add(data.data(), kRows, nullptr, 0);
+  assert(sharded.size() == kRows);
+
+  std::vector<std::uint64_t> want_ids, ids;
+  std::vector<float> want_scores, scores;
+  search_all(exact, queries, kK, 1, want_ids, want_scores);
+  search_all(sharded, queries, kK, 0, ids, scores);
+  std::size_t hits = 0;
+  for (std::size_t q = 0; q < kQueries; ++q) {
+    for (std::size_t i = 0; i < kK; ++i) {
+      hits += std::count(ids.begin() + q * kK, ids.begin() + (q + 1) * kK, want_ids[q * kK + i]);
+    }
+  }
+  assert(hits >= kQueries * kK * 9 / 10);
+}
+
+void test_thread_pool_override() {
+  // An index searches on the pool it is given instead of the global one.
+  const auto data = random_matrix(kRows, kDim, 7);
+  const auto queries = random_matrix(kQueries, kDim, 8);
+  vectorcore::ThreadPool pool(2, vectorcore::numa_node_cpus(0));
+
+  vectorcore::BruteForceIndex index(kDim);
+  index.add(data.data(), kRows);
+  std::vector<std::uint64_t> want_ids, ids;
+  std::vector<float> want_scores, scores;
+  search_all(index, queries, kK, 0, want_ids, want_scores);
+  index.set_thread_pool(&pool);
+  search_all(index, queries, kK, 0, ids, scores);
+  assert(ids == want_ids && scores == want_scores);
+
+  // Shards must agree on dim and metric.
+  bool threw = false;
+  try {
+    ShardedBruteForce bad(2, [](std::size_t shard, const vectorcore::MemoryPolicy&) {
+      return std::make_unique<vectorcore::BruteForceIndex>(kDim + shard);
+    });
+  } catch (const std::invalid_argument&) {
+    threw = true;
+  }
+  assert(threw);
+}
+
+} // namespace
+
+int main() {
+  for (const auto metric : {vectorcore::Metric::L2_SQUARED, vectorcore::Metric::INNER_PRODUCT,
+                            vectorcore::Metric::COSINE}) {
+    check_matches_single(metric, vectorcore::ShardRouting::ROUND_ROBIN);
+    check_matches_single(metric, vectorcore::ShardRouting::HASH);
+  }
+  test_ids_filters_remove();
+  test_hnsw_shards();
+  test_thread_pool_override();
+  return 0;
+}
@@ -0,0 +1,138 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "vectorcore/bruteforce_index.h"
+#include "vectorcore/hnsw_index.h"
+#include "vectorcore/search_filter.h"
+#include "vectorcore/search_stats.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+constexpr std::size_t kDim = 16;
+constexpr std::size_t kRows = 2000;
+constexpr std::size_t kQueries = 30;
+constexpr std::size_t kK = 10;
+
+#if VECTORCORE_STATS
+template <typename Index>
+void search_all(const Index& index, const std::vector<float>& queries) {
+  std::vector<std::uint64_t> ids(kK);
+  std::vector<float> scores(kK);
+  for (std::size_t i = 0; i < kQueries; ++i) {
+    index.search(queries.data() + i * kDim, kK, ids.data(), scores.data());
+  }
+}
+#endif
+
+} // namespace
+
+int main() {
+  using vectorcore::LatencyHistogram;
+
+  // Histogram buckets: exact below 16, within 1/16 above, ordered.
+  {
+    std::mt19937_64 rng(5);
+    std::size_t prev_bucket = 0;
+    for (std::uint64_t v = 0; v < 5000; ++v) {
+      const std::size_t b = LatencyHistogram::bucket_of(v);
+      assert(b >= prev_bucket && b < LatencyHistogram::kBuckets);
+      assert(LatencyHistogram::upper_bound(b) >= v);
+      prev_bucket = b;
+    }
+    for (int i = 0; i < 10000; ++i) {
+      const std::uint64_t v = rng() >> (rng() % 64);
+      const std::uint64_t hi = LatencyHistogram::upper_bound(LatencyHistogram::bucket_of(v));
+      assert(hi >= v && hi - v <= v / 16);
+    }
+    assert(LatencyHistogram::bucket_of(UINT64_MAX) == LatencyHistogram::kBuckets - 1);
+    assert(LatencyHistogram::upper_bound(LatencyHistogram::kBuckets - 1) == UINT64_MAX);
+
+    LatencyHistogram h;
+    assert(h.percentile(0.5) == 0);
+    for (std::uint64_t v = 1; v <= 1000; ++v) {
+      h.record(v);
+    }
+    assert(h.total() == 1000);
+    const std::uint64_t p50 = h.percentile(0.5);
+    assert(p50 >= 500 && p50 <= 500 + 500 / 16);
+    assert(h.percentile(1.0) >= 1000 && h.percentile(0.0) == 1);
+    h.reset();
+    assert(h.total() == 0);
+  }
+
+  // Built with VECTORCORE_STATS=0, indexes never record anything.
+#if VECTORCORE_STATS
+  const auto data = random_matrix(kRows, kDim, 1);
+  const auto queries = random_matrix(kQueries, kDim, 2);
+
+  // Brute force: off by default; when on, every row is visited and scored.
+  {
+    vectorcore::BruteForceIndex index(kDim);
+    index.add(data.data(), kRows);
+    search_all(index, queries);
+    assert(index.stats().queries() == 0);
+
+    index.set_stats_enabled(true);
+    search_all(index, queries);
+    const auto& stats = index.stats();
+    assert(stats.queries() == kQueries);
+    assert(stats.latency().total() == kQueries);
+    assert(stats.total_ns() > 0 && stats.max_ns() > 0);
+    const auto totals = stats.totals();
+    assert(totals.visited == kQueries * kRows);
+    assert(totals.distances == kQueries * kRows);
+    assert(totals.heap_ops >= kQueries * kK && totals.hops == 0);
+    assert(totals.cycles > 0);
+
+    // Filtered rows are visited but not scored.
+    index.reset_stats();
+    assert(index.stats().queries() == 0 && index.stats().totals().distances == 0);
+    const auto even = vectorcore::SearchFilter::predicate([](std::uint64_t id) { return id % 2 == 0; });
+    std::vector<std::uint64_t> ids(kK);
+    std::vector<float> scores(kK);
+    index.search(queries.data(), kK, ids.data(), scores.data(), 1, &even);
+    assert(vectorcore::SearchStats::last_query().visited == kRows);
+    assert(vectorcore::SearchStats::last_query().distances == kRows / 2);
+  }
+
+  // HNSW: single queries and batches record one entry per query.
+  {
+    vectorcore::HnswIndex index(kDim, 12, vectorcore::Metric::L2_SQUARED, 100);
+    index.add(data.data(), kRows);
+    assert(index.stats().queries() == 0); // construction walks are not recorded
+
+    index.set_stats_enabled(true);
+    search_all(index, queries);
+    assert(index.stats().queries() == kQueries);
+    const auto totals = index.stats().totals();
+    assert(totals.distances > kQueries * kK && totals.distances < kQueries * kRows);
+    assert(totals.visited == totals.distances);
+    assert(totals.hops > 0 && totals.hops < totals.distances);
+    assert(totals.heap_ops > totals.hops);
+    const auto last = vectorcore::SearchStats::last_query();
+    assert(last.distances > 0 && last.hops > 0 && last.cycles > 0);
+
+    std::vector<std::uint64_t> ids(kQueries * kK);
+    std::vector<float> scores(kQueries * kK);
+    index.search_batch(queries.data(), kQueries, kK, ids.data(), scores.data(), 0);
+    assert(index.stats().queries() == 2 * kQueries);
+    assert(index.stats().latency().total() == 2 * kQueries);
+
+    index.reset_stats();
+    index.set_stats_enabled(false);
+    search_all(index, queries);
+    assert(index.stats().queries() == 0);
+  }
+#endif
+
+  return 0;
+}
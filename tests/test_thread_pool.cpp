@@ -0,0 +1,83 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "vectorcore/thread_pool.h"
+
+int main() {
+  vectorcore::ThreadPool pool(4);
+  assert(pool.num_threads() == 4);
+  assert(pool.participants(10, 1, 2) == 2);
+  assert(pool.participants(3, 1, 0) == 3);
+  assert(pool.participants(100, 1000, 0) == 1);
+
+  // Every index is visited exactly once; worker ids stay in range.
+  constexpr std::size_t n = 100000;
+  std::vector<std::uint8_t> hits(n, 0);
+  std::atomic<bool> bad_worker{false};
+  for (int round = 0; round < 20; ++round) {
+    pool.parallel_for(n, 97, [&](std::size_t b, std::size_t e, std::size_t w) {
+      if (w >= 4) {
+        bad_worker = true;
+      }
+      for (std::size_t i = b; i < e; ++i) {
+        ++hits[i];
+      }
+    });
+  }
+  assert(!bad_worker);
+  for (const auto h : hits) {
+    assert(h == 20);
+  }
+
+  // max_threads caps the worker ids handed out.
+  std::atomic<std::size_t> max_worker{0};
+  pool.parallel_for(1000, 1, [&](std::size_t, std::size_t, std::size_t w) {
+    std::size_t cur = max_worker.load();
+    while (w > cur && !max_worker.compare_exchange_weak(cur, w)) {
+    }
+  }, 2);
+  assert(max_worker.load() <= 1);
+
+  // Exceptions reach the caller and the pool stays usable.
+  bool caught = false;
+  try {
+    pool.parallel_for(1000, 10, [](std::size_t b, std::size_t, std::size_t) {
+      if (b == 500) {
+        throw std::runtime_error("boom");
+      }
+    });
+  } catch (const std::runtime_error&) {
+    caught = true;
+  }
+  assert(caught);
+
+  // Nested loops run inline on the worker instead of deadlocking.
+  std::atomic<std::size_t> total{0};
+  pool.parallel_for(8, 1, [&](std::size_t, std::size_t, std::size_t) {
+    pool.parallel_for(10, 1, [&](std::size_t b, std::size_t e, std::size_t) { total += e - b; });
+  });
+  assert(total.load() == 80);
+
+  // A loop on another pool from inside a worker is dispatched to that pool.
+  vectorcore::ThreadPool inner(3, {0});
+  assert(inner.num_threads() == 3);
+  std::atomic<std::size_t> inner_max{0};
+  total = 0;
+  pool.parallel_for(4, 1, [&](std::size_t, std::size_t, std::size_t) {
+    inner.parallel_for(30, 1, [&](std::size_t b, std::size_t e, std::size_t w) {
+      total += e - b;
+      std::size_t cur = inner_max.load();
+      while (w > cur && !inner_max.compare_exchange_weak(cur, w)) {
+      }
+    });
+  });
+  assert(total.load() == 120 && inner_max.load() < 3);
+
+  return 0;
+}
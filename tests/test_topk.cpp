@@ -0,0 +1,96 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "vectorcore/topk.h"
+
+namespace {
+
+// Reference: stable sort of (badness, position), first k.
+std::vector<std::pair<float, std::size_t>> reference(const std::vector<float>& xs, std::size_t k) {
+  std::vector<std::pair<float, std::size_t>> all;
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    all.emplace_back(xs[i], i);
+  }
+  std::stable_sort(all.begin(), all.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+  all.resize(std::min(k, all.size()));
+  return all;
+}
+
+void check(const vectorcore::TopK<std::size_t>& top, const std::vector<std::pair<float, std::size_t>>& ref) {
+  assert(top.size() == ref.size());
+  for (std::size_t i = 0; i < ref.size(); ++i) {
+    assert(top.badness()[i] == ref[i].first);
+    assert(top.ids()[i] == ref[i].second);
+  }
+}
+
+} // namespace
+
+int main() {
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> uni(0.f, 1.f);
+  std::uniform_int_distribution<int> coarse(0, 20); // many ties
+
+  vectorcore::TopK<std::size_t> top;
+  for (std::size_t n : {0u, 1u, 7u, 100u, 5000u}) {
+    for (std::size_t k : {1u, 3u, 10u, 64u, 200u}) {
+      for (bool ties : {false, true}) {
+        std::vector<float> xs(n);
+        for (float& x : xs) {
+          x = ties ? static_cast<float>(coarse(rng)) : uni(rng);
+        }
+        const auto ref = reference(xs, k);
+
+        // One at a time.
+        top.reset(k);
+        for (std::size_t i = 0; i < n; ++i) {
+          top.push(xs[i], i);
+        }
+        top.sort();
+        check(top, ref);
+
+        // In blocks, with the ids implied by position.
+        top.reset(k);
+        top.push_block(xs.data(), 0, n);
+        top.sort();
+        check(top, ref);
+
+        // Split across two partial selectors, merged in order.
+        vectorcore::TopK<std::size_t> a(k), b(k);
+        a.push_block(xs.data(), 0, n / 2);
+        b.push_block(xs.data() + n / 2, n / 2, n - n / 2);
+        a.merge(b);
+        a.sort();
+        check(a, ref);
+      }
+    }
+  }
+
+  // Nothing passes an unfilled k == 0 selector.
+  top.reset(0);
+  top.push(0.f, 1);
+  top.sort();
+  assert(top.size() == 0);
+
+  // Re-scoring a wider set, then keeping fewer.
+  top.reset(4);
+  for (std::size_t i = 0; i < 4; ++i) {
+    top.push(static_cast<float>(i), i);
+  }
+  top.sort();
+  for (std::size_t i = 0; i < top.size(); ++i) {
+    top.badness()[i] = -top.badness()[i];
+  }
+  top.truncate(2);
+  top.sort();
+  assert(top.size() == 2 && top.ids()[0] == 3 && top.ids()[1] == 2);
+
+  return 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// Shared helpers for the C++ tests: seeded random data sets and recall.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace vectorcore::test {
+
+// rows x dim floats, uniform in [-1, 1).
+inline std::vector<float> random_matrix(std::size_t rows, std::size_t dim, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uni(-1.f, 1.f);
+  std::vector<float> out(rows * dim);
+  for (float& x : out) {
+    x = uni(rng);
+  }
+  return out;
+}
+
+// rows x dim floats, standard normal.
+inline std::vector<float> gaussian_matrix(std::size_t rows, std::size_t dim, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> gauss(0.f, 1.f);
+  std::vector<float> out(rows * dim);
+  for (float& x : out) {
+    x = gauss(rng);
+  }
+  return out;
+}
+
+// Unit-variance Gaussian blobs around `clusters` centers drawn with
+// standard deviation 4, so IVF and PQ have structure to find.
+inline std::vector<float> clustered_matrix(std::size_t rows, std::size_t dim, std::size_t clusters, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> gauss(0.f, 1.f);
+  std::vector<float> centers(clusters * dim);
+  for (float& x : centers) {
+    x = 4.f * gauss(rng);
+  }
+  std::uniform_int_distribution<std::size_t> pick(0, clusters - 1);
+  std::vector<float> out(rows * dim);
+  for (std::size_t i = 0; i < rows; ++i) {
+    const float* c = centers.data() + pick(rng) * dim;
+    for (std::size_t d = 0; d < dim; ++d) {
+      out[i * dim + d] = c[d] + gauss(rng);
+    }
+  }
+  return out;
+}
+
+// Fraction of the true top-k ids found, over (queries, k) row-major id
+// matrices; the query count is truth.size() / k.
+inline double recall(const std::vector<std::uint64_t>& got, const std::vector<std::uint64_t>& truth, std::size_t k) {
+  const std::size_t queries = truth.size() / k;
+  std::size_t hits = 0;
+  for (std::size_t q = 0; q < queries; ++q) {
+    const auto begin = truth.begin() + q * k;
+    for (std::size_t i = 0; i < k; ++i) {
+      hits += std::count(begin, begin + k, got[q * k + i]) > 0 ? 1 : 0;
+    }
+  }
+  return static_cast<double>(hits) / static_cast<double>(queries * k);
+}
+
+} // namespace vectorcore::test
@@ -0,0 +1,73 @@
+// Keep asserts active in Release builds.
+#undef NDEBUG
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "VectorStore.hpp"
+#include "vectorcore/distance.h"
+
+#include "test_util.h"
+
+namespace {
+
+using vectorcore::test::random_matrix;
+
+// 1000 floats per row -> 256-row chunks, so a few thousand rows span many.
+constexpr std::size_t kDim = 1000;
+constexpr std::size_t kRows = 1500;
+
+} // namespace
+
+int main() {
+  const auto data = random_matrix(kRows, kDim, 1);
+  std::vector<std::uint64_t> ids(kRows);
+  for (std::size_t i = 0; i < kRows; ++i) {
+    ids[i] = (std::uint64_t{1} << 40) + i; // beyond int range
+  }
+
+  vectorcore::VectorStore store(kDim);
+  assert(store.chunk_rows() == 256);
+
+  // One row, then bulk batches that start and end mid-chunk.
+  store.add_vector(ids[0], data.data(), kDim);
+  const float* first = store.get_vector(0);
+  std::size_t row = 1;
+  for (const std::size_t batch : {100u, 300u, 1u, 700u, 398u}) {
+    store.add_vectors(ids.data() + row, data.data() + row * kDim, batch);
+    row += batch;
+  }
+  assert(row == kRows && store.size() == kRows);
+
+  // Growth never moved earlier rows.
+  assert(store.get_vector(0) == first);
+  for (std::size_t i = 0; i < kRows; ++i) {
+    assert(store.get_id(i) == ids[i]);
+    assert(std::equal(data.begin() + i * kDim, data.begin() + (i + 1) * kDim, store.get_vector(i)));
+  }
+
+  // Search spans every chunk: each row finds itself first.
+  for (const std::size_t i : {0u, 255u, 256u, 777u, 1499u}) {
+    const auto hits = store.search(data.data() + i * kDim, 3);
+    assert(hits.size() == 3 && hits[0].second == ids[i] && hits[0].first == 0.f);
+    assert(hits[1].first <= hits[2].first);
+  }
+
+  // Exact top-k against a direct scan.
+  const auto q = random_matrix(1, kDim, 2);
+  std::vector<std::pair<float, std::uint64_t>> truth;
+  for (std::size_t i = 0; i < kRows; ++i) {
+    truth.emplace_back(vectorcore::l2_squared(q.data(), data.data() + i * kDim, kDim), ids[i]);
+  }
+  std::sort(truth.begin(), truth.end());
+  const auto hits = store.search(q.data(), 10);
+  for (std::size_t i = 0; i < 10; ++i) {
+    assert(hits[i] == truth[i]);
+  }
+
+  store.add_vectors(ids.data(), data.data(), 0);
+  assert(store.size() == kRows);
+  return 0;
+}